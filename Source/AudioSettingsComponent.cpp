@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    AudioSettingsComponent.cpp
+    Created: 19 Oct 2026 12:23:40pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "AudioSettingsComponent.h"
+
+//==============================================================================
+AudioSettingsComponent::AudioSettingsComponent(AudioDeviceManager& _deviceManager)
+                                              : deviceManager(_deviceManager),
+                                                deviceSelector(_deviceManager,
+                                                               0, 2,   // inputs are only needed for the loopback test
+                                                               2, 2,
+                                                               true, false,   // MIDI inputs, for MidiController
+                                                               true,
+                                                               false),
+                                                latencyTester(_deviceManager)
+{
+    addAndMakeVisible(deviceSelector);
+    addAndMakeVisible(loopbackButton);
+    addAndMakeVisible(jitterButton);
+    addAndMakeVisible(sweepButton);
+    addAndMakeVisible(hintLabel);
+    addAndMakeVisible(resultsBox);
+
+    loopbackButton.addListener(this);
+    jitterButton.addListener(this);
+    sweepButton.addListener(this);
+    latencyTester.addChangeListener(this);
+
+    for (auto* button : { &loopbackButton, &jitterButton, &sweepButton }){
+        button->setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+        button->setColour(TextButton::textColourOffId, Colours::white);
+        button->setLookAndFeel(&lookAndFeel);
+    }
+
+    hintLabel.setFont(14.0f);
+    hintLabel.setColour(Label::textColourId, Colours::white);
+    hintLabel.setText("Round trip: enable an input and patch it to an output (the test plays a short noise burst). "
+                      "Pause both decks while testing.",
+                      dontSendNotification);
+
+    resultsBox.setMultiLine(true);
+    resultsBox.setReadOnly(true);
+    resultsBox.setFont(Font(Font::getDefaultMonospacedFontName(), 14.0f, Font::plain));
+    resultsBox.setColour(TextEditor::backgroundColourId, Colour(32, 32, 32));
+    resultsBox.setColour(TextEditor::textColourId, Colours::white);
+}
+
+AudioSettingsComponent::~AudioSettingsComponent()
+{
+    latencyTester.removeChangeListener(this);
+    latencyTester.cancel();
+
+    loopbackButton.setLookAndFeel(nullptr);
+    jitterButton.setLookAndFeel(nullptr);
+    sweepButton.setLookAndFeel(nullptr);
+}
+
+void AudioSettingsComponent::paint(Graphics& g)
+{
+    g.fillAll(Colour(22, 22, 22));//background colour
+}
+
+void AudioSettingsComponent::resized()
+{
+    auto area = getLocalBounds().reduced(8);
+
+    deviceSelector.setBounds(area.removeFromTop(area.getHeight() / 2));
+
+    auto buttonRow = area.removeFromTop(32);
+    const int buttonW = buttonRow.getWidth() / 3;
+    loopbackButton.setBounds(buttonRow.removeFromLeft(buttonW).reduced(2));
+    jitterButton.setBounds(buttonRow.removeFromLeft(buttonW).reduced(2));
+    sweepButton.setBounds(buttonRow.reduced(2));
+
+    hintLabel.setBounds(area.removeFromTop(40));
+    resultsBox.setBounds(area);
+}
+
+void AudioSettingsComponent::buttonClicked(Button* button)
+{
+    if (button == &loopbackButton){
+        setButtonsEnabled(false);
+        resultsBox.setText("Measuring round trip...");
+        latencyTester.startLoopbackTest();
+    }
+    if (button == &jitterButton){
+        setButtonsEnabled(false);
+        resultsBox.setText("Measuring callback jitter for 3 seconds...");
+        latencyTester.startJitterTest(3000);
+    }
+    if (button == &sweepButton){
+        auto* device = deviceManager.getCurrentAudioDevice();
+        if (device == nullptr){
+            resultsBox.setText("No audio device is open");
+            return;
+        }
+        sweepBufferSizes = device->getAvailableBufferSizes();
+        sweepBufferSizes.sort();
+        sweepOriginalBufferSize = device->getCurrentBufferSizeSamples();
+        safeBufferSize = 0;
+        sweepIndex = -1;
+        sweepLog.clear();
+
+        setButtonsEnabled(false);
+        testNextSweepBufferSize();
+    }
+}
+
+void AudioSettingsComponent::changeListenerCallback(ChangeBroadcaster* source)
+{
+    if (source != &latencyTester){
+        return;
+    }
+
+    const auto& results = latencyTester.getResults();
+
+    if (sweepIndex < 0){
+        resultsBox.setText(results.toString());
+        setButtonsEnabled(true);
+        return;
+    }
+
+    //buffer sizes are tried from small to large, so the first safe one wins
+    sweepLog << results.bufferSize << " samples: "
+             << (results.isSafe() ? "ok" : "unsafe")
+             << " (max jitter " << String(results.maxJitterMs, 2) << " ms, xruns "
+             << results.xruns << ")\n";
+    resultsBox.setText(sweepLog);
+
+    if (results.isSafe()){
+        safeBufferSize = results.bufferSize;
+        finishSweep();
+    }
+    else{
+        testNextSweepBufferSize();
+    }
+}
+
+void AudioSettingsComponent::testNextSweepBufferSize()
+{
+    ++sweepIndex;
+    if (sweepIndex >= sweepBufferSizes.size()){
+        finishSweep();
+        return;
+    }
+
+    AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager.getAudioDeviceSetup(setup);
+    setup.bufferSize = sweepBufferSizes[sweepIndex];
+
+    const String error = deviceManager.setAudioDeviceSetup(setup, true);
+    if (error.isNotEmpty()){
+        sweepLog << setup.bufferSize << " samples: " << error << "\n";
+        resultsBox.setText(sweepLog);
+        testNextSweepBufferSize();
+        return;
+    }
+
+    latencyTester.startJitterTest(3000);
+}
+
+void AudioSettingsComponent::finishSweep()
+{
+    AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager.getAudioDeviceSetup(setup);
+    setup.bufferSize = (safeBufferSize > 0) ? safeBufferSize : sweepOriginalBufferSize;
+    deviceManager.setAudioDeviceSetup(setup, true);
+
+    if (safeBufferSize > 0){
+        sweepLog << "\nSmallest safe buffer: " << safeBufferSize << " samples (now selected)";
+    }
+    else{
+        sweepLog << "\nNo buffer size ran cleanly, kept " << sweepOriginalBufferSize << " samples";
+    }
+    resultsBox.setText(sweepLog);
+
+    sweepIndex = -1;
+    setButtonsEnabled(true);
+}
+
+void AudioSettingsComponent::setButtonsEnabled(bool enabled)
+{
+    loopbackButton.setEnabled(enabled);
+    jitterButton.setEnabled(enabled);
+    sweepButton.setEnabled(enabled);
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    AudioSettingsComponent.h
+    Created: 19 Oct 2026 12:23:40pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "LatencyTester.h"
+
+//==============================================================================
+/*
+    Audio settings panel shown in a dialog from MainComponent.
+    Device type (incl. ALSA/JACK on Linux), device, sample rate and buffer size
+    are picked with JUCE's AudioDeviceSelectorComponent, along with the MIDI
+    inputs the controllers are on; MainComponent persists whatever ends up
+    selected. Underneath there are the latency tools.
+*/
+class AudioSettingsComponent  : public Component,
+                                public Button::Listener,
+                                public ChangeListener
+{
+public:
+    AudioSettingsComponent(AudioDeviceManager& deviceManager);
+    ~AudioSettingsComponent() override;
+
+    void paint (Graphics&) override;
+    void resized() override;
+
+    /** implement Button::Listener */
+    void buttonClicked (Button* button) override;
+
+    /** called by the LatencyTester when a test has finished */
+    void changeListenerCallback (ChangeBroadcaster* source) override;
+
+private:
+    /** switches the device to the next buffer size of the sweep and tests it */
+    void testNextSweepBufferSize();
+    /** ends the sweep, keeping the smallest safe buffer size found (if any) */
+    void finishSweep();
+    void setButtonsEnabled(bool enabled);
+
+    AudioDeviceManager& deviceManager;
+    AudioDeviceSelectorComponent deviceSelector;
+    LatencyTester latencyTester;
+
+    TextButton loopbackButton{ "MEASURE ROUND TRIP" };
+    TextButton jitterButton{ "MEASURE JITTER" };
+    TextButton sweepButton{ "FIND SMALLEST SAFE BUFFER" };
+    Label hintLabel;
+    TextEditor resultsBox;
+
+    //buffer size sweep state
+    Array<int> sweepBufferSizes;
+    int sweepIndex = -1;
+    int sweepOriginalBufferSize = 0;
+    int safeBufferSize = 0;
+    String sweepLog;
+
+    //lookAndFeel variable used to match the buttons of the rest of the app
+    LookAndFeel_V2 lookAndFeel;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioSettingsComponent)
+};
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    BandEnergyAnalyser.cpp
+    Created: 19 Oct 2026 12:33:16pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "BandEnergyAnalyser.h"
+
+//==============================================================================
+BandEnergyAnalyser::BandEnergyAnalyser(double sampleRate)
+{
+    //the filters run on the audio decimated by 2
+    const double rate = sampleRate / 2.0;
+
+    using Coefficients = dsp::IIR::Coefficients<float>;
+    const Coefficients::Ptr filters[] = { Coefficients::makeLowPass(rate, 200.0f),
+                                          Coefficients::makeBandPass(rate, 1000.0f, 0.6f),
+                                          Coefficients::makeHighPass(rate, 4000.0f) };
+
+    b0 = b1 = b2 = a1 = a2 = s1 = s2 = Register::expand(0.0f);
+
+    for (size_t lane = 0; lane < 3; ++lane){
+        //normalised second order coefficients: b0, b1, b2, a1, a2
+        const float* c = filters[lane]->getRawCoefficients();
+        b0.set(lane, c[0]);
+        b1.set(lane, c[1]);
+        b2.set(lane, c[2]);
+        a1.set(lane, c[3]);
+        a2.set(lane, c[4]);
+    }
+}
+
+BandEnergyAnalyser::Bands BandEnergyAnalyser::process(const float* monoSamples, int numSamples)
+{
+    Register energy = Register::expand(0.0f);
+    int numFiltered = 0;
+
+    for (int i = 0; i + 1 < numSamples; i += 2){
+        //averaging pairs is a crude but cheap anti-alias filter for the decimation
+        const Register x = Register::expand((monoSamples[i] + monoSamples[i + 1]) * 0.5f);
+
+        const Register y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+
+        energy += y * y;
+        ++numFiltered;
+    }
+
+    Bands bands;
+    if (numFiltered > 0){
+        auto toLevel = [numFiltered] (float sumOfSquares) {
+            return static_cast<uint8>(jlimit(0, 255, roundToInt(std::sqrt(sumOfSquares / numFiltered) * 255.0f)));
+        };
+        bands.low = toLevel(energy.get(0));
+        bands.mid = toLevel(energy.get(1));
+        bands.high = toLevel(energy.get(2));
+    }
+    return bands;
+}
+
+Colour BandEnergyAnalyser::getColourFor(const Bands& bands)
+{
+    const float low = bands.low;
+    const float mid = bands.mid;
+    const float high = bands.high;
+    const float total = low + mid + high;
+
+    if (total < 1.0f){
+        return Colour(90, 90, 90); //silence
+    }
+
+    //weighted mix of the three band colours
+    const Colour lowColour(255, 50, 60);
+    const Colour midColour(70, 255, 100);
+    const Colour highColour(80, 150, 255);
+
+    auto mix = [&] (uint8 l, uint8 m, uint8 h) {
+        return static_cast<uint8>(jlimit(0, 255, roundToInt((low * l + mid * m + high * h) / total)));
+    };
+    return Colour(mix(lowColour.getRed(), midColour.getRed(), highColour.getRed()),
+                  mix(lowColour.getGreen(), midColour.getGreen(), highColour.getGreen()),
+                  mix(lowColour.getBlue(), midColour.getBlue(), highColour.getBlue()));
+}
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    BandEnergyAnalyser.h
+    Created: 19 Oct 2026 12:33:16pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/*
+    Splits mono audio into low (< 200 Hz), mid (around 1 kHz) and high (> 4 kHz)
+    bands and measures the energy of each, so the waveform can be coloured by
+    what is playing (kicks, vocals, hats).
+    The input is decimated by 2 and the three biquads run side by side in the
+    lanes of one dsp::SIMDRegister, so each sample costs a single vectorised
+    filter step. Used by WaveformPyramid::build() on the background threads.
+*/
+class BandEnergyAnalyser
+{
+public:
+    /** rms of each band, scaled to 0..255 like WaveformPyramid::Peak::rms */
+    struct Bands
+    {
+        uint8 low = 0;
+        uint8 mid = 0;
+        uint8 high = 0;
+    };
+
+    BandEnergyAnalyser(double sampleRate);
+
+    /** filters the next run of mono samples (one pyramid bin) and returns its band levels */
+    Bands process(const float* monoSamples, int numSamples);
+
+    /** colour of a column with these band levels: red for lows, green for mids, blue for highs */
+    static Colour getColourFor(const Bands& bands);
+
+private:
+    using Register = dsp::SIMDRegister<float>;
+
+    //lane 0 = low pass, lane 1 = band pass, lane 2 = high pass, any other lanes are unused
+    Register b0, b1, b2, a1, a2;
+    //filter state (transposed direct form II), kept between calls
+    Register s1, s2;
+};
@@ -0,0 +1,533 @@
+/*
+  ==============================================================================
+
+    ControlSession.cpp
+    Created: 19 Oct 2026 1:13:25pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "ControlSession.h"
+#include "DJAudioPlayer.h"
+#include "DeckMixer.h"
+#include <algorithm>
+
+namespace
+{
+    //an offline render goes on this long after the last call, so the end of the set is in it
+    const double renderTailSeconds = 10.0;
+}
+
+//==============================================================================
+String ControlSession::Metrics::toString() const
+{
+    String text;
+    text << "events: " << numEvents << "\n";
+    if (maxLatenessMs > 0.0){
+        text << "lateness: average " << String(averageLatenessMs, 2) << " ms, max " << String(maxLatenessMs, 2) << " ms\n";
+    }
+    text << "blocks: " << numBlocks << ", average " << String(averageBlockMs, 3) << " ms, max "
+         << String(maxBlockMs, 3) << " ms, overruns " << numOverruns << "\n";
+    text << "audio: " << String(audioSeconds, 1) << " s in " << String(wallSeconds, 1) << " s";
+    if (wallSeconds > 0.0){
+        text << " (" << String(audioSeconds / wallSeconds, 1) << "x real time)";
+    }
+    text << "\n";
+    return text;
+}
+
+//==============================================================================
+ControlSession::ControlSession()
+{
+}
+
+ControlSession::~ControlSession()
+{
+    stopReplay();
+    stopRecording();
+}
+
+bool ControlSession::startRecording(const File& file)
+{
+    stopRecording();
+
+    if (!file.getParentDirectory().createDirectory()){
+        return false;
+    }
+    std::unique_ptr<FileOutputStream> out (new FileOutputStream(file));
+    if (!out->openedOk() || !out->setPosition(0) || out->truncate().failed()){
+        std::cout << "ControlSession::startRecording could not write " << file.getFullPathName() << std::endl;
+        return false;
+    }
+    String header;
+    header << "# OtoDecks " << ProjectInfo::versionString << " control session, started "
+           << Time::getCurrentTime().toString(true, true) << "\n"
+           << "# time ms, sample, deck, event, value, path\n";
+    out->writeText(header, false, false, nullptr);
+    out->flush();
+
+    output = std::move(out);
+    startMs = Time::getMillisecondCounterHiRes();
+    lastFlushMs = startMs;
+    recording = true;
+    startTimer(isReplaying() ? 1 : 1000);
+    return true;
+}
+
+void ControlSession::stopRecording()
+{
+    if (output == nullptr){
+        return;
+    }
+    recording = false;
+    flush();
+    output.reset();
+    if (!isReplaying()){
+        stopTimer();
+    }
+}
+
+bool ControlSession::isRecording() const
+{
+    return recording.load();
+}
+
+void ControlSession::record(int deck, EventType type, double value, const String& path)
+{
+    if (!recording.load()){
+        return;
+    }
+
+    const String line = formatLine(Time::getMillisecondCounterHiRes() - startMs, samplesRendered.load(),
+                                   deck, type, value, path);
+    const ScopedLock sl(pendingLock);
+    pendingLines << line;
+}
+
+void ControlSession::recordControl(int deck, EventType type, double value, double timeMs)
+{
+    if (!recording.load()){
+        return;
+    }
+
+    const SpinLock::ScopedLockType sl(controlWriterLock);
+    int start1, size1, start2, size2;
+    controlFifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 + size2 == 0){
+        ++numControlsDropped;
+        return;
+    }
+    controlQueue[size1 > 0 ? start1 : start2] = { timeMs - startMs, samplesRendered.load(), deck, type, value };
+    controlFifo.finishedWrite(1);
+}
+
+void ControlSession::deviceStarted(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    record(-1, deviceEvent, newSampleRate);
+}
+
+void ControlSession::audioBlockRendered(int numSamples, double processingMs)
+{
+    samplesRendered += numSamples;
+    if (!measuringBlocks.load()){
+        return;
+    }
+
+    const int64 micros = static_cast<int64>(processingMs * 1000.0);
+    ++numBlocks;
+    totalBlockMicros += micros;
+    measuredSamples += numSamples;
+    int64 previousMax = maxBlockMicros.load();
+    while (micros > previousMax && !maxBlockMicros.compare_exchange_weak(previousMax, micros)){
+    }
+    if (processingMs > numSamples * 1000.0 / sampleRate.load()){
+        ++numOverruns;
+    }
+}
+
+void ControlSession::flush()
+{
+    String lines;
+    {
+        const ScopedLock sl(pendingLock);
+        lines.swapWith(pendingLines);
+    }
+
+    //written after the calls of the same second, load() puts them back in time order
+    int start1, size1, start2, size2;
+    controlFifo.prepareToRead(controlFifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1 + size2; ++i){
+        const ControlRecord& control = controlQueue[i < size1 ? start1 + i : start2 + i - size1];
+        lines << formatLine(control.timeMs, control.samplePosition, control.deck, control.type, control.value, {});
+    }
+    controlFifo.finishedRead(size1 + size2);
+    if (const int dropped = numControlsDropped.exchange(0)){
+        std::cout << "ControlSession::flush " << dropped << " controller moves came too fast to be recorded" << std::endl;
+    }
+
+    lastFlushMs = Time::getMillisecondCounterHiRes();
+    if (output != nullptr && lines.isNotEmpty()){
+        output->writeText(lines, false, false, nullptr);
+        output->flush();
+    }
+}
+
+//==============================================================================
+bool ControlSession::startReplay(const File& file, DJAudioPlayer& leftPlayer, DJAudioPlayer& rightPlayer)
+{
+    stopReplay();
+    if (!load(file, replayEvents)){
+        std::cout << "ControlSession::startReplay could not read " << file.getFullPathName() << std::endl;
+        return false;
+    }
+
+    replayFile = file;
+    replayPlayers[0] = &leftPlayer;
+    replayPlayers[1] = &rightPlayer;
+    nextReplayEvent = 0;
+    totalLatenessMs = 0.0;
+    maxLatenessMs = 0.0;
+
+    numBlocks = 0;
+    numOverruns = 0;
+    totalBlockMicros = 0;
+    maxBlockMicros = 0;
+    measuredSamples = 0;
+    measuringBlocks = true;
+
+    //checked every millisecond (as often as the message thread allows), on the thread the calls were made on
+    replayStartMs = Time::getMillisecondCounterHiRes();
+    startTimer(1);
+    return true;
+}
+
+void ControlSession::stopReplay()
+{
+    if (!isReplaying()){
+        return;
+    }
+    measuringBlocks = false;
+    replayEvents.clear();
+    nextReplayEvent = 0;
+    if (isRecording()){
+        startTimer(1000);
+    }
+    else{
+        stopTimer();
+    }
+}
+
+bool ControlSession::isReplaying() const
+{
+    return !replayEvents.empty();
+}
+
+void ControlSession::timerCallback()
+{
+    if (isReplaying()){
+        replayDueEvents();
+    }
+    //the timer runs every millisecond during a replay, so the flush goes by the clock
+    if (isRecording() && Time::getMillisecondCounterHiRes() - lastFlushMs >= 1000.0){
+        flush();
+    }
+}
+
+void ControlSession::replayDueEvents()
+{
+    const double nowMs = Time::getMillisecondCounterHiRes() - replayStartMs;
+    while (nextReplayEvent < replayEvents.size() && replayEvents[nextReplayEvent].timeMs <= nowMs){
+        const Event& event = replayEvents[nextReplayEvent++];
+        if (event.deck < 0){
+            continue;
+        }
+        const double latenessMs = nowMs - event.timeMs;
+        totalLatenessMs += latenessMs;
+        maxLatenessMs = jmax(maxLatenessMs, latenessMs);
+        apply(event, *replayPlayers[event.deck]);
+    }
+
+    if (nextReplayEvent >= replayEvents.size()){
+        finishReplay();
+    }
+}
+
+void ControlSession::finishReplay()
+{
+    measuringBlocks = false;
+
+    Metrics metrics;
+    for (const Event& event : replayEvents){
+        metrics.numEvents += event.deck >= 0 ? 1 : 0;
+    }
+    metrics.averageLatenessMs = metrics.numEvents > 0 ? totalLatenessMs / metrics.numEvents : 0.0;
+    metrics.maxLatenessMs = maxLatenessMs;
+    metrics.numBlocks = numBlocks.load();
+    metrics.averageBlockMs = metrics.numBlocks > 0 ? totalBlockMicros.load() / 1000.0 / metrics.numBlocks : 0.0;
+    metrics.maxBlockMs = maxBlockMicros.load() / 1000.0;
+    metrics.numOverruns = numOverruns.load();
+    metrics.audioSeconds = measuredSamples.load() / sampleRate.load();
+    metrics.wallSeconds = (Time::getMillisecondCounterHiRes() - replayStartMs) / 1000.0;
+    writeReport(replayFile, "live", metrics);
+
+    stopReplay();
+}
+
+//==============================================================================
+ControlSession::Metrics ControlSession::renderOffline(const File& sessionFile, AudioFormatManager& formatManager,
+                                                      int blockSize, const File& outputFile)
+{
+    Metrics metrics;
+    std::vector<Event> events;
+    if (!load(sessionFile, events)){
+        std::cout << "ControlSession::renderOffline could not read " << sessionFile.getFullPathName() << std::endl;
+        return metrics;
+    }
+
+    //the rate of the device it was recorded on, so the sample positions mean the same here
+    double rate = 44100.0;
+    for (const Event& event : events){
+        if (event.type == deviceEvent && event.value > 0.0){
+            rate = event.value;
+            break;
+        }
+    }
+
+    DJAudioPlayer leftPlayer{ formatManager };
+    DJAudioPlayer rightPlayer{ formatManager };
+    DJAudioPlayer* players[2] = { &leftPlayer, &rightPlayer };
+    //mixed the same way as live, without plugins
+    DeckMixer mixer;
+    mixer.addDeck(&leftPlayer, nullptr);
+    mixer.addDeck(&rightPlayer, nullptr);
+    mixer.prepareToPlay(blockSize, rate);
+
+    std::unique_ptr<AudioFormatWriter> writer;
+    if (outputFile != File()){
+        outputFile.deleteFile();
+        std::unique_ptr<FileOutputStream> stream (outputFile.createOutputStream());
+        WavAudioFormat wav;
+        if (stream != nullptr){
+            writer.reset(wav.createWriterFor(stream.get(), rate, 2, 24, {}, 0));
+        }
+        if (writer != nullptr){
+            stream.release(); //owned by the writer now
+        }
+    }
+
+    const int64 lastSample = events.empty() ? 0 : events.back().samplePosition;
+    const int64 totalSamples = lastSample + static_cast<int64>(rate * renderTailSeconds);
+    const double blockMs = blockSize * 1000.0 / rate;
+    AudioBuffer<float> buffer(2, blockSize);
+    double totalBlockMs = 0.0;
+    size_t next = 0;
+
+    const double startMs = Time::getMillisecondCounterHiRes();
+    for (int64 position = 0; position < totalSamples; position += blockSize){
+        //a call made while a block was playing took effect at the start of the next one
+        while (next < events.size() && events[next].samplePosition <= position){
+            const Event& event = events[next++];
+            if (event.deck >= 0){
+                apply(event, *players[event.deck]);
+                ++metrics.numEvents;
+            }
+        }
+
+        const double blockStartMs = Time::getMillisecondCounterHiRes();
+        AudioSourceChannelInfo info(&buffer, 0, blockSize);
+        mixer.getNextAudioBlock(info);
+        const double thisBlockMs = Time::getMillisecondCounterHiRes() - blockStartMs;
+
+        ++metrics.numBlocks;
+        totalBlockMs += thisBlockMs;
+        metrics.maxBlockMs = jmax(metrics.maxBlockMs, thisBlockMs);
+        metrics.numOverruns += thisBlockMs > blockMs ? 1 : 0;
+
+        if (writer != nullptr){
+            writer->writeFromAudioSampleBuffer(buffer, 0, blockSize);
+        }
+    }
+    metrics.wallSeconds = (Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+    metrics.audioSeconds = totalSamples / rate;
+    metrics.averageBlockMs = metrics.numBlocks > 0 ? totalBlockMs / metrics.numBlocks : 0.0;
+
+    mixer.releaseResources();
+    return metrics;
+}
+
+//==============================================================================
+bool ControlSession::load(const File& file, std::vector<Event>& events)
+{
+    events.clear();
+    const String text = file.loadFileAsString();
+    if (text.isEmpty()){
+        return false;
+    }
+
+    StringArray lines;
+    lines.addLines(text);
+    //a crash while writing can leave the last line cut short
+    if (!text.endsWithChar('\n')){
+        lines.remove(lines.size() - 1);
+    }
+
+    for (const String& line : lines){
+        if (line.isEmpty() || line.startsWithChar('#')){
+            continue;
+        }
+        StringArray fields = StringArray::fromTokens(line, "\t", "");
+        Event event;
+        if (fields.size() < 5 || !parseTypeName(fields[3], event.type)){
+            continue;
+        }
+        event.timeMs = fields[0].getDoubleValue();
+        event.samplePosition = fields[1].getLargeIntValue();
+        event.deck = fields[2].getIntValue();
+        event.value = fields[4].getDoubleValue();
+        fields.removeRange(0, 5);
+        event.path = fields.joinIntoString("\t");
+        if (event.deck < -1 || event.deck > 1){
+            continue;
+        }
+        events.push_back(event);
+    }
+
+    //controller moves are written at the next flush, after the calls made in the meantime
+    std::stable_sort(events.begin(), events.end(), [] (const Event& a, const Event& b) {
+        return a.timeMs < b.timeMs;
+    });
+    return true;
+}
+
+void ControlSession::apply(const Event& event, DJAudioPlayer& player)
+{
+    switch (event.type){
+        case loadEvent:
+            player.loadURL(File::isAbsolutePath(event.path) ? URL(File(event.path)) : URL(event.path));
+            break;
+        case playEvent:
+            player.start();
+            break;
+        case pauseEvent:
+            player.pause();
+            break;
+        case resetEvent:
+            player.reset();
+            break;
+        case loopEvent:
+            player.loop(event.value != 0.0);
+            break;
+        case gainEvent:
+            player.setGain(event.value);
+            break;
+        case speedEvent:
+            player.setSpeed(event.value);
+            break;
+        case positionEvent:
+            player.setPosition(event.value);
+            break;
+        case positionRelativeEvent:
+            player.setPositionRelative(event.value);
+            break;
+        case eqLowEvent:
+            player.setEqGain(DJAudioPlayer::eqLow, event.value);
+            break;
+        case eqMidEvent:
+            player.setEqGain(DJAudioPlayer::eqMid, event.value);
+            break;
+        case eqHighEvent:
+            player.setEqGain(DJAudioPlayer::eqHigh, event.value);
+            break;
+        case jogEvent:
+        case cueEvent:
+        {
+            //these act on the audio thread's state; a time long past puts them at the start of the next block,
+            //which is where they land both live and offline
+            DJAudioPlayer::ControlChange change;
+            change.type = event.type == jogEvent ? DJAudioPlayer::ControlChange::jogChange
+                                                 : DJAudioPlayer::ControlChange::cueChange;
+            change.value = event.value;
+            change.timeMs = 0.0;
+            player.pushControl(change);
+            break;
+        }
+        case deviceEvent:
+            break;
+    }
+}
+
+void ControlSession::writeReport(const File& sessionFile, const String& mode, const Metrics& metrics)
+{
+    const Time now = Time::getCurrentTime();
+    String text;
+    text << "OtoDecks " << ProjectInfo::versionString << ", " << mode << " replay of " << sessionFile.getFileName()
+         << " on " << now.toString(true, true) << "\n" << metrics.toString();
+    std::cout << text << std::endl;
+
+    const File report = sessionFile.getSiblingFile(sessionFile.getFileNameWithoutExtension() + "-" + mode + "-"
+                                                   + now.formatted("%Y%m%d-%H%M%S") + ".txt");
+    if (!report.replaceWithText(text)){
+        std::cout << "ControlSession::writeReport could not write " << report.getFullPathName() << std::endl;
+    }
+}
+
+File ControlSession::getSessionsFolder()
+{
+    return File::getSpecialLocation(File::userApplicationDataDirectory)
+               .getChildFile(ProjectInfo::projectName).getChildFile("Sessions");
+}
+
+void ControlSession::deleteOldSessions(int maxSessions)
+{
+    //the names start with the date, so they sort oldest first
+    Array<File> sessions = getSessionsFolder().findChildFiles(File::findFiles, false, "*.otosession");
+    sessions.sort();
+    for (int i = 0; i < sessions.size() - maxSessions; ++i){
+        sessions[i].deleteFile();
+    }
+}
+
+//==============================================================================
+String ControlSession::getTypeName(EventType type)
+{
+    switch (type){
+        case loadEvent:             return "load";
+        case playEvent:             return "play";
+        case pauseEvent:            return "pause";
+        case resetEvent:            return "reset";
+        case loopEvent:             return "loop";
+        case gainEvent:             return "gain";
+        case speedEvent:            return "speed";
+        case positionEvent:         return "position";
+        case positionRelativeEvent: return "positionRelative";
+        case eqLowEvent:            return "eqLow";
+        case eqMidEvent:            return "eqMid";
+        case eqHighEvent:           return "eqHigh";
+        case jogEvent:              return "jog";
+        case cueEvent:              return "cue";
+        case deviceEvent:           return "device";
+    }
+    return {};
+}
+
+String ControlSession::formatLine(double timeMs, int64 samplePosition, int deck, EventType type,
+                                  double value, const String& path)
+{
+    String line;
+    line << String(timeMs, 3) << "\t" << samplePosition << "\t" << deck << "\t" << getTypeName(type) << "\t"
+         << String(value, 9) << "\t" << path << "\n";
+    return line;
+}
+
+bool ControlSession::parseTypeName(const String& name, EventType& type)
+{
+    for (int i = loadEvent; i <= deviceEvent; ++i){
+        if (name == getTypeName(static_cast<EventType>(i))){
+            type = static_cast<EventType>(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    ControlSession.h
+    Created: 19 Oct 2026 1:13:25pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <vector>
+
+class DJAudioPlayer;
+
+//==============================================================================
+/*
+    Records every control call made on the decks' DJAudioPlayers (loads from
+    the deck or the playlist, play, pause, reset, loop, gain, speed, seeks)
+    and every MIDI controller move (fader, speed, EQ, jog, cue), with the
+    time since the session started and the position of the audio stream
+    (samples rendered so far) when the call was made. Controller moves come
+    from the MIDI thread through a lock-free queue that the message thread
+    empties when it writes. Sessions are kept as text files, one event per
+    line, flushed once a second, so a crash loses at most the last second.
+    A session can be replayed live, re-driving the same player calls at the
+    recorded times while the audio device runs, or rendered offline as fast
+    as possible, applying each call before the block it fell into, so the
+    render is the same on every run. Both measure how long the audio blocks
+    took (and, live, how late each call was) and write a report next to the
+    session, so two builds can be compared on the same workload.
+    Message thread only, except audioBlockRendered() and deviceStarted().
+*/
+class ControlSession  : private Timer
+{
+public:
+    enum EventType
+    {
+        loadEvent,
+        playEvent,
+        pauseEvent,
+        resetEvent,
+        loopEvent,
+        gainEvent,
+        speedEvent,
+        positionEvent,
+        positionRelativeEvent,
+        //EQ gain in dB
+        eqLowEvent,
+        eqMidEvent,
+        eqHighEvent,
+        //value is signed jog ticks
+        jogEvent,
+        cueEvent,
+        //the audio device (re)started; value is its sample rate
+        deviceEvent
+    };
+
+    struct Event
+    {
+        //since the start of the recording
+        double timeMs = 0.0;
+        //samples the device had rendered when the call was made
+        int64 samplePosition = 0;
+        //0 left, 1 right, -1 for device events
+        int deck = 0;
+        EventType type = playEvent;
+        double value = 0.0;
+        //file of a load
+        String path;
+    };
+
+    struct Metrics
+    {
+        int numEvents = 0;
+        //live replay only: how much later than recorded the calls were made
+        double averageLatenessMs = 0.0;
+        double maxLatenessMs = 0.0;
+        int numBlocks = 0;
+        double averageBlockMs = 0.0;
+        double maxBlockMs = 0.0;
+        //blocks that took longer to make than they take to play
+        int numOverruns = 0;
+        double audioSeconds = 0.0;
+        double wallSeconds = 0.0;
+
+        String toString() const;
+    };
+
+    ControlSession();
+    ~ControlSession() override;
+
+    /** starts a new session file; events are appended to it from now on */
+    bool startRecording(const File& file);
+    /** writes out what is left and closes the file */
+    void stopRecording();
+    bool isRecording() const;
+
+    /** called by the players for every control call */
+    void record(int deck, EventType type, double value, const String& path = {});
+    /** called for a controller move on the MIDI thread (or any other); lock-free for the message thread,
+        timeMs is Time::getMillisecondCounterHiRes() when the move was made */
+    void recordControl(int deck, EventType type, double value, double timeMs);
+
+    /** called when the audio device starts, from whichever thread starts it */
+    void deviceStarted(double sampleRate);
+    /** called on the audio thread after each block, with the time it took to make */
+    void audioBlockRendered(int numSamples, double processingMs);
+
+    /** replays a session on the players (deck 0 and 1) at the recorded times */
+    bool startReplay(const File& file, DJAudioPlayer& leftPlayer, DJAudioPlayer& rightPlayer);
+    void stopReplay();
+    bool isReplaying() const;
+
+    /** renders a session offline with new players, writing the mix to outputFile unless it is File() */
+    static Metrics renderOffline(const File& sessionFile, AudioFormatManager& formatManager,
+                                 int blockSize, const File& outputFile);
+
+    /** reads a session file in time order; lines cut short by a crash are skipped */
+    static bool load(const File& file, std::vector<Event>& events);
+
+    /** makes the recorded call on a player */
+    static void apply(const Event& event, DJAudioPlayer& player);
+
+    /** writes the metrics next to the session, with the build version, and logs them */
+    static void writeReport(const File& sessionFile, const String& mode, const Metrics& metrics);
+
+    /** where sessions are kept; the oldest go once there are more than maxSessions */
+    static File getSessionsFolder();
+    static void deleteOldSessions(int maxSessions);
+
+private:
+    void timerCallback() override;
+    void flush();
+    /** applies the events that are due; stops the replay after the last one */
+    void replayDueEvents();
+    void finishReplay();
+
+    static String getTypeName(EventType type);
+    static String formatLine(double timeMs, int64 samplePosition, int deck, EventType type,
+                             double value, const String& path);
+    static bool parseTypeName(const String& name, EventType& type);
+
+    //recording
+    std::unique_ptr<FileOutputStream> output;
+    //lines waiting for the next flush; record() may be called while the device starts
+    String pendingLines;
+    CriticalSection pendingLock;
+    std::atomic<bool> recording{ false };
+    double startMs = 0.0;
+    double lastFlushMs = 0.0;
+
+    //controller moves waiting for the next flush
+    struct ControlRecord
+    {
+        double timeMs;
+        int64 samplePosition;
+        int deck;
+        EventType type;
+        double value;
+    };
+    static constexpr int controlQueueSize = 4096;
+    AbstractFifo controlFifo{ controlQueueSize };
+    ControlRecord controlQueue[controlQueueSize];
+    //the MIDI inputs can call back on different threads; the message thread never takes it
+    SpinLock controlWriterLock;
+    std::atomic<int> numControlsDropped{ 0 };
+
+    //replay
+    File replayFile;
+    std::vector<Event> replayEvents;
+    size_t nextReplayEvent = 0;
+    double replayStartMs = 0.0;
+    DJAudioPlayer* replayPlayers[2] = { nullptr, nullptr };
+    double totalLatenessMs = 0.0;
+    double maxLatenessMs = 0.0;
+
+    //the audio stream's clock, and block timings while replaying
+    std::atomic<int64> samplesRendered{ 0 };
+    std::atomic<double> sampleRate{ 44100.0 };
+    std::atomic<bool> measuringBlocks{ false };
+    std::atomic<int> numBlocks{ 0 };
+    std::atomic<int> numOverruns{ 0 };
+    std::atomic<int64> totalBlockMicros{ 0 };
+    std::atomic<int64> maxBlockMicros{ 0 };
+    std::atomic<int64> measuredSamples{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ControlSession)
+};
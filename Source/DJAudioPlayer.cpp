@@ -26,11 +26,208 @@ void DJAudioPlayer::prepareToPlay (int samplesPerBlockExpected, double sampleRat
 {
     transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
     resampleSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    blockSize = samplesPerBlockExpected;
+    maxSpeedRatio = speedRatio.load();
+    deviceSampleRate = sampleRate;
+
+    //made again for the new rate on the next block
+    for (int band = 0; band < numEqBands; ++band){
+        appliedEqDb[band] = 0.0f;
+        eqFilters[band][0].reset();
+        eqFilters[band][1].reset();
+    }
 }
 void DJAudioPlayer::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
 {
-    resampleSource.getNextAudioBlock(bufferToFill);
+    //the first sample of this block is heard one output latency from now
+    PlayheadSnapshot snapshot;
+    snapshot.positionInSeconds = transportSource.getCurrentPosition();
+    snapshot.lengthInSeconds = transportSource.getLengthInSeconds();
+    snapshot.rate = transportSource.isPlaying() ? speedRatio.load() : 0.0;
+    const double nowMs = Time::getMillisecondCounterHiRes();
+    snapshot.timeStampMs = nowMs + outputLatency.load() * 1000.0;
+    publishPlayhead(snapshot);
+
+    //controller moves made during the last block period are applied at the matching sample of this one,
+    //so they keep their spacing instead of all landing on block edges (at the cost of one block of latency)
+    const int numSamples = bufferToFill.numSamples;
+    const double blockMs = numSamples * 1000.0 / deviceSampleRate.load();
+    int done = 0;
+    int start1, size1, start2, size2;
+    controlFifo.prepareToRead(controlFifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1 + size2; ++i){
+        const ControlChange& change = controlQueue[i < size1 ? start1 + i : start2 + i - size1];
+        const int offset = jlimit(done, numSamples, roundToInt((change.timeMs - (nowMs - blockMs)) / blockMs * numSamples));
+        if (offset > done){
+            renderSegment(bufferToFill, done, offset - done);
+            done = offset;
+        }
+        applyControl(change);
+    }
+    controlFifo.finishedRead(size1 + size2);
+    if (done < numSamples){
+        renderSegment(bufferToFill, done, numSamples - done);
+    }
+
+    //the jog bend halves every 60 ms
+    if (jogBend != 0.0){
+        jogBend *= std::pow(0.5, blockMs / 60.0);
+        jogBend = std::abs(jogBend) < 0.0001 ? 0.0 : jogBend;
+    }
+}
+
+void DJAudioPlayer::renderSegment(const AudioSourceChannelInfo& bufferToFill, int start, int numSamples)
+{
+    const double ratio = speedRatio.load() * (1.0 + jogBend);
+    if (ratio != resampleSource.getResamplingRatio()){
+        resampleSource.setResamplingRatio(ratio);
+    }
+
+    AudioSourceChannelInfo segment(bufferToFill.buffer, bufferToFill.startSample + start, numSamples);
+    resampleSource.getNextAudioBlock(segment);
+    processEq(*segment.buffer, segment.startSample, numSamples);
+
+    //the stem is captured before the fader, so the recording is independent of the mix
+    if (recorder != nullptr){
+        recorder->pushBlock(recorderStream, *segment.buffer, segment.startSample, numSamples);
+    }
+
+    //ramp between segments to avoid zipper noise when the fader moves
+    const float newGain = gain.load();
+    segment.buffer->applyGainRamp(segment.startSample, numSamples, lastGain, newGain);
+    lastGain = newGain;
+}
+
+void DJAudioPlayer::applyControl(const ControlChange& change)
+{
+    switch (change.type){
+        case ControlChange::gainChange:
+            gain = static_cast<float>(jlimit(0.0, 1.0, change.value));
+            break;
+        case ControlChange::speedChange:
+            speedRatio = jlimit(0.0, 2.0, change.value);
+            maxSpeedRatio = jmax(maxSpeedRatio.load(), speedRatio.load());
+            break;
+        case ControlChange::eqLowChange:
+            eqGainDb[eqLow] = static_cast<float>(change.value);
+            break;
+        case ControlChange::eqMidChange:
+            eqGainDb[eqMid] = static_cast<float>(change.value);
+            break;
+        case ControlChange::eqHighChange:
+            eqGainDb[eqHigh] = static_cast<float>(change.value);
+            break;
+        case ControlChange::jogChange:
+            if (transportSource.isPlaying()){
+                jogBend = jlimit(-0.5, 0.5, jogBend + change.value * 0.01);
+            }
+            else{
+                transportSource.setPosition(jmax(0.0, transportSource.getCurrentPosition() + change.value * 0.01));
+            }
+            break;
+        case ControlChange::cueChange:
+            if (transportSource.isPlaying()){
+                transportSource.setPosition(cuePoint.load());
+            }
+            else{
+                cuePoint = transportSource.getCurrentPosition();
+            }
+            break;
+    }
+}
 
+void DJAudioPlayer::processEq(AudioBuffer<float>& buffer, int start, int numSamples)
+{
+    const double rate = deviceSampleRate.load();
+    bool flat = true;
+    for (int band = 0; band < numEqBands; ++band){
+        const float gainDb = eqGainDb[band].load();
+        flat = flat && gainDb == 0.0f;
+        if (gainDb == appliedEqDb[band]){
+            continue;
+        }
+        if (appliedEqDb[band] == 0.0f){
+            //the band was skipped, its history is stale
+            eqFilters[band][0].reset();
+            eqFilters[band][1].reset();
+        }
+        appliedEqDb[band] = gainDb;
+        const double bandGain = Decibels::decibelsToGain(static_cast<double>(gainDb), -100.0);
+        const IIRCoefficients coefficients = band == eqLow ? IIRCoefficients::makeLowShelf(rate, 250.0, 0.7, bandGain)
+                                           : band == eqMid ? IIRCoefficients::makePeakFilter(rate, 1000.0, 0.7, bandGain)
+                                                           : IIRCoefficients::makeHighShelf(rate, 4000.0, 0.7, bandGain);
+        eqFilters[band][0].setCoefficients(coefficients);
+        eqFilters[band][1].setCoefficients(coefficients);
+    }
+    if (flat){
+        return;
+    }
+
+    for (int band = 0; band < numEqBands; ++band){
+        if (appliedEqDb[band] == 0.0f){
+            continue;
+        }
+        for (int channel = 0; channel < jmin(2, buffer.getNumChannels()); ++channel){
+            eqFilters[band][channel].processSamples(buffer.getWritePointer(channel, start), numSamples);
+        }
+    }
+}
+
+bool DJAudioPlayer::pushControl(const ControlChange& change)
+{
+    //recorded even if the queue is full, the move was still made
+    if (controlSession != nullptr){
+        const ControlSession::EventType type = change.type == ControlChange::gainChange ? ControlSession::gainEvent
+                                             : change.type == ControlChange::speedChange ? ControlSession::speedEvent
+                                             : change.type == ControlChange::eqLowChange ? ControlSession::eqLowEvent
+                                             : change.type == ControlChange::eqMidChange ? ControlSession::eqMidEvent
+                                             : change.type == ControlChange::eqHighChange ? ControlSession::eqHighEvent
+                                             : change.type == ControlChange::jogChange ? ControlSession::jogEvent
+                                                                                       : ControlSession::cueEvent;
+        controlSession->recordControl(controlDeck, type, change.value,
+                                      change.timeMs > 0.0 ? change.timeMs : Time::getMillisecondCounterHiRes());
+    }
+
+    const SpinLock::ScopedLockType sl(controlWriterLock);
+    int start1, size1, start2, size2;
+    controlFifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 + size2 == 0){
+        return false;
+    }
+    controlQueue[size1 > 0 ? start1 : start2] = change;
+    controlFifo.finishedWrite(1);
+    return true;
+}
+
+void DJAudioPlayer::setEqGain(int band, double gainDb)
+{
+    if (band < 0 || band >= numEqBands){
+        std::cout << "DJAudioPlayer::setEqGain band should be between 0 and 2" << std::endl;
+    }
+    else {
+        eqGainDb[band] = static_cast<float>(jlimit(-40.0, 6.0, gainDb));
+        record(static_cast<ControlSession::EventType>(ControlSession::eqLowEvent + band), gainDb);
+    }
+}
+
+double DJAudioPlayer::getEqGain(int band) const
+{
+    return band >= 0 && band < numEqBands ? eqGainDb[band].load() : 0.0;
+}
+
+double DJAudioPlayer::getGain() const
+{
+    return gain.load();
+}
+
+double DJAudioPlayer::getSpeed() const
+{
+    return speedRatio.load();
+}
+
+double DJAudioPlayer::getCuePoint() const
+{
+    return cuePoint.load();
 }
 void DJAudioPlayer::releaseResources()
 {
@@ -38,8 +235,18 @@ void DJAudioPlayer::releaseResources()
     resampleSource.releaseResources();
 }
 
+size_t DJAudioPlayer::getMemoryUsage() const
+{
+    //the resampler reads ratio x block size (plus a few samples of history) for each output block;
+    //the transport has no read-ahead buffer and the reader only keeps its decoder state
+    const size_t samples = static_cast<size_t>(blockSize.load() * maxSpeedRatio.load()) + 35;
+    return 2 * samples * sizeof(float) + sizeof(controlQueue);
+}
+
 void DJAudioPlayer::loadURL(URL audioURL)
 {
+    record(ControlSession::loadEvent, 0.0, audioURL.isLocalFile() ? audioURL.getLocalFile().getFullPathName()
+                                                                   : audioURL.toString(true));
     auto* reader = formatManager.createReaderFor(audioURL.createInputStream(false));
     if (reader != nullptr) // good file!
     {       
@@ -56,7 +263,8 @@ void DJAudioPlayer::setGain(double gain)
         std::cout << "DJAudioPlayer::setGain gain should be between 0 and 1" << std::endl;
     }
     else {
-        transportSource.setGain(gain);
+        this->gain = static_cast<float>(gain);
+        record(ControlSession::gainEvent, gain);
     }
    
 }
@@ -68,11 +276,15 @@ void DJAudioPlayer::setSpeed(double ratio)
     }
     else {
         resampleSource.setResamplingRatio(ratio);
+        speedRatio = ratio;
+        record(ControlSession::speedEvent, ratio);
+        maxSpeedRatio = jmax(maxSpeedRatio.load(), ratio);
     }
 }
 void DJAudioPlayer::setPosition(double posInSecs)
 {
     transportSource.setPosition(posInSecs);
+    record(ControlSession::positionEvent, posInSecs);
 }
 
 void DJAudioPlayer::setPositionRelative(double pos)
@@ -83,7 +295,9 @@ void DJAudioPlayer::setPositionRelative(double pos)
     }
     else {
         double posInSecs = transportSource.getLengthInSeconds() * pos;
-        setPosition(posInSecs);
+        //recorded as a relative seek, not as setPosition, so a replay with another file length still lands right
+        transportSource.setPosition(posInSecs);
+        record(ControlSession::positionRelativeEvent, pos);
     }
 }
 
@@ -91,11 +305,13 @@ void DJAudioPlayer::start()
 {
     transportSource.start();
     isPlaying = true;
+    record(ControlSession::playEvent, 0.0);
 }
 void DJAudioPlayer::pause()
 {
     transportSource.stop();
     isPlaying = false;
+    record(ControlSession::pauseEvent, 0.0);
 }
 
 void DJAudioPlayer::reset()
@@ -103,11 +319,13 @@ void DJAudioPlayer::reset()
     transportSource.stop();
     transportSource.setPosition(0.0);
     isPlaying = false;
+    record(ControlSession::resetEvent, 0.0);
 }
 
 void DJAudioPlayer::loop(bool toLoop)
 {
     isLooping = toLoop;
+    record(ControlSession::loopEvent, toLoop ? 1.0 : 0.0);
 }
 
 void DJAudioPlayer::timerCallback()
@@ -123,12 +341,85 @@ double DJAudioPlayer::getLengthInSeconds()
     return transportSource.getLengthInSeconds();
 }
 
-double DJAudioPlayer::getPositionRelative()
+DJAudioPlayer::PlayheadSnapshot DJAudioPlayer::getPlayheadSnapshot() const
+{
+    PlayheadSnapshot snapshot;
+    for (;;){
+        const uint32 before = snapshotSequence.load(std::memory_order_acquire);
+        if ((before & 1) == 0){
+            snapshot.positionInSeconds = snapshotPosition.load(std::memory_order_relaxed);
+            snapshot.lengthInSeconds = snapshotLength.load(std::memory_order_relaxed);
+            snapshot.rate = snapshotRate.load(std::memory_order_relaxed);
+            snapshot.timeStampMs = snapshotTimeStamp.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (snapshotSequence.load(std::memory_order_relaxed) == before){
+                return snapshot;
+            }
+        }
+    }
+}
+
+void DJAudioPlayer::publishPlayhead(const PlayheadSnapshot& snapshot)
+{
+    //only ever called from the audio thread, so there is a single writer
+    const uint32 sequence = snapshotSequence.load(std::memory_order_relaxed);
+    snapshotSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    snapshotPosition.store(snapshot.positionInSeconds, std::memory_order_relaxed);
+    snapshotLength.store(snapshot.lengthInSeconds, std::memory_order_relaxed);
+    snapshotRate.store(snapshot.rate, std::memory_order_relaxed);
+    snapshotTimeStamp.store(snapshot.timeStampMs, std::memory_order_relaxed);
+
+    snapshotSequence.store(sequence + 2, std::memory_order_release);
+}
+
+double DJAudioPlayer::getPositionInSeconds() const
+{
+    const PlayheadSnapshot snapshot = getPlayheadSnapshot();
+
+    //move on from the snapshot at the playback rate, so the display is smooth between blocks
+    const double elapsed = (Time::getMillisecondCounterHiRes() - snapshot.timeStampMs) / 1000.0;
+    const double position = snapshot.positionInSeconds + elapsed * snapshot.rate;
+    return jlimit(0.0, jmax(0.0, snapshot.lengthInSeconds), position);
+}
+
+double DJAudioPlayer::getPositionRelative() const
+{
+    const double length = getPlayheadSnapshot().lengthInSeconds;
+    if (length <= 0.0){
+        return 0.0; //nothing loaded
+    }
+    return getPositionInSeconds() / length;
+}
+
+void DJAudioPlayer::setOutputLatency(double seconds)
 {
-    return transportSource.getCurrentPosition() / transportSource.getLengthInSeconds();
+    outputLatency = seconds;
+}
+
+void DJAudioPlayer::setRecorder(MixRecorder* _recorder, int stream)
+{
+    recorder = _recorder;
+    recorderStream = stream;
+}
+
+void DJAudioPlayer::setControlSession(ControlSession* session, int deck)
+{
+    controlSession = session;
+    controlDeck = deck;
+}
+
+void DJAudioPlayer::record(ControlSession::EventType type, double value, const String& path)
+{
+    if (controlSession != nullptr){
+        controlSession->record(controlDeck, type, value, path);
+    }
 }
 
-bool DJAudioPlayer::reachedTheEnd()
+bool DJAudioPlayer::reachedTheEnd() const
 {
-    return transportSource.getCurrentPosition() >= transportSource.getLengthInSeconds() - 1.0;
+    const PlayheadSnapshot snapshot = getPlayheadSnapshot();
+    return snapshot.lengthInSeconds > 0.0 && snapshot.positionInSeconds >= snapshot.lengthInSeconds - 1.0;
 }
\ No newline at end of file
@@ -11,6 +11,9 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "MixRecorder.h"
+#include "ControlSession.h"
+#include <atomic>
 
 class DJAudioPlayer : public AudioSource,
                       public Timer
@@ -38,8 +41,74 @@ class DJAudioPlayer : public AudioSource,
     /**function for stopping the track and reset the position to starting point*/
     void reset();
 
-    /** get the relative position of the playhead */
-    double getPositionRelative();
+    /** a controller move for the audio thread, applied at the sample it was made (see getNextAudioBlock) */
+    struct ControlChange
+    {
+        enum Type
+        {
+            gainChange,
+            speedChange,
+            eqLowChange,
+            eqMidChange,
+            eqHighChange,
+            //value is signed jog ticks: bends the speed while playing, moves the playhead while paused
+            jogChange,
+            //sets the cue point while paused, jumps back to it while playing
+            cueChange
+        };
+
+        Type type = gainChange;
+        //gain 0..1, speed ratio, EQ gain in dB or jog ticks
+        double value = 0.0;
+        //Time::getMillisecondCounterHiRes() when the move was made
+        double timeMs = 0.0;
+    };
+
+    /** queues a change for the audio thread and records it in the control session; lock-free for the
+        audio thread (writers on different threads take turns); false if the queue is full */
+    bool pushControl(const ControlChange& change);
+
+    enum EqBand
+    {
+        eqLow,
+        eqMid,
+        eqHigh,
+        numEqBands
+    };
+
+    /** gain of an EQ band in dB (0 is flat, -40 kills the band); applied on the next block */
+    void setEqGain(int band, double gainDb);
+    double getEqGain(int band) const;
+
+    /** fader gain and speed ratio, also when they were set from a controller */
+    double getGain() const;
+    double getSpeed() const;
+
+    /** where the last cue press while paused left the cue point, in seconds */
+    double getCuePoint() const;
+
+    /** where the playhead was at the start of the last audio block, published by the audio thread */
+    struct PlayheadSnapshot
+    {
+        double positionInSeconds = 0.0;
+        double lengthInSeconds = 0.0;
+        //track seconds per second of real time, 0 when paused
+        double rate = 0.0;
+        //Time::getMillisecondCounterHiRes() at which positionInSeconds reaches the speakers
+        double timeStampMs = 0.0;
+    };
+
+    /** latest snapshot; lock-free, safe to call from any thread */
+    PlayheadSnapshot getPlayheadSnapshot() const;
+
+    /** get the relative position of the playhead (0 when nothing is loaded) */
+    double getPositionRelative() const;
+
+    /** get the playhead position in seconds, interpolated from the last snapshot to the current time */
+    double getPositionInSeconds() const;
+
+    /** output latency of the device (in seconds), used to time stamp the snapshots */
+    void setOutputLatency(double seconds);
 
     /**get the transport source length in seconds*/
     double getLengthInSeconds();
@@ -53,7 +122,16 @@ class DJAudioPlayer : public AudioSource,
     void timerCallback() override;
 
     /**helper function detecting if track has reched the end*/
-    bool reachedTheEnd();
+    bool reachedTheEnd() const;
+
+    /** sends the deck's pre-fader signal to the recorder as the given stem */
+    void setRecorder(MixRecorder* recorder, int stream);
+
+    /** records the control calls made on this player into the session as the given deck */
+    void setControlSession(ControlSession* session, int deck);
+
+    /** estimated bytes of the playback buffers (the resampler's input block) */
+    size_t getMemoryUsage() const;
 
     //helper variable for implementing changes in the playbutton
     bool isPlaying;
@@ -69,6 +147,57 @@ private:
     //helper variable for implementing the loop function
     bool isLooping;
 
+    //fader gain, applied after the recorder tap (see renderSegment)
+    std::atomic<float> gain{ 1.0f };
+    float lastGain = 1.0f;
+
+    MixRecorder* recorder = nullptr;
+    int recorderStream = 0;
+
+    ControlSession* controlSession = nullptr;
+    int controlDeck = 0;
+    void record(ControlSession::EventType type, double value, const String& path = {});
+
+    void publishPlayhead(const PlayheadSnapshot& snapshot);
+
+    /** audio thread: makes part of a block (resampler, EQ, recorder tap, fader) */
+    void renderSegment(const AudioSourceChannelInfo& bufferToFill, int start, int numSamples);
+    /** audio thread: applies a queued controller move */
+    void applyControl(const ControlChange& change);
+    /** audio thread: runs the EQ over part of the block, making new coefficients if a band changed */
+    void processEq(AudioBuffer<float>& buffer, int start, int numSamples);
+
+    //controller moves from the MIDI thread to the audio thread
+    static constexpr int controlQueueSize = 256;
+    AbstractFifo controlFifo{ controlQueueSize };
+    ControlChange controlQueue[controlQueueSize];
+    //the MIDI inputs and a session replay can push from different threads; the audio thread never takes it
+    SpinLock controlWriterLock;
+
+    //jog bend on top of the speed ratio, dies away after the jog wheel stops
+    double jogBend = 0.0;
+    std::atomic<double> cuePoint{ 0.0 };
+
+    //3 band EQ (low shelf, peak, high shelf) per channel; bands at 0 dB are skipped
+    std::atomic<float> eqGainDb[numEqBands]{};
+    //audio thread: the gains the filters were last made for
+    float appliedEqDb[numEqBands] = { 0.0f, 0.0f, 0.0f };
+    IIRFilter eqFilters[numEqBands][2];
+    std::atomic<double> deviceSampleRate{ 44100.0 };
+
+    //seqlock: odd while the audio thread is writing, readers retry until they get a stable copy
+    std::atomic<uint32> snapshotSequence{ 0 };
+    std::atomic<double> snapshotPosition{ 0.0 };
+    std::atomic<double> snapshotLength{ 0.0 };
+    std::atomic<double> snapshotRate{ 0.0 };
+    std::atomic<double> snapshotTimeStamp{ 0.0 };
+
+    std::atomic<double> speedRatio{ 1.0 };
+    //largest ratio since the last prepareToPlay, the resampler's buffer only ever grows to it
+    std::atomic<double> maxSpeedRatio{ 1.0 };
+    std::atomic<int> blockSize{ 0 };
+    std::atomic<double> outputLatency{ 0.0 };
+
 };
 
 
@@ -10,16 +10,18 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "DeckGUI.h"
+#include "PaintProfiler.h"
 
 //==============================================================================
 DeckGUI::DeckGUI(DJAudioPlayer* _player,
-                AudioFormatManager& formatManagerToUse,
-                AudioThumbnailCache& cacheToUse,
+                WaveformCache& cacheToUse,
+                WaveformTileRenderer& tileRendererToUse,
                 bool differentSkin
                 ) : 
                 player(_player),
-                waveformDisplay1(formatManagerToUse, cacheToUse, false),
-                waveformDisplay2(formatManagerToUse, cacheToUse, true),
+                waveformDisplay1(cacheToUse, tileRendererToUse, false),
+                waveformDisplay2(cacheToUse, tileRendererToUse, true),
+                zoomedDisplay(cacheToUse, _player, differentSkin),
                 isLooping(false)
 {
     //add various components and make them visible
@@ -43,6 +45,7 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player,
         waveformDisplay = &waveformDisplay1;
     }
     addAndMakeVisible(waveformDisplay);
+    addAndMakeVisible(zoomedDisplay);
    
     //add listeners for buttons and sliders
     playButton.addListener(this);
@@ -84,80 +87,32 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player,
     // to use inside resized()/paint() functions; they do not have access to differentSkin
     differentLayout = differentSkin;
 
-    //start timer with interval length of 500 milliseconds
-    startTimer(500);
+    //colours and look and feel are set once here; setting them in paint() triggered more repaints
+    setupColours();
+
+    //the playhead is read lock-free from the player, so it can follow at display rate
+    startTimerHz(60);
 
 }
 
 DeckGUI::~DeckGUI()
 {
     stopTimer(); //stop timer callbacks after deckGUI gets destroyed
+
+    playButton.setLookAndFeel(nullptr);
+    resetButton.setLookAndFeel(nullptr);
+    loadButton.setLookAndFeel(nullptr);
+    loopButton.setLookAndFeel(nullptr);
 }
 
 void DeckGUI::paint(Graphics& g)
 {
+    PaintProfiler::ScopedPaint profile(g, differentLayout ? "DeckGUI (right)" : "DeckGUI (left)");
+
     g.fillAll(Colour(22, 22, 22));//background colour
 
     g.setColour(Colour(0, 245, 245)); //outline colour
     g.drawRect(getLocalBounds(), 1); //draw an outline around the component
-
-    //volSlider customisations
-    volSlider.setColour(Slider::backgroundColourId, Colour(32, 32, 32));
-    // I did not find a way to change this colour with LookAndFeel between the two DeckGUIs
-    // so I did it manually by using the differentSkin parameter in DeckGUI object
-    if (!differentLayout) {
-        volSlider.setColour(Slider::trackColourId, Colour(0, 255, 127));
-    }
-    else {
-        volSlider.setColour(Slider::trackColourId, Colour(255, 20, 147));
-    }
-
-    //speedSlider customisations
-    // same customisation logic as with vol slider:
-    if (!differentLayout) {
-        speedSlider.setColour(Slider::rotarySliderFillColourId, Colour(0, 255, 127));
-        speedSlider.setColour(Slider::rotarySliderOutlineColourId, Colour(229, 204, 255));
-    }
-    else {
-        speedSlider.setColour(Slider::rotarySliderFillColourId, Colour(255, 20, 147));
-    }
-
-    //customisation for pos slider
-    if (!differentLayout) {
-        posSlider.setColour(Slider::trackColourId, Colour(100, 255, 178));
-        posSlider.setColour(Slider::backgroundColourId, Colour(229, 204, 255));
-    }
-
-    //customisation for buttons:
- 
-    playButton.setColour(TextButton::buttonColourId, Colour(27, 255, 255));
-    if (player->isPlaying) {
-        playButton.setColour(TextButton::buttonColourId, Colour(255, 255, 102));
-    }
-   
-    resetButton.setColour(TextButton::buttonColourId, Colour(226, 107, 255));
-    
-    loadButton.setColour(TextButton::buttonColourId, Colour(64, 64, 64));
-    loadButton.setColour(TextButton::textColourOffId, Colours::white);
-
-    // when loopButton is off:
-    loopButton.setColour(TextButton::buttonColourId, Colour(64, 64, 64));
-    loopButton.setColour(TextButton::textColourOffId, Colours::white);
-    // when loopButton is on:
-    if (!differentLayout) {
-        loopButton.setColour(TextButton::buttonOnColourId, Colour(0, 255, 127)); //Left DeckDUI
-    }
-    else {
-        loopButton.setColour(TextButton::buttonOnColourId, Colour(255, 20, 147)); //Right DeckGUI
-    }
-    loopButton.setColour(TextButton::textColourOnId, Colours::black);
-    
-    //adding lookAndFeel_V2 style on buttons
-    playButton.setLookAndFeel(&lookAndFeel);
-    resetButton.setLookAndFeel(&lookAndFeel);
-    loadButton.setLookAndFeel(&lookAndFeel);
-    loopButton.setLookAndFeel(&lookAndFeel);
-
 }
 
 void DeckGUI::resized()
@@ -179,12 +134,14 @@ void DeckGUI::resized()
         speedSlider.setBounds(widthR * 0.1/4, rowH * 5.5, widthR/5, rowH * 2.8);  
         loopButton.setBounds(widthR * 0.26 / 4, rowH * 4.2, widthR / 8, rowH);
         loadButton.setBounds(widthR * 0.26/4, rowH * 8.5, widthR/8, rowH);
+        zoomedDisplay.setBounds(widthR * 0.3, rowH * 4.2, widthR * 0.53, rowH * 4);
     }
     else{
         volSlider.setBounds(widthR* 1.5/20, rowH * 4.5, widthR/20, rowH * 5);
         speedSlider.setBounds(widthR - (widthR/5 + widthR * 0.2/4), rowH * 5.5, widthR/5, rowH * 2.8);
         loopButton.setBounds(widthR - (widthR / 8 + widthR * 0.37 / 4), rowH * 4.2, widthR / 8, rowH);
         loadButton.setBounds(widthR - (widthR/8 + widthR * 0.37/4), rowH * 8.5, widthR/8, rowH);
+        zoomedDisplay.setBounds(widthR * 0.17, rowH * 4.2, widthR * 0.53, rowH * 4);
     }
 }
 
@@ -193,16 +150,15 @@ void DeckGUI::buttonClicked(Button* button)
     if (button == &playButton) {
         if (player->isPlaying) {
             player->pause();
-            playButton.setButtonText("PLAY");
         }
         else {
             player->start();
-            playButton.setButtonText("PAUSE");
         }
+        updatePlayButton();
     }
     if (button == &resetButton) {
         player->reset();
-        playButton.setButtonText("PLAY");
+        updatePlayButton();
     }
     if (button == &loopButton) {
         if (loopButton.getToggleState()) {
@@ -221,6 +177,7 @@ void DeckGUI::buttonClicked(Button* button)
             url = URL{ chooser.getResult() };
             player->loadURL(url);
             waveformDisplay->loadURL(url);
+            zoomedDisplay.loadURL(url);
             trackTitleLabel.setText(trackTitle, sendNotification);// add track title in the label
         }
     }
@@ -260,6 +217,7 @@ void DeckGUI::loadTrack(URL audioURL, String trackTitle)
     url = audioURL;
     player->loadURL(url);
     waveformDisplay->loadURL(url);
+    zoomedDisplay.loadURL(url);
     trackTitleLabel.setText(trackTitle, sendNotification); // also add track title in label 
 }
 
@@ -269,12 +227,92 @@ void DeckGUI::timerCallback()
     
     waveformDisplay->setPositionRelative(relativePos);
 
-    if (!isnan(relativePos)) { //if track has loaded only
-        posSlider.setValue(relativePos);
+    //don't fight the user while they drag, and don't seek back to where we already are
+    if (!posSlider.isMouseButtonDown()){
+        posSlider.setValue(relativePos, dontSendNotification);
+    }
+
+    //a MIDI controller sets these on the player directly
+    if (!volSlider.isMouseButtonDown()){
+        volSlider.setValue(player->getGain(), dontSendNotification);
+    }
+    if (!speedSlider.isMouseButtonDown()){
+        speedSlider.setValue(player->getSpeed(), dontSendNotification);
     }
+    updatePlayButton();
 
     if (isLooping && player->reachedTheEnd()) {
         player->loadURL(url);
         player->start();
     }
 }
+
+void DeckGUI::setupColours()
+{
+    //volSlider customisations
+    volSlider.setColour(Slider::backgroundColourId, Colour(32, 32, 32));
+    // I did not find a way to change this colour with LookAndFeel between the two DeckGUIs
+    // so I did it manually by using the differentSkin parameter in DeckGUI object
+    if (!differentLayout) {
+        volSlider.setColour(Slider::trackColourId, Colour(0, 255, 127));
+    }
+    else {
+        volSlider.setColour(Slider::trackColourId, Colour(255, 20, 147));
+    }
+
+    //speedSlider customisations
+    // same customisation logic as with vol slider:
+    if (!differentLayout) {
+        speedSlider.setColour(Slider::rotarySliderFillColourId, Colour(0, 255, 127));
+        speedSlider.setColour(Slider::rotarySliderOutlineColourId, Colour(229, 204, 255));
+    }
+    else {
+        speedSlider.setColour(Slider::rotarySliderFillColourId, Colour(255, 20, 147));
+    }
+
+    //customisation for pos slider
+    if (!differentLayout) {
+        posSlider.setColour(Slider::trackColourId, Colour(100, 255, 178));
+        posSlider.setColour(Slider::backgroundColourId, Colour(229, 204, 255));
+    }
+
+    //customisation for buttons:
+ 
+    updatePlayButton();
+   
+    resetButton.setColour(TextButton::buttonColourId, Colour(226, 107, 255));
+    
+    loadButton.setColour(TextButton::buttonColourId, Colour(64, 64, 64));
+    loadButton.setColour(TextButton::textColourOffId, Colours::white);
+
+    // when loopButton is off:
+    loopButton.setColour(TextButton::buttonColourId, Colour(64, 64, 64));
+    loopButton.setColour(TextButton::textColourOffId, Colours::white);
+    // when loopButton is on:
+    if (!differentLayout) {
+        loopButton.setColour(TextButton::buttonOnColourId, Colour(0, 255, 127)); //Left DeckDUI
+    }
+    else {
+        loopButton.setColour(TextButton::buttonOnColourId, Colour(255, 20, 147)); //Right DeckGUI
+    }
+    loopButton.setColour(TextButton::textColourOnId, Colours::black);
+    
+    //adding lookAndFeel_V2 style on buttons
+    playButton.setLookAndFeel(&lookAndFeel);
+    resetButton.setLookAndFeel(&lookAndFeel);
+    loadButton.setLookAndFeel(&lookAndFeel);
+    loopButton.setLookAndFeel(&lookAndFeel);
+}
+
+void DeckGUI::updatePlayButton()
+{
+    //yellow while playing
+    if (player->isPlaying) {
+        playButton.setColour(TextButton::buttonColourId, Colour(255, 255, 102));
+        playButton.setButtonText("PAUSE");
+    }
+    else {
+        playButton.setColour(TextButton::buttonColourId, Colour(27, 255, 255));
+        playButton.setButtonText("PLAY");
+    }
+}
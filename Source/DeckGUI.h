@@ -13,6 +13,7 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "DJAudioPlayer.h"
 #include "WaveformDisplay.h"
+#include "ScrollingWaveformDisplay.h"
 
 //==============================================================================
 /*
@@ -25,8 +26,8 @@ class DeckGUI    : public Component,
 {
 public:
     DeckGUI(DJAudioPlayer* player, 
-            AudioFormatManager & 	formatManagerToUse,
-            AudioThumbnailCache & 	cacheToUse,
+            WaveformCache & 	cacheToUse,
+            WaveformTileRenderer & 	tileRendererToUse,
             bool differentSkin);
     ~DeckGUI();
 
@@ -48,6 +49,10 @@ public:
     void loadTrack(URL audioURL, String trackTitle);
 
 private:
+    /** slider and button colours, set once in the constructor */
+    void setupColours();
+    /** play button text and colour follow the player state */
+    void updatePlayButton();
 
     TextButton playButton{"PLAY"};
     TextButton resetButton{"RESET"};
@@ -62,6 +67,9 @@ private:
     WaveformDisplay waveformDisplay2;
     WaveformDisplay* waveformDisplay;
 
+    //zoomed view following the playhead
+    ScrollingWaveformDisplay zoomedDisplay;
+
     DJAudioPlayer* player;
 
     //label, displaying track title
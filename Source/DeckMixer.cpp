@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    DeckMixer.cpp
+    Created: 19 Oct 2026 1:22:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "DeckMixer.h"
+
+//==============================================================================
+/*
+    Renders one deck whenever the device callback hands it a block.
+*/
+class DeckMixer::Worker  : public Thread
+{
+public:
+    Worker(DeckMixer& _mixer, int _deckIndex)
+          : Thread("Deck " + String(_deckIndex) + " renderer"),
+            mixer(_mixer),
+            deckIndex(_deckIndex)
+    {
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        blockReady.signal();
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit()){
+            if (!blockReady.wait(100) || threadShouldExit()){
+                continue;
+            }
+            //the callback may have taken the deck already, if this thread woke too late
+            if (!mixer.decks[deckIndex]->claimed.exchange(true)){
+                mixer.renderDeck(deckIndex, mixer.numSamplesToRender.load());
+                if (mixer.decksRemaining.fetch_sub(1) == 1){
+                    mixer.decksDone.signal();
+                }
+            }
+        }
+    }
+
+    WaitableEvent blockReady;
+
+private:
+    DeckMixer& mixer;
+    int deckIndex;
+};
+
+//==============================================================================
+DeckMixer::DeckMixer()
+{
+}
+
+DeckMixer::~DeckMixer()
+{
+    stopWorkers();
+}
+
+void DeckMixer::addDeck(AudioSource* source, PluginChain* chain)
+{
+    auto* deck = decks.add(new Deck());
+    deck->source = source;
+    deck->chain = chain;
+}
+
+void DeckMixer::setMasterChain(PluginChain* chain)
+{
+    masterChain = chain;
+}
+
+void DeckMixer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    stopWorkers();
+
+    //a second of compensation, plus room for a block; bigger device blocks are mixed in pieces of this size
+    maxBlockSize = jmax(1, samplesPerBlockExpected);
+    maxDelaySamples = static_cast<int>(sampleRate);
+    currentSampleRate = sampleRate;
+    for (auto* deck : decks){
+        deck->source->prepareToPlay(samplesPerBlockExpected, sampleRate);
+        if (deck->chain != nullptr){
+            deck->chain->prepareToPlay(sampleRate, samplesPerBlockExpected);
+        }
+        deck->buffer.setSize(2, maxBlockSize);
+        deck->delayLine.setSize(2, maxDelaySamples + 2 * maxBlockSize);
+        deck->delayLine.clear();
+        deck->delayWritePosition = 0;
+    }
+    if (masterChain != nullptr){
+        masterChain->prepareToPlay(sampleRate, samplesPerBlockExpected);
+    }
+
+    for (int i = 1; i < decks.size(); ++i){
+        workers.add(new Worker(*this, i))->startThread(10);
+    }
+}
+
+void DeckMixer::releaseResources()
+{
+    stopWorkers();
+    for (auto* deck : decks){
+        deck->source->releaseResources();
+        if (deck->chain != nullptr){
+            deck->chain->releaseResources();
+        }
+    }
+    if (masterChain != nullptr){
+        masterChain->releaseResources();
+    }
+}
+
+void DeckMixer::stopWorkers()
+{
+    workers.clear();
+}
+
+void DeckMixer::getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill)
+{
+    bufferToFill.clearActiveBufferRegion();
+    if (maxBlockSize <= 0){
+        return;
+    }
+
+    //the device may hand over a bigger block than it said it would; resizing here could allocate
+    for (int done = 0; done < bufferToFill.numSamples;){
+        const int numSamples = jmin(maxBlockSize, bufferToFill.numSamples - done);
+        mixBlock(*bufferToFill.buffer, bufferToFill.startSample + done, numSamples);
+        done += numSamples;
+    }
+}
+
+void DeckMixer::mixBlock(AudioBuffer<float>& output, int startSample, int numSamples)
+{
+    bool anyPlugins = false;
+    for (auto* deck : decks){
+        anyPlugins = anyPlugins || (deck->chain != nullptr && !deck->chain->isEmpty());
+    }
+
+    if (anyPlugins && workers.size() > 0){
+        renderOnWorkers(numSamples);
+    }
+    else{
+        for (int i = 0; i < decks.size(); ++i){
+            renderDeck(i, numSamples);
+        }
+    }
+
+    int maxLatency = 0;
+    for (auto* deck : decks){
+        maxLatency = jmax(maxLatency, getDeckChainLatency(*deck));
+    }
+
+    for (auto* deck : decks){
+        delayDeck(*deck, numSamples, maxLatency - getDeckChainLatency(*deck));
+        for (int channel = 0; channel < jmin(2, output.getNumChannels()); ++channel){
+            output.addFrom(channel, startSample, deck->buffer, channel, 0, numSamples);
+        }
+    }
+
+    if (masterChain != nullptr){
+        masterChain->process(output, startSample, numSamples);
+    }
+}
+
+void DeckMixer::renderOnWorkers(int numSamples)
+{
+    const int64 startTicks = Time::getHighResolutionTicks();
+    const int64 deadlineTicks = startTicks + static_cast<int64>(0.5 * numSamples / currentSampleRate
+                                                                * Time::getHighResolutionTicksPerSecond());
+
+    //the block is set up before the decks are released, so a worker that claims one sees it
+    numSamplesToRender = numSamples;
+    decksRemaining = workers.size();
+    //a signal left over from a block the spin already saw finish
+    decksDone.reset();
+    for (int i = 1; i < decks.size(); ++i){
+        decks[i]->claimed = false;
+    }
+    for (auto* worker : workers){
+        worker->blockReady.signal();
+    }
+    renderDeck(0, numSamples);
+
+    //spin rather than sleep: a sleep can last longer than the whole block
+    while (decksRemaining.load() > 0 && Time::getHighResolutionTicks() < deadlineTicks){
+        Thread::yield();
+    }
+    if (decksRemaining.load() == 0){
+        return;
+    }
+
+    //a worker that hasn't started by now may not get to run at all, so its deck is done here
+    for (int i = 1; i < decks.size(); ++i){
+        if (!decks[i]->claimed.exchange(true)){
+            renderDeck(i, numSamples);
+            decksRemaining.fetch_sub(1);
+        }
+    }
+    //the rest are being rendered; waiting rather than spinning lets a worker below the callback's
+    //priority finish them, and the timeout only guards against missing the signal
+    const int blockMs = jmax(1, roundToInt(1000.0 * numSamples / currentSampleRate));
+    while (decksRemaining.load() > 0){
+        decksDone.wait(blockMs);
+    }
+}
+
+void DeckMixer::renderDeck(int index, int numSamples)
+{
+    Deck& deck = *decks[index];
+    AudioSourceChannelInfo info(&deck.buffer, 0, numSamples);
+    deck.source->getNextAudioBlock(info);
+    if (deck.chain != nullptr){
+        deck.chain->process(deck.buffer, 0, numSamples);
+    }
+}
+
+void DeckMixer::delayDeck(Deck& deck, int numSamples, int delaySamples)
+{
+    const int size = deck.delayLine.getNumSamples();
+    delaySamples = jlimit(0, maxDelaySamples, delaySamples);
+    if (numSamples + delaySamples > size){
+        return;
+    }
+
+    //the block is always written, so the history is there when a chain's latency changes
+    const int readPosition = (deck.delayWritePosition - delaySamples + size) % size;
+    for (int channel = 0; channel < 2; ++channel){
+        int position = deck.delayWritePosition;
+        for (int done = 0; done < numSamples;){
+            const int chunk = jmin(numSamples - done, size - position);
+            deck.delayLine.copyFrom(channel, position, deck.buffer, channel, done, chunk);
+            position = (position + chunk) % size;
+            done += chunk;
+        }
+        if (delaySamples == 0){
+            continue;
+        }
+        position = readPosition;
+        for (int done = 0; done < numSamples;){
+            const int chunk = jmin(numSamples - done, size - position);
+            deck.buffer.copyFrom(channel, done, deck.delayLine, channel, position, chunk);
+            position = (position + chunk) % size;
+            done += chunk;
+        }
+    }
+    deck.delayWritePosition = (deck.delayWritePosition + numSamples) % size;
+}
+
+int DeckMixer::getDeckChainLatency(const Deck& deck) const
+{
+    return deck.chain != nullptr ? deck.chain->getLatencySamples() : 0;
+}
+
+int DeckMixer::getLatencySamples() const
+{
+    int maxLatency = 0;
+    for (auto* deck : decks){
+        maxLatency = jmax(maxLatency, getDeckChainLatency(*deck));
+    }
+    return maxLatency + (masterChain != nullptr ? masterChain->getLatencySamples() : 0);
+}
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    DeckMixer.h
+    Created: 19 Oct 2026 1:22:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PluginChain.h"
+#include <atomic>
+
+//==============================================================================
+/*
+    Mixes the decks (in place of a MixerAudioSource), each through its own
+    PluginChain, then runs the mix through the master chain.
+    While any deck has plugins, every deck after the first is rendered on its
+    own worker thread (at the highest thread priority) while the device
+    callback renders the first one, and the callback spins until they are
+    done. The spin lasts half a block at most: a deck whose worker hasn't
+    picked it up by then (a real-time callback thread can starve it) is
+    rendered on the callback instead, and a deck a late worker has already
+    started is waited for on an event its worker signals.
+    With no plugins a deck costs less than waking a thread, so they are
+    rendered in turn on the callback.
+    The deck buffers are sized in prepareToPlay and a bigger device block is
+    mixed in pieces of that size, so the callback never allocates.
+    Each deck is delayed by the difference between its chain's latency and
+    the slowest deck chain's, so decks played in sync stay in sync whatever
+    plugins they have (up to a second of difference).
+*/
+class DeckMixer  : public AudioSource
+{
+public:
+    DeckMixer();
+    ~DeckMixer() override;
+
+    /** adds a deck, before the device starts; chain may be nullptr */
+    void addDeck(AudioSource* source, PluginChain* chain);
+    /** the chain the mix goes through, may be nullptr */
+    void setMasterChain(PluginChain* chain);
+
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+    /** latency of the slowest deck chain plus the master chain, in samples */
+    int getLatencySamples() const;
+
+private:
+    class Worker;
+
+    struct Deck
+    {
+        AudioSource* source = nullptr;
+        PluginChain* chain = nullptr;
+        AudioBuffer<float> buffer;
+        //taken by whichever of the worker and the callback renders this block; set while idle
+        std::atomic<bool> claimed{ true };
+        //lines the deck up with the slowest chain
+        AudioBuffer<float> delayLine;
+        int delayWritePosition = 0;
+    };
+
+    /** renders a deck and runs it through its chain; called on the callback or a worker */
+    void renderDeck(int index, int numSamples);
+    /** mixes one piece of a device block, no longer than maxBlockSize */
+    void mixBlock(AudioBuffer<float>& output, int startSample, int numSamples);
+    /** renders the worker decks in parallel, or on the callback if their worker is late */
+    void renderOnWorkers(int numSamples);
+    /** delays a rendered deck by delaySamples */
+    void delayDeck(Deck& deck, int numSamples, int delaySamples);
+    int getDeckChainLatency(const Deck& deck) const;
+    void stopWorkers();
+
+    OwnedArray<Deck> decks;
+    PluginChain* masterChain = nullptr;
+
+    //worker i renders deck i + 1
+    OwnedArray<Worker> workers;
+    std::atomic<int> numSamplesToRender{ 0 };
+    std::atomic<int> decksRemaining{ 0 };
+    //signalled by whichever worker renders the last deck of a block
+    WaitableEvent decksDone;
+
+    //what the deck buffers were sized for
+    int maxBlockSize = 0;
+    int maxDelaySamples = 0;
+    double currentSampleRate = 44100.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckMixer)
+};
@@ -0,0 +1,484 @@
+/*
+  ==============================================================================
+
+    DuplicateFinder.cpp
+    Created: 19 Oct 2026 12:44:40pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "DuplicateFinder.h"
+#include "MemoryMonitor.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace
+{
+    const double secondsToFingerprint = 30.0;
+    const double targetSampleRate = 5512.5;
+
+    const int fftOrder = 11;
+    const int fftSize = 1 << fftOrder;
+    const int hopSize = 256;
+
+    //33 bands give 32 neighbouring pairs, one bit each
+    const int numBands = 33;
+    const double lowestFrequency = 300.0;
+    const double highestFrequency = 2000.0;
+
+    //a frame value held by more tracks than this says nothing about any of them
+    const size_t maxPostingsPerValue = 200;
+    const int minVotes = 2;
+    const int maxCandidatesToCompare = 5;
+    //about 4.5 seconds of overlap
+    const int minFramesToCompare = 100;
+    const float maxBitErrorRate = 0.33f;
+
+    //30 s at 5.5 kHz is about 650 frames, anything far bigger is a damaged file
+    const int maxStoredFrames = 4096;
+}
+
+//==============================================================================
+/** reads the stored fingerprint of one file, or fingerprints it, on the finder's thread */
+class DuplicateFinder::FingerprintJob : public ThreadPoolJob
+{
+public:
+    FingerprintJob(DuplicateFinder& _owner, int64 _id, const File& _file)
+                  : ThreadPoolJob("Fingerprint " + _file.getFileName()),
+                    owner(&_owner),
+                    finder(_owner),
+                    id(_id),
+                    file(_file)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        std::vector<uint32> fingerprint;
+        if (!finder.loadFingerprint(file, fingerprint)){
+            fingerprint = computeFingerprint(finder.formatManager, file, this);
+            if (shouldExit()){
+                return jobHasFinished;
+            }
+            //an unreadable file is stored too (empty), so it isn't decoded again next time
+            finder.saveFingerprintIfPending(id, file, fingerprint);
+        }
+
+        //hand the result over on the message thread, if the finder still exists
+        WeakReference<DuplicateFinder> weakFinder = owner;
+        int64 trackId = id;
+        MessageManager::callAsync([weakFinder, trackId, fingerprint] {
+            if (auto* f = weakFinder.get()){
+                f->fingerprintFinished(trackId, fingerprint);
+            }
+        });
+        return jobHasFinished;
+    }
+
+private:
+    WeakReference<DuplicateFinder> owner;
+    //only used from the job, which the finder stops before it goes away
+    const DuplicateFinder& finder;
+    int64 id;
+    File file;
+};
+
+//==============================================================================
+DuplicateFinder::DuplicateFinder(AudioFormatManager& _formatManager, const File& cacheDirectory)
+                                : formatManager(_formatManager),
+                                  directory(cacheDirectory)
+{
+    threadPool.setThreadPriorities(0);
+}
+
+DuplicateFinder::~DuplicateFinder()
+{
+    threadPool.removeAllJobs(true, 5000);
+    masterReference.clear();
+}
+
+//==============================================================================
+void DuplicateFinder::addTrack(int64 id, const File& file)
+{
+    if (fingerprints.count(id) > 0 || pendingIds.count(id) > 0){
+        return;
+    }
+    {
+        const ScopedLock sl(pendingLock);
+        pendingIds.insert(id);
+    }
+    threadPool.addJob(new FingerprintJob(*this, id, file), true);
+}
+
+void DuplicateFinder::removeTrack(int64 id, const File& file)
+{
+    //a job still fingerprinting the track sees it is gone and doesn't store the fingerprint again
+    {
+        const ScopedLock sl(pendingLock);
+        pendingIds.erase(id);
+    }
+    getCacheFileFor(file).deleteFile();
+
+    auto found = fingerprints.find(id);
+    if (found != fingerprints.end()){
+        unindex(id, found->second);
+        contentBytes -= jmin(contentBytes, MemoryMonitor::getVectorBytes(found->second));
+        fingerprints.erase(found);
+    }
+
+    auto original = duplicateOf.find(id);
+    if (original != duplicateOf.end()){
+        std::vector<int64>& copies = copiesOf[original->second];
+        copies.erase(std::remove(copies.begin(), copies.end(), id), copies.end());
+        if (copies.empty()){
+            copiesOf.erase(original->second);
+        }
+        duplicateOf.erase(original);
+    }
+
+    //whatever was a copy of this track is the only one left now
+    auto copies = copiesOf.find(id);
+    if (copies != copiesOf.end()){
+        for (int64 copy : copies->second){
+            duplicateOf.erase(copy);
+        }
+        copiesOf.erase(copies);
+    }
+}
+
+void DuplicateFinder::clear()
+{
+    //queued jobs are dropped; one still running finishes, but its result is ignored
+    threadPool.removeAllJobs(true, 0);
+    {
+        const ScopedLock sl(pendingLock);
+        pendingIds.clear();
+    }
+    fingerprints.clear();
+    postings.clear();
+    duplicateOf.clear();
+    copiesOf.clear();
+    contentBytes = 0;
+}
+
+int64 DuplicateFinder::getDuplicateOf(int64 id) const
+{
+    auto found = duplicateOf.find(id);
+    return found != duplicateOf.end() ? found->second : 0;
+}
+
+//==============================================================================
+void DuplicateFinder::fingerprintFinished(int64 id, std::vector<uint32> fingerprint)
+{
+    //removed (or cleared) while it was being fingerprinted
+    {
+        const ScopedLock sl(pendingLock);
+        if (pendingIds.erase(id) == 0){
+            return;
+        }
+    }
+    if (fingerprint.empty()){
+        return;
+    }
+
+    const int64 match = findMatch(id, fingerprint);
+    index(id, fingerprint);
+    contentBytes += MemoryMonitor::getVectorBytes(fingerprint);
+    fingerprints[id] = std::move(fingerprint);
+
+    if (match != 0){
+        //tracks finish in any order; the one added later is the copy
+        const int64 copy = jmax(id, match);
+        const int64 original = jmin(id, match);
+        if (duplicateOf.count(copy) == 0){
+            duplicateOf[copy] = original;
+            copiesOf[original].push_back(copy);
+            listeners.call([&] (Listener& l) { l.duplicateFound(copy, original); });
+        }
+    }
+}
+
+int64 DuplicateFinder::findMatch(int64 id, const std::vector<uint32>& fingerprint) const
+{
+    //votes for (track, time offset); a real match piles its votes on a single offset
+    std::map<std::pair<int64, int>, int> votes;
+    for (int frame = 0; frame < static_cast<int>(fingerprint.size()); ++frame){
+        const uint32 value = fingerprint[static_cast<size_t>(frame)];
+        if (value == 0 || value == 0xffffffffu){
+            continue; //silence
+        }
+        auto found = postings.find(value);
+        if (found == postings.end() || found->second.size() > maxPostingsPerValue){
+            continue;
+        }
+        for (const Posting& posting : found->second){
+            if (posting.id != id){
+                ++votes[{ posting.id, posting.frame - frame }];
+            }
+        }
+    }
+
+    std::vector<std::pair<int, std::pair<int64, int>>> candidates;
+    for (const auto& vote : votes){
+        if (vote.second >= minVotes){
+            candidates.push_back({ vote.second, vote.first });
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [] (const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+
+    //the votes only say where to look, the bits decide
+    for (size_t i = 0; i < candidates.size() && i < static_cast<size_t>(maxCandidatesToCompare); ++i){
+        const int64 candidateId = candidates[i].second.first;
+        const int offset = candidates[i].second.second;
+        auto other = fingerprints.find(candidateId);
+        if (other != fingerprints.end() && getBitErrorRate(fingerprint, other->second, offset) < maxBitErrorRate){
+            return candidateId;
+        }
+    }
+    return 0;
+}
+
+void DuplicateFinder::index(int64 id, const std::vector<uint32>& fingerprint)
+{
+    for (int frame = 0; frame < static_cast<int>(fingerprint.size()); ++frame){
+        const uint32 value = fingerprint[static_cast<size_t>(frame)];
+        if (isIndexed(frame, value)){
+            std::vector<Posting>& list = postings[value];
+            const size_t capacity = list.capacity();
+            list.push_back({ id, frame });
+            contentBytes += (list.capacity() - capacity) * sizeof(Posting);
+        }
+    }
+}
+
+void DuplicateFinder::unindex(int64 id, const std::vector<uint32>& fingerprint)
+{
+    for (int frame = 0; frame < static_cast<int>(fingerprint.size()); ++frame){
+        const uint32 value = fingerprint[static_cast<size_t>(frame)];
+        if (!isIndexed(frame, value)){
+            continue;
+        }
+        auto found = postings.find(value);
+        if (found == postings.end()){
+            continue;
+        }
+        std::vector<Posting>& list = found->second;
+        list.erase(std::remove_if(list.begin(), list.end(), [id] (const Posting& p) { return p.id == id; }), list.end());
+        if (list.empty()){
+            contentBytes -= jmin(contentBytes, MemoryMonitor::getVectorBytes(list));
+            postings.erase(found);
+        }
+    }
+}
+
+bool DuplicateFinder::isIndexed(int frame, uint32 value)
+{
+    //every fourth frame is enough, since a new track looks up all of its frames
+    return frame % 4 == 0 && value != 0 && value != 0xffffffffu;
+}
+
+float DuplicateFinder::getBitErrorRate(const std::vector<uint32>& a, const std::vector<uint32>& b, int offset)
+{
+    //frame i of a lines up with frame i + offset of b
+    const int first = jmax(0, -offset);
+    const int last = jmin(static_cast<int>(a.size()), static_cast<int>(b.size()) - offset);
+    if (last - first < minFramesToCompare){
+        return 1.0f;
+    }
+
+    int64 differentBits = 0;
+    for (int i = first; i < last; ++i){
+        differentBits += countNumberOfBits(a[static_cast<size_t>(i)] ^ b[static_cast<size_t>(i + offset)]);
+    }
+    return static_cast<float>(differentBits) / static_cast<float>(32 * (last - first));
+}
+
+//==============================================================================
+String DuplicateFinder::getIdentity(const File& audioFile)
+{
+    return audioFile.getFullPathName()
+         + "|" + String(audioFile.getSize())
+         + "|" + String(audioFile.getLastModificationTime().toMilliseconds());
+}
+
+File DuplicateFinder::getCacheFileFor(const File& audioFile) const
+{
+    //keyed by the path alone, so a changed file replaces its old entry rather than leaving it behind
+    return directory.getChildFile(String::toHexString(audioFile.getFullPathName().hashCode64()) + ".ofp");
+}
+
+bool DuplicateFinder::loadFingerprint(const File& audioFile, std::vector<uint32>& fingerprint) const
+{
+    FileInputStream in(getCacheFileFor(audioFile));
+    if (!in.openedOk()){
+        return false;
+    }
+
+    //the full identity is stored too, in case two paths share a hash
+    if (in.readString() != getIdentity(audioFile)){
+        return false;
+    }
+
+    const int numFrames = in.readInt();
+    if (numFrames < 0 || numFrames > maxStoredFrames || in.getNumBytesRemaining() < numFrames * 4){
+        return false;
+    }
+    fingerprint.resize(static_cast<size_t>(numFrames));
+    for (uint32& value : fingerprint){
+        value = static_cast<uint32>(in.readInt());
+    }
+    return true;
+}
+
+void DuplicateFinder::saveFingerprintIfPending(int64 id, const File& audioFile, const std::vector<uint32>& fingerprint) const
+{
+    //held while writing, so removeTrack() either stops the save or deletes the file after it
+    const ScopedLock sl(pendingLock);
+    if (pendingIds.count(id) > 0){
+        saveFingerprint(audioFile, fingerprint);
+    }
+}
+
+void DuplicateFinder::saveFingerprint(const File& audioFile, const std::vector<uint32>& fingerprint) const
+{
+    if (!directory.createDirectory()){
+        return;
+    }
+
+    //written next to the target and renamed over it, so a crash never leaves half a file
+    const File cacheFile = getCacheFileFor(audioFile);
+    TemporaryFile temp(cacheFile);
+    {
+        FileOutputStream out(temp.getFile());
+        if (!out.openedOk()){
+            return;
+        }
+        out.writeString(getIdentity(audioFile));
+        out.writeInt(static_cast<int>(fingerprint.size()));
+        for (uint32 value : fingerprint){
+            out.writeInt(static_cast<int>(value));
+        }
+        out.flush();
+        if (out.getStatus().failed()){
+            return;
+        }
+    }
+    temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+std::vector<uint32> DuplicateFinder::computeFingerprint(AudioFormatManager& formatManager,
+                                                        const File& file,
+                                                        const ThreadPoolJob* job)
+{
+    std::vector<uint32> fingerprint;
+
+    std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->numChannels == 0){
+        return fingerprint;
+    }
+
+    //mono at about 5.5 kHz; averaging each block of samples is a crude low pass,
+    //but nothing above 2 kHz is used
+    const int numChannels = static_cast<int>(reader->numChannels);
+    const int decimation = jmax(1, roundToInt(reader->sampleRate / targetSampleRate));
+    const double rate = reader->sampleRate / decimation;
+    const int64 numSamples = jmin(reader->lengthInSamples, static_cast<int64>(reader->sampleRate * secondsToFingerprint));
+
+    std::vector<float> mono;
+    mono.reserve(static_cast<size_t>(numSamples / decimation + 1));
+    const int blockSize = 16384;
+    AudioBuffer<float> block(numChannels, blockSize);
+    float sum = 0.0f;
+    int count = 0;
+    for (int64 position = 0; position < numSamples; position += blockSize){
+        if (job != nullptr && job->shouldExit()){
+            return {};
+        }
+        const int numToRead = static_cast<int>(jmin(static_cast<int64>(blockSize), numSamples - position));
+        reader->read(&block, 0, numToRead, position, true, true);
+
+        for (int i = 0; i < numToRead; ++i){
+            for (int channel = 0; channel < numChannels; ++channel){
+                sum += block.getSample(channel, i);
+            }
+            if (++count == decimation){
+                mono.push_back(sum / static_cast<float>(decimation * numChannels));
+                sum = 0.0f;
+                count = 0;
+            }
+        }
+    }
+
+    //band edges as FFT bins, log spaced
+    int edges[numBands + 1];
+    for (int band = 0; band <= numBands; ++band){
+        const double frequency = lowestFrequency * std::pow(highestFrequency / lowestFrequency, band / static_cast<double>(numBands));
+        edges[band] = jlimit(1, fftSize / 2 - 1, roundToInt(frequency * fftSize / rate));
+    }
+
+    dsp::FFT fft(fftOrder);
+    dsp::WindowingFunction<float> window(static_cast<size_t>(fftSize), dsp::WindowingFunction<float>::hann, false);
+    std::vector<float> frame(static_cast<size_t>(fftSize * 2));
+    float differences[numBands - 1];
+    float previousDifferences[numBands - 1];
+    bool hasPrevious = false;
+
+    for (size_t start = 0; start + fftSize <= mono.size(); start += hopSize){
+        std::copy(mono.begin() + static_cast<std::ptrdiff_t>(start),
+                  mono.begin() + static_cast<std::ptrdiff_t>(start + fftSize),
+                  frame.begin());
+        std::fill(frame.begin() + fftSize, frame.end(), 0.0f);
+        window.multiplyWithWindowingTable(frame.data(), static_cast<size_t>(fftSize));
+        fft.performFrequencyOnlyForwardTransform(frame.data());
+
+        float energies[numBands];
+        for (int band = 0; band < numBands; ++band){
+            float energy = 0.0f;
+            for (int bin = edges[band]; bin < jmax(edges[band + 1], edges[band] + 1); ++bin){
+                energy += frame[static_cast<size_t>(bin)] * frame[static_cast<size_t>(bin)];
+            }
+            energies[band] = energy;
+        }
+        for (int band = 0; band < numBands - 1; ++band){
+            differences[band] = energies[band] - energies[band + 1];
+        }
+
+        //one bit per band pair: did the difference grow since the last frame
+        if (hasPrevious){
+            uint32 value = 0;
+            for (int band = 0; band < numBands - 1; ++band){
+                if (differences[band] - previousDifferences[band] > 0.0f){
+                    value |= 1u << band;
+                }
+            }
+            fingerprint.push_back(value);
+        }
+        std::copy(differences, differences + numBands - 1, previousDifferences);
+        hasPrevious = true;
+    }
+    return fingerprint;
+}
+
+//==============================================================================
+void DuplicateFinder::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void DuplicateFinder::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
+
+size_t DuplicateFinder::getMemoryUsage() const
+{
+    size_t bytes = MemoryMonitor::getHashBytes(pendingIds) + MemoryMonitor::getHashBytes(fingerprints)
+                 + MemoryMonitor::getHashBytes(postings) + MemoryMonitor::getHashBytes(duplicateOf)
+                 + MemoryMonitor::getHashBytes(copiesOf);
+    return bytes + contentBytes;
+}
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    DuplicateFinder.h
+    Created: 19 Oct 2026 12:44:40pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//==============================================================================
+/*
+    Finds the same recording stored twice under different paths (two rips,
+    two folders, a different format) from the audio itself.
+    Each track gets a compact acoustic fingerprint on a single low priority
+    thread of its own, so a library full of new files never holds up the
+    searches, probes and waveforms on the shared pool: the first 30 seconds are mixed to mono, brought down to about
+    5.5 kHz and cut into overlapping frames, and every frame gives 32 bits,
+    one per pair of neighbouring bands (300 Hz - 2 kHz, log spaced), telling
+    whether the energy difference between the two bands went up or down
+    since the last frame. Those bits survive re-encoding and level changes.
+    Every fourth frame value of each track goes into a hash table; a new
+    track looks up all of its frame values, so matching costs the same
+    whatever the size of the library. Tracks that share enough values at the
+    same time offset are compared bit by bit, and are duplicates if fewer
+    than a third of the bits differ.
+    Fingerprints are also stored in the cache folder, one small file per
+    track keyed by its path and checked against its size and modification
+    time, so only new or changed files are ever decoded again.
+    Only used from the message thread; listeners are told on the message
+    thread.
+*/
+class DuplicateFinder
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called when a track turns out to be the same recording as one added before it */
+        virtual void duplicateFound(int64 id, int64 duplicateOfId) = 0;
+    };
+
+    DuplicateFinder(AudioFormatManager& formatManager, const File& cacheDirectory);
+    ~DuplicateFinder();
+
+    /** queues a track for fingerprinting (or for reading its stored fingerprint) */
+    void addTrack(int64 id, const File& file);
+    /** forgets a track and deletes its stored fingerprint */
+    void removeTrack(int64 id, const File& file);
+    void clear();
+
+    /** id of the earlier track this one is a copy of, or 0 (also 0 until both are fingerprinted) */
+    int64 getDuplicateOf(int64 id) const;
+
+    /** fingerprints a file, one value per frame (empty if it can't be read); thread safe */
+    static std::vector<uint32> computeFingerprint(AudioFormatManager& formatManager,
+                                                  const File& file,
+                                                  const ThreadPoolJob* job = nullptr);
+
+    /** estimated bytes held by the fingerprints and their index */
+    size_t getMemoryUsage() const;
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    class FingerprintJob;
+
+    struct Posting
+    {
+        int64 id;
+        int frame;
+    };
+
+    /** called on the message thread by a finished FingerprintJob */
+    void fingerprintFinished(int64 id, std::vector<uint32> fingerprint);
+    /** earlier fingerprinted track with the same audio, or 0 */
+    int64 findMatch(int64 id, const std::vector<uint32>& fingerprint) const;
+    void index(int64 id, const std::vector<uint32>& fingerprint);
+    void unindex(int64 id, const std::vector<uint32>& fingerprint);
+
+    static bool isIndexed(int frame, uint32 value);
+
+    /** the size and modification time a stored fingerprint was made from */
+    static String getIdentity(const File& audioFile);
+    File getCacheFileFor(const File& audioFile) const;
+    /** false if nothing is stored for the file or it has changed since; thread safe */
+    bool loadFingerprint(const File& audioFile, std::vector<uint32>& fingerprint) const;
+    void saveFingerprint(const File& audioFile, const std::vector<uint32>& fingerprint) const;
+    /** saves unless the track was removed (or the finder cleared) since it was queued; thread safe */
+    void saveFingerprintIfPending(int64 id, const File& audioFile, const std::vector<uint32>& fingerprint) const;
+    static float getBitErrorRate(const std::vector<uint32>& a, const std::vector<uint32>& b, int offset);
+
+    AudioFormatManager& formatManager;
+    const File directory;
+    //one thread at the lowest priority, a first run over a big library can take hours
+    ThreadPool threadPool{1};
+
+    //queued or being fingerprinted; changed on the message thread, read by the job under pendingLock
+    std::unordered_set<int64> pendingIds;
+    CriticalSection pendingLock;
+    std::unordered_map<int64, std::vector<uint32>> fingerprints;
+    //frame value -> tracks and frames it was seen at
+    std::unordered_map<uint32, std::vector<Posting>> postings;
+    //later track -> earlier track with the same audio
+    std::unordered_map<int64, int64> duplicateOf;
+    //earlier track -> its copies, so removing a track doesn't scan duplicateOf
+    std::unordered_map<int64, std::vector<int64>> copiesOf;
+    //bytes of the fingerprints and posting lists, kept up to date as they change so counting doesn't walk them
+    size_t contentBytes = 0;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (DuplicateFinder)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DuplicateFinder)
+};
@@ -0,0 +1,490 @@
+/*
+  ==============================================================================
+
+    FolderWatcher.cpp
+    Created: 19 Oct 2026 12:49:06pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "FolderWatcher.h"
+
+#if JUCE_LINUX
+ #include <sys/inotify.h>
+ #include <poll.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    //changes are posted once the folders have been quiet this long...
+    const uint32 quietMilliseconds = 300;
+    //...or this long after the first one, whichever comes first
+    const uint32 maxDelayMilliseconds = 2000;
+
+    bool isInside(const String& path, const String& folder)
+    {
+        return path == folder || path.startsWith(folder + File::getSeparatorString());
+    }
+
+    /** where a linked folder really is, so it is only walked (and watched) under one path */
+    File resolveLink(const File& folder)
+    {
+        File target = folder;
+        //a chain of links is followed, a loop of them is given up on
+        for (int i = 0; i < 8 && target.isSymbolicLink(); ++i){
+            target = target.getLinkedTarget();
+        }
+        return target;
+    }
+}
+
+//==============================================================================
+FolderWatcher::FolderWatcher(const File& _stateFile)
+                            : Thread("Folder watcher"),
+                              stateFile(_stateFile)
+{
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    stopThread(2000);
+    masterReference.clear();
+}
+
+void FolderWatcher::start(const String& _audioExtensions)
+{
+    //the state and extensions belong to the thread once it runs
+    jassert(!isThreadRunning());
+    if (isThreadRunning()){
+        return;
+    }
+
+    loadState();
+
+    //the thread owns this once it runs
+    audioExtensions = _audioExtensions;
+
+    selfReference = this;
+
+    //as low as the analysis jobs, it should never compete with the audio or message threads
+    startThread(3);
+}
+
+void FolderWatcher::addFolder(const File& folder)
+{
+    {
+        const ScopedLock sl(lock);
+        if (roots.contains(folder.getFullPathName())){
+            return;
+        }
+        roots.add(folder.getFullPathName());
+        foldersToAdd.add(folder.getFullPathName());
+    }
+    notify();
+}
+
+void FolderWatcher::removeFolder(const File& folder)
+{
+    {
+        const ScopedLock sl(lock);
+        roots.removeString(folder.getFullPathName());
+        foldersToRemove.add(folder.getFullPathName());
+    }
+    notify();
+}
+
+Array<File> FolderWatcher::getFolders() const
+{
+    const ScopedLock sl(lock);
+    Array<File> folders;
+    for (const String& root : roots){
+        folders.add(File(root));
+    }
+    return folders;
+}
+
+//==============================================================================
+void FolderWatcher::run()
+{
+   #if JUCE_LINUX
+    inotifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyHandle < 0){
+        std::cout << "FolderWatcher::run inotify is not available, folders are only checked at start-up" << std::endl;
+    }
+   #endif
+
+    reconcile();
+
+    while (!threadShouldExit()){
+        takeRequests();
+
+       #if JUCE_LINUX
+        if (inotifyHandle >= 0){
+            //sleeps in the kernel until something happens (or a request may be waiting)
+            pollfd fd { inotifyHandle, POLLIN, 0 };
+            if (poll(&fd, 1, 250) > 0){
+                readEvents();
+            }
+        }
+        else{
+            wait(500);
+        }
+       #else
+        wait(500);
+       #endif
+
+        if (needsReconcile){
+            needsReconcile = false;
+            reconcile();
+        }
+
+        const uint32 now = Time::getMillisecondCounter();
+        if (firstPendingTime != 0
+            && (now - lastEventTime >= quietMilliseconds || now - firstPendingTime >= maxDelayMilliseconds)){
+            postChanges();
+        }
+    }
+
+    if (firstPendingTime != 0){
+        postChanges();
+    }
+    saveState();
+
+   #if JUCE_LINUX
+    if (inotifyHandle >= 0){
+        close(inotifyHandle);
+        inotifyHandle = -1;
+    }
+   #endif
+}
+
+//==============================================================================
+void FolderWatcher::reconcile()
+{
+    //a copy, folders can be forgotten (with a parent) or found while going through it
+    const std::map<String, int64> knownFolders = folderTimes;
+
+    for (auto it = knownFolders.begin(); it != knownFolders.end() && !threadShouldExit(); ++it){
+        const String& path = it->first;
+        if (folderTimes.count(path) == 0){
+            continue;
+        }
+
+        const File folder(path);
+        if (!folder.isDirectory()){
+            //offline folders keep their time and are looked at again next time
+            if (isReallyGone(folder)){
+                pendingFoldersRemoved.insert(path);
+                forgetTree(folder);
+                noteChange();
+            }
+            continue;
+        }
+
+        //unchanged folders cost this one stat
+        const int64 time = getFolderTime(folder);
+        if (time != it->second){
+            //compared with the library on the message thread, which knows what it holds now
+            Array<File> onDisk;
+            for (const DirectoryEntry& entry : RangedDirectoryIterator(folder, false, "*",
+                                                                       File::findFilesAndDirectories | File::ignoreHiddenFiles)){
+                const File child = entry.getFile();
+                if (entry.isDirectory()){
+                    scanTree(resolveLink(child), true);
+                }
+                else if (isAudioFile(child)){
+                    onDisk.add(child);
+                }
+            }
+            pendingListings[path] = onDisk;
+            noteChange();
+            folderTimes[path] = time;
+        }
+        watch(folder);
+    }
+
+    //first run, or a watched folder that was missing and is back
+    for (const File& root : getFolders()){
+        if (folderTimes.count(root.getFullPathName()) == 0){
+            scanTree(root, true);
+        }
+    }
+}
+
+bool FolderWatcher::isReallyGone(const File& folder) const
+{
+    //an unplugged drive or unmounted share looks just like a deleted folder
+    if (getFolders().contains(folder)){
+        return false;
+    }
+    return folder.getParentDirectory().isDirectory();
+}
+
+void FolderWatcher::scanTree(const File& folder, bool reportFiles)
+{
+    //a folder reached again (through a link back up the tree, or to a folder watched already) is walked once
+    if (!folder.isDirectory() || folderTimes.count(folder.getFullPathName()) > 0){
+        return;
+    }
+
+    //watched before it is listed, so nothing created in between is missed
+    folderTimes[folder.getFullPathName()] = getFolderTime(folder);
+    watch(folder);
+
+    for (const DirectoryEntry& entry : RangedDirectoryIterator(folder, false, "*",
+                                                               File::findFilesAndDirectories | File::ignoreHiddenFiles)){
+        const File child = entry.getFile();
+        if (entry.isDirectory()){
+            scanTree(resolveLink(child), reportFiles);
+        }
+        else if (reportFiles && isAudioFile(child)){
+            pendingFiles[child.getFullPathName()] = true;
+            noteChange();
+        }
+    }
+}
+
+void FolderWatcher::forgetTree(const File& folder)
+{
+    const String path = folder.getFullPathName();
+
+    for (auto it = folderTimes.lower_bound(path); it != folderTimes.end() && it->first.startsWith(path);){
+        if (isInside(it->first, path)){
+            it = folderTimes.erase(it);
+        }
+        else{
+            ++it;
+        }
+    }
+
+    for (auto it = foldersByWatch.begin(); it != foldersByWatch.end();){
+        if (isInside(it->second, path)){
+           #if JUCE_LINUX
+            inotify_rm_watch(inotifyHandle, it->first);
+           #endif
+            it = foldersByWatch.erase(it);
+        }
+        else{
+            ++it;
+        }
+    }
+}
+
+void FolderWatcher::watch(const File& folder)
+{
+   #if JUCE_LINUX
+    if (inotifyHandle < 0){
+        return;
+    }
+
+    const int watchDescriptor = inotify_add_watch(inotifyHandle, folder.getFullPathName().toRawUTF8(),
+                                                  IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+    if (watchDescriptor < 0){
+        //usually fs.inotify.max_user_watches; the folder is still checked at start-up
+        if (!watchLimitReported){
+            std::cout << "FolderWatcher::watch could not watch " << folder.getFullPathName()
+                      << ", raise fs.inotify.max_user_watches for live updates" << std::endl;
+            watchLimitReported = true;
+        }
+        return;
+    }
+    foldersByWatch[watchDescriptor] = folder.getFullPathName();
+   #else
+    ignoreUnused(folder);
+   #endif
+}
+
+bool FolderWatcher::isAudioFile(const File& file) const
+{
+    return file.hasFileExtension(audioExtensions);
+}
+
+//==============================================================================
+void FolderWatcher::takeRequests()
+{
+    StringArray toAdd, toRemove;
+    {
+        const ScopedLock sl(lock);
+        toAdd.swapWith(foldersToAdd);
+        toRemove.swapWith(foldersToRemove);
+    }
+
+    for (const String& path : toRemove){
+        forgetTree(File(path));
+    }
+    for (const String& path : toAdd){
+        scanTree(File(path), false);
+    }
+    if (!toAdd.isEmpty() || !toRemove.isEmpty()){
+        saveState();
+    }
+}
+
+void FolderWatcher::readEvents()
+{
+   #if JUCE_LINUX
+    alignas(inotify_event) char buffer[16384];
+
+    for (;;){
+        const ssize_t numBytes = read(inotifyHandle, buffer, sizeof(buffer));
+        if (numBytes <= 0){
+            return; //drained
+        }
+
+        for (char* p = buffer; p < buffer + numBytes;){
+            const inotify_event& event = *reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event.len;
+
+            //the kernel dropped events: check the folders' times again
+            if (event.mask & IN_Q_OVERFLOW){
+                needsReconcile = true;
+                continue;
+            }
+
+            auto found = foldersByWatch.find(event.wd);
+            if (found == foldersByWatch.end()){
+                continue;
+            }
+            if (event.mask & IN_IGNORED){
+                foldersByWatch.erase(found);
+                continue;
+            }
+            if (event.len == 0){
+                continue;
+            }
+
+            const String folderPath = found->second;
+            const File child = File(folderPath).getChildFile(String::fromUTF8(event.name));
+            changedFolders.insert(folderPath);
+
+            //a link to a folder isn't flagged as one, it is told apart by what it points at
+            const bool isNewLinkedFolder = (event.mask & (IN_CREATE | IN_MOVED_TO)) != 0 && child.isSymbolicLink() && child.isDirectory();
+            if ((event.mask & IN_ISDIR) || isNewLinkedFolder){
+                if (event.mask & (IN_CREATE | IN_MOVED_TO)){
+                    scanTree(resolveLink(child), true);
+                }
+                else if (event.mask & (IN_DELETE | IN_MOVED_FROM)){
+                    pendingFoldersRemoved.insert(child.getFullPathName());
+                    forgetTree(child);
+                }
+            }
+            else if (isAudioFile(child)){
+                //a new file is only reported once it has been written and closed
+                if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)){
+                    pendingFiles[child.getFullPathName()] = true;
+                }
+                else if (event.mask & (IN_DELETE | IN_MOVED_FROM)){
+                    pendingFiles[child.getFullPathName()] = false;
+                }
+            }
+            noteChange();
+        }
+    }
+   #endif
+}
+
+void FolderWatcher::noteChange()
+{
+    lastEventTime = Time::getMillisecondCounter();
+    if (firstPendingTime == 0){
+        firstPendingTime = jmax(static_cast<uint32>(1), lastEventTime);
+    }
+}
+
+void FolderWatcher::postChanges()
+{
+    Changes changes;
+    for (auto it = pendingFiles.begin(); it != pendingFiles.end(); ++it){
+        if (it->second){
+            changes.filesAdded.add(File(it->first));
+        }
+        else{
+            changes.filesRemoved.add(File(it->first));
+        }
+    }
+    for (const String& path : pendingFoldersRemoved){
+        changes.foldersRemoved.add(File(path));
+    }
+    for (auto it = pendingListings.begin(); it != pendingListings.end(); ++it){
+        changes.foldersListed.add({ File(it->first), it->second });
+    }
+
+    //the folders are up to date as of now
+    for (const String& path : changedFolders){
+        auto found = folderTimes.find(path);
+        if (found != folderTimes.end()){
+            found->second = getFolderTime(File(path));
+        }
+    }
+
+    pendingFiles.clear();
+    pendingFoldersRemoved.clear();
+    pendingListings.clear();
+    changedFolders.clear();
+    firstPendingTime = 0;
+
+    //hand the batch over on the message thread, if the watcher still exists
+    WeakReference<FolderWatcher> watcher = selfReference;
+    MessageManager::callAsync([watcher, changes] {
+        if (auto* w = watcher.get()){
+            w->listeners.call([&] (Listener& l) { l.watchedFilesChanged(changes); });
+        }
+    });
+
+    saveState();
+}
+
+//==============================================================================
+void FolderWatcher::loadState()
+{
+    std::unique_ptr<XmlElement> state = parseXML(stateFile);
+    if (state == nullptr){
+        return;
+    }
+
+    const ScopedLock sl(lock);
+    for (auto* element : state->getChildIterator()){
+        if (element->hasTagName("ROOT")){
+            roots.addIfNotAlreadyThere(element->getStringAttribute("path"));
+        }
+        else if (element->hasTagName("FOLDER")){
+            folderTimes[element->getStringAttribute("path")] = element->getStringAttribute("modified").getLargeIntValue();
+        }
+    }
+}
+
+void FolderWatcher::saveState()
+{
+    XmlElement state("WATCHEDFOLDERS");
+    for (const File& root : getFolders()){
+        state.createNewChildElement("ROOT")->setAttribute("path", root.getFullPathName());
+    }
+    for (auto it = folderTimes.begin(); it != folderTimes.end(); ++it){
+        XmlElement* folder = state.createNewChildElement("FOLDER");
+        folder->setAttribute("path", it->first);
+        folder->setAttribute("modified", String(it->second));
+    }
+
+    //written to a temporary file and renamed, like the library snapshot
+    if (!state.writeTo(stateFile)){
+        std::cout << "FolderWatcher::saveState could not write " << stateFile.getFullPathName() << std::endl;
+    }
+}
+
+int64 FolderWatcher::getFolderTime(const File& folder)
+{
+    return folder.getLastModificationTime().toMilliseconds();
+}
+
+//==============================================================================
+void FolderWatcher::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void FolderWatcher::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
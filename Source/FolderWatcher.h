@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    FolderWatcher.h
+    Created: 19 Oct 2026 12:49:06pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <map>
+#include <set>
+
+//==============================================================================
+/*
+    Keeps the library in step with watched music folders.
+    On Linux every watched folder (and subfolder) has an inotify watch, and
+    a background thread turns created, moved and deleted files into changes.
+    Changes are collected until the folders have been quiet for a moment
+    (or a couple of seconds have passed), so a big copy or move arrives as
+    one batch; a file created and deleted again in the meantime is never
+    reported. While nothing happens the thread sleeps in poll().
+    The modification time of every watched folder is kept with the list of
+    folders. A folder's time changes whenever a file in it is added, removed
+    or renamed, so at start-up only the folders whose time changed since the
+    last session are listed again; the rest of the tree costs one stat each.
+    A listed folder is handed over as it is on disk and compared with the
+    library on the message thread, so the comparison is with the library as
+    it is then. A missing folder only counts as deleted if its parent is
+    still there: a watched folder that is gone, or one on a drive that isn't
+    plugged in, is offline and its tracks stay until it is back.
+    A linked subfolder is followed to where it really is and kept under that
+    path, so a link back up the tree (or to a folder already watched) is
+    never walked or watched twice.
+    On other platforms the start-up check is all there is (no live events).
+    Listeners are told on the message thread.
+*/
+class FolderWatcher  : private Thread
+{
+public:
+    /** the music files in a folder (not its subfolders) when it was listed */
+    struct FolderListing
+    {
+        File folder;
+        Array<File> files;
+    };
+
+    struct Changes
+    {
+        Array<File> filesAdded;
+        Array<File> filesRemoved;
+        //gone with everything in them
+        Array<File> foldersRemoved;
+        //listed again because their time changed; library tracks in them that aren't listed are gone
+        Array<FolderListing> foldersListed;
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called with a batch of changes in the watched folders */
+        virtual void watchedFilesChanged(const Changes& changes) = 0;
+    };
+
+    /** the watched folders and their times are saved in stateFile */
+    FolderWatcher(const File& stateFile);
+    ~FolderWatcher() override;
+
+    /** catches up with what changed while the app was closed, then starts watching;
+        audioExtensions is like ".wav;.mp3"; only called once */
+    void start(const String& audioExtensions);
+
+    /** watches a folder and its subfolders; the files already in it are not reported (import them) */
+    void addFolder(const File& folder);
+    /** stops watching a folder; its tracks stay in the library */
+    void removeFolder(const File& folder);
+    Array<File> getFolders() const;
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    void run() override;
+
+    void loadState();
+    void saveState();
+
+    /** lists only the folders whose time changed since they were last seen */
+    void reconcile();
+    /** a missing folder is only gone if its parent is still there and it isn't a watched root */
+    bool isReallyGone(const File& folder) const;
+    /** records and watches a folder tree; reports its files if asked */
+    void scanTree(const File& folder, bool reportFiles);
+    void forgetTree(const File& folder);
+    void watch(const File& folder);
+    bool isAudioFile(const File& file) const;
+
+    void takeRequests();
+    void readEvents();
+    /** something is pending: restarts the quiet time */
+    void noteChange();
+    void postChanges();
+
+    static int64 getFolderTime(const File& folder);
+
+    File stateFile;
+
+    //shared with the message thread
+    mutable CriticalSection lock;
+    StringArray roots;
+    StringArray foldersToAdd;
+    StringArray foldersToRemove;
+
+    //only used on the thread from here on
+    String audioExtensions;
+    //folder -> modification time when it was last listed or changed
+    std::map<String, int64> folderTimes;
+    int inotifyHandle = -1;
+    std::map<int, String> foldersByWatch;
+    bool watchLimitReported = false;
+    bool needsReconcile = false;
+
+    //changes not posted yet: file -> true if added, false if removed
+    std::map<String, bool> pendingFiles;
+    std::set<String> pendingFoldersRemoved;
+    std::map<String, Array<File>> pendingListings;
+    std::set<String> changedFolders;
+    uint32 firstPendingTime = 0;
+    uint32 lastEventTime = 0;
+
+    ListenerList<Listener> listeners;
+    //made on the message thread, copied by the watcher thread to post its changes
+    WeakReference<FolderWatcher> selfReference;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (FolderWatcher)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FolderWatcher)
+};
@@ -0,0 +1,317 @@
+/*
+  ==============================================================================
+
+    LatencyTester.cpp
+    Created: 19 Oct 2026 12:23:40pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "LatencyTester.h"
+
+//==============================================================================
+bool LatencyTester::Results::isSafe() const
+{
+    //no dropouts and no callback arrived later than a whole buffer period
+    return succeeded && xruns <= 0 && numCallbacks > 0 && maxJitterMs < expectedPeriodMs;
+}
+
+String LatencyTester::Results::toString() const
+{
+    if (!succeeded){
+        return "Test failed: " + error;
+    }
+
+    String text;
+    text << "Device: " << String(sampleRate, 0) << " Hz, " << bufferSize << " samples ("
+         << String(1000.0 * bufferSize / sampleRate, 2) << " ms)\n";
+
+    if (loopback){
+        text << "Round trip (measured): " << roundTripSamples << " samples = "
+             << String(1000.0 * roundTripSamples / sampleRate, 2) << " ms\n";
+        text << "Round trip (reported by driver): " << reportedLatencySamples << " samples = "
+             << String(1000.0 * reportedLatencySamples / sampleRate, 2) << " ms\n";
+    }
+
+    text << "Callbacks: " << numCallbacks << ", period " << String(meanPeriodMs, 3)
+         << " ms (expected " << String(expectedPeriodMs, 3) << " ms)\n";
+    text << "Jitter: rms " << String(jitterRmsMs, 3) << " ms, max " << String(maxJitterMs, 3) << " ms\n";
+    text << "Xruns: " << (xruns < 0 ? String("not reported by this driver") : String(xruns)) << "\n";
+    text << (isSafe() ? "Buffer size looks safe" : "Buffer size is NOT safe on this machine");
+    return text;
+}
+
+//==============================================================================
+LatencyTester::LatencyTester(AudioDeviceManager& _deviceManager)
+                            : deviceManager(_deviceManager)
+{
+}
+
+LatencyTester::~LatencyTester()
+{
+    cancel();
+}
+
+void LatencyTester::startLoopbackTest()
+{
+    start(true, 0);
+}
+
+void LatencyTester::startJitterTest(int durationMs)
+{
+    start(false, durationMs);
+}
+
+void LatencyTester::cancel()
+{
+    stopTimer();
+    deviceManager.removeAudioCallback(this);
+    phase = idle;
+}
+
+bool LatencyTester::isRunning() const
+{
+    return isTimerRunning();
+}
+
+const LatencyTester::Results& LatencyTester::getResults() const
+{
+    return results;
+}
+
+void LatencyTester::start(bool isLoopback, int durationMs)
+{
+    cancel();
+    results = Results();
+    results.loopback = isLoopback;
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr){
+        results.error = "no audio device is open";
+        sendChangeMessage();
+        return;
+    }
+    if (isLoopback && device->getActiveInputChannels().countNumberOfSetBits() == 0){
+        results.error = "enable an input channel and connect it to an output to measure the round trip";
+        sendChangeMessage();
+        return;
+    }
+
+    results.sampleRate = device->getCurrentSampleRate();
+    results.bufferSize = device->getCurrentBufferSizeSamples();
+    results.reportedLatencySamples = device->getInputLatencyInSamples() + device->getOutputLatencyInSamples();
+
+    loopbackMode = isLoopback;
+    if (loopbackMode){
+        //a fixed seed keeps the burst identical between runs
+        Random random(0x0d0d);
+        testSound.resize(4096);
+        for (float& sample : testSound){
+            sample = (random.nextFloat() * 2.0f - 1.0f) * 0.25f;
+        }
+        //one second of listening covers any sensible device latency
+        recording.assign(static_cast<size_t>(results.sampleRate) + testSound.size(), 0.0f);
+        durationMs = 1000 + roundToInt(1000.0 * testSound.size() / results.sampleRate);
+    }
+
+    //all storage is allocated here so the audio thread never has to
+    callbackTicks.assign(static_cast<size_t>(durationMs) * 2 + 1024, 0);
+    testDurationTicks = Time::secondsToHighResolutionTicks(durationMs / 1000.0);
+    numCallbackTicks = 0;
+    callbackBufferSize = 0;
+    playPosition = 0;
+    recordPosition = 0;
+    startTicks = 0;
+    xrunsAtStart = device->getXRunCount();
+    testStartedMs = Time::getMillisecondCounter();
+    testTimeoutMs = static_cast<uint32>(durationMs) + 5000;
+
+    phase = running;
+    deviceManager.addAudioCallback(this);
+    startTimer(50);
+}
+
+//==============================================================================
+void LatencyTester::audioDeviceIOCallback(const float** inputChannelData,
+                                          int numInputChannels,
+                                          float** outputChannelData,
+                                          int numOutputChannels,
+                                          int numSamples)
+{
+    //the device manager sums every callback's output, so stay silent when idle
+    if (phase.load() != running){
+        for (int ch = 0; ch < numOutputChannels; ++ch){
+            if (outputChannelData[ch] != nullptr){
+                FloatVectorOperations::clear(outputChannelData[ch], numSamples);
+            }
+        }
+        return;
+    }
+
+    const int64 now = Time::getHighResolutionTicks();
+    if (startTicks == 0){
+        startTicks = now;
+    }
+
+    const int n = numCallbackTicks.load();
+    if (n < static_cast<int>(callbackTicks.size())){
+        callbackTicks[static_cast<size_t>(n)] = now;
+        numCallbackTicks.store(n + 1);
+    }
+    callbackBufferSize = numSamples;
+
+    const float* input = nullptr;
+    for (int ch = 0; ch < numInputChannels && input == nullptr; ++ch){
+        input = inputChannelData[ch];
+    }
+
+    for (int i = 0; i < numSamples; ++i){
+        float out = 0.0f;
+        if (loopbackMode){
+            if (playPosition < static_cast<int>(testSound.size())){
+                out = testSound[static_cast<size_t>(playPosition++)];
+            }
+            if (recordPosition < static_cast<int>(recording.size())){
+                recording[static_cast<size_t>(recordPosition++)] = (input != nullptr) ? input[i] : 0.0f;
+            }
+        }
+        for (int ch = 0; ch < numOutputChannels; ++ch){
+            if (outputChannelData[ch] != nullptr){
+                outputChannelData[ch][i] = out;
+            }
+        }
+    }
+
+    const bool done = loopbackMode ? recordPosition >= static_cast<int>(recording.size())
+                                   : now - startTicks >= testDurationTicks;
+    if (done){
+        phase = finished;
+    }
+}
+
+void LatencyTester::audioDeviceAboutToStart(AudioIODevice*)
+{
+}
+
+void LatencyTester::audioDeviceStopped()
+{
+}
+
+//==============================================================================
+void LatencyTester::timerCallback()
+{
+    if (phase.load() != finished){
+        //the device was stopped or changed under us
+        if (Time::getMillisecondCounter() - testStartedMs > testTimeoutMs){
+            cancel();
+            results.error = "the audio device stopped calling back during the test";
+            sendChangeMessage();
+        }
+        return;
+    }
+
+    stopTimer();
+    deviceManager.removeAudioCallback(this);
+    phase = idle;
+
+    if (auto* device = deviceManager.getCurrentAudioDevice()){
+        const int xruns = device->getXRunCount();
+        results.xruns = (xruns < 0 || xrunsAtStart < 0) ? -1 : xruns - xrunsAtStart;
+    }
+
+    analyseCallbackTimes();
+
+    if (loopbackMode){
+        results.roundTripSamples = findBurstInRecording();
+        if (results.roundTripSamples < 0){
+            results.error = "the test signal was not heard on the input, check the loopback cable and levels";
+        }
+    }
+
+    results.succeeded = results.error.isEmpty();
+    sendChangeMessage();
+}
+
+void LatencyTester::analyseCallbackTimes()
+{
+    const int n = numCallbackTicks.load();
+    results.numCallbacks = n;
+    results.expectedPeriodMs = 1000.0 * callbackBufferSize.load() / results.sampleRate;
+
+    // the first interval includes the device warming up, so it is left out
+    double sum = 0.0;
+    double sumOfSquares = 0.0;
+    double maxDeviation = 0.0;
+    int count = 0;
+
+    for (int i = 2; i < n; ++i){
+        const double period = 1000.0 * Time::highResolutionTicksToSeconds(callbackTicks[static_cast<size_t>(i)]
+                                                                            - callbackTicks[static_cast<size_t>(i - 1)]);
+        const double deviation = period - results.expectedPeriodMs;
+        sum += period;
+        sumOfSquares += deviation * deviation;
+        maxDeviation = jmax(maxDeviation, std::abs(deviation));
+        ++count;
+    }
+
+    if (count > 0){
+        results.meanPeriodMs = sum / count;
+        results.jitterRmsMs = std::sqrt(sumOfSquares / count);
+        results.maxJitterMs = maxDeviation;
+    }
+    else{
+        results.error = "too few audio callbacks to measure";
+    }
+}
+
+int LatencyTester::findBurstInRecording() const
+{
+    //cross-correlate the recording with the burst in the frequency domain
+    const size_t totalLength = recording.size() + testSound.size();
+    int order = 1;
+    while ((static_cast<size_t>(1) << order) < totalLength){
+        ++order;
+    }
+
+    dsp::FFT fft(order);
+    const size_t size = static_cast<size_t>(fft.getSize());
+
+    std::vector<dsp::Complex<float>> recorded(size), burst(size), recordedSpectrum(size), burstSpectrum(size);
+    for (size_t i = 0; i < recording.size(); ++i){
+        recorded[i] = recording[i];
+    }
+    for (size_t i = 0; i < testSound.size(); ++i){
+        burst[i] = testSound[i];
+    }
+
+    fft.perform(recorded.data(), recordedSpectrum.data(), false);
+    fft.perform(burst.data(), burstSpectrum.data(), false);
+
+    for (size_t i = 0; i < size; ++i){
+        recordedSpectrum[i] *= std::conj(burstSpectrum[i]);
+    }
+    fft.perform(recordedSpectrum.data(), recorded.data(), true);
+
+    //recorded[lag] now holds the correlation at that lag
+    const size_t maxLag = recording.size() - testSound.size();
+    float best = 0.0f;
+    size_t bestLag = 0;
+    double sumOfMagnitudes = 0.0;
+
+    for (size_t lag = 0; lag <= maxLag; ++lag){
+        const float value = std::abs(recorded[lag].real());
+        sumOfMagnitudes += value;
+        if (value > best){
+            best = value;
+            bestLag = lag;
+        }
+    }
+
+    //the peak has to stand well clear of the noise floor to count
+    const double mean = sumOfMagnitudes / static_cast<double>(maxLag + 1);
+    if (best <= 0.0f || best < mean * 10.0){
+        return -1;
+    }
+    return static_cast<int>(bestLag);
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    LatencyTester.h
+    Created: 19 Oct 2026 12:23:40pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/*
+    Temporary audio callback used by the audio settings panel.
+    A loopback test plays a short noise burst out of the outputs, records the
+    first input channel and finds the burst again by cross-correlation, which
+    gives the real input->output round trip of the current device setup.
+    Every test also timestamps the device callbacks so the callback jitter and
+    xruns of the current buffer size can be reported.
+*/
+class LatencyTester : public AudioIODeviceCallback,
+                      public ChangeBroadcaster,
+                      private Timer
+{
+public:
+    /** what a finished test measured; latencies are in samples, times in ms */
+    struct Results
+    {
+        bool succeeded = false;
+        bool loopback = false;
+        String error;
+
+        double sampleRate = 0.0;
+        int bufferSize = 0;
+
+        int roundTripSamples = -1;
+        int reportedLatencySamples = 0;
+
+        int numCallbacks = 0;
+        double expectedPeriodMs = 0.0;
+        double meanPeriodMs = 0.0;
+        double jitterRmsMs = 0.0;
+        double maxJitterMs = 0.0;
+        int xruns = 0;
+
+        /** true when the buffer size kept up with the device for the whole test */
+        bool isSafe() const;
+        /** multi-line, human readable summary */
+        String toString() const;
+    };
+
+    LatencyTester(AudioDeviceManager& deviceManager);
+    ~LatencyTester() override;
+
+    /** plays a noise burst and listens for it on the first input (needs an output->input cable) */
+    void startLoopbackTest();
+    /** only records callback timing and xruns for the given duration, no inputs needed */
+    void startJitterTest(int durationMs);
+    /** stops a running test without reporting results */
+    void cancel();
+
+    bool isRunning() const;
+    /** results of the last finished test, sendChangeMessage() is called when they change */
+    const Results& getResults() const;
+
+    //AudioIODeviceCallback functions, called by the AudioDeviceManager:
+    void audioDeviceIOCallback(const float** inputChannelData,
+                               int numInputChannels,
+                               float** outputChannelData,
+                               int numOutputChannels,
+                               int numSamples) override;
+    void audioDeviceAboutToStart(AudioIODevice* device) override;
+    void audioDeviceStopped() override;
+
+private:
+    enum Phase
+    {
+        idle,
+        running,
+        finished
+    };
+
+    void start(bool isLoopback, int durationMs);
+    /** polls the audio thread for the end of the test and analyses the captured data */
+    void timerCallback() override;
+    void analyseCallbackTimes();
+    /** finds the lag of the test burst in the recording, -1 when nothing stands out */
+    int findBurstInRecording() const;
+
+    AudioDeviceManager& deviceManager;
+
+    //written by the message thread before the callback is added, read by the audio thread
+    std::vector<float> testSound;
+    std::vector<float> recording;
+    std::vector<int64> callbackTicks;
+    bool loopbackMode = false;
+    int64 testDurationTicks = 0;
+
+    //audio thread state
+    std::atomic<int> phase{ idle };
+    std::atomic<int> numCallbackTicks{ 0 };
+    std::atomic<int> callbackBufferSize{ 0 };
+    int playPosition = 0;
+    int recordPosition = 0;
+    int64 startTicks = 0;
+
+    int xrunsAtStart = 0;
+    uint32 testStartedMs = 0;
+    uint32 testTimeoutMs = 0;
+    Results results;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyTester)
+};
@@ -0,0 +1,1364 @@
+/*
+  ==============================================================================
+
+    LibraryStore.cpp
+    Created: 19 Oct 2026 12:37:41pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "LibraryStore.h"
+#include "StartupTrace.h"
+#include "MemoryMonitor.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace
+{
+    const int snapshotMagic = 0x534c544f; //"OTLS"
+    const int journalMagic = 0x4a4c544f;  //"OTLJ"
+    //version 2 added the time of each change (used as the date a track was added),
+    //version 3 made the snapshot a table of fixed size rows so it can be used straight from a mapped file,
+    //version 4 added the length and play count of each track (a stats record in the journal),
+    //version 5 the tags read from each file (a tags record), version 6 the rating (a rating record)
+    const int formatVersion = 6;
+    const int journalVersion = 5;
+
+    //snapshot: magic, version, generation, next id, number of rows, size of the paths (with the tags, from version 5)
+    const size_t snapshotHeaderSize = 32;
+    //snapshot row: id, date added, offset and size of the path (UTF-8, no terminator),
+    //then from version 4 the length in milliseconds and the play count,
+    //then from version 5 offset and size of the tags (0 if they haven't been read), stored with the paths,
+    //then from version 6 the rating
+    const size_t snapshotRowSize = 44;
+    const size_t version5RowSize = 40;
+    const size_t version4RowSize = 32;
+    const size_t version3RowSize = 24;
+
+    //a broken tag can be megabytes long, journal records are kept under 64 KB
+    const int maxTagLength = 1024;
+
+    MemoryBlock writeTags(const TagReader::Tags& tags)
+    {
+        MemoryOutputStream out;
+        for (const String* text : { &tags.title, &tags.artist, &tags.album, &tags.genre }){
+            out.writeString(text->substring(0, maxTagLength));
+        }
+        out.writeInt(tags.year);
+        out.writeDouble(tags.bpm);
+        out.writeByte(static_cast<char>(tags.key));
+        return out.getMemoryBlock();
+    }
+
+    TagReader::Tags readTags(const void* data, size_t size)
+    {
+        MemoryInputStream in(data, size, false);
+        TagReader::Tags tags;
+        for (String* text : { &tags.title, &tags.artist, &tags.album, &tags.genre }){
+            *text = in.readString();
+        }
+        tags.year = in.readInt();
+        tags.bpm = in.readDouble();
+        tags.key = jlimit(0, 24, static_cast<int>(in.readByte()));
+        return tags;
+    }
+
+    //compact once the journal holds this many records, or half the library if that is more
+    const int minRecordsBeforeCompaction = 1000;
+
+    //standard CRC-32 (same polynomial as zip)
+    uint32 crc32(const void* data, size_t numBytes, uint32 crc = 0)
+    {
+        static const auto table = [] {
+            std::vector<uint32> t(256);
+            for (uint32 i = 0; i < 256; ++i){
+                uint32 c = i;
+                for (int k = 0; k < 8; ++k){
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        crc = ~crc;
+        auto* bytes = static_cast<const uint8*>(data);
+        for (size_t i = 0; i < numBytes; ++i){
+            crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+}
+
+
+//==============================================================================
+struct LibraryStore::Snapshot
+{
+    std::unique_ptr<MemoryMappedFile> mappedFile;
+    //only used if the file could not be mapped
+    MemoryBlock data;
+
+    const uint8* start = nullptr;
+    size_t size = 0;
+    int version = 0;
+
+    //the rest is only set for version 3 and later
+    int64 generation = 0;
+    int64 nextId = 0;
+    int numRows = 0;
+    size_t rowSize = snapshotRowSize;
+    const uint8* rows = nullptr;
+    const char* paths = nullptr;
+    size_t pathsSize = 0;
+
+    /** maps a snapshot file and checks its layout (not its checksum); nullptr if it isn't one */
+    static std::shared_ptr<Snapshot> open(const File& file)
+    {
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->mappedFile.reset(new MemoryMappedFile(file, MemoryMappedFile::readOnly));
+        if (snapshot->mappedFile->getData() != nullptr){
+            snapshot->start = static_cast<const uint8*>(snapshot->mappedFile->getData());
+            snapshot->size = snapshot->mappedFile->getSize();
+        }
+        else{
+            snapshot->mappedFile.reset();
+            if (!file.loadFileAsData(snapshot->data)){
+                return nullptr;
+            }
+            snapshot->start = static_cast<const uint8*>(snapshot->data.getData());
+            snapshot->size = snapshot->data.getSize();
+        }
+        return snapshot->parseHeader() ? snapshot : nullptr;
+    }
+
+    /** a snapshot kept in memory, when the file could not be written or mapped */
+    static std::shared_ptr<Snapshot> fromData(const void* bytes, size_t numBytes)
+    {
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->data.append(bytes, numBytes);
+        snapshot->start = static_cast<const uint8*>(snapshot->data.getData());
+        snapshot->size = snapshot->data.getSize();
+        return snapshot->parseHeader() ? snapshot : nullptr;
+    }
+
+    bool parseHeader()
+    {
+        if (start == nullptr || size < 8 + sizeof(uint32) || static_cast<int>(ByteOrder::littleEndianInt(start)) != snapshotMagic){
+            return false;
+        }
+        version = static_cast<int>(ByteOrder::littleEndianInt(start + 4));
+        if (version < 1 || version > formatVersion){
+            return false;
+        }
+        if (version < 3){
+            return true; //read as a whole by loadOldSnapshot()
+        }
+
+        if (size < snapshotHeaderSize + sizeof(uint32)){
+            return false;
+        }
+        generation = static_cast<int64>(ByteOrder::littleEndianInt64(start + 8));
+        nextId = static_cast<int64>(ByteOrder::littleEndianInt64(start + 16));
+        const int rowCount = static_cast<int>(ByteOrder::littleEndianInt(start + 24));
+        const uint64 pathBytes = ByteOrder::littleEndianInt(start + 28);
+        rowSize = version >= 6 ? snapshotRowSize
+                : version >= 5 ? version5RowSize
+                : version >= 4 ? version4RowSize : version3RowSize;
+        if (rowCount < 0 || snapshotHeaderSize + static_cast<uint64>(rowCount) * rowSize + pathBytes + sizeof(uint32) != size){
+            return false;
+        }
+        numRows = rowCount;
+        rows = start + snapshotHeaderSize;
+        paths = reinterpret_cast<const char*>(rows + static_cast<size_t>(numRows) * rowSize);
+        pathsSize = static_cast<size_t>(pathBytes);
+        return true;
+    }
+
+    /** the checksum covers the whole file, so it is only checked in the background */
+    bool isIntact() const
+    {
+        const size_t bodySize = size - sizeof(uint32);
+        return crc32(start, bodySize) == ByteOrder::littleEndianInt(start + bodySize);
+    }
+
+    int64 getId(int row) const
+    {
+        return static_cast<int64>(ByteOrder::littleEndianInt64(rows + static_cast<size_t>(row) * rowSize));
+    }
+
+    int64 getDateAdded(int row) const
+    {
+        return static_cast<int64>(ByteOrder::littleEndianInt64(rows + static_cast<size_t>(row) * rowSize + 8));
+    }
+
+    /** in milliseconds; 0 for a version 3 snapshot, whose tracks are probed again */
+    uint32 getLengthMs(int row) const
+    {
+        return version >= 4 ? ByteOrder::littleEndianInt(rows + static_cast<size_t>(row) * rowSize + 24) : 0;
+    }
+
+    int getPlayCount(int row) const
+    {
+        return version >= 4 ? static_cast<int>(ByteOrder::littleEndianInt(rows + static_cast<size_t>(row) * rowSize + 28)) : 0;
+    }
+
+    int getRating(int row) const
+    {
+        return version >= 6 ? jlimit(0, 5, static_cast<int>(ByteOrder::littleEndianInt(rows + static_cast<size_t>(row) * rowSize + 40))) : 0;
+    }
+
+    /** the UTF-8 bytes of a row's path; nothing if the row points outside the paths */
+    void getPathBytes(int row, const char*& path, size_t& pathSize) const
+    {
+        getBytes(row, 16, path, pathSize);
+    }
+
+    /** the stored tags of a row; nothing if they haven't been read (or it is an older snapshot) */
+    void getTagBytes(int row, const char*& tags, size_t& tagsSize) const
+    {
+        if (version < 5){
+            tags = paths;
+            tagsSize = 0;
+            return;
+        }
+        getBytes(row, 32, tags, tagsSize);
+    }
+
+    /** bytes after the rows, at the offset and size stored at a position in a row */
+    void getBytes(int row, size_t position, const char*& bytes, size_t& numBytes) const
+    {
+        const uint8* rowData = rows + static_cast<size_t>(row) * rowSize;
+        const size_t offset = ByteOrder::littleEndianInt(rowData + position);
+        numBytes = ByteOrder::littleEndianInt(rowData + position + 4);
+        if (offset > pathsSize || numBytes > pathsSize - offset){
+            numBytes = 0;
+        }
+        bytes = paths + (numBytes > 0 ? offset : 0);
+    }
+
+    String getPath(int row) const
+    {
+        const char* path;
+        size_t pathSize;
+        getPathBytes(row, path, pathSize);
+        return String::fromUTF8(path, static_cast<int>(pathSize));
+    }
+
+    /** rows are in id order, so this is a binary search; -1 if there is no such row */
+    int findRow(int64 id) const
+    {
+        int low = 0;
+        int high = numRows;
+        while (low < high){
+            const int middle = low + (high - low) / 2;
+            if (getId(middle) < id){
+                low = middle + 1;
+            }
+            else{
+                high = middle;
+            }
+        }
+        return low < numRows && getId(low) == id ? low : -1;
+    }
+};
+
+//==============================================================================
+/** builds the path lookup, checks the snapshot's checksum and looks for missing files on a pool thread */
+class LibraryStore::CheckJob : public ThreadPoolJob
+{
+public:
+    CheckJob(LibraryStore& _owner,
+             std::shared_ptr<const Snapshot> _snapshot,
+             const std::vector<int>& _snapshotRows,
+             bool _someSnapshotRowsRemoved,
+             std::vector<std::pair<int64, String>> _addedTracks,
+             int _changeNumber)
+            : ThreadPoolJob("Library check"),
+              owner(&_owner),
+              snapshot(std::move(_snapshot)),
+              snapshotRows(_snapshotRows),
+              someSnapshotRowsRemoved(_someSnapshotRowsRemoved),
+              addedTracks(std::move(_addedTracks)),
+              changeNumber(_changeNumber)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        StartupTrace::ScopedPhase phase("library check");
+
+        const bool snapshotIntact = snapshot == nullptr || snapshot->isIntact();
+
+        auto paths = std::make_shared<PathIndex>();
+        size_t pathBytes = 0;
+        std::vector<int64> missing;
+        auto check = [&] (int64 id, const String& path) {
+            if (paths->emplace(path, id).second){
+                pathBytes += MemoryMonitor::getStringBytes(path);
+            }
+            const File file = File::isAbsolutePath(path) ? File(path) : File();
+            if (!file.existsAsFile()){
+                missing.push_back(id);
+            }
+        };
+
+        const int numSnapshotRows = snapshot == nullptr ? 0
+                                  : someSnapshotRowsRemoved ? static_cast<int>(snapshotRows.size()) : snapshot->numRows;
+        for (int i = 0; i < numSnapshotRows; ++i){
+            if ((i & 255) == 0 && shouldExit()){
+                return jobHasFinished;
+            }
+            const int row = someSnapshotRowsRemoved ? snapshotRows[static_cast<size_t>(i)] : i;
+            check(snapshot->getId(row), snapshot->getPath(row));
+        }
+        for (const auto& track : addedTracks){
+            check(track.first, track.second);
+        }
+
+        //hand the results over on the message thread, if the store still exists
+        WeakReference<LibraryStore> store = owner;
+        int number = changeNumber;
+        std::shared_ptr<const Snapshot> checked = snapshot;
+        MessageManager::callAsync([store, number, paths, pathBytes, missing, checked, snapshotIntact] {
+            if (auto* s = store.get()){
+                s->checkFinished(number, paths, pathBytes, missing, checked, snapshotIntact);
+            }
+        });
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const LibraryStore* store) const
+    {
+        return owner.get() == store;
+    }
+
+private:
+    WeakReference<LibraryStore> owner;
+    //kept mapped by this reference until the job is done
+    std::shared_ptr<const Snapshot> snapshot;
+    std::vector<int> snapshotRows;
+    bool someSnapshotRowsRemoved;
+    std::vector<std::pair<int64, String>> addedTracks;
+    int changeNumber;
+};
+
+//==============================================================================
+LibraryStore::LibraryStore(const File& _directory, ThreadPool& _threadPool)
+                          : directory(_directory),
+                            snapshotFile(_directory.getChildFile("library.snapshot")),
+                            journalFile(_directory.getChildFile("library.journal")),
+                            threadPool(_threadPool)
+{
+}
+
+LibraryStore::~LibraryStore()
+{
+    //the pool is shared, so only this store's job is stopped
+    struct OwnJobs : public ThreadPool::JobSelector
+    {
+        const LibraryStore* store;
+        bool isJobSuitable(ThreadPoolJob* job) override
+        {
+            auto* checkJob = dynamic_cast<CheckJob*>(job);
+            return checkJob != nullptr && checkJob->belongsTo(store);
+        }
+    };
+    OwnJobs selector;
+    selector.store = this;
+    threadPool.removeAllJobs(true, 5000, &selector);
+
+    masterReference.clear();
+
+    //nothing is compacted here: the journal is replayed next time, and a few records
+    //(a play count ...) aren't worth rewriting the whole snapshot on every quit
+}
+
+bool LibraryStore::open(const File& legacyPlaylist)
+{
+    if (!directory.createDirectory()){
+        std::cout << "LibraryStore::open could not create " << directory.getFullPathName() << std::endl;
+        return false;
+    }
+
+    const bool isNewLibrary = !snapshotFile.existsAsFile() && !journalFile.existsAsFile();
+
+    const bool snapshotLoaded = loadSnapshot();
+    if (!snapshotLoaded && snapshotFile.existsAsFile()){
+        //the next compaction would write over it, and it may still be read by hand
+        setAside(snapshotFile, true);
+        std::cout << "LibraryStore::open snapshot is damaged, using the journal only" << std::endl;
+    }
+    replayJournal(!snapshotLoaded);
+
+    //an old format snapshot or journal is rewritten in the current format first, so it is never lost
+    if (needsCompaction){
+        needsCompaction = false;
+        if (!compact()){
+            return false;
+        }
+    }
+    if (journal == nullptr && !startNewJournal()){
+        return false;
+    }
+
+    //first run after the update: bring over the old plain text playlist
+    if (isNewLibrary && legacyPlaylist.existsAsFile()){
+        StringArray paths;
+        legacyPlaylist.readLines(paths);
+        paths.removeEmptyStrings();
+
+        Array<File> files;
+        for (const String& path : paths){
+            if (File::isAbsolutePath(path)){
+                files.add(File(path));
+            }
+        }
+        addTracks(files);
+        compact();
+    }
+
+    startCheck();
+    return true;
+}
+
+//==============================================================================
+int LibraryStore::getNumTracks() const
+{
+    //sweeps the removed tracks first, so addedIds is only looked at after it
+    const int numSnapshotTracks = getNumSnapshotTracks();
+    return numSnapshotTracks + static_cast<int>(addedIds.size());
+}
+
+int LibraryStore::getNumSnapshotTracks() const
+{
+    dropTombstones();
+    if (snapshot == nullptr){
+        return 0;
+    }
+    return snapshotRowsRemoved ? static_cast<int>(liveSnapshotRows.size()) : snapshot->numRows;
+}
+
+int LibraryStore::getSnapshotRow(int index) const
+{
+    return snapshotRowsRemoved ? liveSnapshotRows[static_cast<size_t>(index)] : index;
+}
+
+int64 LibraryStore::getTrackId(int index) const
+{
+    const int numSnapshotTracks = getNumSnapshotTracks();
+    if (index < numSnapshotTracks){
+        return snapshot->getId(getSnapshotRow(index));
+    }
+    return addedIds[static_cast<size_t>(index - numSnapshotTracks)];
+}
+
+const LibraryStore::Track& LibraryStore::getTrack(int index) const
+{
+    auto found = trackCache.find(getTrackId(index));
+    if (found != trackCache.end()){
+        return found->second;
+    }
+    //tracks added since the snapshot are always made already, so this one is from the snapshot
+    return makeSnapshotTrack(getSnapshotRow(index));
+}
+
+LibraryStore::Track LibraryStore::readTrack(int index) const
+{
+    auto found = trackCache.find(getTrackId(index));
+    if (found != trackCache.end()){
+        return found->second;
+    }
+    return readSnapshotTrack(getSnapshotRow(index));
+}
+
+LibraryStore::Track LibraryStore::readSnapshotTrack(int row) const
+{
+    const String path = snapshot->getPath(row);
+
+    Track track;
+    track.id = snapshot->getId(row);
+    track.file = File::isAbsolutePath(path) ? File(path) : File();
+    track.title = track.file.getFileNameWithoutExtension();
+    track.dateAdded = snapshot->getDateAdded(row);
+    track.length = snapshot->getLengthMs(row) / 1000.0;
+    track.playCount = snapshot->getPlayCount(row);
+    track.rating = snapshot->getRating(row);
+
+    const char* tags;
+    size_t tagsSize;
+    snapshot->getTagBytes(row, tags, tagsSize);
+    if (tagsSize > 0){
+        track.tags = readTags(tags, tagsSize);
+        track.hasTags = true;
+    }
+    return track;
+}
+
+const LibraryStore::Track& LibraryStore::makeSnapshotTrack(int row) const
+{
+    Track track = readSnapshotTrack(row);
+    trackBytes += getTrackBytes(track);
+    return trackCache.emplace(track.id, std::move(track)).first->second;
+}
+
+int LibraryStore::getIndexAfter(int64 id) const
+{
+    //ids increase with the index, so this is a binary search
+    int low = 0;
+    int high = getNumTracks();
+    while (low < high){
+        const int middle = low + (high - low) / 2;
+        if (getTrackId(middle) <= id){
+            low = middle + 1;
+        }
+        else{
+            high = middle;
+        }
+    }
+    return low;
+}
+
+const LibraryStore::Track* LibraryStore::findTrack(int64 id) const
+{
+    //only tracks still in the library are kept made
+    auto found = trackCache.find(id);
+    if (found != trackCache.end()){
+        return &found->second;
+    }
+    const int row = findSnapshotRow(id);
+    return row >= 0 ? &makeSnapshotTrack(row) : nullptr;
+}
+
+int LibraryStore::findSnapshotRow(int64 id) const
+{
+    if (snapshot == nullptr){
+        return -1;
+    }
+    if (tombstones.count(id) > 0){
+        return -1;
+    }
+    const int row = snapshot->findRow(id);
+    if (row < 0 || (snapshotRowsRemoved && !std::binary_search(liveSnapshotRows.begin(), liveSnapshotRows.end(), row))){
+        return -1;
+    }
+    return row;
+}
+
+const LibraryStore::PathIndex& LibraryStore::getPathIndex() const
+{
+    //normally the background check has made it already
+    if (idsByPath == nullptr){
+        auto paths = std::make_shared<PathIndex>();
+        paths->reserve(static_cast<size_t>(getNumTracks()));
+        pathBytes = 0;
+        auto add = [&] (const String& path, int64 id) {
+            if (paths->emplace(path, id).second){
+                pathBytes += MemoryMonitor::getStringBytes(path);
+            }
+        };
+        for (int i = 0; i < getNumSnapshotTracks(); ++i){
+            const int row = getSnapshotRow(i);
+            add(snapshot->getPath(row), snapshot->getId(row));
+        }
+        for (int64 id : addedIds){
+            add(trackCache.at(id).file.getFullPathName(), id);
+        }
+        idsByPath = paths;
+    }
+    return *idsByPath;
+}
+
+bool LibraryStore::contains(const File& file) const
+{
+    return getPathIndex().count(file.getFullPathName()) > 0;
+}
+
+int64 LibraryStore::getId(const File& file) const
+{
+    const PathIndex& paths = getPathIndex();
+    auto found = paths.find(file.getFullPathName());
+    return found != paths.end() ? found->second : 0;
+}
+
+Array<File> LibraryStore::getFilesIn(const File& folder) const
+{
+    Array<File> files;
+
+    //snapshot paths are compared as bytes, only the ones inside the folder are turned into Files
+    const String folderPath = File::addTrailingSeparator(folder.getFullPathName());
+    const size_t prefixSize = folderPath.getNumBytesAsUTF8();
+    for (int i = 0; i < getNumSnapshotTracks(); ++i){
+        const int row = getSnapshotRow(i);
+        const char* path;
+        size_t pathSize;
+        snapshot->getPathBytes(row, path, pathSize);
+        if (pathSize > prefixSize && memcmp(path, folderPath.toRawUTF8(), prefixSize) == 0){
+            files.add(File(snapshot->getPath(row)));
+        }
+    }
+    for (int64 id : addedIds){
+        const File& file = trackCache.at(id).file;
+        if (file.isAChildOf(folder)){
+            files.add(file);
+        }
+    }
+    return files;
+}
+
+bool LibraryStore::isMissing(int64 id) const
+{
+    return missingIds.count(id) > 0;
+}
+
+int64 LibraryStore::addTrack(const File& file)
+{
+    const PathIndex& paths = getPathIndex();
+    auto found = paths.find(file.getFullPathName());
+    if (found != paths.end()){
+        return found->second;
+    }
+
+    const int64 id = nextId;
+    const int64 now = Time::currentTimeMillis();
+    applyAdd(id, file, now);
+    appendRecord(addRecord, id, now, file.getFullPathName());
+    return id;
+}
+
+void LibraryStore::addTracks(const Array<File>& files)
+{
+    batching = true;
+    for (const File& file : files){
+        addTrack(file);
+    }
+    batching = false;
+    flushJournal();
+}
+
+void LibraryStore::removeTrack(const File& file)
+{
+    const int64 id = getId(file);
+    if (id == 0){
+        return;
+    }
+    applyRemove({ id });
+    appendRecord(removeRecord, id, Time::currentTimeMillis(), {});
+}
+
+void LibraryStore::removeTracks(const Array<File>& files)
+{
+    //a single flush of the journal for the whole batch
+    std::unordered_set<int64> ids;
+    batching = true;
+    for (const File& file : files){
+        const int64 id = getId(file);
+        if (id != 0 && ids.insert(id).second){
+            appendRecord(removeRecord, id, Time::currentTimeMillis(), {});
+        }
+    }
+    batching = false;
+
+    applyRemove(ids);
+    flushJournal();
+}
+
+void LibraryStore::clear()
+{
+    applyClear();
+    appendRecord(clearRecord, 0, Time::currentTimeMillis(), {});
+}
+
+void LibraryStore::setLength(int64 id, double seconds)
+{
+    //the length shown is rounded to seconds, so a length probed again after a compaction isn't a change
+    if (const Track* track = findTrack(id)){
+        if (std::abs(track->length - seconds) >= 0.001){
+            updateStats(id, seconds, track->playCount);
+        }
+    }
+}
+
+void LibraryStore::incrementPlayCount(int64 id)
+{
+    if (const Track* track = findTrack(id)){
+        updateStats(id, track->length, track->playCount + 1);
+    }
+}
+
+void LibraryStore::setRating(int64 id, int rating)
+{
+    rating = jlimit(0, 5, rating);
+    if (const Track* track = findTrack(id)){
+        if (track->rating != rating){
+            applyRating(id, rating);
+            MemoryOutputStream value;
+            value.writeByte(static_cast<char>(rating));
+            appendRecord(ratingRecord, id, Time::currentTimeMillis(), value.getMemoryBlock());
+        }
+    }
+}
+
+void LibraryStore::setTags(const std::vector<TagReader::Result>& results)
+{
+    batching = true;
+    for (const TagReader::Result& result : results){
+        if (findTrack(result.id) != nullptr){
+            applyTags(result.id, result.tags);
+            appendRecord(tagsRecord, result.id, Time::currentTimeMillis(), writeTags(result.tags));
+        }
+    }
+    batching = false;
+    flushJournal();
+}
+
+void LibraryStore::updateStats(int64 id, double length, int playCount)
+{
+    applyStats(id, length, playCount);
+
+    MemoryOutputStream stats;
+    stats.writeDouble(length);
+    stats.writeInt(playCount);
+    appendRecord(statsRecord, id, Time::currentTimeMillis(), stats.getMemoryBlock());
+}
+
+const File& LibraryStore::getDirectory() const
+{
+    return directory;
+}
+
+//==============================================================================
+void LibraryStore::applyAdd(int64 id, const File& file, int64 dateAdded)
+{
+    Track track;
+    track.id = id;
+    track.file = file;
+    track.title = file.getFileNameWithoutExtension();
+    track.dateAdded = dateAdded;
+    trackBytes += getTrackBytes(track);
+    trackCache[id] = track;
+    addedIds.push_back(id);
+
+    if (idsByPath != nullptr){
+        auto inserted = idsByPath->emplace(file.getFullPathName(), id);
+        if (inserted.second){
+            pathBytes += MemoryMonitor::getStringBytes(inserted.first->first);
+        }
+        else{
+            inserted.first->second = id;
+        }
+    }
+    nextId = jmax(nextId, id + 1);
+    ++changeNumber;
+}
+
+void LibraryStore::applyRemove(const std::unordered_set<int64>& ids)
+{
+    for (int64 id : ids){
+        //the path is needed for the lookup, so this comes before the track goes
+        const int row = findSnapshotRow(id);
+        auto found = trackCache.find(id);
+        if (found == trackCache.end() && row < 0){
+            continue; //not in the library (tracks added since the snapshot are always made)
+        }
+
+        if (idsByPath != nullptr){
+            const String path = found != trackCache.end() ? found->second.file.getFullPathName() : snapshot->getPath(row);
+            if (idsByPath->erase(path) > 0){
+                pathBytes -= jmin(pathBytes, MemoryMonitor::getStringBytes(path));
+            }
+        }
+        if (found != trackCache.end()){
+            trackBytes -= jmin(trackBytes, getTrackBytes(found->second));
+            trackCache.erase(found);
+        }
+        missingIds.erase(id);
+        changedSnapshotTracks.erase(id);
+
+        //only marked here, so replaying a journal full of removals isn't a pass over the library each
+        tombstones.insert(id);
+    }
+    ++changeNumber;
+}
+
+void LibraryStore::applyStats(int64 id, double length, int playCount)
+{
+    if (findTrack(id) == nullptr){
+        return;
+    }
+    Track& track = trackCache.at(id);
+    track.length = length;
+    track.playCount = playCount;
+
+    //the row on disk is out of date now, so the track is kept made until the next compaction
+    if (findSnapshotRow(id) >= 0){
+        changedSnapshotTracks.insert(id);
+    }
+}
+
+void LibraryStore::applyTags(int64 id, const TagReader::Tags& tags)
+{
+    if (findTrack(id) == nullptr){
+        return;
+    }
+    Track& track = trackCache.at(id);
+    trackBytes -= jmin(trackBytes, getTrackBytes(track));
+    track.tags = tags;
+    track.hasTags = true;
+    trackBytes += getTrackBytes(track);
+
+    if (findSnapshotRow(id) >= 0){
+        changedSnapshotTracks.insert(id);
+    }
+}
+
+void LibraryStore::applyRating(int64 id, int rating)
+{
+    if (findTrack(id) == nullptr){
+        return;
+    }
+    trackCache.at(id).rating = jlimit(0, 5, rating);
+
+    if (findSnapshotRow(id) >= 0){
+        changedSnapshotTracks.insert(id);
+    }
+}
+
+void LibraryStore::dropTombstones() const
+{
+    if (tombstones.empty()){
+        return;
+    }
+
+    const size_t numAdded = addedIds.size();
+    addedIds.erase(std::remove_if(addedIds.begin(), addedIds.end(), [this] (int64 id) {
+        return tombstones.count(id) > 0;
+    }), addedIds.end());
+
+    //the rest were snapshot tracks
+    if (numAdded - addedIds.size() < tombstones.size() && snapshot != nullptr){
+        //the first removal lists the snapshot's rows, from then on removals take rows out of the list
+        if (!snapshotRowsRemoved){
+            liveSnapshotRows.resize(static_cast<size_t>(snapshot->numRows));
+            for (int row = 0; row < snapshot->numRows; ++row){
+                liveSnapshotRows[static_cast<size_t>(row)] = row;
+            }
+            snapshotRowsRemoved = true;
+        }
+        const Snapshot& rows = *snapshot;
+        liveSnapshotRows.erase(std::remove_if(liveSnapshotRows.begin(), liveSnapshotRows.end(), [this, &rows] (int row) {
+            return tombstones.count(rows.getId(row)) > 0;
+        }), liveSnapshotRows.end());
+    }
+    tombstones.clear();
+}
+
+void LibraryStore::applyClear()
+{
+    //the snapshot file stays until the next compaction, but none of its tracks are in the library now
+    snapshot.reset();
+    liveSnapshotRows.clear();
+    snapshotRowsRemoved = false;
+    addedIds.clear();
+    tombstones.clear();
+    trackCache.clear();
+    changedSnapshotTracks.clear();
+    trackBytes = 0;
+    idsByPath = std::make_shared<PathIndex>();
+    pathBytes = 0;
+    missingIds.clear();
+    ++changeNumber;
+}
+
+//==============================================================================
+bool LibraryStore::loadSnapshot()
+{
+    if (!snapshotFile.existsAsFile()){
+        return false;
+    }
+
+    std::shared_ptr<Snapshot> opened = Snapshot::open(snapshotFile);
+    if (opened == nullptr){
+        return false;
+    }
+
+    //an older snapshot is read as a whole and then rewritten in the current format by open()
+    if (opened->version < 3){
+        needsCompaction = loadOldSnapshot(opened->start, opened->size);
+        return needsCompaction;
+    }
+
+    //nothing is read here: rows are looked at when they are needed, the checksum by the background check
+    snapshot = opened;
+    snapshotChecked = false;
+    generation = opened->generation;
+    nextId = jmax(nextId, opened->nextId);
+    return true;
+}
+
+bool LibraryStore::loadOldSnapshot(const void* data, size_t size)
+{
+    //the last 4 bytes are the checksum of everything before them
+    const size_t bodySize = size - sizeof(uint32);
+    const uint32 storedCrc = ByteOrder::littleEndianInt(static_cast<const char*>(data) + bodySize);
+    if (crc32(data, bodySize) != storedCrc){
+        return false;
+    }
+
+    MemoryInputStream in(data, bodySize, false);
+    if (in.readInt() != snapshotMagic){
+        return false;
+    }
+    const int version = in.readInt();
+
+    const int64 snapshotGeneration = in.readInt64();
+    const int64 snapshotNextId = in.readInt64();
+    const int numTracks = in.readInt();
+    if (numTracks < 0){
+        return false;
+    }
+
+    for (int i = 0; i < numTracks && !in.isExhausted(); ++i){
+        const int64 id = in.readInt64();
+        const int64 dateAdded = version >= 2 ? in.readInt64() : 0;
+        applyAdd(id, File(in.readString()), dateAdded);
+    }
+
+    generation = snapshotGeneration;
+    nextId = jmax(nextId, snapshotNextId);
+    return true;
+}
+
+void LibraryStore::replayJournal(bool anyGeneration)
+{
+    //read in one go, like the snapshot
+    MemoryBlock data;
+    if (!journalFile.existsAsFile() || !journalFile.loadFileAsData(data)){
+        return;
+    }
+    MemoryInputStream in(data, false);
+
+    if (in.readInt() != journalMagic){
+        return;
+    }
+    const int version = in.readInt();
+    if (version < 1 || version > journalVersion){
+        return;
+    }
+    const int64 journalGeneration = in.readInt64();
+    if (journalGeneration != generation){
+        if (!anyGeneration){
+            //from before the last snapshot: everything in it is in the snapshot already
+            return;
+        }
+        //the snapshot it was written on top of is gone, so its changes are all that is left;
+        //the journal is appended to from here, a copy keeps it as it was
+        setAside(journalFile, false);
+        generation = journalGeneration;
+    }
+
+    //replay up to the last complete record; a crash can leave a torn one at the end
+    int64 lastGoodPosition = in.getPosition();
+    int numRecords = 0;
+    for (;;){
+        const int type = in.readByte();
+        const int64 id = in.readInt64();
+        const int64 time = version >= 2 ? in.readInt64() : 0;
+        const int pathSize = in.readInt();
+        if (in.isExhausted() || pathSize < 0 || pathSize > 65536){
+            break;
+        }
+
+        MemoryBlock path;
+        if (in.readIntoMemoryBlock(path, pathSize) != static_cast<size_t>(pathSize)){
+            break;
+        }
+        const uint32 storedCrc = static_cast<uint32>(in.readInt());
+
+        MemoryOutputStream header;
+        header.writeByte(static_cast<char>(type));
+        header.writeInt64(id);
+        if (version >= 2){
+            header.writeInt64(time);
+        }
+        header.writeInt(pathSize);
+        const uint32 crc = crc32(path.getData(), path.getSize(), crc32(header.getData(), header.getDataSize()));
+        if (crc != storedCrc){
+            break;
+        }
+
+        if (type == addRecord){
+            //ids are never reused, so an add at or below the next id is already in the library
+            if (id >= nextId){
+                applyAdd(id, File(path.toString()), time);
+            }
+        }
+        else if (type == removeRecord){
+            applyRemove({ id });
+        }
+        else if (type == clearRecord){
+            applyClear();
+        }
+        else if (type == statsRecord){
+            MemoryInputStream stats(path, false);
+            const double length = stats.readDouble();
+            const int playCount = stats.readInt();
+            applyStats(id, length, playCount);
+        }
+        else if (type == tagsRecord){
+            applyTags(id, readTags(path.getData(), path.getSize()));
+        }
+        else if (type == ratingRecord){
+            applyRating(id, path.getSize() > 0 ? static_cast<int>(path[0]) : 0);
+        }
+        else{
+            break;
+        }
+
+        lastGoodPosition = in.getPosition();
+        ++numRecords;
+    }
+
+    //an older format is not appended to; open() starts a new journal and compacts
+    if (version != journalVersion){
+        needsCompaction = true;
+        return;
+    }
+
+    //keep appending to this journal, cutting off anything damaged at the end first
+    std::unique_ptr<FileOutputStream> out (new FileOutputStream(journalFile));
+    if (out->openedOk() && out->setPosition(lastGoodPosition) && out->truncate().wasOk()){
+        journal = std::move(out);
+        numJournalRecords = numRecords;
+    }
+}
+
+File LibraryStore::setAside(const File& file, bool move)
+{
+    const File aside = file.getSiblingFile(file.getFileName() + ".damaged-"
+                                           + Time::getCurrentTime().formatted("%Y%m%d-%H%M%S")).getNonexistentSibling();
+    if (!(move ? file.moveFileTo(aside) : file.copyFileTo(aside))){
+        std::cout << "LibraryStore::setAside could not keep " << file.getFullPathName() << std::endl;
+    }
+    return aside;
+}
+
+bool LibraryStore::startNewJournal()
+{
+    journal.reset();
+
+    //an empty journal for the current generation, swapped in atomically
+    TemporaryFile temp(journalFile);
+    {
+        FileOutputStream out(temp.getFile());
+        if (!out.openedOk()){
+            return false;
+        }
+        out.writeInt(journalMagic);
+        out.writeInt(journalVersion);
+        out.writeInt64(generation);
+        out.flush();
+        if (out.getStatus().failed()){
+            return false;
+        }
+    }
+    if (!temp.overwriteTargetFileWithTemporary()){
+        std::cout << "LibraryStore::startNewJournal could not write " << journalFile.getFullPathName() << std::endl;
+        return false;
+    }
+
+    std::unique_ptr<FileOutputStream> out (new FileOutputStream(journalFile));
+    if (!out->openedOk()){
+        return false;
+    }
+    journal = std::move(out);
+    numJournalRecords = 0;
+    return true;
+}
+
+void LibraryStore::appendRecord(RecordType type, int64 id, int64 time, const String& path)
+{
+    appendRecord(type, id, time, MemoryBlock(path.toRawUTF8(), path.getNumBytesAsUTF8()));
+}
+
+void LibraryStore::appendRecord(RecordType type, int64 id, int64 time, const MemoryBlock& data)
+{
+    if (journal == nullptr){
+        return;
+    }
+
+    //the path of an add, the values of a stats, tags or rating record
+    MemoryOutputStream record;
+    record.writeByte(static_cast<char>(type));
+    record.writeInt64(id);
+    record.writeInt64(time);
+    record.writeInt(static_cast<int>(data.getSize()));
+    record.write(data.getData(), data.getSize());
+    record.writeInt(static_cast<int>(crc32(record.getData(), record.getDataSize())));
+
+    //one write per record, so a crash can only ever tear the last one
+    journal->write(record.getData(), record.getDataSize());
+    ++numJournalRecords;
+
+    if (!batching){
+        flushJournal();
+    }
+}
+
+void LibraryStore::flushJournal()
+{
+    if (journal == nullptr){
+        return;
+    }
+    journal->flush();
+
+    if (numJournalRecords >= jmax(minRecordsBeforeCompaction, getNumTracks() / 2)){
+        compact();
+    }
+}
+
+bool LibraryStore::compact()
+{
+    //the rows are copied as they are, so a damaged snapshot would come out of this with a good checksum
+    if (snapshotDamaged){
+        return false;
+    }
+    if (snapshot != nullptr && !snapshotChecked){
+        //compacting reads the whole file anyway, so a check still to come isn't waited for
+        if (!snapshot->isIntact()){
+            snapshotCheckFailed();
+            return false;
+        }
+        snapshotChecked = true;
+    }
+
+    //rows and paths (with the tags) are gathered separately and put together at the end
+    MemoryOutputStream rows;
+    MemoryOutputStream paths;
+    const int numTracks = getNumTracks();
+    const int numSnapshotTracks = getNumSnapshotTracks();
+    for (int i = 0; i < numTracks; ++i){
+        int64 id;
+        int64 dateAdded;
+        uint32 lengthMs;
+        int playCount;
+        int rating;
+        const char* path;
+        size_t pathSize;
+        const char* tags;
+        size_t tagsSize;
+        String addedPath;
+        MemoryBlock addedTags;
+        const int row = i < numSnapshotTracks ? getSnapshotRow(i) : -1;
+        if (row >= 0 && changedSnapshotTracks.count(snapshot->getId(row)) == 0){
+            //copied as bytes, without making the Track
+            id = snapshot->getId(row);
+            dateAdded = snapshot->getDateAdded(row);
+            lengthMs = snapshot->getLengthMs(row);
+            playCount = snapshot->getPlayCount(row);
+            rating = snapshot->getRating(row);
+            snapshot->getPathBytes(row, path, pathSize);
+            snapshot->getTagBytes(row, tags, tagsSize);
+        }
+        else{
+            const Track& track = trackCache.at(row >= 0 ? snapshot->getId(row)
+                                                        : addedIds[static_cast<size_t>(i - numSnapshotTracks)]);
+            id = track.id;
+            dateAdded = track.dateAdded;
+            lengthMs = static_cast<uint32>(roundToInt(track.length * 1000.0));
+            playCount = track.playCount;
+            rating = track.rating;
+            addedPath = track.file.getFullPathName();
+            path = addedPath.toRawUTF8();
+            pathSize = addedPath.getNumBytesAsUTF8();
+            if (track.hasTags){
+                addedTags = writeTags(track.tags);
+            }
+            tags = static_cast<const char*>(addedTags.getData());
+            tagsSize = addedTags.getSize();
+        }
+        rows.writeInt64(id);
+        rows.writeInt64(dateAdded);
+        rows.writeInt(static_cast<int>(paths.getDataSize()));
+        rows.writeInt(static_cast<int>(pathSize));
+        rows.writeInt(static_cast<int>(lengthMs));
+        rows.writeInt(playCount);
+        paths.write(path, pathSize);
+        rows.writeInt(static_cast<int>(paths.getDataSize()));
+        rows.writeInt(static_cast<int>(tagsSize));
+        if (tagsSize > 0){
+            paths.write(tags, tagsSize);
+        }
+        rows.writeInt(rating);
+    }
+
+    MemoryOutputStream out;
+    out.writeInt(snapshotMagic);
+    out.writeInt(formatVersion);
+    out.writeInt64(generation + 1);
+    out.writeInt64(nextId);
+    out.writeInt(numTracks);
+    out.writeInt(static_cast<int>(paths.getDataSize()));
+    out.write(rows.getData(), rows.getDataSize());
+    out.write(paths.getData(), paths.getDataSize());
+    out.writeInt(static_cast<int>(crc32(out.getData(), out.getDataSize())));
+
+    //written next to the old snapshot and renamed over it, so there is always a complete one
+    TemporaryFile temp(snapshotFile);
+    {
+        FileOutputStream file(temp.getFile());
+        if (!file.openedOk()){
+            return false;
+        }
+        file.write(out.getData(), out.getDataSize());
+        file.flush();
+        if (file.getStatus().failed()){
+            return false;
+        }
+    }
+
+    //a mapped file can't be replaced on Windows, so the old snapshot is let go of first
+    snapshot.reset();
+    const bool written = temp.overwriteTargetFileWithTemporary();
+
+    snapshotChecked = true;
+
+    //every track is in the new snapshot, so nothing is left on top of it; if the file could not be
+    //replaced the old snapshot and journal on disk still hold the same tracks, so it is used from memory
+    std::shared_ptr<const Snapshot> newSnapshot = written ? Snapshot::open(snapshotFile) : nullptr;
+    snapshot = newSnapshot != nullptr ? newSnapshot : Snapshot::fromData(out.getData(), out.getDataSize());
+    liveSnapshotRows.clear();
+    snapshotRowsRemoved = false;
+    addedIds.clear();
+    changedSnapshotTracks.clear();
+
+    if (!written){
+        std::cout << "LibraryStore::compact could not write " << snapshotFile.getFullPathName() << std::endl;
+        return false;
+    }
+
+    //the old journal is now covered by the snapshot, even if we crash before replacing it
+    ++generation;
+    return startNewJournal();
+}
+
+//==============================================================================
+size_t LibraryStore::getMemoryUsage() const
+{
+    //only a snapshot that could not be mapped is held on the heap
+    size_t bytes = snapshot != nullptr ? snapshot->data.getSize() : 0;
+    bytes += MemoryMonitor::getVectorBytes(liveSnapshotRows) + MemoryMonitor::getVectorBytes(addedIds)
+           + MemoryMonitor::getHashBytes(trackCache) + MemoryMonitor::getHashBytes(missingIds)
+           + MemoryMonitor::getHashBytes(changedSnapshotTracks) + trackBytes;
+    if (idsByPath != nullptr){
+        bytes += MemoryMonitor::getHashBytes(*idsByPath) + pathBytes;
+    }
+    return bytes;
+}
+
+void LibraryStore::trimMemory(size_t targetBytes)
+{
+    //tracks added or changed since the snapshot are only kept here, so they stay
+    size_t bytes = getMemoryUsage();
+    for (auto it = trackCache.begin(); it != trackCache.end() && bytes > targetBytes;){
+        if (findSnapshotRow(it->first) >= 0 && changedSnapshotTracks.count(it->first) == 0){
+            bytes -= jmin(bytes, getTrackBytes(it->second) + sizeof(*it) + 2 * sizeof(void*));
+            trackBytes -= jmin(trackBytes, getTrackBytes(it->second));
+            it = trackCache.erase(it);
+        }
+        else{
+            ++it;
+        }
+    }
+}
+
+size_t LibraryStore::getTrackBytes(const Track& track)
+{
+    return MemoryMonitor::getStringBytes(track.file.getFullPathName()) + MemoryMonitor::getStringBytes(track.title)
+         + MemoryMonitor::getStringBytes(track.tags.title) + MemoryMonitor::getStringBytes(track.tags.artist)
+         + MemoryMonitor::getStringBytes(track.tags.album) + MemoryMonitor::getStringBytes(track.tags.genre);
+}
+
+//==============================================================================
+void LibraryStore::startCheck()
+{
+    dropTombstones();
+    std::vector<std::pair<int64, String>> added;
+    added.reserve(addedIds.size());
+    for (int64 id : addedIds){
+        added.emplace_back(id, trackCache.at(id).file.getFullPathName());
+    }
+    threadPool.addJob(new CheckJob(*this, snapshot, liveSnapshotRows, snapshotRowsRemoved, std::move(added), changeNumber), true);
+}
+
+bool LibraryStore::rebuildFromJournal()
+{
+    //the journal only holds the changes since the snapshot, so the tracks added since are what is left
+    journal.reset();
+    const int64 lastId = nextId;
+    applyClear();
+    nextId = 1;
+    replayJournal(true);
+    //ids are never reused, the playlist indexes rely on it
+    nextId = jmax(nextId, lastId);
+    snapshotDamaged = false;
+
+    //the damaged file was copied aside, so it can be written over now
+    const bool saved = compact();
+    startCheck();
+    return saved;
+}
+
+void LibraryStore::keepDamagedSnapshot()
+{
+    snapshotDamaged = false;
+    snapshotChecked = true;
+}
+
+void LibraryStore::snapshotCheckFailed()
+{
+    if (snapshotDamaged){
+        return;
+    }
+    snapshotDamaged = true;
+
+    //copied, the file is still mapped and in use
+    const File copy = setAside(snapshotFile, false);
+    std::cout << "LibraryStore::snapshotCheckFailed the snapshot checksum doesn't match, kept a copy as "
+              << copy.getFullPathName() << std::endl;
+    listeners.call([&copy] (Listener& l) { l.snapshotDamaged(copy); });
+}
+
+void LibraryStore::checkFinished(int number, std::shared_ptr<PathIndex> paths, size_t checkedPathBytes,
+                                 const std::vector<int64>& missing, std::shared_ptr<const Snapshot> checkedSnapshot,
+                                 bool snapshotIntact)
+{
+    //a compaction since the job started has checked (or written) the snapshot in use itself
+    if (checkedSnapshot != nullptr && checkedSnapshot == snapshot){
+        if (snapshotIntact){
+            snapshotChecked = true;
+        }
+        else{
+            snapshotCheckFailed();
+        }
+    }
+
+    //a lookup from before a change would be out of date; one is made on the spot instead when needed
+    if (number == changeNumber && idsByPath == nullptr){
+        idsByPath = paths;
+        pathBytes = checkedPathBytes;
+    }
+    missingIds.insert(missing.begin(), missing.end());
+
+    listeners.call([] (Listener& l) { l.libraryChecked(); });
+}
+
+void LibraryStore::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void LibraryStore::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
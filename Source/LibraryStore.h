@@ -0,0 +1,256 @@
+/*
+  ==============================================================================
+
+    LibraryStore.h
+    Created: 19 Oct 2026 12:37:41pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "TagReader.h"
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//==============================================================================
+/*
+    On-disk track library (replaces playlist.txt).
+    Every change is appended straight away to a journal as one small record
+    with a checksum, so a crash loses nothing and a change costs the same
+    whatever the size of the library. Only once the journal has grown past
+    half the library (never just because the store is closed) is everything
+    compacted into a snapshot, which is written next to the old one and
+    renamed over it.
+    A journal belongs to one snapshot generation; a journal left over from an
+    older generation was already folded into the snapshot and is ignored.
+    If the snapshot is damaged it is moved aside (and the journal copied)
+    rather than written over, and whatever the journal holds is replayed.
+    A snapshot whose checksum turns out wrong is copied aside and never
+    compacted over (that would give the damage a good checksum) until the
+    listener has it rebuilt from the journal or kept as it is.
+    The snapshot is a table of fixed size rows (id, date added, where the
+    path is, length, play count, where the tags are, rating) followed by the paths
+    and tags, so loading only maps the file into
+    memory and replays the journal (stopping at the first torn or corrupt
+    record); opening costs the same whatever the size of the library.
+    A removal only marks the track; the track lists are swept once, the next
+    time they are used, so removing costs the same at any size.
+    A Track (with its File) is only made the first time it is asked for,
+    e.g. when its row is scrolled into view. The path lookup, the snapshot
+    checksum and the check for files that have gone missing are done by a
+    job on the background ThreadPool once the library is open.
+    Only used from the message thread; listeners are told on the message thread.
+*/
+class LibraryStore
+{
+public:
+    struct Track
+    {
+        //stable for the life of the library, never reused
+        int64 id = 0;
+        File file;
+        //file name without the extension, made once so painting the playlist doesn't build it
+        String title;
+        //milliseconds since 1970, 0 if unknown (libraries from before this was stored)
+        int64 dateAdded = 0;
+        //seconds, 0 until the file has been probed
+        double length = 0.0;
+        int playCount = 0;
+        //0 (not rated) to 5 stars
+        int rating = 0;
+        //as read from the file; hasTags is false until they have been (empty tags are kept too)
+        TagReader::Tags tags;
+        bool hasTags = false;
+    };
+
+    /** hash of a full path name, for hash containers keyed by path */
+    struct PathHash
+    {
+        size_t operator() (const String& path) const noexcept { return static_cast<size_t>(path.hashCode64()); }
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called once the background check started by open() is done; isMissing() is up to date from then on */
+        virtual void libraryChecked() = 0;
+        /** called when the snapshot's checksum doesn't match; copy is where the damaged file was kept */
+        virtual void snapshotDamaged(const File& copy) {}
+    };
+
+    LibraryStore(const File& directory, ThreadPool& threadPool);
+    ~LibraryStore();
+
+    /** maps the snapshot and replays the journal; imports the old playlist.txt the first time */
+    bool open(const File& legacyPlaylist);
+
+    /** tracks are kept in the order they were added, which is also increasing id order */
+    int getNumTracks() const;
+    /** the track at an index; made from the snapshot the first time it is asked for */
+    const Track& getTrack(int index) const;
+    /** the track at an index, made without keeping it (for going over every track once) */
+    Track readTrack(int index) const;
+    /** id of the track at an index, without making the track */
+    int64 getTrackId(int index) const;
+    /** index of the first track with an id above this one (getNumTracks() if there is none) */
+    int getIndexAfter(int64 id) const;
+
+    /** the track with this id, or nullptr */
+    const Track* findTrack(int64 id) const;
+
+    /** the path lookup is made by the background check; used before that, it is made on the spot */
+    bool contains(const File& file) const;
+    /** id of a track in the library, or 0 */
+    int64 getId(const File& file) const;
+
+    /** files of the tracks inside a folder, found without making every track */
+    Array<File> getFilesIn(const File& folder) const;
+
+    /** true if the background check found that the track's file is gone */
+    bool isMissing(int64 id) const;
+
+    /** adds a track and returns its id (or the id it already had) */
+    int64 addTrack(const File& file);
+    /** adds several tracks with a single flush of the journal */
+    void addTracks(const Array<File>& files);
+    void removeTrack(const File& file);
+    /** removes several tracks in one pass, with a single flush of the journal */
+    void removeTracks(const Array<File>& files);
+    void clear();
+
+    /** keeps the length probed for a track, so it isn't probed again next session */
+    void setLength(int64 id, double seconds);
+    /** counts one more play of a track */
+    void incrementPlayCount(int64 id);
+    /** 0 (not rated) to 5 stars */
+    void setRating(int64 id, int rating);
+    /** keeps the tags read for a batch of tracks (with a single flush of the journal), so they aren't read again */
+    void setTags(const std::vector<TagReader::Result>& results);
+
+    /** where the snapshot and journal are kept */
+    const File& getDirectory() const;
+
+    /** folds the journal into a new snapshot; refused while the snapshot is damaged */
+    bool compact();
+
+    /** after snapshotDamaged(): drops the snapshot and keeps the tracks in the journal */
+    bool rebuildFromJournal();
+    /** after snapshotDamaged(): goes on with the snapshot as it reads, compacting over it again */
+    void keepDamagedSnapshot();
+
+    /** estimated bytes held in memory; the mapped snapshot is paged by the system and not counted */
+    size_t getMemoryUsage() const;
+    /** drops Tracks made from the snapshot (they are made again when asked for) until no more than targetBytes are held */
+    void trimMemory(size_t targetBytes);
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    class CheckJob;
+    /** the snapshot file, mapped into memory (or read, if it can't be mapped) */
+    struct Snapshot;
+    using PathIndex = std::unordered_map<String, int64, PathHash>;
+
+    enum RecordType
+    {
+        addRecord = 1,
+        removeRecord = 2,
+        clearRecord = 3,
+        //length and play count of a track
+        statsRecord = 4,
+        tagsRecord = 5,
+        ratingRecord = 6
+    };
+
+    bool loadSnapshot();
+    bool loadOldSnapshot(const void* data, size_t size);
+    /** anyGeneration: there is no snapshot, so a journal written on top of one is replayed too */
+    void replayJournal(bool anyGeneration);
+    /** moves (or copies) a damaged file to library.xxx.damaged-<date> so it is never written over */
+    static File setAside(const File& file, bool move);
+    bool startNewJournal();
+    void appendRecord(RecordType type, int64 id, int64 time, const String& path);
+    void appendRecord(RecordType type, int64 id, int64 time, const MemoryBlock& data);
+    void flushJournal();
+
+    void applyAdd(int64 id, const File& file, int64 dateAdded);
+    void applyRemove(const std::unordered_set<int64>& ids);
+    void applyClear();
+    void applyStats(int64 id, double length, int playCount);
+    void applyTags(int64 id, const TagReader::Tags& tags);
+    void applyRating(int64 id, int rating);
+    void updateStats(int64 id, double length, int playCount);
+
+    /** snapshot row of a track still in the library, or -1 */
+    int findSnapshotRow(int64 id) const;
+    int getNumSnapshotTracks() const;
+    /** takes the removed tracks out of addedIds and liveSnapshotRows */
+    void dropTombstones() const;
+    /** snapshot row of the track at an index below getNumSnapshotTracks() */
+    int getSnapshotRow(int index) const;
+    Track readSnapshotTrack(int row) const;
+    /** makes the Track of a snapshot row and keeps it in trackCache */
+    const Track& makeSnapshotTrack(int row) const;
+    static size_t getTrackBytes(const Track& track);
+    const PathIndex& getPathIndex() const;
+
+    void startCheck();
+    /** called on the message thread by the finished CheckJob */
+    void checkFinished(int changeNumber, std::shared_ptr<PathIndex> paths, size_t pathBytes,
+                       const std::vector<int64>& missing, std::shared_ptr<const Snapshot> checkedSnapshot,
+                       bool snapshotIntact);
+    /** keeps a copy of the damaged snapshot and stops compacting over it */
+    void snapshotCheckFailed();
+
+    File directory;
+    File snapshotFile;
+    File journalFile;
+    ThreadPool& threadPool;
+
+    //tracks of the last snapshot; shared with the check job, so it stays mapped while the job reads it
+    std::shared_ptr<const Snapshot> snapshot;
+    //its checksum was checked (or it was written by this session)
+    bool snapshotChecked = false;
+    //its checksum doesn't match, and the listener hasn't said what to do yet
+    bool snapshotDamaged = false;
+    //snapshot rows still in the library, once one of them has been removed
+    mutable std::vector<int> liveSnapshotRows;
+    mutable bool snapshotRowsRemoved = false;
+    //tracks added since the snapshot, in id order (so all after the snapshot's)
+    mutable std::vector<int64> addedIds;
+    //removed, but still in the two lists above until dropTombstones()
+    mutable std::unordered_set<int64> tombstones;
+    //every track made so far, by id; node based, so a Track stays put while others come and go
+    mutable std::unordered_map<int64, Track> trackCache;
+    //snapshot tracks whose length, play count, tags or rating changed since; kept in trackCache until the next compaction
+    std::unordered_set<int64> changedSnapshotTracks;
+    //full path name -> id; hashed, so checking for a duplicate path costs the same at any size
+    mutable std::shared_ptr<PathIndex> idsByPath;
+    //text of the made tracks and of the paths in the lookup, kept up to date so counting doesn't walk them
+    mutable size_t trackBytes = 0;
+    mutable size_t pathBytes = 0;
+    std::unordered_set<int64> missingIds;
+    int64 nextId = 1;
+    //counts every change, so a check that started before one is not used for the path lookup
+    int changeNumber = 0;
+
+    int64 generation = 0;
+    std::unique_ptr<FileOutputStream> journal;
+    int numJournalRecords = 0;
+    //set when the journal on disk has an older format
+    bool needsCompaction = false;
+    //while adding several tracks, the journal is flushed once at the end
+    bool batching = false;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (LibraryStore)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LibraryStore)
+};
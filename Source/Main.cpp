@@ -10,6 +10,9 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainComponent.h"
+#include "StartupTrace.h"
+#include "ControlSession.h"
+#include "PluginScanner.h"
 
 //==============================================================================
 class OtoDecksApplication  : public JUCEApplication
@@ -25,7 +28,31 @@ public:
     void initialise (const String& commandLine) override
     {
         // This method is where you should put your application's initialisation code..
+        // --startup-trace logs how long each startup phase takes
+        StartupTrace::begin (commandLine);
 
+        // --render-session <file> [--render-output <wav>] renders a recorded session offline
+        // (no window, no audio device), writes the report next to it and quits
+        const StringArray args = StringArray::fromTokens (commandLine, true);
+
+        // --scan-plugin <format> <file> <output> is the PluginScanner's child process:
+        // it opens one plugin, writes what it found and quits (a crash only takes this process down)
+        if (args.contains ("--scan-plugin"))
+        {
+            setApplicationReturnValue (PluginScanner::scanInChildProcess (args));
+            quit();
+            return;
+        }
+
+        const int renderArg = args.indexOf ("--render-session");
+        if (renderArg >= 0)
+        {
+            renderSession (args, renderArg);
+            quit();
+            return;
+        }
+
+        StartupTrace::ScopedPhase phase ("main window");
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
@@ -36,6 +63,21 @@ public:
         mainWindow = nullptr; // (deletes our window)
     }
 
+    void renderSession (const StringArray& args, int renderArg)
+    {
+        AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        const File sessionFile = File::getCurrentWorkingDirectory().getChildFile (args[renderArg + 1].unquoted());
+        const int outputArg = args.indexOf ("--render-output");
+        const File outputFile = outputArg >= 0 ? File::getCurrentWorkingDirectory().getChildFile (args[outputArg + 1].unquoted())
+                                               : File();
+
+        const ControlSession::Metrics metrics = ControlSession::renderOffline (sessionFile, formatManager, renderBlockSize, outputFile);
+        if (metrics.numBlocks > 0)
+            ControlSession::writeReport (sessionFile, "offline", metrics);
+    }
+
     //==============================================================================
     void systemRequestedQuit() override
     {
@@ -75,6 +117,7 @@ public:
            #endif
 
             setVisible (true);
+            StartupTrace::mark ("main window visible");
         }
 
         void closeButtonPressed() override
@@ -97,6 +140,9 @@ public:
     };
 
 private:
+    //same as the usual device block size, so offline timings compare with live ones
+    static constexpr int renderBlockSize = 512;
+
     std::unique_ptr<MainWindow> mainWindow;
 };
 
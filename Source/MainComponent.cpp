@@ -7,33 +7,147 @@
 */
 
 #include "MainComponent.h"
+#include "StartupTrace.h"
 
 //==============================================================================
 MainComponent::MainComponent()
 {
+    //the members (decks, waveform displays, library and playlist) are built by now
+    StartupTrace::mark("decks and playlist built");
+
     // Make sure you set the size of the component after
     // you add any child components.
     setSize (800, 600);
 
-    // Some platforms require permissions to open input channels so request that here
-    if (RuntimePermissions::isRequired (RuntimePermissions::recordAudio)
-        && ! RuntimePermissions::isGranted (RuntimePermissions::recordAudio))
-    {
-        RuntimePermissions::request (RuntimePermissions::recordAudio,
-                                     [&] (bool granted) { if (granted)  setAudioChannels (2, 2); });
-    }  
-    else
-    {
-        // Specify the number of input and output channels that we want to open
-        setAudioChannels (0, 2);
-    }  
+    //the disk cache is sized on the background threads while the window comes up
+    waveformCache.warmUp();
+
+    //settings are stored in the user's application data folder
+    PropertiesFile::Options options;
+    options.applicationName = ProjectInfo::projectName;
+    options.filenameSuffix = ".settings";
+    options.folderName = ProjectInfo::projectName;
+    options.osxLibrarySubFolder = "Application Support";
+    appProperties.setStorageParameters(options);
+
+    //the audio device is opened after the first paint, see paintOverChildren()
+
+    addMemorySubsystems();
 
     addAndMakeVisible(deckGUI1); 
     addAndMakeVisible(deckGUI2);  
 
     addAndMakeVisible(playlistComponent);
 
-    formatManager.registerBasicFormats();
+    //settings button sits on top of the playlist title bar
+    addAndMakeVisible(settingsButton);
+    settingsButton.addListener(this);
+    settingsButton.setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+    settingsButton.setColour(TextButton::textColourOffId, Colours::white);
+    settingsButton.setLookAndFeel(&buttonLookAndFeel);
+
+    //MIDI learn, next to the audio settings where the controller's input is enabled
+    addAndMakeVisible(midiButton);
+    midiButton.addListener(this);
+    midiButton.setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+    midiButton.setColour(TextButton::textColourOffId, Colours::white);
+    midiButton.setLookAndFeel(&buttonLookAndFeel);
+    midiController.start();
+
+    //plugin chains: the decks are mixed through them, the plugins are made once the device is open
+    addAndMakeVisible(pluginsButton);
+    pluginsButton.addListener(this);
+    pluginsButton.setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+    pluginsButton.setColour(TextButton::textColourOffId, Colours::white);
+    pluginsButton.setLookAndFeel(&buttonLookAndFeel);
+    pluginFormatManager.addDefaultFormats();
+    if (auto knownPluginsXml = appProperties.getUserSettings()->getXmlValue("knownPlugins")){
+        knownPlugins.recreateFromXml(*knownPluginsXml);
+    }
+    knownPlugins.addChangeListener(this);
+    deckMixer.addDeck(&player1, &leftChain);
+    deckMixer.addDeck(&player2, &rightChain);
+    deckMixer.setMasterChain(&masterChain);
+    for (auto* chain : { &leftChain, &rightChain, &masterChain }){
+        chain->addChangeListener(this);
+    }
+
+    //recorder: format and stem choice are remembered between sessions
+    addAndMakeVisible(recordButton);
+    addAndMakeVisible(stemsButton);
+    addAndMakeVisible(recordFormatBox);
+    addAndMakeVisible(recorderStatusLabel);
+    recordButton.addListener(this);
+    stemsButton.addListener(this);
+    recordButton.setClickingTogglesState(true);
+    stemsButton.setClickingTogglesState(true);
+    stemsButton.setToggleState(appProperties.getUserSettings()->getBoolValue("recordStems", false), dontSendNotification);
+    for (auto* button : { &recordButton, &stemsButton }){
+        button->setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+        button->setColour(TextButton::textColourOffId, Colours::white);
+        button->setColour(TextButton::textColourOnId, Colours::black);
+        button->setLookAndFeel(&buttonLookAndFeel);
+    }
+    recordButton.setColour(TextButton::buttonOnColourId, Colour(255, 64, 64));
+    stemsButton.setColour(TextButton::buttonOnColourId, Colour(229, 204, 255));
+
+    recordFormatBox.addItem("WAV", 1);
+    recordFormatBox.addItem("FLAC", 2);
+    recordFormatBox.setText(appProperties.getUserSettings()->getValue("recordFormat", "WAV"), dontSendNotification);
+    recordFormatBox.onChange = [this] {
+        appProperties.getUserSettings()->setValue("recordFormat", recordFormatBox.getText());
+    };
+
+    recorderStatusLabel.setColour(Label::textColourId, Colours::white);
+    recorderStatusLabel.setJustificationType(Justification::centredRight);
+
+    //each deck feeds its pre-fader signal to the recorder as a stem
+    player1.setRecorder(&mixRecorder, MixRecorder::leftDeckStream);
+    player2.setRecorder(&mixRecorder, MixRecorder::rightDeckStream);
+
+    //--replay-session <file> replays a recorded session (not recording another one);
+    //otherwise the session is recorded, by default into the sessions folder (the last 20 are kept)
+    const StringArray args = JUCEApplicationBase::getCommandLineParameterArray();
+    //the file after a flag; a flag given without one is ignored (an empty name would mean the working folder)
+    auto getSessionArg = [&args] (const String& flag) {
+        const int index = args.indexOf(flag);
+        if (index < 0){
+            return String();
+        }
+        const String value = args[index + 1].unquoted();
+        if (value.isEmpty() || value.startsWith("--")){
+            std::cout << "MainComponent: " << flag << " needs a file, e.g. " << flag << " mix.otosession" << std::endl;
+            std::cout << "usage: OtoDecks [--replay-session <file> | --record-session <file>]" << std::endl;
+            return String();
+        }
+        return value;
+    };
+    const String replayArg = getSessionArg("--replay-session");
+    const String recordArg = getSessionArg("--record-session");
+    if (replayArg.isNotEmpty()){
+        replaySessionFile = File::getCurrentWorkingDirectory().getChildFile(replayArg);
+    }
+    else if (recordArg.isNotEmpty()){
+        controlSession.startRecording(File::getCurrentWorkingDirectory().getChildFile(recordArg));
+    }
+    else{
+        controlSession.startRecording(ControlSession::getSessionsFolder().getChildFile(
+            "session-" + Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".otosession"));
+        ControlSession::deleteOldSessions(20);
+    }
+    player1.setControlSession(&controlSession, 0);
+    player2.setControlSession(&controlSession, 1);
+
+    {
+        StartupTrace::ScopedPhase phase("audio formats");
+        formatManager.registerBasicFormats();
+    }
+
+    //the watcher starts once the library has been checked in the background (see libraryChecked)
+    library.addListener(this);
+
+    //analysis jobs should never compete with the audio or message threads
+    backgroundJobs.setThreadPriorities(3);
 
     //setting different colour scheme for deckGUI2 posSlider and rotary slider
     otherLookAndFeel.setColour(Slider::thumbColourId, Colour(153, 50, 153));
@@ -41,29 +155,62 @@ MainComponent::MainComponent()
     otherLookAndFeel.setColour(Slider::backgroundColourId, Colour(255, 255, 153));
     otherLookAndFeel.setColour(Slider::rotarySliderOutlineColourId, Colour(255, 255, 175));
     deckGUI2.setLookAndFeel(&otherLookAndFeel);
+
+    //added last so it sits on top of everything else
+    addChildComponent(paintProfilerOverlay);
+    addChildComponent(memoryOverlay);
+    setWantsKeyboardFocus(true);
 }
 
 MainComponent::~MainComponent()
 {
+    deviceManager.removeChangeListener(this);
+    library.removeListener(this);
+    settingsButton.setLookAndFeel(nullptr);
+    midiButton.setLookAndFeel(nullptr);
+    pluginsButton.setLookAndFeel(nullptr);
+    knownPlugins.removeChangeListener(this);
+    for (auto* chain : { &leftChain, &rightChain, &masterChain }){
+        chain->removeChangeListener(this);
+    }
+    recordButton.setLookAndFeel(nullptr);
+    stemsButton.setLookAndFeel(nullptr);
+
     // This shuts down the audio device and clears the audio source.
     shutdownAudio();
+    mixRecorder.stop();
+    controlSession.stopReplay();
+    controlSession.stopRecording();
+
+    //with the plugins' state as it is now
+    if (pluginsRestored){
+        appProperties.getUserSettings()->setValue("pluginChainLeft", leftChain.createStateXml().get());
+        appProperties.getUserSettings()->setValue("pluginChainRight", rightChain.createStateXml().get());
+        appProperties.getUserSettings()->setValue("pluginChainMaster", masterChain.createStateXml().get());
+        appProperties.saveIfNeeded();
+    }
 }
 
 //==============================================================================
 void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
-    player1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    player2.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    
-    mixerSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-
-    mixerSource.addInputSource(&player1, false);
-    mixerSource.addInputSource(&player2, false);
+    //prepares the players and the plugin chains too
+    deckMixer.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    mixRecorder.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    controlSession.deviceStarted(sampleRate);
 
+    updateOutputLatency();
  }
 void MainComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
 {
-    mixerSource.getNextAudioBlock(bufferToFill);
+    const double blockStartMs = Time::getMillisecondCounterHiRes();
+    deckMixer.getNextAudioBlock(bufferToFill);
+
+    //only copies into a FIFO, the files are written on the recorder's own thread
+    mixRecorder.pushBlock(MixRecorder::masterStream, *bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+    //advances the session's sample clock, and times the block while a session is replayed
+    controlSession.audioBlockRendered(bufferToFill.numSamples, Time::getMillisecondCounterHiRes() - blockStartMs);
 }
 
 void MainComponent::releaseResources()
@@ -72,9 +219,23 @@ void MainComponent::releaseResources()
     // restarted due to a setting change.
 
     // For more details, see the help for AudioProcessor::releaseResources()
-    player1.releaseResources();
-    player2.releaseResources();
-    mixerSource.releaseResources();
+    deckMixer.releaseResources();
+}
+
+void MainComponent::updateOutputLatency()
+{
+    //a block is heard after the device latency plus the block that is playing now,
+    //and the plugins hold every deck back by the latency of the slowest chain plus the master chain
+    if (auto* device = deviceManager.getCurrentAudioDevice()){
+        const double sampleRate = device->getCurrentSampleRate();
+        if (sampleRate <= 0.0){
+            return;
+        }
+        const int samples = device->getOutputLatencyInSamples() + device->getCurrentBufferSizeSamples()
+                          + deckMixer.getLatencySamples();
+        player1.setOutputLatency(samples / sampleRate);
+        player2.setOutputLatency(samples / sampleRate);
+    }
 }
 
 //==============================================================================
@@ -83,11 +244,302 @@ void MainComponent::paint (Graphics& g)
    
 }
 
+void MainComponent::paintOverChildren (Graphics& g)
+{
+    if (audioDeviceRequested){
+        return;
+    }
+    //the window is up: the device (which can take a while to open) is opened from the next message,
+    //while the library check, tag reading and cache warm-up go on in the background
+    audioDeviceRequested = true;
+    StartupTrace::windowPainted();
+    SafePointer<MainComponent> safeThis(this);
+    MessageManager::callAsync([safeThis] {
+        if (safeThis != nullptr){
+            safeThis->openAudioDevice();
+        }
+    });
+}
+
+void MainComponent::openAudioDevice()
+{
+    StartupTrace::ScopedPhase phase("audio device");
+
+    //reopen the device, sample rate and buffer size picked in the last session
+    std::unique_ptr<XmlElement> savedAudioState (appProperties.getUserSettings()->getXmlValue("audioDeviceState"));
+
+    // Some platforms require permissions to open input channels so request that here
+    if (RuntimePermissions::isRequired (RuntimePermissions::recordAudio)
+        && ! RuntimePermissions::isGranted (RuntimePermissions::recordAudio))
+    {
+        RuntimePermissions::request (RuntimePermissions::recordAudio,
+                                     [&] (bool granted) { if (granted)  setAudioChannels (2, 2); });
+    }  
+    else
+    {
+        // Specify the number of input and output channels that we want to open
+        setAudioChannels (0, 2, savedAudioState.get());
+    }  
+    deviceManager.addChangeListener(this);
+    restorePlugins();
+
+    if (replaySessionFile != File()){
+        controlSession.startReplay(replaySessionFile, player1, player2);
+    }
+}
+
 void MainComponent::resized()
 {
     deckGUI1.setBounds(0, 0, getWidth()/2, getHeight()*3/5);
     deckGUI2.setBounds(getWidth()/2, 0, getWidth()/2, getHeight()*3/5);
     playlistComponent.setBounds(0, getHeight()*3/5, getWidth(), getHeight()*2/5);
 
+    //same height as the playlist label (1/10 of the playlist area)
+    settingsButton.setBounds(0, getHeight()*3/5, getWidth()/8, getHeight()*2/50);
+    recordButton.setBounds(getWidth()/8, getHeight()*3/5, getWidth()/16, getHeight()*2/50);
+    stemsButton.setBounds(getWidth()*3/16, getHeight()*3/5, getWidth()/16, getHeight()*2/50);
+    recordFormatBox.setBounds(getWidth()/4, getHeight()*3/5, getWidth()/12, getHeight()*2/50);
+    midiButton.setBounds(getWidth()/3, getHeight()*3/5, getWidth()/16, getHeight()*2/50);
+    pluginsButton.setBounds(getWidth()*19/48, getHeight()*3/5, getWidth()/12, getHeight()*2/50);
+    recorderStatusLabel.setBounds(getWidth()*5/8, getHeight()*3/5, getWidth()*3/8, getHeight()*2/50);
+
+    paintProfilerOverlay.setBounds(getWidth() - 364, 4, 360, paintProfilerOverlay.getPreferredHeight());
+    memoryOverlay.setBounds(4, 4, 360, memoryOverlay.getPreferredHeight());
+}
+
+void MainComponent::buttonClicked(Button* button)
+{
+    if (button == &settingsButton){
+        showAudioSettings();
+    }
+    if (button == &midiButton){
+        showMidiLearn();
+    }
+    if (button == &pluginsButton){
+        showPlugins();
+    }
+    if (button == &recordButton){
+        toggleRecording();
+    }
+    if (button == &stemsButton){
+        appProperties.getUserSettings()->setValue("recordStems", stemsButton.getToggleState());
+    }
+}
+
+bool MainComponent::keyPressed(const KeyPress& key)
+{
+    if (key == KeyPress::F12Key){
+        paintProfilerOverlay.setActive(!paintProfilerOverlay.isVisible());
+        return true;
+    }
+    if (key == KeyPress::F10Key){
+        memoryOverlay.setActive(!memoryOverlay.isVisible());
+        return true;
+    }
+    if (key == KeyPress::F11Key){
+        PaintProfiler::setRepaintFlashEnabled(!PaintProfiler::isRepaintFlashEnabled());
+        repaint();
+        return true;
+    }
+    return false;
+}
+
+void MainComponent::addMemorySubsystems()
+{
+    //budgets are in MB in the settings file (memoryBudgetWaveformsMB ...); 0 only counts the subsystem
+    auto budget = [this] (const String& key, int defaultMegabytes) {
+        const int megabytes = jmax(0, appProperties.getUserSettings()->getIntValue(key, defaultMegabytes));
+        return static_cast<size_t>(megabytes) * 1024 * 1024;
+    };
+
+    //the caches drop what they can make again
+    memoryMonitor.add("Waveform overviews",
+                      [this] { return waveformCache.getMemoryUsage(); },
+                      [this] (size_t target) { waveformCache.trimMemory(target); },
+                      budget("memoryBudgetWaveformsMB", 256));
+    memoryMonitor.add("Waveform tiles",
+                      [this] { return waveformTiles.getMemoryUsage(); },
+                      [this] (size_t target) { waveformTiles.trimMemory(target); },
+                      budget("memoryBudgetWaveformTilesMB", 64));
+    memoryMonitor.add("Library tracks",
+                      [this] { return library.getMemoryUsage(); },
+                      [this] (size_t target) { library.trimMemory(target); },
+                      budget("memoryBudgetLibraryMB", 64));
+    memoryMonitor.add("Recorder FIFOs",
+                      [this] { return mixRecorder.getMemoryUsage(); },
+                      [this] (size_t target) { mixRecorder.trimMemory(target); },
+                      budget("memoryBudgetRecorderMB", 0));
+
+    //these hold one entry per track and can't drop any, a budget only warns
+    memoryMonitor.add("Track table",
+                      [this] { return trackTable.getMemoryUsage(); }, nullptr,
+                      budget("memoryBudgetTrackTableMB", 0));
+    memoryMonitor.add("Search index",
+                      [this] { return searchIndex.getMemoryUsage(); }, nullptr,
+                      budget("memoryBudgetSearchIndexMB", 0));
+    memoryMonitor.add("Duplicate fingerprints",
+                      [this] { return duplicateFinder.getMemoryUsage(); }, nullptr,
+                      budget("memoryBudgetFingerprintsMB", 0));
+    memoryMonitor.add("Track metadata",
+                      [this] { return metadataScanner.getMemoryUsage(); }, nullptr,
+                      budget("memoryBudgetMetadataMB", 0));
+    memoryMonitor.add("Playlist rows",
+                      [this] { return playlistComponent.getMemoryUsage(); }, nullptr,
+                      budget("memoryBudgetPlaylistMB", 0));
+    memoryMonitor.add("Left deck buffers",
+                      [this] { return player1.getMemoryUsage(); }, nullptr, 0);
+    memoryMonitor.add("Right deck buffers",
+                      [this] { return player2.getMemoryUsage(); }, nullptr, 0);
+}
+
+void MainComponent::libraryChecked()
+{
+    //a rebuilt library is checked again, but the watcher is already running by then
+    if (folderWatcherStarted){
+        return;
+    }
+    folderWatcherStarted = true;
+
+    //the watcher needs the formats to tell music files apart; they were registered in the constructor
+    folderWatcher.start(formatManager.getWildcardForAllFormats().removeCharacters("*"));
+}
+
+void MainComponent::changeListenerCallback(ChangeBroadcaster* source)
+{
+    if (source == &deviceManager){
+        //save the new device setup straight away so a crash does not lose it
+        std::unique_ptr<XmlElement> audioState (deviceManager.createStateXml());
+        if (audioState != nullptr){
+            appProperties.getUserSettings()->setValue("audioDeviceState", audioState.get());
+            appProperties.saveIfNeeded();
+        }
+    }
+    if (source == &knownPlugins){
+        if (auto knownPluginsXml = knownPlugins.createXml()){
+            appProperties.getUserSettings()->setValue("knownPlugins", knownPluginsXml.get());
+        }
+    }
+    if (source == &leftChain || source == &rightChain || source == &masterChain){
+        updateOutputLatency();
+    }
+}
+
+void MainComponent::showAudioSettings()
+{
+    auto* settings = new AudioSettingsComponent(deviceManager);
+    settings->setSize(520, 640);
+
+    DialogWindow::LaunchOptions options;
+    options.content.setOwned(settings);
+    options.dialogTitle = "Audio Settings";
+    options.dialogBackgroundColour = Colour(22, 22, 22);
+    options.escapeKeyTriggersCloseButton = true;
+    options.useNativeTitleBar = true;
+    options.resizable = true;
+    options.launchAsync();
 }
 
+void MainComponent::showMidiLearn()
+{
+    auto* midiLearn = new MidiLearnComponent(midiController);
+    midiLearn->setSize(420, 520);
+
+    DialogWindow::LaunchOptions options;
+    options.content.setOwned(midiLearn);
+    options.dialogTitle = "MIDI Learn";
+    options.dialogBackgroundColour = Colour(22, 22, 22);
+    options.escapeKeyTriggersCloseButton = true;
+    options.useNativeTitleBar = true;
+    options.resizable = true;
+    options.launchAsync();
+}
+
+void MainComponent::showPlugins()
+{
+    auto* plugins = new PluginsComponent(knownPlugins, pluginScanner, leftChain, rightChain, masterChain);
+    plugins->setSize(720, 420);
+
+    DialogWindow::LaunchOptions options;
+    options.content.setOwned(plugins);
+    options.dialogTitle = "Plugins";
+    options.dialogBackgroundColour = Colour(22, 22, 22);
+    options.escapeKeyTriggersCloseButton = true;
+    options.useNativeTitleBar = true;
+    options.resizable = true;
+    options.launchAsync();
+}
+
+void MainComponent::restorePlugins()
+{
+    StartupTrace::ScopedPhase phase("plugin chains");
+
+    const std::pair<PluginChain*, const char*> chains[] = { { &leftChain, "pluginChainLeft" },
+                                                             { &rightChain, "pluginChainRight" },
+                                                             { &masterChain, "pluginChainMaster" } };
+    for (const auto& chain : chains){
+        if (auto xml = appProperties.getUserSettings()->getXmlValue(chain.second)){
+            chain.first->restoreFromXml(*xml);
+        }
+    }
+    pluginsRestored = true;
+
+    //the first time, look for plugins in the background (a scan asked for in the plugins panel retries failures)
+    if (!appProperties.getUserSettings()->getBoolValue("pluginsScanned", false)){
+        appProperties.getUserSettings()->setValue("pluginsScanned", true);
+        pluginScanner.scan(false);
+    }
+}
+
+void MainComponent::toggleRecording()
+{
+    if (mixRecorder.isRecording()){
+        mixRecorder.stop();
+        stopTimer();
+        recordButton.setToggleState(false, dontSendNotification);
+        stemsButton.setEnabled(true);
+        recordFormatBox.setEnabled(true);
+        recorderStatusLabel.setText("saved to " + mixRecorder.getRecordingFolder().getFullPathName(),
+                                    dontSendNotification);
+        return;
+    }
+
+    //every recording gets its own folder, named after the time it started
+    File folder = File::getSpecialLocation(File::userMusicDirectory)
+                      .getChildFile("OtoDecks Recordings")
+                      .getChildFile(Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S"));
+
+    String error = mixRecorder.start(folder, recordFormatBox.getText(), stemsButton.getToggleState());
+    if (error.isNotEmpty()){
+        recordButton.setToggleState(false, dontSendNotification);
+        recorderStatusLabel.setText(error, dontSendNotification);
+        return;
+    }
+
+    stemsButton.setEnabled(false);
+    recordFormatBox.setEnabled(false);
+    lastBytesWritten = 0;
+    lastStatsTime = Time::getMillisecondCounter();
+    startTimer(250);
+}
+
+void MainComponent::timerCallback()
+{
+    auto stats = mixRecorder.getStats();
+    const uint32 now = Time::getMillisecondCounter();
+
+    //disk throughput since the last update
+    const double elapsed = jmax(1u, now - lastStatsTime) / 1000.0;
+    const double megabytesPerSecond = (stats.bytesWritten - lastBytesWritten) / (elapsed * 1024.0 * 1024.0);
+    lastBytesWritten = stats.bytesWritten;
+    lastStatsTime = now;
+
+    const int secs = static_cast<int>(stats.secondsRecorded);
+    String status;
+    status << "REC " << String(secs / 3600).paddedLeft('0', 2) << ":"
+           << String((secs / 60) % 60).paddedLeft('0', 2) << ":"
+           << String(secs % 60).paddedLeft('0', 2)
+           << "  " << String(megabytesPerSecond, 2) << " MB/s"
+           << "  fifo " << roundToInt(stats.peakFifoUsage * 100.0f) << "%"
+           << "  dropped " << stats.droppedBlocks;
+    recorderStatusLabel.setText(status, dontSendNotification);
+}
@@ -12,6 +12,18 @@
 #include "DJAudioPlayer.h"
 #include "DeckGUI.h"
 #include "PlaylistComponent.h"
+#include "AudioSettingsComponent.h"
+#include "MixRecorder.h"
+#include "PaintProfilerOverlay.h"
+#include "MemoryMonitor.h"
+#include "MemoryOverlay.h"
+#include "ControlSession.h"
+#include "MidiController.h"
+#include "MidiLearnComponent.h"
+#include "PluginChain.h"
+#include "PluginScanner.h"
+#include "PluginsComponent.h"
+#include "DeckMixer.h"
 
 
 //==============================================================================
@@ -19,7 +31,11 @@
     This component lives inside our window, and this is where you should put all
     your controls and content.
 */
-class MainComponent   : public AudioAppComponent
+class MainComponent   : public AudioAppComponent,
+                        public Button::Listener,
+                        public ChangeListener,
+                        public Timer,
+                        public LibraryStore::Listener
 {
 public:
     //==============================================================================
@@ -33,29 +49,153 @@ public:
 
     //==============================================================================
     void paint (Graphics& g) override;
+    /** the first call opens the audio device, once the window has been drawn */
+    void paintOverChildren (Graphics& g) override;
     void resized() override;
 
+    /** implement Button::Listener */
+    void buttonClicked (Button* button) override;
+
+    /** called when the audio device setup changes, so it can be saved; also when the plugins or the chains change */
+    void changeListenerCallback (ChangeBroadcaster* source) override;
+
+    /** refreshes the recorder counters while a recording is running */
+    void timerCallback() override;
+
+    /** F12 toggles the paint profiler overlay, F11 the repaint flash, F10 the memory overlay (debugging aids) */
+    bool keyPressed (const KeyPress& key) override;
+
+    /** starts the folder watcher the first time the library has been checked in the background */
+    void libraryChecked() override;
+
 private:
+    /** counts the memory of every subsystem, with the budgets from the settings file */
+    void addMemorySubsystems();
+    /** opens the audio device set up in the last session (or the default one) */
+    void openAudioDevice();
+    /** opens the audio settings panel in a dialog window */
+    void showAudioSettings();
+    /** opens the MIDI learn panel in a dialog window */
+    void showMidiLearn();
+    /** opens the plugin chains panel in a dialog window */
+    void showPlugins();
+    /** makes the plugin chains saved in the last session and scans for plugins the first time */
+    void restorePlugins();
+    /** tells the players when their blocks are heard: device latency, the block playing now, the plugins */
+    void updateOutputLatency();
+    /** starts a new recording of the set, or stops the running one */
+    void toggleRecording();
+
+
     //==============================================================================
     // Your private member variables go here...
      
     LookAndFeel_V4 otherLookAndFeel;
+    LookAndFeel_V2 buttonLookAndFeel;
+
+    //user settings file (audio device setup etc.), kept between sessions
+    ApplicationProperties appProperties;
+
+    TextButton settingsButton{"AUDIO SETTINGS"};
+    TextButton midiButton{"MIDI"};
+    TextButton pluginsButton{"PLUGINS"};
+
+    //set recorder controls, also on the playlist title bar
+    MixRecorder mixRecorder;
+    TextButton recordButton{"REC"};
+    TextButton stemsButton{"STEMS"};
+    ComboBox recordFormatBox;
+    Label recorderStatusLabel;
+    int64 lastBytesWritten = 0;
+    uint32 lastStatsTime = 0;
+
+    //set by the first paint, see paintOverChildren()
+    bool audioDeviceRequested = false;
+
+    //every control call on the decks is recorded, so a set can be replayed to compare builds;
+    //declared before the players, which hold a pointer to it
+    ControlSession controlSession;
+    //set by --replay-session, replayed once the audio device is open
+    File replaySessionFile;
     
     AudioFormatManager formatManager;
-    AudioThumbnailCache thumbCache{100}; 
+
+    //shared worker threads for decoding/analysis, one core is left for audio and UI
+    ThreadPool backgroundJobs{jmax(2, SystemStats::getNumCpus() - 1)};
+
+    //waveform overviews of the last 100 tracks in memory, up to 256 MB more on disk
+    WaveformCache waveformCache{formatManager, backgroundJobs, 100,
+                                File::getSpecialLocation(File::userApplicationDataDirectory)
+                                    .getChildFile(ProjectInfo::projectName).getChildFile("WaveformCache"),
+                                256 * 1024 * 1024};
+
+    //overview waveforms are rasterised into tiles on the background threads
+    WaveformTileRenderer waveformTiles{backgroundJobs, 64};
+
+    //plugins found by the scanner (kept in the settings file) and the chains of each deck and the master bus
+    AudioPluginFormatManager pluginFormatManager;
+    KnownPluginList knownPlugins;
+    PluginScanner pluginScanner{pluginFormatManager, knownPlugins};
+    PluginChain leftChain{pluginFormatManager};
+    PluginChain rightChain{pluginFormatManager};
+    PluginChain masterChain{pluginFormatManager};
+    //set once the chains of the last session have been restored (the plugins still being made are saved
+    //as they were), so a session that quits before the device opens doesn't save empty chains
+    bool pluginsRestored = false;
 
     DJAudioPlayer player1{formatManager};
-    DeckGUI deckGUI1{&player1, formatManager, thumbCache, false}; 
+    DeckGUI deckGUI1{&player1, waveformCache, waveformTiles, false}; 
 
     DJAudioPlayer player2{formatManager};
-    DeckGUI deckGUI2{&player2, formatManager, thumbCache, true};
+    DeckGUI deckGUI2{&player2, waveformCache, waveformTiles, true};
 
-    MixerAudioSource mixerSource; 
+    //hardware controllers: moves go from the MIDI thread straight to the players' audio thread queues
+    MidiController midiController{deviceManager, player1, player2, appProperties};
 
-    DJAudioPlayer metadataPlayer{formatManager};
+    //mixes the decks through their chains (in parallel while they have plugins), then the master chain
+    DeckMixer deckMixer;
+
+    //track lengths etc. for the playlist, probed on the background threads
+    TrackMetadataScanner metadataScanner{formatManager, backgroundJobs};
+    
+    //track library, saved as a journal + snapshot in the user's application data folder;
+    //checked for missing files on the background threads once it is open
+    LibraryStore library{File::getSpecialLocation(File::userApplicationDataDirectory)
+                             .getChildFile(ProjectInfo::projectName).getChildFile("Library"), backgroundJobs};
     
+    //metadata columns of the library tracks (bpm, key, rating ...), for the search filters
+    TrackTable trackTable;
+
+    //trigram index of the track titles; searches start 150 ms after the last keystroke
+    SearchIndex searchIndex{backgroundJobs, trackTable, 150};
+    
+    //acoustic fingerprints of the library tracks, to spot the same song stored twice;
+    //made on a low priority thread of its own and kept on disk
+    DuplicateFinder duplicateFinder{formatManager,
+                                    File::getSpecialLocation(File::userApplicationDataDirectory)
+                                        .getChildFile(ProjectInfo::projectName).getChildFile("Fingerprints")};
+
+    //title, artist, album, genre, year, bpm and key tags, read from the file headers on the background threads
+    TagReader tagReader{formatManager, backgroundJobs};
+
+    //walks dropped folders on the background threads and feeds the playlist
+    TrackImporter importer{formatManager, backgroundJobs, library, metadataScanner};
+
+    //music folders whose changes on disk are brought into the library
+    FolderWatcher folderWatcher{library.getDirectory().getChildFile("WatchedFolders.xml")};
+    bool folderWatcherStarted = false;
+
     //playlist component 
-    PlaylistComponent playlistComponent{&deckGUI1, &deckGUI2, &metadataPlayer};
+    PlaylistComponent playlistComponent{&deckGUI1, &deckGUI2, metadataScanner, library, trackTable, searchIndex, duplicateFinder, tagReader, importer, folderWatcher};
+
+    //memory held by the caches, decks, library and indexes; declared after them, so it goes first
+    MemoryMonitor memoryMonitor;
+
+    //paint timings, hidden until F12 is pressed
+    PaintProfilerOverlay paintProfilerOverlay;
+
+    //memory figures, hidden until F10 is pressed
+    MemoryOverlay memoryOverlay{memoryMonitor};
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
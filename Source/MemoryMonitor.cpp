@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    MemoryMonitor.cpp
+    Created: 19 Oct 2026 1:09:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "MemoryMonitor.h"
+
+//==============================================================================
+MemoryMonitor::MemoryMonitor()
+{
+    startTimer(1000);
+}
+
+MemoryMonitor::~MemoryMonitor()
+{
+    stopTimer();
+}
+
+void MemoryMonitor::add(const String& name,
+                        std::function<size_t()> getBytes,
+                        std::function<void(size_t)> trim,
+                        size_t budget)
+{
+    Subsystem subsystem;
+    subsystem.stats.name = name;
+    subsystem.stats.budget = budget;
+    subsystem.stats.canTrim = trim != nullptr;
+    subsystem.getBytes = std::move(getBytes);
+    subsystem.trim = std::move(trim);
+    subsystems.push_back(std::move(subsystem));
+}
+
+void MemoryMonitor::setBudget(const String& name, size_t budget)
+{
+    for (Subsystem& subsystem : subsystems){
+        if (subsystem.stats.name == name){
+            subsystem.stats.budget = budget;
+            subsystem.reportedOverBudget = false;
+        }
+    }
+}
+
+std::vector<MemoryMonitor::Stats> MemoryMonitor::getStats() const
+{
+    std::vector<Stats> stats;
+    for (const Subsystem& subsystem : subsystems){
+        stats.push_back(subsystem.stats);
+    }
+    return stats;
+}
+
+size_t MemoryMonitor::getTotalBytes() const
+{
+    size_t total = 0;
+    for (const Subsystem& subsystem : subsystems){
+        total += subsystem.stats.bytes;
+    }
+    return total;
+}
+
+String MemoryMonitor::dump() const
+{
+    String text;
+    for (const Subsystem& subsystem : subsystems){
+        const Stats& s = subsystem.stats;
+        text << s.name << ": " << formatBytes(s.bytes) << " (peak " << formatBytes(s.peakBytes);
+        if (s.budget > 0){
+            text << ", budget " << formatBytes(s.budget) << ", trimmed " << s.numTrims << "x";
+        }
+        text << ")\n";
+    }
+    text << "total: " << formatBytes(getTotalBytes()) << "\n";
+    return text;
+}
+
+String MemoryMonitor::formatBytes(size_t bytes)
+{
+    if (bytes >= 1024 * 1024){
+        return String(bytes / (1024.0 * 1024.0), 1) + " MB";
+    }
+    return String(bytes / 1024.0, 1) + " KB";
+}
+
+//==============================================================================
+void MemoryMonitor::timerCallback()
+{
+    for (Subsystem& subsystem : subsystems){
+        check(subsystem);
+    }
+}
+
+void MemoryMonitor::check(Subsystem& subsystem)
+{
+    Stats& stats = subsystem.stats;
+    stats.bytes = subsystem.getBytes();
+    stats.peakBytes = jmax(stats.peakBytes, stats.bytes);
+
+    if (stats.budget == 0 || stats.bytes <= stats.budget){
+        subsystem.reportedOverBudget = false;
+        return;
+    }
+
+    //trimmed to 3/4 of the budget, so it isn't over again after the next few additions
+    if (subsystem.trim != nullptr){
+        subsystem.trim(stats.budget / 4 * 3);
+        ++stats.numTrims;
+        stats.bytes = subsystem.getBytes();
+        if (stats.bytes <= stats.budget){
+            return;
+        }
+    }
+
+    //nothing (more) can be dropped: it is either leaking or the budget is too small for this set
+    if (!subsystem.reportedOverBudget){
+        subsystem.reportedOverBudget = true;
+        std::cout << "MemoryMonitor: " << stats.name << " is over its budget ("
+                  << formatBytes(stats.bytes) << " of " << formatBytes(stats.budget) << ")\n"
+                  << dump() << std::endl;
+    }
+}
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    MemoryMonitor.h
+    Created: 19 Oct 2026 1:09:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+//==============================================================================
+/*
+    Keeps count of the memory held by each subsystem (waveform caches, decks,
+    library, indexes ...) and holds the ones with a budget to it.
+    Every subsystem is added with a function returning its bytes in use and,
+    if it can drop things it can make again, a trim function. Once a second
+    each one is asked for its bytes (the subsystems keep running counts as
+    things come and go, so asking never walks a container); one over its
+    budget is trimmed to 3/4 of the budget (so it doesn't go over again
+    straight away), and one that has no trim function or can't get under its
+    budget is logged, so a leak or a buffer that keeps growing shows up during
+    a set rather than at an out of memory crash. The figures are estimates:
+    containers count their capacity and per-node overhead, not what the
+    allocator really hands out.
+    Message thread only; the functions are always called on the message thread.
+*/
+class MemoryMonitor  : private Timer
+{
+public:
+    struct Stats
+    {
+        String name;
+        size_t bytes = 0;
+        //highest seen since the subsystem was added
+        size_t peakBytes = 0;
+        //0 if there is none
+        size_t budget = 0;
+        //how many times it was trimmed
+        int numTrims = 0;
+        bool canTrim = false;
+    };
+
+    MemoryMonitor();
+    ~MemoryMonitor() override;
+
+    /** adds a subsystem; trim may be empty if it can't drop anything, budget 0 only counts it */
+    void add(const String& name,
+             std::function<size_t()> getBytes,
+             std::function<void(size_t targetBytes)> trim,
+             size_t budget);
+
+    /** 0 removes the budget */
+    void setBudget(const String& name, size_t budget);
+
+    /** the figures of the last check, in the order the subsystems were added */
+    std::vector<Stats> getStats() const;
+    size_t getTotalBytes() const;
+
+    /** one line per subsystem, for the log */
+    String dump() const;
+
+    static String formatBytes(size_t bytes);
+
+    //estimates used by the subsystems' own counting functions
+    static size_t getStringBytes(const String& s)
+    {
+        //the shared text holder has a reference count and its allocated size in front of the text
+        return s.isEmpty() ? 0 : s.getNumBytesAsUTF8() + 1 + 2 * sizeof(size_t);
+    }
+
+    static size_t getStringBytes(const std::string& s)
+    {
+        //short strings live inside the std::string itself
+        return s.capacity() >= sizeof(std::string) ? s.capacity() + 1 : 0;
+    }
+
+    template <typename Type>
+    static size_t getVectorBytes(const std::vector<Type>& v)
+    {
+        return v.capacity() * sizeof(Type);
+    }
+
+    /** buckets plus one node (value and next pointer, cached hash) per element */
+    template <typename HashContainer>
+    static size_t getHashBytes(const HashContainer& c)
+    {
+        return c.bucket_count() * sizeof(void*)
+             + c.size() * (sizeof(typename HashContainer::value_type) + 2 * sizeof(void*));
+    }
+
+    /** one tree node (value, three pointers and the colour) per element */
+    template <typename TreeContainer>
+    static size_t getTreeBytes(const TreeContainer& c)
+    {
+        return c.size() * (sizeof(typename TreeContainer::value_type) + 4 * sizeof(void*));
+    }
+
+private:
+    struct Subsystem
+    {
+        Stats stats;
+        std::function<size_t()> getBytes;
+        std::function<void(size_t)> trim;
+        //so a subsystem stuck over its budget is logged once, not every second
+        bool reportedOverBudget = false;
+    };
+
+    void timerCallback() override;
+    void check(Subsystem& subsystem);
+
+    std::vector<Subsystem> subsystems;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryMonitor)
+};
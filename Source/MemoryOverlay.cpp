@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    MemoryOverlay.cpp
+    Created: 19 Oct 2026 1:09:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MemoryOverlay.h"
+
+//==============================================================================
+MemoryOverlay::MemoryOverlay(MemoryMonitor& _monitor)
+                            : monitor(_monitor)
+{
+    setOpaque(true);
+    setInterceptsMouseClicks(false, false);
+}
+
+MemoryOverlay::~MemoryOverlay()
+{
+    stopTimer();
+}
+
+void MemoryOverlay::paint (Graphics& g)
+{
+    g.fillAll (Colour(12, 12, 12));
+    g.setColour (Colour(0, 245, 245)); //outline colour
+    g.drawRect (getLocalBounds(), 1);
+
+    g.setFont (13.0f);
+    auto area = getLocalBounds().reduced(6, 3);
+    const int nameW = area.getWidth() / 2;
+    const int valueW = (area.getWidth() - nameW) / 3;
+
+    auto drawRow = [&] (const String& name, const String& bytes, const String& peak, const String& budget) {
+        auto row = area.removeFromTop(rowHeight);
+        g.drawText (name, row.removeFromLeft(nameW), Justification::centredLeft, true);
+        g.drawText (bytes, row.removeFromLeft(valueW), Justification::centredRight, true);
+        g.drawText (peak, row.removeFromLeft(valueW), Justification::centredRight, true);
+        g.drawText (budget, row, Justification::centredRight, true);
+    };
+
+    g.setColour (Colour(229, 204, 255));
+    drawRow ("subsystem", "now", "peak", "budget");
+
+    size_t total = 0;
+    for (const auto& s : stats){
+        g.setColour (s.budget > 0 && s.bytes > s.budget ? Colour(255, 64, 64) : Colours::white);
+        drawRow (s.name, MemoryMonitor::formatBytes(s.bytes), MemoryMonitor::formatBytes(s.peakBytes),
+                 s.budget > 0 ? MemoryMonitor::formatBytes(s.budget) : String("-"));
+        total += s.bytes;
+    }
+
+    g.setColour (Colour(0, 255, 127));
+    drawRow ("total", MemoryMonitor::formatBytes(total), "", "");
+}
+
+void MemoryOverlay::timerCallback()
+{
+    const int oldNumRows = static_cast<int>(stats.size());
+    stats = monitor.getStats();
+
+    if (static_cast<int>(stats.size()) != oldNumRows){
+        setSize(getWidth(), getPreferredHeight());
+    }
+    repaint();
+}
+
+void MemoryOverlay::setActive(bool shouldBeActive)
+{
+    setVisible(shouldBeActive);
+
+    if (shouldBeActive){
+        std::cout << "MemoryMonitor:\n" << monitor.dump() << std::endl;
+        stats = monitor.getStats();
+        setSize(getWidth(), getPreferredHeight());
+        startTimer(1000);
+    }
+    else{
+        stopTimer();
+    }
+}
+
+int MemoryOverlay::getPreferredHeight() const
+{
+    //header + one row per subsystem + total
+    return (static_cast<int>(stats.size()) + 2) * rowHeight + 6;
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    MemoryOverlay.h
+    Created: 19 Oct 2026 1:09:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MemoryMonitor.h"
+
+//==============================================================================
+/*
+    Small table on top of the UI with the MemoryMonitor figures: the bytes
+    held by each subsystem, the most it has held and its budget, with
+    anything over budget in red. Refreshes once a second. Opaque, like the
+    PaintProfilerOverlay, so refreshing it never repaints what is underneath.
+*/
+class MemoryOverlay  : public Component,
+                       public Timer
+{
+public:
+    MemoryOverlay(MemoryMonitor& monitor);
+    ~MemoryOverlay();
+
+    void paint (Graphics&) override;
+
+    void timerCallback() override;
+
+    /** shows the overlay (and writes the figures to the log), or hides it */
+    void setActive(bool shouldBeActive);
+
+    /** height needed for the current number of rows */
+    int getPreferredHeight() const;
+
+private:
+    MemoryMonitor& monitor;
+    std::vector<MemoryMonitor::Stats> stats;
+
+    static constexpr int rowHeight = 16;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MemoryOverlay)
+};
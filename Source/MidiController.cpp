@@ -0,0 +1,272 @@
+/*
+  ==============================================================================
+
+    MidiController.cpp
+    Created: 19 Oct 2026 1:17:14pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "MidiController.h"
+
+MidiController::MidiController(AudioDeviceManager& _deviceManager, DJAudioPlayer& leftPlayer, DJAudioPlayer& rightPlayer,
+                               ApplicationProperties& _appProperties)
+                              : deviceManager(_deviceManager),
+                                players{ &leftPlayer, &rightPlayer },
+                                appProperties(_appProperties)
+{
+    selfReference = this;
+}
+
+MidiController::~MidiController()
+{
+    //no callback is running once these return
+    if (started){
+        deviceManager.removeMidiInputDeviceCallback({}, this);
+    }
+    if (virtualInput != nullptr){
+        virtualInput->stop();
+        virtualInput.reset();
+    }
+    masterReference.clear();
+}
+
+void MidiController::start()
+{
+    //"slot=code slot=code ..."
+    StringArray entries = StringArray::fromTokens(appProperties.getUserSettings()->getValue("midiMapping"), false);
+    for (const String& entry : entries){
+        const int slot = entry.upToFirstOccurrenceOf("=", false, false).getIntValue();
+        const int code = entry.fromFirstOccurrenceOf("=", false, false).getIntValue();
+        if (slot >= 0 && slot < numSlots && code > 0 && code <= 2 * numTargets){
+            slots[slot] = static_cast<uint8>(code);
+        }
+    }
+
+    //an empty identifier means every input enabled in the audio settings
+    deviceManager.addMidiInputDeviceCallback({}, this);
+    started = true;
+
+   #if JUCE_LINUX || JUCE_MAC
+    //e.g. aconnect a virtual raw MIDI port (snd-virmidi) or a sequencer to it, no hardware needed
+    virtualInput = MidiInput::createNewDevice(ProjectInfo::projectName, this);
+    if (virtualInput != nullptr){
+        virtualInput->start();
+    }
+    else{
+        std::cout << "MidiController::start could not create the virtual MIDI input" << std::endl;
+    }
+   #endif
+}
+
+void MidiController::learn(int deck, Target target)
+{
+    learningCode = getCode(deck, target);
+    listeners.call([](Listener& l) { l.midiMappingChanged(); });
+}
+
+void MidiController::cancelLearn()
+{
+    learningCode = 0;
+    listeners.call([](Listener& l) { l.midiMappingChanged(); });
+}
+
+bool MidiController::isLearning(int deck, Target target) const
+{
+    return learningCode.load() == getCode(deck, target);
+}
+
+void MidiController::clearMapping(int deck, Target target)
+{
+    const int code = getCode(deck, target);
+    for (auto& slot : slots){
+        if (slot.load() == code){
+            slot = 0;
+        }
+    }
+    saveMapping();
+    listeners.call([](Listener& l) { l.midiMappingChanged(); });
+}
+
+String MidiController::getMappingName(int deck, Target target) const
+{
+    const int code = getCode(deck, target);
+    for (int slot = 0; slot < numSlots; ++slot){
+        if (slots[slot].load() != code){
+            continue;
+        }
+        const int channel = (slot / 128) % 16 + 1;
+        const int number = slot % 128;
+        if (slot < numSlots / 2){
+            return "CC " + String(number) + ", channel " + String(channel);
+        }
+        return "note " + MidiMessage::getMidiNoteName(number, true, true, 3) + ", channel " + String(channel);
+    }
+    return {};
+}
+
+String MidiController::getTargetName(Target target)
+{
+    switch (target){
+        case faderTarget:  return "fader";
+        case speedTarget:  return "speed";
+        case jogTarget:    return "jog wheel";
+        case eqLowTarget:  return "EQ low";
+        case eqMidTarget:  return "EQ mid";
+        case eqHighTarget: return "EQ high";
+        case cueTarget:    return "cue";
+        case playTarget:   return "play / pause";
+        case numTargets:   break;
+    }
+    return {};
+}
+
+void MidiController::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void MidiController::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
+
+//==============================================================================
+void MidiController::handleIncomingMidiMessage(MidiInput*, const MidiMessage& message)
+{
+    const int slot = getSlot(message);
+    if (slot < 0){
+        return;
+    }
+
+    //letting go of a button (note off) is not learned, the press that follows the learn is
+    int learning = learningCode.load();
+    if (learning != 0){
+        if (!message.isNoteOff() && learningCode.compare_exchange_strong(learning, 0)){
+            //a control is mapped to one slot, a slot to one control
+            for (auto& other : slots){
+                if (other.load() == learning){
+                    other = 0;
+                }
+            }
+            slots[slot] = static_cast<uint8>(learning);
+
+            WeakReference<MidiController> weakThis = selfReference;
+            MessageManager::callAsync([weakThis] {
+                if (weakThis != nullptr){
+                    weakThis->mappingLearned();
+                }
+            });
+        }
+        return;
+    }
+
+    const int code = slots[slot].load();
+    if (code != 0){
+        sendToDeck((code - 1) / numTargets, static_cast<Target>((code - 1) % numTargets), message);
+    }
+}
+
+void MidiController::sendToDeck(int deck, Target target, const MidiMessage& message)
+{
+    //0..127; buttons send their velocity when pressed and 0 (or a note off) when let go
+    const int value = message.isController() ? message.getControllerValue()
+                    : message.isNoteOn() ? message.getVelocity() : 0;
+
+    DJAudioPlayer::ControlChange change;
+    //inputs stamp messages with Time::getMillisecondCounterHiRes() (in seconds) when they arrive
+    change.timeMs = message.getTimeStamp() > 0.0 ? message.getTimeStamp() * 1000.0 : Time::getMillisecondCounterHiRes();
+
+    switch (target){
+        case faderTarget:
+            change.type = DJAudioPlayer::ControlChange::gainChange;
+            change.value = value / 127.0;
+            break;
+        case speedTarget:
+            //same range as the deck's speed knob
+            change.type = DJAudioPlayer::ControlChange::speedChange;
+            change.value = value / 127.0 * 2.0;
+            break;
+        case jogTarget:
+            change.type = DJAudioPlayer::ControlChange::jogChange;
+            change.value = value < 64 ? value : value - 128;
+            break;
+        case eqLowTarget:
+        case eqMidTarget:
+        case eqHighTarget:
+            //centre is flat, fully down kills the band
+            change.type = target == eqLowTarget ? DJAudioPlayer::ControlChange::eqLowChange
+                        : target == eqMidTarget ? DJAudioPlayer::ControlChange::eqMidChange
+                                                : DJAudioPlayer::ControlChange::eqHighChange;
+            change.value = value <= 64 ? jmap(static_cast<double>(value), 0.0, 64.0, -40.0, 0.0)
+                                       : jmap(static_cast<double>(value), 64.0, 127.0, 0.0, 6.0);
+            break;
+        case cueTarget:
+            if (value == 0){
+                return;
+            }
+            change.type = DJAudioPlayer::ControlChange::cueChange;
+            break;
+        case playTarget:
+        {
+            if (value == 0){
+                return;
+            }
+            //the transport is started and stopped on the message thread, like the deck's play button
+            WeakReference<MidiController> weakThis = selfReference;
+            DJAudioPlayer* player = players[deck];
+            MessageManager::callAsync([weakThis, player] {
+                if (weakThis == nullptr){
+                    return;
+                }
+                if (player->isPlaying){
+                    player->pause();
+                }
+                else{
+                    player->start();
+                }
+            });
+            return;
+        }
+        case numTargets:
+            return;
+    }
+
+    //dropped if the queue is full, i.e. the audio device is not running
+    players[deck]->pushControl(change);
+}
+
+void MidiController::mappingLearned()
+{
+    saveMapping();
+    listeners.call([](Listener& l) { l.midiMappingChanged(); });
+}
+
+void MidiController::saveMapping()
+{
+    StringArray entries;
+    for (int slot = 0; slot < numSlots; ++slot){
+        if (const int code = slots[slot].load()){
+            entries.add(String(slot) + "=" + String(code));
+        }
+    }
+    appProperties.getUserSettings()->setValue("midiMapping", entries.joinIntoString(" "));
+}
+
+int MidiController::getSlot(const MidiMessage& message)
+{
+    const int channel = message.getChannel() - 1;
+    if (message.isController()){
+        return channel * 128 + message.getControllerNumber();
+    }
+    if (message.isNoteOnOrOff()){
+        return numSlots / 2 + channel * 128 + message.getNoteNumber();
+    }
+    return -1;
+}
+
+int MidiController::getCode(int deck, Target target)
+{
+    return deck * numTargets + target + 1;
+}
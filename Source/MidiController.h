@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    MidiController.h
+    Created: 19 Oct 2026 1:17:14pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "DJAudioPlayer.h"
+#include <atomic>
+
+//==============================================================================
+/*
+    MIDI controller input for the decks. Listens to the MIDI inputs enabled
+    in the audio settings and (on Linux and macOS) to a virtual input port
+    called "OtoDecks", which other programs or an ALSA virtual MIDI port can
+    be connected to without any hardware.
+    Controls are mapped by MIDI learn: pick a deck control, then move a knob
+    or press a button on the controller. The mapping is a flat table of
+    atomics (channel x controller or note), so the MIDI thread looks a
+    message up without a lock. Jog, fader, speed, EQ and cue moves go from
+    the MIDI thread straight into the deck's lock-free queue, with the time
+    the message arrived, and the audio thread applies them at the matching
+    sample (see DJAudioPlayer::getNextAudioBlock), and are recorded in the
+    control session on the way; the message thread is not involved. Only play/pause goes through the message thread, as it drives
+    the transport and the deck's play button.
+    The mapping is kept in the settings file. Listeners are told on the
+    message thread.
+*/
+class MidiController  : private MidiInputCallback
+{
+public:
+    enum Target
+    {
+        faderTarget,
+        speedTarget,
+        //relative controller: 1..63 forwards, 65..127 backwards
+        jogTarget,
+        eqLowTarget,
+        eqMidTarget,
+        eqHighTarget,
+        cueTarget,
+        playTarget,
+        numTargets
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called when a control has been learned or cleared */
+        virtual void midiMappingChanged() = 0;
+    };
+
+    MidiController(AudioDeviceManager& deviceManager, DJAudioPlayer& leftPlayer, DJAudioPlayer& rightPlayer,
+                   ApplicationProperties& appProperties);
+    ~MidiController() override;
+
+    /** loads the mapping and starts listening; the settings file must be set up by then */
+    void start();
+
+    /** the next controller or note that arrives is mapped to this deck control */
+    void learn(int deck, Target target);
+    void cancelLearn();
+    bool isLearning(int deck, Target target) const;
+    void clearMapping(int deck, Target target);
+
+    /** e.g. "CC 7, channel 1"; empty if the control is not mapped */
+    String getMappingName(int deck, Target target) const;
+    static String getTargetName(Target target);
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    /** called on the MIDI thread(s) */
+    void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) override;
+    /** turns a mapped message into a move for the deck */
+    void sendToDeck(int deck, Target target, const MidiMessage& message);
+    /** called on the message thread once the MIDI thread has learned a control */
+    void mappingLearned();
+    void saveMapping();
+
+    /** slot of a controller or note message, or -1 */
+    static int getSlot(const MidiMessage& message);
+    static int getCode(int deck, Target target);
+
+    AudioDeviceManager& deviceManager;
+    DJAudioPlayer* players[2];
+    ApplicationProperties& appProperties;
+
+    //16 channels x 128 controllers, then 16 channels x 128 notes
+    static constexpr int numSlots = 2 * 16 * 128;
+    //deck * numTargets + target + 1 of each slot, 0 if it is not mapped
+    std::atomic<uint8> slots[numSlots]{};
+    //code of the control being learned, 0 if none
+    std::atomic<int> learningCode{ 0 };
+
+    std::unique_ptr<MidiInput> virtualInput;
+    bool started = false;
+
+    //made on the message thread, copied by the MIDI thread for its callAsync()s
+    WeakReference<MidiController> selfReference;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (MidiController)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiController)
+};
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    MidiLearnComponent.cpp
+    Created: 19 Oct 2026 1:17:14pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MidiLearnComponent.h"
+
+//==============================================================================
+MidiLearnComponent::MidiLearnComponent(MidiController& _midiController)
+                                      : midiController(_midiController)
+{
+    addAndMakeVisible(controlList);
+    addAndMakeVisible(clearButton);
+    addAndMakeVisible(hintLabel);
+
+    controlList.setRowHeight(24);
+    controlList.setColour(ListBox::backgroundColourId, Colour(32, 32, 32));
+
+    clearButton.addListener(this);
+    clearButton.setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+    clearButton.setColour(TextButton::textColourOffId, Colours::white);
+    clearButton.setLookAndFeel(&lookAndFeel);
+
+    hintLabel.setFont(14.0f);
+    hintLabel.setColour(Label::textColourId, Colours::white);
+    hintLabel.setText("Click a control, then move a knob or press a button on the controller. "
+                      "Enable the controller's MIDI input in the audio settings first.",
+                      dontSendNotification);
+
+    midiController.addListener(this);
+}
+
+MidiLearnComponent::~MidiLearnComponent()
+{
+    midiController.removeListener(this);
+    midiController.cancelLearn();
+    clearButton.setLookAndFeel(nullptr);
+}
+
+void MidiLearnComponent::paint(Graphics& g)
+{
+    g.fillAll(Colour(22, 22, 22));//background colour
+}
+
+void MidiLearnComponent::resized()
+{
+    auto area = getLocalBounds().reduced(8);
+
+    hintLabel.setBounds(area.removeFromTop(40));
+    clearButton.setBounds(area.removeFromBottom(32).removeFromRight(120).reduced(2));
+    controlList.setBounds(area.reduced(0, 4));
+}
+
+int MidiLearnComponent::getNumRows()
+{
+    return 2 * MidiController::numTargets;
+}
+
+void MidiLearnComponent::paintListBoxItem(int rowNumber, Graphics& g, int width, int height, bool rowIsSelected)
+{
+    const int deck = getDeck(rowNumber);
+    const MidiController::Target target = getTarget(rowNumber);
+    const bool learning = midiController.isLearning(deck, target);
+
+    if (learning){
+        g.fillAll(Colour(255, 64, 64));
+    }
+    else if (rowIsSelected){
+        g.fillAll(Colour(64, 64, 64));
+    }
+
+    g.setColour(Colours::white);
+    g.setFont(14.0f);
+    g.drawText((deck == 0 ? "Left " : "Right ") + MidiController::getTargetName(target),
+               8, 0, width / 2 - 8, height, Justification::centredLeft, true);
+
+    const String mapping = learning ? "move a control..." : midiController.getMappingName(deck, target);
+    g.setColour(mapping.isEmpty() ? Colours::grey : Colours::white);
+    g.drawText(mapping.isEmpty() ? "not mapped" : mapping,
+               width / 2, 0, width / 2 - 8, height, Justification::centredLeft, true);
+}
+
+void MidiLearnComponent::listBoxItemClicked(int row, const MouseEvent&)
+{
+    const int deck = getDeck(row);
+    const MidiController::Target target = getTarget(row);
+    if (midiController.isLearning(deck, target)){
+        midiController.cancelLearn();
+    }
+    else{
+        midiController.learn(deck, target);
+    }
+}
+
+void MidiLearnComponent::buttonClicked(Button* button)
+{
+    if (button == &clearButton){
+        const int row = controlList.getSelectedRow();
+        if (row >= 0){
+            midiController.clearMapping(getDeck(row), getTarget(row));
+        }
+    }
+}
+
+void MidiLearnComponent::midiMappingChanged()
+{
+    controlList.repaint();
+}
+
+int MidiLearnComponent::getDeck(int row)
+{
+    return row / MidiController::numTargets;
+}
+
+MidiController::Target MidiLearnComponent::getTarget(int row)
+{
+    return static_cast<MidiController::Target>(row % MidiController::numTargets);
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    MidiLearnComponent.h
+    Created: 19 Oct 2026 1:17:14pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MidiController.h"
+
+//==============================================================================
+/*
+    MIDI learn panel shown in a dialog from MainComponent: one row per deck
+    control with the controller or note it is mapped to. Clicking a row
+    starts learning it (clicking it again cancels); CLEAR unmaps the selected
+    row. The inputs themselves are enabled in the audio settings.
+*/
+class MidiLearnComponent  : public Component,
+                            public ListBoxModel,
+                            public Button::Listener,
+                            public MidiController::Listener
+{
+public:
+    MidiLearnComponent(MidiController& midiController);
+    ~MidiLearnComponent() override;
+
+    void paint (Graphics&) override;
+    void resized() override;
+
+    /** implement ListBoxModel */
+    int getNumRows() override;
+    void paintListBoxItem (int rowNumber, Graphics& g, int width, int height, bool rowIsSelected) override;
+    void listBoxItemClicked (int row, const MouseEvent& event) override;
+
+    /** implement Button::Listener */
+    void buttonClicked (Button* button) override;
+
+    /** implement MidiController::Listener */
+    void midiMappingChanged() override;
+
+private:
+    static int getDeck(int row);
+    static MidiController::Target getTarget(int row);
+
+    MidiController& midiController;
+
+    ListBox controlList{ "MIDI controls", this };
+    TextButton clearButton{ "CLEAR" };
+    Label hintLabel;
+    LookAndFeel_V2 lookAndFeel;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiLearnComponent)
+};
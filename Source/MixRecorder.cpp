@@ -0,0 +1,268 @@
+/*
+  ==============================================================================
+
+    MixRecorder.cpp
+    Created: 19 Oct 2026 12:25:30pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "MixRecorder.h"
+
+//==============================================================================
+MixRecorder::MixRecorder() : Thread("Mix recorder")
+{
+}
+
+MixRecorder::~MixRecorder()
+{
+    stop();
+}
+
+void MixRecorder::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    //a running recording keeps the rate its file headers were written with
+    if (!isRecording()){
+        sampleRate = newSampleRate;
+    }
+}
+
+String MixRecorder::start(const File& folder, const String& formatName, bool withStems)
+{
+    stop();
+
+    if (!folder.createDirectory()){
+        return "Could not create " + folder.getFullPathName();
+    }
+
+    WavAudioFormat wavFormat;
+    FlacAudioFormat flacFormat;
+    AudioFormat& format = formatName.equalsIgnoreCase("FLAC") ? static_cast<AudioFormat&>(flacFormat)
+                                                              : static_cast<AudioFormat&>(wavFormat);
+    const String extension = format.getFileExtensions()[0];
+
+    const char* fileNames[numStreams] = { "master", "deck L", "deck R" };
+    const int fifoSize = static_cast<int>(sampleRate) * fifoSeconds;
+
+    for (int i = 0; i < numStreams; ++i){
+        auto& stream = streams[i];
+        stream.writer.reset();
+        stream.outputStream = nullptr;
+        stream.droppedBlocks = 0;
+        stream.peakFill = 0;
+        stream.samplesWritten = 0;
+
+        if (i != masterStream && !withStems){
+            continue;
+        }
+
+        //all the FIFO memory is allocated here, never on the audio thread
+        stream.buffer.setSize(numChannels, fifoSize);
+        stream.fifo.setTotalSize(fifoSize);
+        stream.fifo.reset();
+
+        String error = openStream(stream, folder.getChildFile(fileNames[i] + extension), format);
+        if (error.isNotEmpty()){
+            for (auto& s : streams){
+                s.writer.reset();
+                s.outputStream = nullptr;
+            }
+            return error;
+        }
+    }
+
+    recordingFolder = folder;
+    bytesWritten = 0;
+    stemsEnabled = withStems;
+
+    //high priority so the library scanner and loaders never starve the writer
+    startThread(8);
+    recording = true;
+    return {};
+}
+
+String MixRecorder::openStream(StreamState& stream, const File& file, AudioFormat& format)
+{
+    file.deleteFile();
+
+    //a big stream buffer turns the writes into few large disk requests
+    std::unique_ptr<FileOutputStream> fileStream (file.createOutputStream(1 << 18));
+    if (fileStream == nullptr || fileStream->failedToOpen()){
+        return "Could not write to " + file.getFullPathName();
+    }
+
+    //24 bit works for both WAV and FLAC
+    auto* writer = format.createWriterFor(fileStream.get(), sampleRate, numChannels, 24, {}, 0);
+    if (writer == nullptr){
+        return "Could not create a " + format.getFormatName() + " writer for " + file.getFullPathName();
+    }
+
+    stream.outputStream = fileStream.release(); //the writer owns it now
+    stream.writer.reset(writer);
+    return {};
+}
+
+void MixRecorder::stop()
+{
+    if (!recording.exchange(false) && !isThreadRunning()){
+        return;
+    }
+
+    //wait for an audio callback that may still be copying into a FIFO
+    while (pushesInFlight.load() > 0){
+        Thread::yield();
+    }
+
+    //run() drains the FIFOs one last time before it returns
+    signalThreadShouldExit();
+    notify();
+    stopThread(10000);
+
+    //deleting the writers finalises the file headers
+    for (auto& stream : streams){
+        stream.writer.reset();
+        stream.outputStream = nullptr;
+    }
+}
+
+bool MixRecorder::isRecording() const
+{
+    return recording.load();
+}
+
+void MixRecorder::pushBlock(int streamIndex, const AudioBuffer<float>& source, int startSample, int numSamples)
+{
+    //counted before checking the flag, so stop() can't miss a push in progress
+    ++pushesInFlight;
+
+    auto& stream = streams[streamIndex];
+    const bool wanted = recording.load() && (streamIndex == masterStream || stemsEnabled.load());
+
+    if (wanted && stream.writer != nullptr && source.getNumChannels() > 0){
+        if (stream.fifo.getFreeSpace() < numSamples){
+            //the writer has fallen behind: lose this block rather than wait
+            ++stream.droppedBlocks;
+        }
+        else{
+            int start1, size1, start2, size2;
+            stream.fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+            for (int ch = 0; ch < numChannels; ++ch){
+                //mono sources are copied to both channels
+                const int sourceCh = jmin(ch, source.getNumChannels() - 1);
+                if (size1 > 0){
+                    stream.buffer.copyFrom(ch, start1, source, sourceCh, startSample, size1);
+                }
+                if (size2 > 0){
+                    stream.buffer.copyFrom(ch, start2, source, sourceCh, startSample + size1, size2);
+                }
+            }
+            stream.fifo.finishedWrite(size1 + size2);
+
+            const int fill = stream.fifo.getNumReady();
+            if (fill > stream.peakFill.load()){
+                stream.peakFill = fill;
+            }
+        }
+    }
+
+    --pushesInFlight;
+}
+
+//==============================================================================
+void MixRecorder::run()
+{
+    while (!threadShouldExit()){
+        int samplesWritten = 0;
+        for (auto& stream : streams){
+            samplesWritten += drainStream(stream);
+        }
+
+        //nothing queued: sleep a little (a typical block arrives every few ms)
+        if (samplesWritten == 0){
+            wait(10);
+        }
+    }
+
+    //write out what was queued before stop() was called
+    for (auto& stream : streams){
+        drainStream(stream);
+    }
+}
+
+int MixRecorder::drainStream(StreamState& stream)
+{
+    if (stream.writer == nullptr){
+        return 0;
+    }
+
+    const int numReady = stream.fifo.getNumReady();
+    if (numReady == 0){
+        return 0;
+    }
+
+    int start1, size1, start2, size2;
+    stream.fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    if (size1 > 0){
+        stream.writer->writeFromAudioSampleBuffer(stream.buffer, start1, size1);
+    }
+    if (size2 > 0){
+        stream.writer->writeFromAudioSampleBuffer(stream.buffer, start2, size2);
+    }
+    stream.fifo.finishedRead(size1 + size2);
+    stream.samplesWritten += size1 + size2;
+
+    int64 total = 0;
+    for (auto& s : streams){
+        if (s.outputStream != nullptr){
+            total += s.outputStream->getPosition();
+        }
+    }
+    bytesWritten = total;
+
+    return size1 + size2;
+}
+
+//==============================================================================
+size_t MixRecorder::getMemoryUsage() const
+{
+    size_t bytes = 0;
+    for (auto& stream : streams){
+        bytes += static_cast<size_t>(stream.buffer.getNumChannels()) * static_cast<size_t>(stream.buffer.getNumSamples()) * sizeof(float);
+    }
+    return bytes;
+}
+
+void MixRecorder::trimMemory(size_t targetBytes)
+{
+    //stop() has waited for the audio thread and closed the writers, so nothing pushes into the buffers any more
+    if (isRecording()){
+        return;
+    }
+    for (auto& stream : streams){
+        stream.buffer.setSize(0, 0);
+    }
+}
+
+MixRecorder::Stats MixRecorder::getStats() const
+{
+    Stats stats;
+    stats.secondsRecorded = streams[masterStream].samplesWritten.load() / sampleRate;
+    stats.bytesWritten = bytesWritten.load();
+
+    for (auto& stream : streams){
+        stats.droppedBlocks += stream.droppedBlocks.load();
+        if (stream.fifo.getTotalSize() > 1){
+            stats.peakFifoUsage = jmax(stats.peakFifoUsage,
+                                       stream.peakFill.load() / static_cast<float>(stream.fifo.getTotalSize()));
+        }
+    }
+    return stats;
+}
+
+File MixRecorder::getRecordingFolder() const
+{
+    return recordingFolder;
+}
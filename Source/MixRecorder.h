@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    MixRecorder.h
+    Created: 19 Oct 2026 12:25:30pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+//==============================================================================
+/*
+    Records the set to disk.
+    The audio thread hands blocks over with pushBlock(), which only copies them
+    into a lock-free FIFO per stream (and drops the block if the FIFO is full).
+    A dedicated writer thread drains the FIFOs into WAV or FLAC files, so disk
+    stalls, track loading or library scans can never block the audio callback.
+    Besides the master output, each deck can be captured pre-fader as a stem.
+*/
+class MixRecorder : private Thread
+{
+public:
+    enum Stream
+    {
+        masterStream = 0,
+        leftDeckStream,
+        rightDeckStream,
+        numStreams
+    };
+
+    /** counters shown while recording */
+    struct Stats
+    {
+        double secondsRecorded = 0.0;
+        int64 bytesWritten = 0;
+        int droppedBlocks = 0;
+        /** highest FIFO fill level seen so far, 0..1 */
+        float peakFifoUsage = 0.0f;
+    };
+
+    MixRecorder();
+    ~MixRecorder() override;
+
+    /** sample rate of the audio device, used for the next recording */
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    /** starts new files in the folder, formatName is "WAV" or "FLAC"; returns an error message or an empty string */
+    String start(const File& folder, const String& formatName, bool withStems);
+    /** stops recording, writes out whatever is still queued and closes the files */
+    void stop();
+    bool isRecording() const;
+
+    /** called from the audio thread: never blocks or allocates */
+    void pushBlock(int stream, const AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    Stats getStats() const;
+
+    /** bytes held by the FIFOs, which stay allocated after a recording until trimmed */
+    size_t getMemoryUsage() const;
+    /** frees the FIFOs if nothing is being recorded (start() makes them again) */
+    void trimMemory(size_t targetBytes);
+    /** the folder of the current (or last) recording */
+    File getRecordingFolder() const;
+
+private:
+    struct StreamState
+    {
+        AbstractFifo fifo{ 1 };
+        AudioBuffer<float> buffer;
+        std::unique_ptr<AudioFormatWriter> writer;
+        //owned by the writer, only used to count the bytes on disk
+        OutputStream* outputStream = nullptr;
+        std::atomic<int> droppedBlocks{ 0 };
+        std::atomic<int> peakFill{ 0 };
+        std::atomic<int64> samplesWritten{ 0 };
+    };
+
+    void run() override;
+    /** moves everything waiting in the stream's FIFO to its writer, returns the number of samples written */
+    int drainStream(StreamState& stream);
+    /** creates the file and writer for one stream */
+    String openStream(StreamState& stream, const File& file, AudioFormat& format);
+
+    StreamState streams[numStreams];
+
+    std::atomic<bool> recording{ false };
+    std::atomic<bool> stemsEnabled{ false };
+    std::atomic<int> pushesInFlight{ 0 };
+    std::atomic<int64> bytesWritten{ 0 };
+
+    double sampleRate = 44100.0;
+    File recordingFolder;
+
+    //FIFOs hold this many seconds, enough to ride out slow disks
+    static constexpr int fifoSeconds = 4;
+    static constexpr int numChannels = 2;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MixRecorder)
+};
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    PaintProfiler.cpp
+    Created: 19 Oct 2026 12:35:35pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "PaintProfiler.h"
+
+bool PaintProfiler::enabled = false;
+bool PaintProfiler::repaintFlash = false;
+std::map<String, PaintProfiler::Counters> PaintProfiler::counters;
+double PaintProfiler::periodStartMs = 0.0;
+
+//==============================================================================
+PaintProfiler::ScopedPaint::ScopedPaint(Graphics& g, const char* _name)
+                                       : graphics(g),
+                                         name(_name)
+{
+    if (enabled || repaintFlash){
+        startMs = Time::getMillisecondCounterHiRes();
+    }
+}
+
+PaintProfiler::ScopedPaint::~ScopedPaint()
+{
+    if (enabled){
+        addPaint(name, Time::getMillisecondCounterHiRes() - startMs);
+    }
+
+    if (repaintFlash){
+        //a new colour every time, so areas that keep repainting flicker
+        graphics.fillAll(Colour(static_cast<uint8>(Random::getSystemRandom().nextInt(256)),
+                                static_cast<uint8>(Random::getSystemRandom().nextInt(256)),
+                                static_cast<uint8>(Random::getSystemRandom().nextInt(256)),
+                                0.3f));
+    }
+}
+
+//==============================================================================
+void PaintProfiler::setEnabled(bool shouldBeEnabled)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    if (shouldBeEnabled && !enabled){
+        counters.clear();
+        periodStartMs = Time::getMillisecondCounterHiRes();
+    }
+    enabled = shouldBeEnabled;
+}
+
+bool PaintProfiler::isEnabled()
+{
+    return enabled;
+}
+
+void PaintProfiler::setRepaintFlashEnabled(bool shouldBeEnabled)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    repaintFlash = shouldBeEnabled;
+}
+
+bool PaintProfiler::isRepaintFlashEnabled()
+{
+    return repaintFlash;
+}
+
+std::vector<PaintProfiler::Stats> PaintProfiler::takeStats()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    const double now = Time::getMillisecondCounterHiRes();
+    const double seconds = jmax(0.001, (now - periodStartMs) / 1000.0);
+
+    std::vector<Stats> result;
+    for (const auto& entry : counters){
+        Stats stats;
+        stats.name = entry.first;
+        stats.paintsPerSecond = entry.second.numPaints / seconds;
+        stats.averageMs = entry.second.numPaints > 0 ? entry.second.totalMs / entry.second.numPaints : 0.0;
+        stats.maxMs = entry.second.maxMs;
+        result.push_back(stats);
+    }
+
+    //keep the names, so components that went idle still show up with zeros
+    for (auto& entry : counters){
+        entry.second = Counters();
+    }
+    periodStartMs = now;
+    return result;
+}
+
+void PaintProfiler::addPaint(const char* name, double milliseconds)
+{
+    Counters& c = counters[name];
+    ++c.numPaints;
+    c.totalMs += milliseconds;
+    c.maxMs = jmax(c.maxMs, milliseconds);
+}
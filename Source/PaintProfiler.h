@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    PaintProfiler.h
+    Created: 19 Oct 2026 12:35:35pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <map>
+
+//==============================================================================
+/*
+    Debug counters for the UI: how often each component paints and how long
+    its paint() takes. Components put a ScopedPaint at the top of paint();
+    while profiling is off that costs a single flag check.
+    With repaint flash on, every painted area is tinted with a random colour,
+    so anything that repaints while the app is idle flickers.
+    Message thread only (paint() always runs there).
+*/
+class PaintProfiler
+{
+public:
+    struct Stats
+    {
+        String name;
+        double paintsPerSecond = 0.0;
+        double averageMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    /** times the enclosing paint() under the given name */
+    class ScopedPaint
+    {
+    public:
+        ScopedPaint(Graphics& g, const char* name);
+        ~ScopedPaint();
+
+    private:
+        Graphics& graphics;
+        const char* name;
+        double startMs = 0.0;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedPaint)
+    };
+
+    static void setEnabled(bool shouldBeEnabled);
+    static bool isEnabled();
+
+    static void setRepaintFlashEnabled(bool shouldBeEnabled);
+    static bool isRepaintFlashEnabled();
+
+    /** per component figures since the last call, which starts a new period */
+    static std::vector<Stats> takeStats();
+
+private:
+    struct Counters
+    {
+        int numPaints = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static void addPaint(const char* name, double milliseconds);
+
+    static bool enabled;
+    static bool repaintFlash;
+    static std::map<String, Counters> counters;
+    static double periodStartMs;
+};
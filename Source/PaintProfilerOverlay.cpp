@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    PaintProfilerOverlay.cpp
+    Created: 19 Oct 2026 12:35:35pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PaintProfilerOverlay.h"
+
+//==============================================================================
+PaintProfilerOverlay::PaintProfilerOverlay()
+{
+    setOpaque(true);
+    setInterceptsMouseClicks(false, false);
+}
+
+PaintProfilerOverlay::~PaintProfilerOverlay()
+{
+    stopTimer();
+    PaintProfiler::setEnabled(false);
+}
+
+void PaintProfilerOverlay::paint (Graphics& g)
+{
+    g.fillAll (Colour(12, 12, 12));
+    g.setColour (Colour(0, 245, 245)); //outline colour
+    g.drawRect (getLocalBounds(), 1);
+
+    g.setFont (13.0f);
+    auto area = getLocalBounds().reduced(6, 3);
+    const int nameW = area.getWidth() / 2;
+    const int valueW = (area.getWidth() - nameW) / 3;
+
+    auto drawRow = [&] (const String& name, const String& perSecond, const String& average, const String& worst) {
+        auto row = area.removeFromTop(rowHeight);
+        g.drawText (name, row.removeFromLeft(nameW), Justification::centredLeft, true);
+        g.drawText (perSecond, row.removeFromLeft(valueW), Justification::centredRight, true);
+        g.drawText (average, row.removeFromLeft(valueW), Justification::centredRight, true);
+        g.drawText (worst, row, Justification::centredRight, true);
+    };
+
+    g.setColour (Colour(229, 204, 255));
+    drawRow ("component", "paints/s", "avg ms", "max ms");
+
+    double totalMsPerSecond = 0.0;
+    g.setColour (Colours::white);
+    for (const auto& s : stats){
+        drawRow (s.name, String(s.paintsPerSecond, 1), String(s.averageMs, 2), String(s.maxMs, 2));
+        totalMsPerSecond += s.paintsPerSecond * s.averageMs;
+    }
+
+    g.setColour (Colour(0, 255, 127));
+    drawRow ("total paint time", String(totalMsPerSecond, 1) + " ms/s", "", "");
+}
+
+void PaintProfilerOverlay::timerCallback()
+{
+    const int oldNumRows = static_cast<int>(stats.size());
+    stats = PaintProfiler::takeStats();
+
+    if (static_cast<int>(stats.size()) != oldNumRows){
+        setSize(getWidth(), getPreferredHeight());
+    }
+    repaint();
+}
+
+void PaintProfilerOverlay::setActive(bool shouldBeActive)
+{
+    PaintProfiler::setEnabled(shouldBeActive);
+    setVisible(shouldBeActive);
+
+    if (shouldBeActive){
+        stats.clear();
+        startTimer(500);
+    }
+    else{
+        stopTimer();
+    }
+}
+
+int PaintProfilerOverlay::getPreferredHeight() const
+{
+    //header + one row per component + total
+    return (static_cast<int>(stats.size()) + 2) * rowHeight + 6;
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    PaintProfilerOverlay.h
+    Created: 19 Oct 2026 12:35:35pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PaintProfiler.h"
+
+//==============================================================================
+/*
+    Small table on top of the UI with the PaintProfiler figures: paints per
+    second, average and worst paint time of each instrumented component, and
+    the total paint time per second. Refreshes twice a second.
+    The overlay is opaque, so refreshing it never repaints what is underneath
+    and it does not show up in its own numbers.
+*/
+class PaintProfilerOverlay  : public Component,
+                              public Timer
+{
+public:
+    PaintProfilerOverlay();
+    ~PaintProfilerOverlay();
+
+    void paint (Graphics&) override;
+
+    void timerCallback() override;
+
+    /** shows the overlay and starts profiling, or hides it and stops */
+    void setActive(bool shouldBeActive);
+
+    /** height needed for the current number of rows */
+    int getPreferredHeight() const;
+
+private:
+    std::vector<PaintProfiler::Stats> stats;
+
+    static constexpr int rowHeight = 16;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PaintProfilerOverlay)
+};
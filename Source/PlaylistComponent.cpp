@@ -10,35 +10,73 @@
 
 #include <JuceHeader.h>
 #include "PlaylistComponent.h"
+#include "PaintProfiler.h"
+#include "StartupTrace.h"
+#include <algorithm>
+
+namespace
+{
+    //library tracks added to the per-track indexes per message
+    const int tracksPerIndexChunk = 2000;
+}
 
 //==============================================================================
 PlaylistComponent::PlaylistComponent(DeckGUI* deck1,
                                      DeckGUI* deck2,
-                                     DJAudioPlayer* player
+                                     TrackMetadataScanner& metadataScanner,
+                                     LibraryStore& library,
+                                     TrackTable& trackTable,
+                                     SearchIndex& searchIndex,
+                                     DuplicateFinder& duplicateFinder,
+                                     TagReader& tagReader,
+                                     TrackImporter& importer,
+                                     FolderWatcher& folderWatcher
                                      ): deck1(deck1),
                                         deck2(deck2),
-                                        player(player)
+                                        metadataScanner(metadataScanner),
+                                        library(library),
+                                        trackTable(trackTable),
+                                        searchIndex(searchIndex),
+                                        duplicateFinder(duplicateFinder),
+                                        tagReader(tagReader),
+                                        importer(importer),
+                                        folderWatcher(folderWatcher)
 {
     // Create a table that will act as a Music Library
     // Create columns and set their headers
-    tableComponent.getHeader().addColumn("#", 1, 1);
-    tableComponent.getHeader().addColumn("Length", 2, 1);
-    tableComponent.getHeader().addColumn("Track title", 3, 1);
-    tableComponent.getHeader().addColumn("Add to...", 4, 1);
-    tableComponent.getHeader().addColumn("Add to...", 5, 1);
-    tableComponent.getHeader().addColumn("Delete", 6, 1);
+    // Widths are in 1/32nds of the table; the header scales them to fit on every resize
+    // Click a column header to sort by it, shift-click another one to sort ties by it too
+    const int fixedColumn = TableHeaderComponent::visible | TableHeaderComponent::resizable | TableHeaderComponent::notSortable;
+    tableComponent.getHeader().addColumn("#", 1, 1 * 40, 30, -1, fixedColumn);
+    tableComponent.getHeader().addColumn("Length", lengthColumnId, 2 * 40);
+    tableComponent.getHeader().addColumn("Track title", titleColumnId, 7 * 40);
+    tableComponent.getHeader().addColumn("Album", albumColumnId, 3 * 40);
+    tableComponent.getHeader().addColumn("Genre", genreColumnId, 3 * 40);
+    tableComponent.getHeader().addColumn("Year", yearColumnId, 2 * 40);
+    tableComponent.getHeader().addColumn("BPM", bpmColumnId, 2 * 40);
+    tableComponent.getHeader().addColumn("Key", keyColumnId, 2 * 40);
+    tableComponent.getHeader().addColumn("Added", dateAddedColumnId, 2 * 40);
+    tableComponent.getHeader().addColumn("Rating", ratingColumnId, 2 * 40);
+    tableComponent.getHeader().addColumn("Add to...", loadLeftColumnId, 2 * 40, 30, -1, fixedColumn);
+    tableComponent.getHeader().addColumn("Add to...", loadRightColumnId, 2 * 40, 30, -1, fixedColumn);
+    tableComponent.getHeader().addColumn("Delete", deleteColumnId, 2 * 40, 30, -1, fixedColumn);
+    tableComponent.getHeader().setStretchToFitActive(true);
     tableComponent.setModel(this);
 
     //make table, loadButton, clearAllButton, searchBar and playlistLabel visible
     addAndMakeVisible(tableComponent);
     addAndMakeVisible(loadButton);
     addAndMakeVisible(clearAllButton);
+    addAndMakeVisible(watchButton);
     addAndMakeVisible(searchBar);
     addAndMakeVisible(playlistLabel);
+    //only shown while importing, in place of playlistLabel
+    addChildComponent(importProgressBar);
+    addChildComponent(cancelImportButton);
 
     //add text in search bar (can type in) and playlistLabel (not editable)
-    searchBar.setFont(19.0f);
-    searchBar.setTextToShowWhenEmpty(" Type and press enter to search...  ", Colours::white);
+    searchBar.setFont(18.0f);
+    searchBar.setTextToShowWhenEmpty(" Search... (filters: bpm:120-128 key:8A rating:>=4 artist:name added:<7)  ", Colours::white);
     //add text in playlistLabel (not editable) - centred
     playlistLabel.setFont(18.0f);
     playlistLabel.setText(" CREATE PLAYLIST ", dontSendNotification);
@@ -47,6 +85,8 @@ PlaylistComponent::PlaylistComponent(DeckGUI* deck1,
     //Register listeners to loadButton and searchBar
     loadButton.addListener(this);
     clearAllButton.addListener(this);
+    cancelImportButton.addListener(this);
+    watchButton.addListener(this);
     searchBar.addListener(this);
 
     //if there is a playlist saved, load it
@@ -54,25 +94,15 @@ PlaylistComponent::PlaylistComponent(DeckGUI* deck1,
 
     searchBar.onTextChange = [this] {filterPlaylist(searchBar.getText());};
 
-}
-
-PlaylistComponent::~PlaylistComponent()
-{
-    //when the app is closed, the playlist is automatically saved
-    std::ofstream savedPlaylist("playlist.txt");
-
-    // playlist is saved to file, by saving each tracks fullpath names
-    for (File& t : tracks){
-        savedPlaylist << t.getFullPathName() << "\n";
-    }
-}
-
-void PlaylistComponent::paint(juce::Graphics& g)
-{
-    //background colour (only visible behind loadButton and clearAllButton)
-    //matching label and searchbar background colours
-    g.fillAll(Colour(32, 32, 32));
+    metadataScanner.addListener(this);
+    searchIndex.addListener(this);
+    duplicateFinder.addListener(this);
+    tagReader.addListener(this);
+    importer.addListener(this);
+    folderWatcher.addListener(this);
+    library.addListener(this);
 
+    //colours and look and feel are set once here; setting them in paint() triggered more repaints
     //customise table's colours:
     //table background - matching added rows colours (when not selected)
     tableComponent.setColour(TableListBox::backgroundColourId, Colour(40,40,40));
@@ -83,9 +113,8 @@ void PlaylistComponent::paint(juce::Graphics& g)
     //customise playlist label's background and font:
     playlistLabel.setColour(Label::backgroundColourId, Colour(12,12,12));
     
-    //customise searchbar text editor's background and font:
+    //customise searchbar text editor's background:
     searchBar.setColour(TextEditor::backgroundColourId, Colour(32, 32, 32));
-    searchBar.setFont(18.0f);
 
     //customise loadButton's background:
     loadButton.setColour(TextButton::buttonColourId, Colour(12, 12, 12));
@@ -97,9 +126,46 @@ void PlaylistComponent::paint(juce::Graphics& g)
     //customise clearAllButton's text colour:    
     clearAllButton.setColour(TextButton::textColourOffId, Colour(255, 64, 64));
 
+    //customise watchButton like loadButton:
+    watchButton.setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+    watchButton.setColour(TextButton::textColourOffId, Colours::white);
+
+    //customise cancelImportButton like clearAllButton:
+    cancelImportButton.setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+    cancelImportButton.setColour(TextButton::textColourOffId, Colour(255, 64, 64));
+    //customise importProgressBar's colours:
+    importProgressBar.setColour(ProgressBar::backgroundColourId, Colour(12, 12, 12));
+    importProgressBar.setColour(ProgressBar::foregroundColourId, Colour(0, 245, 245));
+
     //adding lookAndFeel_V2 style on buttons
     loadButton.setLookAndFeel(&lookAndFeel);
     clearAllButton.setLookAndFeel(&lookAndFeel);
+    cancelImportButton.setLookAndFeel(&lookAndFeel);
+    watchButton.setLookAndFeel(&lookAndFeel);
+}
+
+PlaylistComponent::~PlaylistComponent()
+{
+    metadataScanner.removeListener(this);
+    searchIndex.removeListener(this);
+    duplicateFinder.removeListener(this);
+    tagReader.removeListener(this);
+    importer.removeListener(this);
+    folderWatcher.removeListener(this);
+    library.removeListener(this);
+    loadButton.setLookAndFeel(nullptr);
+    clearAllButton.setLookAndFeel(nullptr);
+    cancelImportButton.setLookAndFeel(nullptr);
+    watchButton.setLookAndFeel(nullptr);
+}
+
+void PlaylistComponent::paint(juce::Graphics& g)
+{
+    PaintProfiler::ScopedPaint profile(g, "PlaylistComponent");
+
+    //background colour (only visible behind loadButton and clearAllButton)
+    //matching label and searchbar background colours
+    g.fillAll(Colour(32, 32, 32));
 }
 
 void PlaylistComponent::resized()
@@ -109,32 +175,32 @@ void PlaylistComponent::resized()
 
     double rowH = getHeight() / static_cast<double>(10);
     float columnW = getWidth() / static_cast <float>(8);
-    float tableColW = getWidth() / static_cast <float>(24);
 
     playlistLabel.setBounds(0, 0, columnW * 8, rowH);
+    importProgressBar.setBounds(0, 0, columnW * 7, rowH);
+    cancelImportButton.setBounds(columnW * 7, 0, columnW, rowH);
     tableComponent.setBounds(0, rowH, columnW * 8, rowH * 8);
-    searchBar.setBounds(0, rowH * 9, columnW * 6, rowH);
+    searchBar.setBounds(0, rowH * 9, columnW * 5, rowH);
+    watchButton.setBounds(columnW * 5, rowH * 9, columnW, rowH);
     loadButton.setBounds(columnW * 6, rowH * 9, columnW, rowH);
     clearAllButton.setBounds(columnW * 7, rowH * 9, columnW, rowH);
 
-    tableComponent.getHeader().setColumnWidth(1, tableColW);
-    tableComponent.getHeader().setColumnWidth(2, tableColW*3);
-    tableComponent.getHeader().setColumnWidth(3, tableColW*14);
-    tableComponent.getHeader().setColumnWidth(4, tableColW*2);
-    tableComponent.getHeader().setColumnWidth(5, tableColW*2);
-    tableComponent.getHeader().setColumnWidth(6, tableColW*2);
-
-    tableComponent.setRowHeight(getHeight() / 10);
+    //column widths are kept in proportion by the header (stretch to fit), so the user's
+    //own column resizing survives a window resize
+    //setRowHeight() refreshes the whole table, so only call it when the height changes
+    if (tableComponent.getRowHeight() != getHeight() / 10){
+        tableComponent.setRowHeight(jmax(1, getHeight() / 10));
+    }
 
 }
 
 int  PlaylistComponent::getNumRows()
 {
-    if (searchBar.isEmpty()){
-        return tracks.size();
+    if (!hasRowOrder){
+        return library.getNumTracks();
     }
     else{
-        return filteredTracks.size();
+        return static_cast<int>(rowIds.size());
     }
 }
 
@@ -144,6 +210,8 @@ void PlaylistComponent::paintRowBackground(Graphics& g,
                                            int height,
                                            bool rowIsSelected)
 {
+    PaintProfiler::ScopedPaint profile(g, "Playlist rows");
+
     if (rowIsSelected){
         g.fillAll(Colour(65, 65, 65));
     }
@@ -159,8 +227,11 @@ void PlaylistComponent::paintCell(Graphics& g,
     int height,
     bool rowIsSelected)
 {
+    PaintProfiler::ScopedPaint profile(g, "Playlist cells");
+
     g.setFont(16.0f);
-    if (rowNumber < getNumRows()) // added to fix the bug when resizing the window
+    const LibraryStore::Track* track = getTrackForRow(rowNumber);
+    if (track != nullptr) // added to fix the bug when resizing the window
     {
         g.setColour(Colours::white);
         if (columnId == 1) {
@@ -172,175 +243,318 @@ void PlaylistComponent::paintCell(Graphics& g,
             return;
         }
         if (columnId == 2) {
-            URL trackURL;
-            if (searchBar.isEmpty()) {
-                trackURL = URL{ tracks[rowNumber] };
+            //never touch the file here: show a placeholder until the scanner has probed it
+            String trackLength{"..."};
+            TrackMetadataScanner::TrackInfo info;
+            if (track->length > 0.0) {
+                trackLength = formatLength(track->length);
             }
-            else {
-                trackURL = URL{ filteredTracks[rowNumber] };
+            else if (metadataScanner.getOrRequest(track->file, info)) {
+                trackLength = info.valid ? formatLength(info.lengthInSeconds) : String{"--:--"};
             }
-            String trackLength = getTrackLength(trackURL);
-            g.drawText(trackLength.toStdString(),
+            g.drawText(trackLength,
                 2, 0,
                 width - 4, height,
                 Justification::centredLeft,
                 true);
             return;
         }
-        if (columnId == 3) {
-            String trackTitle;
-            if (searchBar.isEmpty()) {
-                trackTitle = tracks[rowNumber].getFileNameWithoutExtension();
+        if (columnId == titleColumnId || columnId == albumColumnId || columnId == genreColumnId) {
+            //"Artist - Title" as the tags have it, or as the file name had it until they are read
+            TrackTable::Text text;
+            String cellText = columnId == titleColumnId ? track->title : String();
+            if (trackTable.getText(track->id, text)) {
+                if (columnId == titleColumnId) {
+                    cellText = text.artist.isEmpty() ? text.title : text.artist + " - " + text.title;
+                }
+                else {
+                    cellText = columnId == albumColumnId ? text.album : text.genre;
+                }
             }
-            else {
-                trackTitle = filteredTracks[rowNumber].getFileNameWithoutExtension();
+            //same audio as a track added before it, under another path
+            if (columnId == titleColumnId && duplicateFinder.getDuplicateOf(track->id) != 0) {
+                g.setColour(Colour(255, 190, 0));
+                cellText << "  (duplicate)";
+            }
+            //the file was gone when the library was checked at startup
+            if (columnId == titleColumnId && library.isMissing(track->id)) {
+                g.setColour(Colours::grey);
+                cellText << "  (missing)";
+            }
+            g.drawText(cellText,
+                2, 0,
+                width - 4, height,
+                Justification::centredLeft,
+                true);
+            return;
+        }
+        if (columnId == bpmColumnId || columnId == keyColumnId || columnId == dateAddedColumnId || columnId == yearColumnId) {
+            //left blank until the tags have been read
+            String text;
+            TrackTable::Values values;
+            if (trackTable.getValues(track->id, values)) {
+                if (columnId == bpmColumnId && values.bpm > 0.0f) {
+                    text = String(values.bpm, 1);
+                }
+                else if (columnId == keyColumnId) {
+                    text = TrackTable::getCamelotKeyName(values.key);
+                }
+                else if (columnId == dateAddedColumnId && values.dateAdded > 0) {
+                    text = Time(values.dateAdded).formatted("%d/%m/%y");
+                }
+                else if (columnId == yearColumnId && values.year > 0) {
+                    text = String(values.year);
+                }
             }
-            g.drawText(trackTitle.toStdString(),
+            g.drawText(text,
                 2, 0,
                 width - 4, height,
                 Justification::centredLeft,
                 true);
             return;
         }
+        if (columnId == ratingColumnId) {
+            TrackTable::Values values;
+            drawRating(g, width, height, trackTable.getValues(track->id, values) ? values.rating : 0);
+            return;
+        }
+        //the deck and delete buttons are only drawn; cellClicked() does the rest,
+        //so scrolling never creates components
+        if (isButtonColumn(columnId)) {
+            static const String leftDeckText{"L Deck"}, rightDeckText{"R Deck"}, deleteText{"X"};
+            const Rectangle<float> area = getCellButtonArea(width, height).toFloat();
+            if (columnId == loadLeftColumnId) {
+                drawCellButton(g, area, leftDeckText, Colours::springgreen, Colours::black);
+            }
+            else if (columnId == loadRightColumnId) {
+                drawCellButton(g, area, rightDeckText, Colours::deeppink, Colours::black);
+            }
+            else {
+                drawCellButton(g, area, deleteText, Colour(229, 204, 255), Colour(220, 0, 0));
+            }
+            return;
+        }
         g.setColour(Colour(60, 60, 60));
         g.drawRect(getLocalBounds(), 1);
     }
 }
 
-Component* PlaylistComponent::refreshComponentForCell(int 	rowNumber,
-                                                      int 	columnId,
-                                                      bool 	isRowSelected,
-                                                      Component* existingComponentToUpdate)
+void PlaylistComponent::drawRating(Graphics& g, int width, int height, int rating)
 {
-    //Inspired by the last topic's lectures' code, create buttons in columns 6,7 and 8 
-    //for loading tracks to the two decks and deleting tracks from the list  
-    //unique ids are also created for each button for the ButtonListener torecognise which button is clicked
-    
-    if (columnId == 4){
-        if (existingComponentToUpdate == nullptr){
+    //five equal slots across the cell, the same ones rateTrack() hit tests
+    const float slot = width / 5.0f;
+    const float radius = jmax(2.0f, jmin(slot, static_cast<float>(height)) * 0.4f);
+    for (int i = 0; i < 5; ++i) {
+        Path star;
+        star.addStar({ slot * (i + 0.5f), height * 0.5f }, 5, radius * 0.45f, radius);
+        if (i < rating) {
+            g.setColour(Colours::gold);
+            g.fillPath(star);
+        }
+        else {
+            g.setColour(Colours::grey);
+            g.strokePath(star, PathStrokeType(1.0f));
+        }
+    }
+}
+
+bool PlaylistComponent::isButtonColumn(int columnId)
+{
+    return columnId == loadLeftColumnId || columnId == loadRightColumnId || columnId == deleteColumnId;
+}
 
-            TextButton* btn = new TextButton{"L Deck"};
-            String id{std::to_string(rowNumber)};
-            btn->setComponentID(id);
+void PlaylistComponent::drawCellButton(Graphics& g, Rectangle<float> area, const String& text,
+                                       Colour background, Colour textColour)
+{
+    //looks like the LookAndFeel_V2 TextButtons these used to be
+    g.setColour(background);
+    g.fillRoundedRectangle(area, 3.0f);
+    g.setColour(background.darker(0.4f));
+    g.drawRoundedRectangle(area, 3.0f, 1.0f);
+    g.setColour(textColour);
+    g.setFont(14.0f);
+    g.drawText(text, area, Justification::centred, true);
+}
 
-            btn->addListener(this);
-            existingComponentToUpdate = btn;
+void PlaylistComponent::buttonClicked(Button* button)
+{
+    if (button == &loadButton){
 
-            btn->setColour(TextButton::buttonColourId, Colours::springgreen);
-            btn->setColour(TextButton::textColourOffId, Colours::black);
-            btn->setLookAndFeel(&lookAndFeel);
-            
+        FileChooser chooser{"Select files or folders..."};
+        if (chooser.browseForMultipleFilesOrDirectories()){
+            //folders are walked in the background, rows arrive in tracksImported()
+            importer.import(chooser.getResults());
         }
     }
-    if (columnId == 5){
-        if (existingComponentToUpdate == nullptr){
-
-            TextButton* btn = new TextButton{"R Deck"};
-            String id{std::to_string(rowNumber + 1000)};
-            btn->setComponentID(id);
+    else if (button == &cancelImportButton){
+        importer.cancel();
+    }
+    else if (button == &watchButton){
+        showWatchedFoldersMenu();
+    }
+    else if (button == &clearAllButton){
+        if (library.getNumTracks() > 0){
+            library.clear();
+            trackTable.clear();
+            searchIndex.clear();
+            duplicateFinder.clear();
+            metadataScanner.clear();
+            rowIds.clear();
+        }
+        tableComponent.updateContent();
+    }
+}
 
-            btn->addListener(this);
-            existingComponentToUpdate = btn;
+void PlaylistComponent::cellClicked(int rowNumber, int columnId, const MouseEvent& e)
+{
+    if (!isButtonColumn(columnId) && columnId != ratingColumnId){
+        return;
+    }
 
-            btn->setColour(TextButton::buttonColourId, Colours::deeppink);
-            btn->setColour(TextButton::textColourOffId, Colours::black);
-            btn->setLookAndFeel(&lookAndFeel);
+    //the event is relative to the row, so take off where the column starts
+    TableHeaderComponent& header = tableComponent.getHeader();
+    const Rectangle<int> column = header.getColumnPosition(header.getIndexOfColumnId(columnId, true));
+    if (columnId == ratingColumnId){
+        if (const LibraryStore::Track* track = getTrackForRow(rowNumber)){
+            rateTrack(track->id, e.x - column.getX(), column.getWidth());
         }
+        return;
+    }
+    if (!getCellButtonArea(column.getWidth(), tableComponent.getRowHeight()).contains(e.x - column.getX(), e.y)){
+        return;
     }
-    if (columnId == 6){
-        if (existingComponentToUpdate == nullptr){
-
-            TextButton* btn = new TextButton{"X"};
-            String id{std::to_string(rowNumber + 1000000)};
-            btn->setComponentID(id);
 
-            btn->addListener(this);
-            existingComponentToUpdate = btn;
+    //the row only picks the track; the action works on its id, so it doesn't matter what the rows do next
+    const LibraryStore::Track* track = getTrackForRow(rowNumber);
+    if (track == nullptr){
+        return;
+    }
+    const int64 id = track->id;
 
-            btn->setColour(TextButton::buttonColourId, Colour(229, 204, 255));
-            btn->setColour(TextButton::textColourOffId, Colour(220, 0, 0));
-            btn->setLookAndFeel(&lookAndFeel);
-        }
+    if (columnId == loadLeftColumnId){
+        loadTrack(id, deck1);
+    }
+    else if (columnId == loadRightColumnId){
+        loadTrack(id, deck2);
+    }
+    else if (columnId == deleteColumnId){
+        deleteTrack(id);
     }
-    return existingComponentToUpdate;
 }
 
-void PlaylistComponent::buttonClicked(Button* button)
+void PlaylistComponent::loadTrack(int64 id, DeckGUI* deck)
 {
-    if (button == &loadButton){
+    if (const LibraryStore::Track* track = library.findTrack(id)){
+        deck->loadTrack(URL{ track->file }, track->title);
+        trackTable.incrementPlayCount(id);
+        library.incrementPlayCount(id);
+    }
+}
 
-        FileChooser chooser{"Select a file..."};
-        if (chooser.browseForMultipleFilesToOpen()){
-            for (const File& file : chooser.getResults()){
+void PlaylistComponent::rateTrack(int64 id, int x, int columnWidth)
+{
+    if (columnWidth <= 0){
+        return;
+    }
+    //clicking the star of the current rating takes the rating away
+    int rating = jlimit(1, 5, x * 5 / columnWidth + 1);
+    TrackTable::Values values;
+    if (trackTable.getValues(id, values) && values.rating == rating){
+        rating = 0;
+    }
+    trackTable.setRating(id, rating);
+    library.setRating(id, rating);
+    tableComponent.repaint();
+}
 
-                File newTrack{file};
-                String newTrackTitle = newTrack.getFileNameWithoutExtension();
-                // if not already loaded in Playlist:
-                if (!(std::find(tracks.begin(), tracks.end(), file) != tracks.end())){
-                    
-                    tracks.push_back(newTrack);
-                }
-                else{ // display error message
-                    juce::AlertWindow::showMessageBox(AlertWindow::AlertIconType::InfoIcon,
-                                                      "Action Not Completed - Reason:",
-                                                      newTrackTitle + " is already loaded!");
-                }
-            }
-        }
+void PlaylistComponent::deleteTrack(int64 id)
+{
+    if (const LibraryStore::Track* track = library.findTrack(id)){
+        removeTracks({ track->file });
         tableComponent.updateContent();
+        tableComponent.repaint();
     }
-    else if (button == &clearAllButton){
-        if (tracks.size() > 0){
-            tracks.clear();
+}
+
+Rectangle<int> PlaylistComponent::getCellButtonArea(int width, int height)
+{
+    //the same margin the old TextButtons had around them
+    return Rectangle<int>(width, height).reduced(2);
+}
+
+const LibraryStore::Track* PlaylistComponent::getTrackForRow(int rowNumber) const
+{
+    if (hasRowOrder){
+        if (rowNumber < 0 || rowNumber >= static_cast<int>(rowIds.size())){
+            return nullptr;
         }
-        tableComponent.updateContent();
+        return library.findTrack(rowIds[static_cast<size_t>(rowNumber)]);
     }
-    else{
-        int id = std::stoi(button->getComponentID().toStdString());
-        if (id < 1000){ //Add to L Deck button
-            if (searchBar.isEmpty()){
-                URL trackURL = URL{ tracks[id] };
-                String trackTitle = tracks[id].getFileNameWithoutExtension();
-                deck1->loadTrack(trackURL, trackTitle);
-            }
-            else{
-                URL trackURL = URL{ filteredTracks[id] };
-                String trackTitle = filteredTracks[id].getFileNameWithoutExtension();
-                deck1->loadTrack(trackURL, trackTitle);
-            }
-            
-        }
-        else if (id >= 1000 && id < 1000000){ //Add to R Deck button
-            if (searchBar.isEmpty()){
-                URL trackURL = URL{ tracks[id - 1000]};
-                String trackTitle = tracks[id - 1000].getFileNameWithoutExtension();
-                deck2->loadTrack(trackURL, trackTitle);
-            }
-            else{
-                URL trackURL = URL{ filteredTracks[id - 1000] };
-                String trackTitle = filteredTracks[id - 1000].getFileNameWithoutExtension();
-                deck2->loadTrack(trackURL, trackTitle);
-            }
-        }        
-        else{ //Delete track button
-            if (searchBar.isEmpty()){
-                tracks.erase(tracks.begin() + (id - 1000000));
-            }
-            else{ // if playlist is filtered by search function
-                int index = (id - 1000000);
-                for (int i = 0; i < tracks.size(); ++i)//loops through tracks vector
-                {
-                    if (tracks[i] == filteredTracks[index]) //locates selected track for deletion
-                    {
-                        tracks.erase(tracks.begin() + i);// deletes track in (original) tracks vector
-                    }
-                }
-                filteredTracks.erase(filteredTracks.begin() + index); // deletes selected track in filteredTracks vector
-            }
-            tableComponent.updateContent();
-        }
+    if (rowNumber < 0 || rowNumber >= library.getNumTracks()){
+        return nullptr;
     }
-    
+    //only the rows being painted are ever made into Tracks
+    return &library.getTrack(rowNumber);
+}
+
+void PlaylistComponent::metadataReady(const File& file, const TrackMetadataScanner::TrackInfo& info)
+{
+    if (info.valid){
+        //kept by the library, so the file isn't probed again next session
+        const int64 id = library.getId(file);
+        trackTable.setDuration(id, info.lengthInSeconds);
+        library.setLength(id, info.lengthInSeconds);
+    }
+    //repaints are coalesced, so a burst of results still costs one paint
+    tableComponent.repaint();
+}
+
+void PlaylistComponent::tracksImported(const Array<File>& files)
+{
+    addTracks(files);
+    tableComponent.updateContent();
+}
+
+void PlaylistComponent::importProgressChanged(double progress)
+{
+    importProgress = progress;
+    if (!importProgressBar.isVisible()){
+        playlistLabel.setVisible(false);
+        importProgressBar.setVisible(true);
+        cancelImportButton.setVisible(true);
+    }
+}
+
+void PlaylistComponent::importFinished(const TrackImporter::Summary& summary)
+{
+    importProgress = 0.0;
+    importProgressBar.setVisible(false);
+    cancelImportButton.setVisible(false);
+    playlistLabel.setVisible(true);
+
+    // a single file added is obvious from the table, anything more gets one summary
+    if (summary.duplicates == 0 && summary.filesSkipped == 0 && summary.foldersScanned == 0 && !summary.cancelled){
+        return;
+    }
+    String message;
+    message << summary.tracksAdded << " track(s) added";
+    if (summary.duplicates > 0){
+        message << "\n" << summary.duplicates << " already in the playlist";
+    }
+    if (summary.filesSkipped > 0){
+        message << "\n" << summary.filesSkipped << " file(s) skipped (not audio)";
+    }
+    if (summary.foldersScanned > 0){
+        message << "\n" << summary.foldersScanned << " folder(s) scanned";
+    }
+    AlertWindow::showMessageBoxAsync(AlertWindow::AlertIconType::InfoIcon,
+                                     summary.cancelled ? "Import Cancelled" : "Import Finished",
+                                     message);
+}
+
+void PlaylistComponent::duplicateFound(int64 id, int64 duplicateOfId)
+{
+    tableComponent.repaint();
 }
 
 bool PlaylistComponent::isInterestedInFileDrag(const StringArray& files)
@@ -351,24 +565,13 @@ bool PlaylistComponent::isInterestedInFileDrag(const StringArray& files)
 void PlaylistComponent::filesDropped(const StringArray& files, int x, int y)
 {
     if (files.size() >= 1){
+        Array<File> droppedFiles;
         for (int i = 0; i < files.size(); ++i){
-
-            File newTrack{ files[i] };
-            String newTrackTitle = newTrack.getFileNameWithoutExtension();
-
-            // if not already loaded in Playlist, add it 
-            if (!(std::find(tracks.begin(), tracks.end(), files[i]) != tracks.end())){
-                
-                tracks.push_back(newTrack);
-            }
-            else{   // display error message
-                juce::AlertWindow::showMessageBox(AlertWindow::AlertIconType::InfoIcon,
-                                                  "Action Not Completed - Reason:",
-                                                  newTrackTitle + " is already loaded!");
-            }
+            droppedFiles.add(File{ files[i] });
         }
+        //folders are walked in the background, rows arrive in tracksImported()
+        importer.import(droppedFiles);
     }
-    tableComponent.updateContent();
 }
 
 String PlaylistComponent::formatLength(double _secs)
@@ -392,48 +595,344 @@ String PlaylistComponent::formatLength(double _secs)
     return String{ mins + ":" + secs };
 }
 
-String PlaylistComponent::getTrackLength(juce::URL audioURL)
+void PlaylistComponent::loadPlaylist()
 {
-    player -> loadURL(audioURL);
-
-    //get track length in seconds(double) using DJAudioPlayer object "player"
-    double secs {player -> getLengthInSeconds()};
+    StartupTrace::ScopedPhase phase("library open");
 
-    //turn length to string format of 
-    String mins {formatLength(secs)};
+    // the old playlist.txt (saved in the working directory) is imported the first time only
+    if (!library.open(File::getCurrentWorkingDirectory().getChildFile("playlist.txt"))){
+        std::cout << "PlaylistComponent::loadPlaylist library could not be opened, changes will not be saved" << std::endl;
+    }
 
-    return mins;
+    // the rows show straight away; the indexes are filled in chunks from the message loop
+    triggerAsyncUpdate();
 }
 
-void PlaylistComponent::loadPlaylist()
+void PlaylistComponent::handleAsyncUpdate()
 {
-    // create input stream from the saved playlist
-    std::ifstream playlist("playlist.txt");
-    std::string filePath;
+    // library ids only grow, so everything after the last indexed id is new (clearing doesn't reuse ids)
+    const int first = library.getIndexAfter(lastIndexedId);
+    const int last = jmin(library.getNumTracks(), first + tracksPerIndexChunk);
+    for (int i = first; i < last; ++i){
+        // not kept by the library, so indexing doesn't hold every track in memory
+        const LibraryStore::Track track = library.readTrack(i);
+        trackTable.addRow(track.id, track.file, track.dateAdded);
+        trackTable.setPlayCount(track.id, track.playCount);
+        trackTable.setRating(track.id, track.rating);
+        // lengths not kept yet are probed in the background, so length filters and sorting see every track
+        if (track.length > 0.0){
+            trackTable.setDuration(track.id, track.length);
+        }
+        else{
+            TrackMetadataScanner::TrackInfo info;
+            if (metadataScanner.getOrRequest(track.file, info) && info.valid){
+                trackTable.setDuration(track.id, info.lengthInSeconds);
+                library.setLength(track.id, info.lengthInSeconds);
+            }
+        }
+        // tags kept by the library are used as they are, only files never read are opened
+        if (track.hasTags){
+            showTags(track.id, track.tags);
+            searchIndex.add(track.id, getSearchText(track.title, track.tags));
+        }
+        else{
+            searchIndex.add(track.id, track.title);
+            tagReader.read(track.id, track.file);
+        }
+        duplicateFinder.addTrack(track.id, track.file);
+        lastIndexedId = track.id;
+    }
 
-    // read saved file, line by line
-    if (playlist.is_open()){
-        while (getline(playlist, filePath)) {
+    if (last < library.getNumTracks()){
+        triggerAsyncUpdate();
+        return;
+    }
+    if (!libraryIndexed){
+        libraryIndexed = true;
+        StartupTrace::mark("library indexed");
+    }
+    if (hasRowOrder && last > first){
+        // the search or sort so far only saw part of the library
+        refreshRows(true);
+    }
+}
 
-            File newTrack{filePath};
-            tracks.push_back(newTrack);
+void PlaylistComponent::addTracks(const Array<File>& files)
+{
+    // the importer has already dropped duplicates, this only guards against a track
+    // added some other way in the meantime
+    Array<File> newTracks;
+    for (const File& file : files){
+        if (!library.contains(file)){
+            newTracks.add(file);
         }
     }
-    playlist.close();
+    // saved with a single write to the journal
+    library.addTracks(newTracks);
+
+    // the new tracks are at the end of the library, after any still waiting to be indexed
+    if (newTracks.size() > 0){
+        handleAsyncUpdate();
+    }
 }
 
 void PlaylistComponent::filterPlaylist(String input)
 {
-    filteredTracks.clear();
+    refreshRows(false);
+}
+
+void PlaylistComponent::refreshRows(bool immediately)
+{
+    const String input = searchBar.getText();
+    if (input.trim().isEmpty() && !searchIndex.isSorted()){
+        // the library order needs no row list at all
+        searchIndex.cancel();
+        hasRowOrder = false;
+        rowIds.clear();
+        tableComponent.updateContent();
+        tableComponent.repaint();
+        return;
+    }
+
+    // the search (and sort) runs in the background, see searchResultsReady();
+    // typing waits for a pause, a new sort order or new tracks don't
+    if (immediately){
+        searchIndex.searchNow(input);
+    }
+    else{
+        searchIndex.search(input);
+    }
+}
+
+void PlaylistComponent::searchResultsReady(const String& query, const std::vector<int64>& ids)
+{
+    // the old rows stay up until the new order is ready, then it is swapped in whole
+    rowIds = ids;
+    hasRowOrder = true;
+    tableComponent.updateContent();
+    tableComponent.repaint();
+}
+
+void PlaylistComponent::sortOrderChanged(int newSortColumnId, bool isForwards)
+{
+    const bool ascending = isForwards;
+    std::vector<TrackTable::SortKey> newKeys;
 
-    for (File& t : tracks){
-        if (t.getFileNameWithoutExtension().containsIgnoreCase(input)){
-            if (!(std::find(filteredTracks.begin(), filteredTracks.end(), input) != filteredTracks.end())){
-                
-                filteredTracks.push_back(t);
+    // the title shows "Artist - Title", so that is how it sorts
+    if (newSortColumnId == titleColumnId){
+        newKeys.push_back({ TrackTable::artistColumn, ascending });
+        newKeys.push_back({ TrackTable::titleColumn, ascending });
+    }
+    else if (newSortColumnId == lengthColumnId){
+        newKeys.push_back({ TrackTable::durationColumn, ascending });
+    }
+    else if (newSortColumnId == bpmColumnId){
+        newKeys.push_back({ TrackTable::bpmColumn, ascending });
+    }
+    else if (newSortColumnId == keyColumnId){
+        newKeys.push_back({ TrackTable::keyColumn, ascending });
+    }
+    else if (newSortColumnId == dateAddedColumnId){
+        newKeys.push_back({ TrackTable::dateAddedColumn, ascending });
+    }
+    else if (newSortColumnId == albumColumnId){
+        newKeys.push_back({ TrackTable::albumColumn, ascending });
+    }
+    else if (newSortColumnId == genreColumnId){
+        newKeys.push_back({ TrackTable::genreColumn, ascending });
+    }
+    else if (newSortColumnId == yearColumnId){
+        newKeys.push_back({ TrackTable::yearColumn, ascending });
+    }
+    else if (newSortColumnId == ratingColumnId){
+        newKeys.push_back({ TrackTable::ratingColumn, ascending });
+    }
+
+    // shift-click keeps the columns sorted so far and sorts their ties by this one
+    if (ModifierKeys::currentModifiers.isShiftDown()){
+        for (const TrackTable::SortKey& newKey : newKeys){
+            sortKeys.erase(std::remove_if(sortKeys.begin(), sortKeys.end(), [&newKey] (const TrackTable::SortKey& key) {
+                return key.column == newKey.column;
+            }), sortKeys.end());
+        }
+        sortKeys.insert(sortKeys.end(), newKeys.begin(), newKeys.end());
+    }
+    else{
+        sortKeys = newKeys;
+    }
+
+    searchIndex.setSortOrder(sortKeys);
+    refreshRows(true);
+}
+
+void PlaylistComponent::removeTracks(const Array<File>& files)
+{
+    std::unordered_set<int64> removedIds;
+    for (const File& file : files){
+        const int64 id = library.getId(file);
+        if (id != 0){
+            removedIds.insert(id);
+            trackTable.removeRow(id);
+            searchIndex.remove(id);
+            duplicateFinder.removeTrack(id, file);
+            metadataScanner.remove(file);
+        }
+    }
+    // saved with a single write to the journal
+    library.removeTracks(files);
+
+    // the rows are ids, so the others stay where they are
+    rowIds.erase(std::remove_if(rowIds.begin(), rowIds.end(), [&removedIds] (int64 id) {
+        return removedIds.count(id) > 0;
+    }), rowIds.end());
+}
+
+void PlaylistComponent::tagsRead(const std::vector<TagReader::Result>& results)
+{
+    // kept even when empty, so the files aren't read again next session
+    library.setTags(results);
+
+    std::vector<std::pair<int64, String>> texts;
+    for (const TagReader::Result& result : results){
+        const TagReader::Tags& tags = result.tags;
+        // a track deleted since it was queued is not in the library any more
+        const LibraryStore::Track* track = library.findTrack(result.id);
+        if (track == nullptr || tags.isEmpty()){
+            continue;
+        }
+        showTags(result.id, tags);
+        texts.emplace_back(result.id, getSearchText(track->title, tags));
+    }
+    // one pass over the index for the whole batch
+    searchIndex.setTexts(texts);
+
+    // rows already sorted stay where they are until the next search or sort
+    tableComponent.repaint();
+}
+
+void PlaylistComponent::showTags(int64 id, const TagReader::Tags& tags)
+{
+    trackTable.setTags(id, tags.title, tags.artist, tags.album, tags.genre, tags.year);
+    if (tags.bpm > 0.0){
+        trackTable.setBpm(id, tags.bpm);
+    }
+    if (tags.key > 0){
+        trackTable.setKey(id, tags.key);
+    }
+}
+
+String PlaylistComponent::getSearchText(const String& fileTitle, const TagReader::Tags& tags)
+{
+    // still found by its file name as well
+    return fileTitle + " " + tags.artist + " " + tags.title + " " + tags.album + " " + tags.genre;
+}
+
+void PlaylistComponent::watchedFilesChanged(const FolderWatcher::Changes& changes)
+{
+    // removals first, so a folder deleted and made again ends up with its new files
+    Array<File> removed = changes.filesRemoved;
+    for (const File& folder : changes.foldersRemoved){
+        removed.addArray(library.getFilesIn(folder));
+    }
+
+    // a folder listed again is compared with the library as it is now
+    Array<File> listed;
+    for (const FolderWatcher::FolderListing& listing : changes.foldersListed){
+        std::unordered_set<String, LibraryStore::PathHash> onDisk;
+        for (const File& file : listing.files){
+            onDisk.insert(file.getFullPathName());
+        }
+        for (const File& file : library.getFilesIn(listing.folder)){
+            // getFilesIn() also has the subfolders, which are listed on their own
+            if (file.getParentDirectory() == listing.folder && onDisk.count(file.getFullPathName()) == 0){
+                removed.add(file);
             }
         }
+        listed.addArray(listing.files);
+    }
+    removeTracks(removed);
+
+    // a file may have gone again since the change was seen; ones already in the library are skipped
+    Array<File> added;
+    for (const File& file : changes.filesAdded){
+        if (file.existsAsFile()){
+            added.add(file);
+        }
+    }
+    for (const File& file : listed){
+        if (file.existsAsFile()){
+            added.add(file);
+        }
     }
+    addTracks(added);
+
     tableComponent.updateContent();
     tableComponent.repaint();
-}
\ No newline at end of file
+}
+
+size_t PlaylistComponent::getMemoryUsage() const
+{
+    // the tracks themselves are counted by the library
+    return rowIds.capacity() * sizeof(int64) + sortKeys.capacity() * sizeof(TrackTable::SortKey);
+}
+
+void PlaylistComponent::libraryChecked()
+{
+    // only the missing marks change
+    tableComponent.repaint();
+}
+
+void PlaylistComponent::snapshotDamaged(const File& copy)
+{
+    // nothing is saved over the library file until one of the two is picked
+    Component::SafePointer<PlaylistComponent> safeThis(this);
+    AlertWindow::showOkCancelBox(AlertWindow::AlertIconType::WarningIcon,
+                                 "Library Damaged",
+                                 "The saved library is damaged, a copy was kept as\n" + copy.getFullPathName()
+                                 + "\n\nRebuild it from the changes made since it was last saved "
+                                   "(tracks from before then are dropped), or keep using it as it is?",
+                                 "Rebuild", "Keep", nullptr,
+                                 ModalCallbackFunction::create([safeThis] (int result) {
+        if (safeThis == nullptr){
+            return;
+        }
+        PlaylistComponent& playlist = *safeThis;
+        if (result != 1){
+            playlist.library.keepDamagedSnapshot();
+            return;
+        }
+        playlist.library.rebuildFromJournal();
+
+        // the ids left are ones indexed already, so the indexes start over
+        playlist.trackTable.clear();
+        playlist.searchIndex.clear();
+        playlist.duplicateFinder.clear();
+        playlist.rowIds.clear();
+        playlist.lastIndexedId = 0;
+        playlist.triggerAsyncUpdate();
+        playlist.tableComponent.updateContent();
+    }));
+}
+
+void PlaylistComponent::showWatchedFoldersMenu()
+{
+    PopupMenu menu;
+    menu.addItem("Watch a folder...", [this] {
+        FileChooser chooser{"Select a music folder to watch..."};
+        if (chooser.browseForDirectory()){
+            // the files already there are imported once, the watcher takes over from then on
+            folderWatcher.addFolder(chooser.getResult());
+            importer.import({ chooser.getResult() });
+        }
+    });
+
+    const Array<File> folders = folderWatcher.getFolders();
+    if (!folders.isEmpty()){
+        menu.addSeparator();
+        menu.addSectionHeader("Stop watching (tracks stay in the playlist)");
+        for (const File& folder : folders){
+            menu.addItem(folder.getFullPathName(), [this, folder] { folderWatcher.removeFolder(folder); });
+        }
+    }
+    menu.showMenuAsync(PopupMenu::Options().withTargetComponent(&watchButton));
+}
@@ -12,10 +12,16 @@
 
 #include <JuceHeader.h>
 #include "DeckGUI.h"
-#include "DJAudioPlayer.h"
+#include "TrackMetadataScanner.h"
+#include "LibraryStore.h"
+#include "SearchIndex.h"
+#include "DuplicateFinder.h"
+#include "TagReader.h"
+#include "TrackImporter.h"
+#include "FolderWatcher.h"
+#include <unordered_set>
 #include <vector>
 #include <string>
-#include <fstream>
 #include <filesystem>
 
 
@@ -26,13 +32,28 @@ class PlaylistComponent  : public Component,
                            public TableListBoxModel,
                            public Button::Listener,
                            public TextEditor::Listener,
-                           public FileDragAndDropTarget
+                           public FileDragAndDropTarget,
+                           public TrackMetadataScanner::Listener,
+                           public SearchIndex::Listener,
+                           public DuplicateFinder::Listener,
+                           public TagReader::Listener,
+                           public TrackImporter::Listener,
+                           public FolderWatcher::Listener,
+                           public LibraryStore::Listener,
+                           private AsyncUpdater
 {
 public:
     /**PlayListComponent constructor*/
     PlaylistComponent(DeckGUI* deck1,
                       DeckGUI* deck2,
-                      DJAudioPlayer* metadataplayer);
+                      TrackMetadataScanner& metadataScanner,
+                      LibraryStore& library,
+                      TrackTable& trackTable,
+                      SearchIndex& searchIndex,
+                      DuplicateFinder& duplicateFinder,
+                      TagReader& tagReader,
+                      TrackImporter& importer,
+                      FolderWatcher& folderWatcher);
     /**PlayListComponent destructor*/
     ~PlaylistComponent() override;
 
@@ -58,11 +79,11 @@ public:
                     int height,
                     bool rowIsSelected) override;
 
-    /**Creates and tracks customised components for certain cells; used to add buttons */
-    Component* refreshComponentForCell(int 	rowNumber,
-                                       int 	columnId,
-                                       bool 	isRowSelected,
-                                       Component* existingComponentToUpdate) override;
+    /**Sorts the rows in the background by the clicked column (shift-click adds a column)*/
+    void sortOrderChanged(int newSortColumnId, bool isForwards) override;
+
+    /**Loads or deletes the track when one of the buttons drawn in its row is clicked*/
+    void cellClicked(int rowNumber, int columnId, const MouseEvent& e) override;
 
     //Button::Listener pure virtual function:
     /**Called to take certain actions when a PlaylistComponent button is clicked*/
@@ -74,12 +95,72 @@ public:
     /**Function that indicates that files are dropped in PlaylistCommponent and processes them*/
     void filesDropped(const StringArray& files, int x, int y) override;
 
+    //TrackMetadataScanner::Listener pure virtual function:
+    /**Repaints the table once a track's length is known*/
+    void metadataReady(const File& file, const TrackMetadataScanner::TrackInfo& info) override;
+
+    //SearchIndex::Listener pure virtual function:
+    /**Shows the rows matching the search bar once the background search is done*/
+    void searchResultsReady(const String& query, const std::vector<int64>& ids) override;
+
+    //DuplicateFinder::Listener pure virtual function:
+    /**Repaints the table so the copy is marked*/
+    void duplicateFound(int64 id, int64 duplicateOfId) override;
+
+    //TagReader::Listener pure virtual function:
+    /**Fills the metadata columns and the search index with the tags of a batch of tracks*/
+    void tagsRead(const std::vector<TagReader::Result>& results) override;
+
+    //TrackImporter::Listener pure virtual functions:
+    /**Adds a batch of imported tracks to the playlist while the import goes on*/
+    void tracksImported(const Array<File>& files) override;
+    /**Shows the progress bar and moves it on*/
+    void importProgressChanged(double progress) override;
+    /**Hides the progress bar and shows one summary of the whole import*/
+    void importFinished(const TrackImporter::Summary& summary) override;
+
+    //FolderWatcher::Listener pure virtual function:
+    /**Adds and removes the tracks that changed in the watched folders*/
+    void watchedFilesChanged(const FolderWatcher::Changes& changes) override;
+
+    /**Estimated bytes held by the rows of a search or sort*/
+    size_t getMemoryUsage() const;
+
+    //LibraryStore::Listener pure virtual function:
+    /**Repaints the table so tracks whose files are gone are marked*/
+    void libraryChecked() override;
+    /**Asks whether to rebuild the library from its journal or keep it as it is*/
+    void snapshotDamaged(const File& copy) override;
+
 private:
+    //the deck and delete columns hold the buttons drawn in paintCell()
+    enum ColumnIds
+    {
+        lengthColumnId = 2,
+        titleColumnId = 3,
+        bpmColumnId = 7,
+        keyColumnId = 8,
+        dateAddedColumnId = 9,
+        albumColumnId = 10,
+        genreColumnId = 11,
+        yearColumnId = 12,
+        ratingColumnId = 13,
+        loadLeftColumnId = 4,
+        loadRightColumnId = 5,
+        deleteColumnId = 6
+    };
 
-    //a juce files vector which will hold all files loaded or dropped in the playlist
-    std::vector<juce::File> tracks;
-    //a secondary juce files vector holding all files loaded/dropped, but updated when searchBar has an input
-    std::vector<juce::File> filteredTracks;
+    //the tracks themselves live in the library; while searching or sorted, the rows
+    //are the ids of the tracks to show, in the order to show them
+    std::vector<int64> rowIds;
+    bool hasRowOrder = false;
+    //what the header asked for, most significant first
+    std::vector<TrackTable::SortKey> sortKeys;
+    //tracks up to this id are in the table, the search index, the duplicate finder and the tag reader;
+    //the rest are added a chunk at a time, so opening a big library doesn't hold up the first paint
+    int64 lastIndexedId = 0;
+    //set once the tracks there were at startup are all indexed
+    bool libraryIndexed = false;
     
     //our playlist component, displayed as a TableListBox
     TableListBox tableComponent;
@@ -93,23 +174,83 @@ private:
     //text button used for clearing all tracks from the playlist
     TextButton clearAllButton{ "CLEAR ALL" };
 
+    //text button opening the menu of watched music folders
+    TextButton watchButton{ "FOLDERS" };
+
+    //progress of a folder import, shown with its cancel button instead of playlistLabel
+    double importProgress = 0.0;
+    ProgressBar importProgressBar{ importProgress };
+    TextButton cancelImportButton{ "CANCEL" };
+
     //search bar implemented as TextEditor
     TextEditor searchBar;
 
     DeckGUI* deck1;
     DeckGUI* deck2;
-    DJAudioPlayer* player;
+
+    //track lengths are probed in the background, paintCell only reads the results
+    TrackMetadataScanner& metadataScanner;
+
+    //every add/delete is saved straight away
+    LibraryStore& library;
+
+    //per-track metadata columns, for the field filters of the search bar
+    TrackTable& trackTable;
+
+    //titles are indexed as they are added, searches run in the background
+    SearchIndex& searchIndex;
+
+    //tracks are fingerprinted in the background to spot the same song under two paths
+    DuplicateFinder& duplicateFinder;
+
+    //title, artist, album ... are read from the file headers in the background
+    TagReader& tagReader;
+
+    //dropped files and folders are imported in the background
+    TrackImporter& importer;
+
+    //watched folders keep the playlist in step with the disk
+    FolderWatcher& folderWatcher;
 
     LookAndFeel_V2 lookAndFeel;
 
     /**function that gets seconds (double) and turns it to string of mm:ss format*/
     String formatLength(double seconds);
-    /**function that gets the track length in seconds and turns it to string of mm:ss format*/
-    String getTrackLength(URL audioURL);
     /** function that filters tracks on playlist by searchBar input */
     void filterPlaylist(String input);
-    /**function that loads the Playlist that was saved upon closure of app*/
+    /** returns the track shown in a row (filtered or not), or nullptr */
+    const LibraryStore::Track* getTrackForRow(int rowNumber) const;
+    /**function that loads the Playlist from the library store (and imports the old playlist.txt once)*/
     void loadPlaylist();
+    /**function that adds imported tracks to the playlist and the library, skipping any already there*/
+    void addTracks(const Array<File>& files);
+    /**function that removes tracks from the playlist and the library in one go*/
+    void removeTracks(const Array<File>& files);
+    /**function that adds the next chunk of library tracks to the per-track indexes*/
+    void handleAsyncUpdate() override;
+    /**function that asks for the rows again for the current search text and sort order*/
+    void refreshRows(bool immediately);
+    /**function that loads a library track to a deck*/
+    void loadTrack(int64 id, DeckGUI* deck);
+    /**function that deletes a library track from the playlist*/
+    void deleteTrack(int64 id);
+    /**function that puts a track's tags in the table columns*/
+    void showTags(int64 id, const TagReader::Tags& tags);
+    /**function that gives the text a track is found by: its file name and its tags*/
+    static String getSearchText(const String& fileTitle, const TagReader::Tags& tags);
+    /**function that draws one of the row buttons in a cell*/
+    static void drawCellButton(Graphics& g, Rectangle<float> area, const String& text,
+                               Colour background, Colour textColour);
+    /**function that draws a track's rating as five stars, filled up to the rating*/
+    static void drawRating(Graphics& g, int width, int height, int rating);
+    /**function that sets the rating of a track from where its rating cell was clicked*/
+    void rateTrack(int64 id, int x, int columnWidth);
+    /**true for the columns holding the buttons drawn in paintCell()*/
+    static bool isButtonColumn(int columnId);
+    /**area of a cell taken by its button, for drawing and for hit testing*/
+    static Rectangle<int> getCellButtonArea(int width, int height);
+    /**function that shows the menu for adding and removing watched folders*/
+    void showWatchedFoldersMenu();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlaylistComponent)
 };
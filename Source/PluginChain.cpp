@@ -0,0 +1,297 @@
+/*
+  ==============================================================================
+
+    PluginChain.cpp
+    Created: 19 Oct 2026 1:22:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "PluginChain.h"
+
+//==============================================================================
+/*
+    Window for a plugin's editor; closing it only hides it, the chain
+    deletes it with the plugin.
+*/
+class PluginChain::EditorWindow  : public DocumentWindow
+{
+public:
+    EditorWindow(AudioPluginInstance& _plugin)
+                : DocumentWindow(_plugin.getName(), Colour(22, 22, 22), DocumentWindow::closeButton),
+                  plugin(_plugin)
+    {
+        setUsingNativeTitleBar(true);
+        //plugins without an editor get the generic one (a slider per parameter)
+        AudioProcessorEditor* editor = plugin.hasEditor() ? plugin.createEditorIfNeeded() : nullptr;
+        if (editor == nullptr){
+            editor = new GenericAudioProcessorEditor(plugin);
+        }
+        setContentOwned(editor, true);
+        setResizable(editor->isResizable(), false);
+        centreWithSize(getWidth(), getHeight());
+    }
+
+    void closeButtonPressed() override
+    {
+        setVisible(false);
+    }
+
+    AudioPluginInstance& plugin;
+};
+
+//==============================================================================
+PluginChain::PluginChain(AudioPluginFormatManager& _formatManager)
+                        : formatManager(_formatManager)
+{
+}
+
+PluginChain::~PluginChain()
+{
+    masterReference.clear();
+    clear();
+}
+
+void PluginChain::addPlugin(const PluginDescription& description, const MemoryBlock& state)
+{
+    pending.push_back({ description, state });
+    if (pending.size() == 1){
+        createNextPlugin();
+    }
+}
+
+void PluginChain::createNextPlugin()
+{
+    //made on the message thread later on (plugins like to be made there), without holding this one up
+    WeakReference<PluginChain> weakThis(this);
+    const int generation = pendingGeneration;
+    const double sampleRate = preparedSampleRate > 0.0 ? preparedSampleRate : 44100.0;
+    const int blockSize = preparedBlockSize > 0 ? preparedBlockSize : 512;
+    formatManager.createPluginInstanceAsync(pending.front().description, sampleRate, blockSize,
+        [weakThis, generation] (std::unique_ptr<AudioPluginInstance> instance, const String& error) {
+            if (weakThis != nullptr){
+                weakThis->pluginCreated(std::move(instance), error, generation);
+            }
+        });
+}
+
+void PluginChain::pluginCreated(std::unique_ptr<AudioPluginInstance> instance, const String& error, int generation)
+{
+    if (generation != pendingGeneration){
+        return;
+    }
+    PendingPlugin made = pending.front();
+    pending.erase(pending.begin());
+    if (!pending.empty()){
+        createNextPlugin();
+    }
+
+    if (instance == nullptr){
+        std::cout << "PluginChain::pluginCreated could not make " << made.description.name << ": " << error << std::endl;
+        made.position = plugins.size();
+        unavailable.push_back(made);
+        return;
+    }
+
+    //the decks are stereo; plugins that insist on more channels (e.g. a side chain) can't be fed
+    AudioProcessor::BusesLayout stereo;
+    stereo.inputBuses.add(AudioChannelSet::stereo());
+    stereo.outputBuses.add(AudioChannelSet::stereo());
+    instance->setBusesLayout(stereo);
+    if (instance->getTotalNumInputChannels() > 2 || instance->getTotalNumOutputChannels() > 2){
+        std::cout << "PluginChain::pluginCreated " << instance->getName() << " needs more than 2 channels" << std::endl;
+        made.position = plugins.size();
+        unavailable.push_back(made);
+        return;
+    }
+
+    if (made.state.getSize() > 0){
+        instance->setStateInformation(made.state.getData(), static_cast<int>(made.state.getSize()));
+    }
+
+    //prepared before it goes in, so the audio thread only waits for the swap
+    double sampleRate = preparedSampleRate;
+    int blockSize = preparedBlockSize;
+    if (sampleRate > 0.0){
+        instance->setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        instance->prepareToPlay(sampleRate, blockSize);
+    }
+
+    {
+        const SpinLock::ScopedLockType sl(chainLock);
+        //the device restarted while the plugin was being prepared
+        if (preparedSampleRate != sampleRate || preparedBlockSize != blockSize){
+            instance->setPlayConfigDetails(2, 2, preparedSampleRate, preparedBlockSize);
+            instance->prepareToPlay(preparedSampleRate, preparedBlockSize);
+        }
+        latencySamples = latencySamples.load() + instance->getLatencySamples();
+        plugins.push_back(std::move(instance));
+        numPlugins = static_cast<int>(plugins.size());
+    }
+    sendChangeMessage();
+}
+
+void PluginChain::removePlugin(int index)
+{
+    if (index < 0 || index >= getNumPlugins()){
+        return;
+    }
+
+    //the editor goes before the plugin it shows
+    for (int i = editors.size(); --i >= 0;){
+        if (&editors[i]->plugin == plugins[static_cast<size_t>(index)].get()){
+            editors.remove(i);
+        }
+    }
+
+    std::unique_ptr<AudioPluginInstance> removed;
+    {
+        const SpinLock::ScopedLockType sl(chainLock);
+        removed = std::move(plugins[static_cast<size_t>(index)]);
+        plugins.erase(plugins.begin() + index);
+        numPlugins = static_cast<int>(plugins.size());
+        latencySamples = jmax(0, latencySamples.load() - removed->getLatencySamples());
+    }
+    for (PendingPlugin& slot : unavailable){
+        if (slot.position > static_cast<size_t>(index)){
+            --slot.position;
+        }
+    }
+    //released and deleted out here, not while the audio thread waits
+    removed->releaseResources();
+    removed.reset();
+    sendChangeMessage();
+}
+
+void PluginChain::clear()
+{
+    pending.clear();
+    unavailable.clear();
+    ++pendingGeneration;
+    while (getNumPlugins() > 0){
+        removePlugin(getNumPlugins() - 1);
+    }
+}
+
+int PluginChain::getNumPlugins() const
+{
+    return numPlugins.load();
+}
+
+String PluginChain::getPluginName(int index) const
+{
+    return index >= 0 && index < getNumPlugins() ? plugins[static_cast<size_t>(index)]->getName() : String();
+}
+
+void PluginChain::showEditor(int index)
+{
+    if (index < 0 || index >= getNumPlugins()){
+        return;
+    }
+    AudioPluginInstance* plugin = plugins[static_cast<size_t>(index)].get();
+
+    EditorWindow* window = nullptr;
+    for (auto* editor : editors){
+        if (&editor->plugin == plugin){
+            window = editor;
+        }
+    }
+    if (window == nullptr){
+        window = editors.add(new EditorWindow(*plugin));
+    }
+    window->setVisible(true);
+    window->toFront(true);
+}
+
+void PluginChain::prepareToPlay(double sampleRate, int blockSize)
+{
+    const SpinLock::ScopedLockType sl(chainLock);
+    preparedSampleRate = sampleRate;
+    preparedBlockSize = blockSize;
+    for (auto& plugin : plugins){
+        plugin->setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        plugin->prepareToPlay(sampleRate, blockSize);
+    }
+}
+
+void PluginChain::releaseResources()
+{
+    const SpinLock::ScopedLockType sl(chainLock);
+    for (auto& plugin : plugins){
+        plugin->releaseResources();
+    }
+}
+
+void PluginChain::process(AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (isEmpty()){
+        return;
+    }
+
+    //a view of the part of the buffer to process, without copying
+    AudioBuffer<float> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), startSample, numSamples);
+    const SpinLock::ScopedLockType sl(chainLock);
+    int latency = 0;
+    for (auto& plugin : plugins){
+        if (!plugin->isSuspended()){
+            plugin->processBlock(block, midiMessages);
+        }
+        latency += plugin->getLatencySamples();
+    }
+    midiMessages.clear();
+    latencySamples = latency;
+}
+
+int PluginChain::getLatencySamples() const
+{
+    return latencySamples.load();
+}
+
+bool PluginChain::isEmpty() const
+{
+    return numPlugins.load() == 0;
+}
+
+std::unique_ptr<XmlElement> PluginChain::createStateXml() const
+{
+    auto xml = std::make_unique<XmlElement>("PLUGINCHAIN");
+    auto addSlot = [&xml] (const PluginDescription& description, const MemoryBlock& state) {
+        auto* entry = xml->createNewChildElement("SLOT");
+        entry->addChildElement(description.createXml().release());
+        entry->setAttribute("state", state.toBase64Encoding());
+    };
+
+    //the ones that could not be made go back where they were, the ones on their way after the rest
+    for (size_t i = 0; i <= plugins.size(); ++i){
+        for (const PendingPlugin& slot : unavailable){
+            if (slot.position == i){
+                addSlot(slot.description, slot.state);
+            }
+        }
+        if (i < plugins.size()){
+            MemoryBlock state;
+            plugins[i]->getStateInformation(state);
+            addSlot(plugins[i]->getPluginDescription(), state);
+        }
+    }
+    for (const PendingPlugin& slot : pending){
+        addSlot(slot.description, slot.state);
+    }
+    return xml;
+}
+
+void PluginChain::restoreFromXml(const XmlElement& xml)
+{
+    clear();
+    for (auto* entry : xml.getChildWithTagNameIterator("SLOT")){
+        PluginDescription description;
+        auto* descriptionXml = entry->getChildByName("PLUGIN");
+        if (descriptionXml == nullptr || !description.loadFromXml(*descriptionXml)){
+            continue;
+        }
+        MemoryBlock state;
+        state.fromBase64Encoding(entry->getStringAttribute("state"));
+        addPlugin(description, state);
+    }
+}
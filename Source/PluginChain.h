@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    PluginChain.h
+    Created: 19 Oct 2026 1:22:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/*
+    A chain of hosted plugins (VST3, AU on macOS, LADSPA on Linux) for one
+    deck or the master bus, processed in place on the audio thread.
+    Plugins are made asynchronously, one after another so they keep the
+    order they were added in, and prepared on the message thread, then
+    put into the chain under a SpinLock that the audio thread only holds
+    while it processes a block, so adding or removing one never blocks the
+    message thread for longer than a block. Only stereo (or mono) plugins
+    are taken.
+    The latency of the chain is the sum of its plugins' latencies, summed
+    again on every block, so a plugin that changes its latency is picked up; see
+    DeckMixer for the compensation. Change messages go out when plugins are
+    added or removed.
+    Plugins still being made, and ones that could not be made (e.g. not
+    installed on this machine right now), are saved with the chain as they
+    were restored, so they are not lost if the app quits early.
+*/
+class PluginChain  : public ChangeBroadcaster
+{
+public:
+    PluginChain(AudioPluginFormatManager& formatManager);
+    ~PluginChain() override;
+
+    /** makes the plugin and appends it once it is ready (or logs why it could not be made) */
+    void addPlugin(const PluginDescription& description, const MemoryBlock& state = {});
+    void removePlugin(int index);
+    void clear();
+
+    int getNumPlugins() const;
+    String getPluginName(int index) const;
+    /** opens (or brings to the front) the plugin's editor window */
+    void showEditor(int index);
+
+    /** called when the device starts; plugins added later are prepared the same way */
+    void prepareToPlay(double sampleRate, int blockSize);
+    void releaseResources();
+
+    /** audio thread: runs the buffer through every plugin in turn */
+    void process(AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    /** total latency of the plugins, in samples */
+    int getLatencySamples() const;
+    bool isEmpty() const;
+
+    /** the plugins and their state, for the settings file; includes the ones being made or that could not be */
+    std::unique_ptr<XmlElement> createStateXml() const;
+    /** replaces the chain with the plugins of a createStateXml() */
+    void restoreFromXml(const XmlElement& xml);
+
+private:
+    class EditorWindow;
+
+    struct PendingPlugin
+    {
+        PluginDescription description;
+        MemoryBlock state;
+        //for one that could not be made: the index it would have had in the chain
+        size_t position = 0;
+    };
+
+    /** starts making the first pending plugin */
+    void createNextPlugin();
+    /** message thread: prepares a made plugin and puts it in the chain, then makes the next one */
+    void pluginCreated(std::unique_ptr<AudioPluginInstance> instance, const String& error, int generation);
+
+    AudioPluginFormatManager& formatManager;
+
+    //held by the audio thread while it processes, by the message thread while it changes the chain
+    SpinLock chainLock;
+    std::vector<std::unique_ptr<AudioPluginInstance>> plugins;
+    std::atomic<int> numPlugins{ 0 };
+    std::atomic<int> latencySamples{ 0 };
+    //plugins being made, the first one is on its way
+    std::vector<PendingPlugin> pending;
+    //bumped by clear(), so a plugin that was on its way is dropped
+    int pendingGeneration = 0;
+    //could not be made; kept so they are saved back in their place
+    std::vector<PendingPlugin> unavailable;
+    OwnedArray<EditorWindow> editors;
+
+    //what the device was last started with, 0 until it has been
+    double preparedSampleRate = 0.0;
+    int preparedBlockSize = 0;
+
+    //plugins are handed an empty MIDI buffer; kept so the audio thread doesn't make one
+    MidiBuffer midiMessages;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (PluginChain)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginChain)
+};
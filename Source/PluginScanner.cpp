@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+    PluginScanner.cpp
+    Created: 19 Oct 2026 1:22:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "PluginScanner.h"
+
+namespace
+{
+    //a plugin that takes longer than this to open is taken to have hung
+    const uint32 scanTimeoutMs = 30000;
+}
+
+//==============================================================================
+PluginScanner::PluginScanner(AudioPluginFormatManager& _formatManager, KnownPluginList& _knownPlugins)
+                            : Thread("Plugin scan"),
+                              formatManager(_formatManager),
+                              knownPlugins(_knownPlugins)
+{
+}
+
+PluginScanner::~PluginScanner()
+{
+    //a child that is still running is killed by the thread on its way out
+    stopThread(5000);
+    masterReference.clear();
+}
+
+void PluginScanner::scan(bool retryFailed)
+{
+    if (scanning){
+        return;
+    }
+    if (retryFailed){
+        knownPlugins.clearBlacklistedFiles();
+    }
+
+    //the last scan posted scanFinished() just before its thread ended, this only waits for that
+    stopThread(5000);
+
+    formats.clear();
+    for (auto* format : formatManager.getFormats()){
+        if (format->canScanForPlugins()){
+            formats.push_back({ format, format->getDefaultLocationsToSearch() });
+        }
+    }
+    knownModTimes.clear();
+    for (const PluginDescription& description : knownPlugins.getTypes()){
+        knownModTimes[description.fileOrIdentifier] = description.lastFileModTime.toMilliseconds();
+    }
+
+    blacklist = knownPlugins.getBlacklistedFiles();
+    selfReference = this;
+
+    scanning = true;
+    numScanned = 0;
+    numToScan = 0;
+    //low, it only waits on the child processes
+    startThread(2);
+    listeners.call([](Listener& l) { l.pluginScanProgress(); });
+}
+
+bool PluginScanner::isScanning() const
+{
+    return scanning;
+}
+
+String PluginScanner::getStatus() const
+{
+    if (!scanning){
+        return String(knownPlugins.getNumTypes()) + " plugins known";
+    }
+    if (numToScan == 0){
+        return "searching the plugin folders...";
+    }
+    return "scanning " + String(jmin(numScanned + 1, numToScan)) + " of " + String(numToScan)
+           + (currentPlugin.isNotEmpty() ? ", last: " + currentPlugin : String());
+}
+
+//==============================================================================
+void PluginScanner::run()
+{
+    //only lists files, nothing is opened in this process
+    std::vector<std::pair<String, String>> toScan;
+    for (const FormatToScan& entry : formats){
+        for (const String& identifier : entry.format->searchPathsForPlugins(entry.paths, true, false)){
+            if (threadShouldExit()){
+                return;
+            }
+            if (blacklist.contains(identifier) || !hasChanged(identifier)){
+                continue;
+            }
+            toScan.emplace_back(entry.format->getName(), identifier);
+        }
+    }
+    post([total = static_cast<int>(toScan.size())] (PluginScanner& scanner) { scanner.numToScan = total; });
+
+    for (const auto& plugin : toScan){
+        bool failed = false;
+        String xmlText;
+        if (!scanInChild(plugin.first, plugin.second, failed, xmlText)){
+            return;
+        }
+        const String identifier = plugin.second;
+        post([identifier, xmlText, failed] (PluginScanner& scanner) { scanner.pluginScanned(identifier, xmlText, failed); });
+    }
+
+    post([] (PluginScanner& scanner) { scanner.scanFinished(); });
+}
+
+bool PluginScanner::hasChanged(const String& identifier) const
+{
+    const auto known = knownModTimes.find(identifier);
+    if (known == knownModTimes.end()){
+        return true;
+    }
+    const File file(File::isAbsolutePath(identifier) ? File(identifier) : File());
+    return file.exists() && file.getLastModificationTime().toMilliseconds() != known->second;
+}
+
+bool PluginScanner::scanInChild(const String& formatName, const String& identifier, bool& failed, String& xmlText)
+{
+    const File output = File::createTempFile(".xml");
+    ChildProcess child;
+    StringArray command;
+    command.add(File::getSpecialLocation(File::currentExecutableFile).getFullPathName());
+    command.add("--scan-plugin");
+    command.add(formatName);
+    command.add(identifier);
+    command.add(output.getFullPathName());
+
+    //its output is not read, so it goes nowhere rather than filling up a pipe
+    failed = !child.start(command, 0);
+    const uint32 startMs = Time::getMillisecondCounter();
+    while (!failed && child.isRunning()){
+        if (threadShouldExit()){
+            child.kill();
+            output.deleteFile();
+            return false;
+        }
+        if (Time::getMillisecondCounter() - startMs > scanTimeoutMs){
+            child.kill();
+            failed = true;
+            break;
+        }
+        wait(50);
+    }
+    //a crash shows up as a non-zero exit code
+    failed = failed || child.getExitCode() != 0;
+    xmlText = output.loadFileAsString();
+    output.deleteFile();
+    return true;
+}
+
+void PluginScanner::post(std::function<void(PluginScanner&)> call)
+{
+    WeakReference<PluginScanner> scanner = selfReference;
+    MessageManager::callAsync([scanner, call] {
+        if (auto* s = scanner.get()){
+            call(*s);
+        }
+    });
+}
+
+void PluginScanner::pluginScanned(const String& fileOrIdentifier, const String& xmlText, bool failed)
+{
+    ++numScanned;
+    currentPlugin = File::isAbsolutePath(fileOrIdentifier) ? File(fileOrIdentifier).getFileName() : fileOrIdentifier;
+
+    int numFound = 0;
+    if (!failed){
+        if (auto xml = parseXML(xmlText)){
+            for (auto* entry : xml->getChildWithTagNameIterator("PLUGIN")){
+                PluginDescription description;
+                if (description.loadFromXml(*entry)){
+                    knownPlugins.addType(description);
+                    ++numFound;
+                }
+            }
+        }
+    }
+    //crashed, hung, or not a plugin after all: skipped by the next scans
+    if (numFound == 0){
+        std::cout << "PluginScanner::pluginScanned no plugin could be opened in " << fileOrIdentifier << std::endl;
+        knownPlugins.addToBlacklist(fileOrIdentifier);
+    }
+    listeners.call([](Listener& l) { l.pluginScanProgress(); });
+}
+
+void PluginScanner::scanFinished()
+{
+    scanning = false;
+    currentPlugin.clear();
+    listeners.call([](Listener& l) { l.pluginScanProgress(); });
+}
+
+int PluginScanner::scanInChildProcess(const StringArray& args)
+{
+    const int index = args.indexOf("--scan-plugin");
+    if (index < 0 || args.size() < index + 4){
+        return 1;
+    }
+    const String formatName = args[index + 1].unquoted();
+    const String identifier = args[index + 2].unquoted();
+    const File output(args[index + 3].unquoted());
+
+    AudioPluginFormatManager formatManager;
+    formatManager.addDefaultFormats();
+    for (auto* format : formatManager.getFormats()){
+        if (format->getName() != formatName){
+            continue;
+        }
+        OwnedArray<PluginDescription> found;
+        format->findAllTypesForFile(found, identifier);
+
+        XmlElement list("PLUGINS");
+        for (auto* description : found){
+            list.addChildElement(description->createXml().release());
+        }
+        return list.writeTo(output) ? 0 : 1;
+    }
+    return 1;
+}
+
+void PluginScanner::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void PluginScanner::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
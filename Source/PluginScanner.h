@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    PluginScanner.h
+    Created: 19 Oct 2026 1:22:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <map>
+#include <vector>
+
+//==============================================================================
+/*
+    Finds the plugins in the default folders of every plugin format and adds
+    them to a KnownPluginList. The folders are searched on a thread of its
+    own (a scan can take minutes, so it would hold up a worker of the shared
+    pool all that time), and each plugin is opened in a child
+    process (OtoDecks started again with --scan-plugin), so a plugin that
+    crashes or hangs while it is scanned only takes the child down: it is
+    put on the list's blacklist and skipped from then on. Plugins already
+    in the list are skipped unless their file has changed since.
+    Only used from the message thread; listeners are told on the message thread.
+*/
+class PluginScanner  : private Thread
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called after each plugin file has been scanned, and once more when the scan is over */
+        virtual void pluginScanProgress() = 0;
+    };
+
+    PluginScanner(AudioPluginFormatManager& formatManager, KnownPluginList& knownPlugins);
+    ~PluginScanner() override;
+
+    /** starts a scan, unless one is running; retryFailed also scans the blacklisted plugins again */
+    void scan(bool retryFailed);
+    bool isScanning() const;
+    /** e.g. "scanning 3 of 40: Reverb.vst3", or how many plugins are known */
+    String getStatus() const;
+
+    /** the child process side: --scan-plugin <format> <file or identifier> <output file>; returns the exit code */
+    static int scanInChildProcess(const StringArray& args);
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    struct FormatToScan
+    {
+        AudioPluginFormat* format;
+        FileSearchPath paths;
+    };
+
+    void run() override;
+
+    /** false if the plugin is already known and its file has not changed since */
+    bool hasChanged(const String& identifier) const;
+    /** runs OtoDecks --scan-plugin; false if the thread was told to stop */
+    bool scanInChild(const String& formatName, const String& identifier, bool& failed, String& xmlText);
+    /** runs a call on the message thread, if the scanner still exists */
+    void post(std::function<void(PluginScanner&)> call);
+
+    /** called on the message thread by the scan thread after each plugin file */
+    void pluginScanned(const String& fileOrIdentifier, const String& xmlText, bool failed);
+    void scanFinished();
+
+    AudioPluginFormatManager& formatManager;
+    KnownPluginList& knownPlugins;
+
+    //set on the message thread before the scan thread starts, only read by it from then on
+    std::vector<FormatToScan> formats;
+    std::map<String, int64> knownModTimes;
+    StringArray blacklist;
+    //made on the message thread, copied by the scan thread to post its results
+    WeakReference<PluginScanner> selfReference;
+
+    bool scanning = false;
+    String currentPlugin;
+    int numScanned = 0;
+    int numToScan = 0;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (PluginScanner)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginScanner)
+};
@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    PluginsComponent.cpp
+    Created: 19 Oct 2026 1:22:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PluginsComponent.h"
+
+//==============================================================================
+/** the plugins of one chain, with its ADD / REMOVE / EDIT buttons */
+class PluginsComponent::ChainColumn  : public Component,
+                                       public ListBoxModel,
+                                       public Button::Listener,
+                                       public ChangeListener
+{
+public:
+    ChainColumn(const String& _title, PluginChain& _chain, KnownPluginList& _knownPlugins, LookAndFeel& buttonLookAndFeel)
+               : title(_title),
+                 chain(_chain),
+                 knownPlugins(_knownPlugins)
+    {
+        addAndMakeVisible(pluginList);
+        pluginList.setRowHeight(24);
+        pluginList.setColour(ListBox::backgroundColourId, Colour(32, 32, 32));
+
+        for (auto* button : { &addButton, &removeButton, &editButton }){
+            addAndMakeVisible(button);
+            button->addListener(this);
+            button->setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+            button->setColour(TextButton::textColourOffId, Colours::white);
+            button->setLookAndFeel(&buttonLookAndFeel);
+        }
+
+        chain.addChangeListener(this);
+    }
+
+    ~ChainColumn() override
+    {
+        chain.removeChangeListener(this);
+        for (auto* button : { &addButton, &removeButton, &editButton }){
+            button->setLookAndFeel(nullptr);
+        }
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.setColour(Colours::white);
+        g.setFont(15.0f);
+        g.drawText(title, 0, 0, getWidth(), 24, Justification::centred, true);
+        g.setFont(13.0f);
+        g.setColour(Colours::grey);
+        g.drawText("latency " + String(chain.getLatencySamples()) + " samples",
+                   0, getHeight() - 20, getWidth(), 20, Justification::centred, true);
+    }
+
+    void resized() override
+    {
+        auto area = getLocalBounds().reduced(4, 0);
+        area.removeFromTop(24);
+        area.removeFromBottom(20);
+        auto buttonRow = area.removeFromBottom(28);
+        const int buttonW = buttonRow.getWidth() / 3;
+        addButton.setBounds(buttonRow.removeFromLeft(buttonW).reduced(1));
+        removeButton.setBounds(buttonRow.removeFromLeft(buttonW).reduced(1));
+        editButton.setBounds(buttonRow.reduced(1));
+        pluginList.setBounds(area.reduced(0, 4));
+    }
+
+    int getNumRows() override
+    {
+        return chain.getNumPlugins();
+    }
+
+    void paintListBoxItem(int rowNumber, Graphics& g, int width, int height, bool rowIsSelected) override
+    {
+        if (rowIsSelected){
+            g.fillAll(Colour(64, 64, 64));
+        }
+        g.setColour(Colours::white);
+        g.setFont(14.0f);
+        g.drawText(String(rowNumber + 1) + ". " + chain.getPluginName(rowNumber),
+                   8, 0, width - 16, height, Justification::centredLeft, true);
+    }
+
+    void listBoxItemDoubleClicked(int row, const MouseEvent&) override
+    {
+        chain.showEditor(row);
+    }
+
+    void buttonClicked(Button* button) override
+    {
+        if (button == &addButton){
+            const Array<PluginDescription> types = knownPlugins.getTypes();
+            if (types.isEmpty()){
+                return;
+            }
+            PopupMenu menu;
+            KnownPluginList::addToMenu(menu, types, KnownPluginList::sortByManufacturer);
+            SafePointer<ChainColumn> safeThis(this);
+            menu.showMenuAsync(PopupMenu::Options().withTargetComponent(&addButton), [safeThis, types] (int result) {
+                const int index = KnownPluginList::getIndexChosenByMenu(types, result);
+                if (safeThis != nullptr && index >= 0){
+                    safeThis->chain.addPlugin(types[index]);
+                }
+            });
+        }
+        if (button == &removeButton){
+            chain.removePlugin(pluginList.getSelectedRow());
+        }
+        if (button == &editButton){
+            chain.showEditor(pluginList.getSelectedRow());
+        }
+    }
+
+    /** the chain got or lost a plugin */
+    void changeListenerCallback(ChangeBroadcaster*) override
+    {
+        pluginList.updateContent();
+        repaint();
+    }
+
+private:
+    String title;
+    PluginChain& chain;
+    KnownPluginList& knownPlugins;
+
+    ListBox pluginList{ "Plugins", this };
+    TextButton addButton{ "ADD" };
+    TextButton removeButton{ "REMOVE" };
+    TextButton editButton{ "EDIT" };
+};
+
+//==============================================================================
+PluginsComponent::PluginsComponent(KnownPluginList& _knownPlugins, PluginScanner& _scanner,
+                                   PluginChain& leftChain, PluginChain& rightChain, PluginChain& masterChain)
+                                  : knownPlugins(_knownPlugins),
+                                    scanner(_scanner)
+{
+    columns.add(new ChainColumn("LEFT DECK", leftChain, knownPlugins, lookAndFeel));
+    columns.add(new ChainColumn("RIGHT DECK", rightChain, knownPlugins, lookAndFeel));
+    columns.add(new ChainColumn("MASTER", masterChain, knownPlugins, lookAndFeel));
+    for (auto* column : columns){
+        addAndMakeVisible(column);
+    }
+
+    addAndMakeVisible(scanButton);
+    addAndMakeVisible(statusLabel);
+    scanButton.addListener(this);
+    scanButton.setColour(TextButton::buttonColourId, Colour(12, 12, 12));
+    scanButton.setColour(TextButton::textColourOffId, Colours::white);
+    scanButton.setLookAndFeel(&lookAndFeel);
+
+    statusLabel.setFont(14.0f);
+    statusLabel.setColour(Label::textColourId, Colours::white);
+
+    scanner.addListener(this);
+    pluginScanProgress();
+}
+
+PluginsComponent::~PluginsComponent()
+{
+    scanner.removeListener(this);
+    scanButton.setLookAndFeel(nullptr);
+    //the columns use the look and feel too
+    columns.clear();
+}
+
+void PluginsComponent::paint(Graphics& g)
+{
+    g.fillAll(Colour(22, 22, 22));//background colour
+}
+
+void PluginsComponent::resized()
+{
+    auto area = getLocalBounds().reduced(8);
+
+    auto bottomRow = area.removeFromBottom(32);
+    scanButton.setBounds(bottomRow.removeFromLeft(120).reduced(2));
+    statusLabel.setBounds(bottomRow);
+
+    const int columnW = area.getWidth() / columns.size();
+    for (auto* column : columns){
+        column->setBounds(area.removeFromLeft(columnW));
+    }
+}
+
+void PluginsComponent::buttonClicked(Button* button)
+{
+    if (button == &scanButton){
+        //a scan asked for by hand also tries the plugins that failed before
+        scanner.scan(true);
+    }
+}
+
+void PluginsComponent::pluginScanProgress()
+{
+    statusLabel.setText(scanner.getStatus(), dontSendNotification);
+    scanButton.setEnabled(!scanner.isScanning());
+}
@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    PluginsComponent.h
+    Created: 19 Oct 2026 1:22:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PluginChain.h"
+#include "PluginScanner.h"
+
+//==============================================================================
+/*
+    Plugin panel shown in a dialog from MainComponent: a column per chain
+    (left deck, right deck, master) listing its plugins and their latency,
+    with ADD (a menu of the known plugins), REMOVE and EDIT (the plugin's
+    editor). SCAN looks for new plugins in the background (see PluginScanner).
+*/
+class PluginsComponent  : public Component,
+                          public Button::Listener,
+                          public PluginScanner::Listener
+{
+public:
+    PluginsComponent(KnownPluginList& knownPlugins, PluginScanner& scanner,
+                     PluginChain& leftChain, PluginChain& rightChain, PluginChain& masterChain);
+    ~PluginsComponent() override;
+
+    void paint (Graphics&) override;
+    void resized() override;
+
+    /** implement Button::Listener */
+    void buttonClicked (Button* button) override;
+
+    /** implement PluginScanner::Listener */
+    void pluginScanProgress() override;
+
+private:
+    class ChainColumn;
+
+    KnownPluginList& knownPlugins;
+    PluginScanner& scanner;
+
+    OwnedArray<ChainColumn> columns;
+    TextButton scanButton{ "SCAN" };
+    Label statusLabel;
+    LookAndFeel_V2 lookAndFeel;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginsComponent)
+};
@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    ScrollingWaveformDisplay.cpp
+    Created: 19 Oct 2026 12:29:28pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "ScrollingWaveformDisplay.h"
+#include "PaintProfiler.h"
+
+//==============================================================================
+ScrollingWaveformDisplay::ScrollingWaveformDisplay(WaveformCache & 	cacheToUse,
+                                                   DJAudioPlayer* _player,
+                                                   bool differentColour
+                                                   ) :
+                                                   cache(cacheToUse),
+                                                   player(_player)
+{
+    cache.addListener(this);
+
+    //same deck colours as the overview WaveformDisplay
+    if (!differentColour){
+        bodyColour = Colour(225, 195, 255);
+    }
+    else{
+        bodyColour = Colour(255, 255, 175);
+    }
+}
+
+ScrollingWaveformDisplay::~ScrollingWaveformDisplay()
+{
+    stopTimer();
+    cache.removeListener(this);
+}
+
+void ScrollingWaveformDisplay::paint (Graphics& g)
+{
+    PaintProfiler::ScopedPaint profile(g, "ScrollingWaveformDisplay");
+
+    if (stripValid){
+        //everything was drawn into the strip already
+        g.drawImageAt(strip, 0, 0);
+    }
+    else{
+        g.fillAll (Colour(22, 22, 22));
+        g.setColour (bodyColour);
+        g.setFont (16.0f);
+        g.drawText (loadedFile.existsAsFile() ? "Analysing waveform..." : "", getLocalBounds(),
+                    Justification::centred, true);
+    }
+
+    //the playhead always sits in the middle
+    g.setColour (Colours::white);
+    g.fillRect (getWidth() / 2, 0, 2, getHeight());
+
+    g.setColour (Colour(0, 245, 245)); //outline colour
+    g.drawRect (getLocalBounds(), 1);
+}
+
+void ScrollingWaveformDisplay::resized()
+{
+    if (getWidth() > 0 && getHeight() > 0){
+        strip = Image(Image::RGB, getWidth(), getHeight(), true);
+    }
+    updateZoom();
+}
+
+void ScrollingWaveformDisplay::mouseWheelMove (const MouseEvent&, const MouseWheelDetails& wheel)
+{
+    //between 2 and 32 seconds across the view
+    secondsVisible = jlimit(2.0, 32.0, secondsVisible * (wheel.deltaY > 0 ? 0.8 : 1.25));
+    updateZoom();
+    timerCallback();
+}
+
+void ScrollingWaveformDisplay::loadURL(URL audioURL)
+{
+    loadedFile = audioURL.isLocalFile() ? audioURL.getLocalFile() : File();
+    pyramid = loadedFile.existsAsFile() ? cache.getOrRequest(loadedFile) : nullptr;
+    updateZoom();
+
+    if (pyramid != nullptr){
+        startTimerHz(60);
+    }
+    repaint();
+}
+
+void ScrollingWaveformDisplay::waveformReady (const File& file, WaveformPyramid::Ptr newPyramid)
+{
+    if (file != loadedFile){
+        return;
+    }
+    pyramid = newPyramid;
+    updateZoom();
+
+    if (pyramid != nullptr){
+        startTimerHz(60);
+    }
+    repaint();
+}
+
+void ScrollingWaveformDisplay::timerCallback()
+{
+    if (pyramid == nullptr || strip.isNull()){
+        stopTimer();
+        return;
+    }
+
+    const double playheadSample = player->getPositionInSeconds() * pyramid->getSampleRate();
+    if (updateStrip(playheadSample)){
+        repaint();
+    }
+}
+
+//==============================================================================
+void ScrollingWaveformDisplay::updateZoom()
+{
+    if (pyramid != nullptr && getWidth() > 0){
+        samplesPerPixel = secondsVisible * pyramid->getSampleRate() / getWidth();
+    }
+    stripValid = false;
+}
+
+bool ScrollingWaveformDisplay::updateStrip(double playheadSample)
+{
+    const int width = strip.getWidth();
+    const int64 playheadColumn = static_cast<int64>(std::floor(playheadSample / samplesPerPixel));
+    const int64 firstColumn = playheadColumn - width / 2;
+
+    if (stripValid && firstColumn == stripFirstColumn){
+        return false;
+    }
+
+    const int64 shift = firstColumn - stripFirstColumn;
+
+    if (!stripValid || std::abs(shift) >= width){
+        //jumped (seek, new track, zoom): redraw everything
+        stripFirstColumn = firstColumn;
+        renderColumns(0, width);
+        stripValid = true;
+    }
+    else if (shift > 0){
+        //playing forwards: the old columns move left, new ones appear on the right
+        const int n = static_cast<int>(shift);
+        strip.moveImageSection(0, 0, n, 0, width - n, strip.getHeight());
+        stripFirstColumn = firstColumn;
+        renderColumns(width - n, n);
+    }
+    else{
+        const int n = static_cast<int>(-shift);
+        strip.moveImageSection(n, 0, 0, 0, width - n, strip.getHeight());
+        stripFirstColumn = firstColumn;
+        renderColumns(0, n);
+    }
+    return true;
+}
+
+void ScrollingWaveformDisplay::renderColumns(int x, int numColumns)
+{
+    Graphics g(strip);
+    const Rectangle<int> area(x, 0, numColumns, strip.getHeight());
+    g.reduceClipRegion(area);
+    g.fillAll(Colour(22, 22, 22));
+
+    const double sampleRate = pyramid->getSampleRate();
+    const double startTime = (stripFirstColumn + x) * samplesPerPixel / sampleRate;
+    const double endTime = startTime + numColumns * samplesPerPixel / sampleRate;
+    const Rectangle<int> waveArea = area.reduced(0, 3);
+
+    //peaks coloured by frequency content underneath, the rms body on top in the deck's colour
+    pyramid->drawChannel(g, waveArea, startTime, endTime, 0, 0.95f, WaveformPyramid::drawBandColouredPeaks);
+    g.setColour(bodyColour.withAlpha(0.5f));
+    pyramid->drawChannel(g, waveArea, startTime, endTime, 0, 0.95f, WaveformPyramid::drawRMS);
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    ScrollingWaveformDisplay.h
+    Created: 19 Oct 2026 12:29:28pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "DJAudioPlayer.h"
+#include "WaveformCache.h"
+
+//==============================================================================
+/*
+    Zoomed waveform of a few seconds around the playhead, which stays in the
+    middle while the track scrolls past at display rate.
+    The waveform is kept in an image strip as wide as the component; each frame
+    the strip is shifted by the number of whole pixels the playhead moved and
+    only the columns that scrolled into view are drawn, so paint() is a single
+    image blit.
+*/
+class ScrollingWaveformDisplay    : public Component,
+                                    public WaveformCache::Listener,
+                                    public Timer
+{
+public:
+    ScrollingWaveformDisplay(WaveformCache & 	cacheToUse,
+                             DJAudioPlayer* player,
+                             bool differentColour);
+    ~ScrollingWaveformDisplay() override;
+
+    void paint (Graphics&) override;
+    void resized() override;
+
+    /** the mouse wheel zooms in and out */
+    void mouseWheelMove (const MouseEvent& event, const MouseWheelDetails& wheel) override;
+
+    void loadURL(URL audioURL);
+
+    /** called by the WaveformCache when a pyramid has been built in the background */
+    void waveformReady (const File& file, WaveformPyramid::Ptr pyramid) override;
+
+    /** follows the playhead, called at display rate */
+    void timerCallback() override;
+
+private:
+    /** scrolls the strip so the playhead is centred; returns true if anything changed */
+    bool updateStrip(double playheadSample);
+    /** draws the waveform into the given columns of the strip */
+    void renderColumns(int x, int numColumns);
+    /** recalculates the samples per pixel and forces a full redraw of the strip */
+    void updateZoom();
+
+    WaveformCache& cache;
+    DJAudioPlayer* player;
+
+    File loadedFile;
+    WaveformPyramid::Ptr pyramid;
+
+    Image strip;
+    //absolute pixel column (sample / samplesPerPixel) shown at x = 0 of the strip
+    int64 stripFirstColumn = 0;
+    bool stripValid = false;
+
+    double secondsVisible = 8.0;
+    double samplesPerPixel = 1.0;
+
+    //rms body colour, the peaks are coloured by their frequency content
+    Colour bodyColour;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScrollingWaveformDisplay)
+};
@@ -0,0 +1,467 @@
+/*
+  ==============================================================================
+
+    SearchIndex.cpp
+    Created: 19 Oct 2026 12:39:39pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "SearchIndex.h"
+#include "MemoryMonitor.h"
+#include <algorithm>
+
+namespace
+{
+    //accented lower case letters and the plain letter each one folds to
+    const char* const accentedLetters = "\xc3\xa0\xc3\xa1\xc3\xa2\xc3\xa3\xc3\xa4\xc3\xa5\xc4\x81\xc4\x83\xc4\x85\xc3\xa6"
+                                        "\xc3\xa7\xc4\x87\xc4\x89\xc4\x8b\xc4\x8d\xc4\x8f\xc4\x91\xc3\xa8\xc3\xa9\xc3\xaa"
+                                        "\xc3\xab\xc4\x93\xc4\x95\xc4\x97\xc4\x99\xc4\x9b\xc4\x9d\xc4\x9f\xc4\xa1\xc4\xa3"
+                                        "\xc4\xa5\xc4\xa7\xc3\xac\xc3\xad\xc3\xae\xc3\xaf\xc4\xa9\xc4\xab\xc4\xad\xc4\xaf"
+                                        "\xc4\xb1\xc4\xb5\xc4\xb7\xc4\xba\xc4\xbc\xc4\xbe\xc5\x80\xc5\x82\xc3\xb1\xc5\x84"
+                                        "\xc5\x86\xc5\x88\xc3\xb2\xc3\xb3\xc3\xb4\xc3\xb5\xc3\xb6\xc3\xb8\xc5\x8d\xc5\x8f"
+                                        "\xc5\x91\xc5\x93\xc5\x95\xc5\x97\xc5\x99\xc5\x9b\xc5\x9d\xc5\x9f\xc5\xa1\xc5\xa3"
+                                        "\xc5\xa5\xc5\xa7\xc3\xb9\xc3\xba\xc3\xbb\xc3\xbc\xc5\xa9\xc5\xab\xc5\xad\xc5\xaf"
+                                        "\xc5\xb1\xc5\xb3\xc5\xb5\xc3\xbd\xc3\xbf\xc5\xb7\xc5\xba\xc5\xbc\xc5\xbe\xc3\x9f";
+    const char* const plainLetters = "aaaaaaaaaacccccddeeeeeeeeegggghhiiiiiiiiijklllllnnnnoooooooooorrrsssstttuuuuuuuuuuwyyyzzzs";
+
+    juce_wchar foldCharacter(juce_wchar c)
+    {
+        static const std::unordered_map<juce_wchar, juce_wchar> table = [] {
+            std::unordered_map<juce_wchar, juce_wchar> t;
+            const String accented = String(CharPointer_UTF8(accentedLetters));
+            for (int i = 0; i < accented.length(); ++i){
+                t[accented[i]] = static_cast<juce_wchar>(plainLetters[i]);
+            }
+            return t;
+        }();
+
+        c = CharacterFunctions::toLowerCase(c);
+        if (c < 128){
+            return CharacterFunctions::isLetterOrDigit(c) ? c : ' ';
+        }
+        auto found = table.find(c);
+        if (found != table.end()){
+            return found->second;
+        }
+        return CharacterFunctions::isLetterOrDigit(c) ? c : ' ';
+    }
+
+    //three 21 bit code points in one key
+    uint64 makeTrigram(juce_wchar a, juce_wchar b, juce_wchar c)
+    {
+        return (static_cast<uint64>(a) << 42) | (static_cast<uint64>(b) << 21) | static_cast<uint64>(c);
+    }
+}
+
+//==============================================================================
+/** runs one query on a pool thread */
+class SearchIndex::QueryJob : public ThreadPoolJob
+{
+public:
+    QueryJob(SearchIndex& _owner, const String& _query, const std::vector<TrackTable::SortKey>& _sortOrder, int _queryNumber)
+            : ThreadPoolJob("Search"),
+              owner(&_owner),
+              index(_owner),
+              query(_query),
+              sortOrder(_sortOrder),
+              queryNumber(_queryNumber)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        std::vector<int64> ids = index.runQuery(query);
+        if (shouldExit()){
+            return jobHasFinished;
+        }
+        if (!sortOrder.empty()){
+            index.table.sort(ids, sortOrder);
+            if (shouldExit()){
+                return jobHasFinished;
+            }
+        }
+
+        //hand the result over on the message thread, if the index still exists
+        WeakReference<SearchIndex> searchIndex = owner;
+        String text = query;
+        int number = queryNumber;
+        MessageManager::callAsync([searchIndex, text, number, ids] {
+            if (auto* s = searchIndex.get()){
+                s->queryFinished(number, text, ids);
+            }
+        });
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const SearchIndex* searchIndex) const
+    {
+        return owner.get() == searchIndex;
+    }
+
+private:
+    WeakReference<SearchIndex> owner;
+    //only valid while the owner exists; the owner removes its jobs before it goes away
+    const SearchIndex& index;
+    String query;
+    std::vector<TrackTable::SortKey> sortOrder;
+    int queryNumber;
+};
+
+//==============================================================================
+SearchIndex::SearchIndex(ThreadPool& _threadPool, TrackTable& _table, int _debounceMilliseconds)
+                        : threadPool(_threadPool),
+                          table(_table),
+                          debounceMilliseconds(_debounceMilliseconds)
+{
+}
+
+SearchIndex::~SearchIndex()
+{
+    stopTimer();
+
+    //the pool is shared, so only this index's jobs are stopped
+    struct OwnJobs : public ThreadPool::JobSelector
+    {
+        const SearchIndex* searchIndex;
+        bool isJobSuitable(ThreadPoolJob* job) override
+        {
+            auto* queryJob = dynamic_cast<QueryJob*>(job);
+            return queryJob != nullptr && queryJob->belongsTo(searchIndex);
+        }
+    };
+    OwnJobs selector;
+    selector.searchIndex = this;
+    threadPool.removeAllJobs(true, 5000, &selector);
+
+    masterReference.clear();
+}
+
+//==============================================================================
+void SearchIndex::add(int64 id, const String& title)
+{
+    const ScopedWriteLock sl(indexLock);
+
+    const int slot = static_cast<int>(slotIds.size());
+    jassert(slotIds.empty() || id > slotIds.back()); //results are returned in slot order
+
+    slotIds.push_back(id);
+    foldedTitles.push_back(fold(title).toStdString());
+    contentBytes += MemoryMonitor::getStringBytes(foldedTitles.back());
+    alive.push_back(true);
+    slotOfId[id] = slot;
+    indexSlot(slot);
+}
+
+void SearchIndex::remove(int64 id)
+{
+    const ScopedWriteLock sl(indexLock);
+
+    auto found = slotOfId.find(id);
+    if (found == slotOfId.end()){
+        return;
+    }
+    alive[static_cast<size_t>(found->second)] = false;
+    slotOfId.erase(found);
+    ++numDead;
+
+    if (numDead > 1000 && numDead > static_cast<int>(slotIds.size()) / 2){
+        rebuild();
+    }
+}
+
+void SearchIndex::clear()
+{
+    const ScopedWriteLock sl(indexLock);
+
+    slotIds.clear();
+    foldedTitles.clear();
+    alive.clear();
+    numDead = 0;
+    slotOfId.clear();
+    postings.clear();
+    contentBytes = 0;
+}
+
+void SearchIndex::setText(int64 id, const String& text)
+{
+    setTexts({ { id, text } });
+}
+
+void SearchIndex::setTexts(const std::vector<std::pair<int64, String>>& texts)
+{
+    const ScopedWriteLock sl(indexLock);
+
+    //trigram -> how much of its posting list was in order before this batch
+    std::unordered_map<uint64, size_t> touched;
+    std::vector<uint64> trigrams;
+    for (const auto& text : texts){
+        auto found = slotOfId.find(text.first);
+        if (found == slotOfId.end()){
+            continue;
+        }
+        const int slot = found->second;
+        std::string folded = fold(text.second).toStdString();
+        if (folded == foldedTitles[static_cast<size_t>(slot)]){
+            continue;
+        }
+        contentBytes += MemoryMonitor::getStringBytes(folded);
+        contentBytes -= jmin(contentBytes, MemoryMonitor::getStringBytes(foldedTitles[static_cast<size_t>(slot)]));
+        foldedTitles[static_cast<size_t>(slot)] = std::move(folded);
+
+        //postings of the old text stay until the next rebuild; find() checks every candidate
+        //against the text anyway, so they only cost a little time
+        trigrams.clear();
+        getTrigrams(String::fromUTF8(foldedTitles[static_cast<size_t>(slot)].c_str()), trigrams);
+        for (uint64 trigram : trigrams){
+            auto list = postings.find(trigram);
+            touched.emplace(trigram, list != postings.end() ? list->second.size() : 0);
+            addPosting(trigram, slot);
+        }
+    }
+
+    //slots were appended out of order: the new ones are sorted and merged in, one pass per list
+    for (const auto& t : touched){
+        std::vector<int>& slots = postings[t.first];
+        const auto sortedEnd = slots.begin() + static_cast<std::ptrdiff_t>(t.second);
+        std::sort(sortedEnd, slots.end());
+        std::inplace_merge(slots.begin(), sortedEnd, slots.end());
+        slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+    }
+}
+
+void SearchIndex::rebuild()
+{
+    std::vector<int64> oldIds;
+    std::vector<std::string> oldTitles;
+    std::vector<bool> oldAlive;
+    oldIds.swap(slotIds);
+    oldTitles.swap(foldedTitles);
+    oldAlive.swap(alive);
+    numDead = 0;
+    slotOfId.clear();
+    postings.clear();
+    contentBytes = 0;
+
+    for (size_t i = 0; i < oldIds.size(); ++i){
+        if (oldAlive[i]){
+            const int slot = static_cast<int>(slotIds.size());
+            slotIds.push_back(oldIds[i]);
+            foldedTitles.push_back(std::move(oldTitles[i]));
+            contentBytes += MemoryMonitor::getStringBytes(foldedTitles.back());
+            alive.push_back(true);
+            slotOfId[oldIds[i]] = slot;
+            indexSlot(slot);
+        }
+    }
+}
+
+void SearchIndex::indexSlot(int slot)
+{
+    std::vector<uint64> trigrams;
+    getTrigrams(String::fromUTF8(foldedTitles[static_cast<size_t>(slot)].c_str()), trigrams);
+
+    for (uint64 trigram : trigrams){
+        addPosting(trigram, slot);
+    }
+}
+
+void SearchIndex::addPosting(uint64 trigram, int slot)
+{
+    std::vector<int>& slots = postings[trigram];
+    //a title can contain the same trigram twice
+    if (slots.empty() || slots.back() != slot){
+        const size_t capacity = slots.capacity();
+        slots.push_back(slot);
+        contentBytes += (slots.capacity() - capacity) * sizeof(int);
+    }
+}
+
+//==============================================================================
+void SearchIndex::search(const String& query)
+{
+    pendingQuery = query;
+    startTimer(debounceMilliseconds);
+}
+
+void SearchIndex::searchNow(const String& query)
+{
+    pendingQuery = query;
+    timerCallback();
+}
+
+void SearchIndex::setSortOrder(const std::vector<TrackTable::SortKey>& sortKeys)
+{
+    sortOrder = sortKeys;
+}
+
+bool SearchIndex::isSorted() const
+{
+    return !sortOrder.empty();
+}
+
+void SearchIndex::cancel()
+{
+    stopTimer();
+    ++latestQueryNumber;
+}
+
+void SearchIndex::timerCallback()
+{
+    stopTimer();
+    threadPool.addJob(new QueryJob(*this, pendingQuery, sortOrder, ++latestQueryNumber), true);
+}
+
+void SearchIndex::queryFinished(int queryNumber, const String& query, const std::vector<int64>& ids)
+{
+    //the user has typed on since this one was started
+    if (queryNumber != latestQueryNumber){
+        return;
+    }
+    listeners.call([&] (Listener& l) { l.searchResultsReady(query, ids); });
+}
+
+std::vector<int64> SearchIndex::find(const String& query) const
+{
+    StringArray words;
+    words.addTokens(fold(query), " ", "");
+    words.removeEmptyStrings();
+
+    std::vector<std::string> wordsUTF8;
+    std::vector<uint64> trigrams;
+    for (const String& word : words){
+        wordsUTF8.push_back(word.toStdString());
+        getTrigrams(word, trigrams);
+    }
+
+    const ScopedReadLock sl(indexLock);
+    std::vector<int64> ids;
+
+    auto matches = [&] (int slot) {
+        if (!alive[static_cast<size_t>(slot)]){
+            return false;
+        }
+        const std::string& title = foldedTitles[static_cast<size_t>(slot)];
+        for (const std::string& word : wordsUTF8){
+            if (title.find(word) == std::string::npos){
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (trigrams.empty()){
+        //only words of one or two letters: check every title
+        for (int slot = 0; slot < static_cast<int>(slotIds.size()); ++slot){
+            if (matches(slot)){
+                ids.push_back(slotIds[static_cast<size_t>(slot)]);
+            }
+        }
+        return ids;
+    }
+
+    //intersect the posting lists, shortest first so the candidate set shrinks fastest
+    std::vector<const std::vector<int>*> lists;
+    for (uint64 trigram : trigrams){
+        auto found = postings.find(trigram);
+        if (found == postings.end()){
+            return ids; //a trigram no title has
+        }
+        lists.push_back(&found->second);
+    }
+    std::sort(lists.begin(), lists.end(), [] (const std::vector<int>* a, const std::vector<int>* b) {
+        return a->size() < b->size();
+    });
+
+    std::vector<int> candidates = *lists.front();
+    std::vector<int> next;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i){
+        next.clear();
+        std::set_intersection(candidates.begin(), candidates.end(),
+                              lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(next));
+        candidates.swap(next);
+    }
+
+    //the trigrams can all be there without the words being there in one piece
+    for (int slot : candidates){
+        if (matches(slot)){
+            ids.push_back(slotIds[static_cast<size_t>(slot)]);
+        }
+    }
+    return ids;
+}
+
+std::vector<int64> SearchIndex::runQuery(const String& query) const
+{
+    const TrackTable::Query parsed = TrackTable::Query::parse(query);
+
+    //the index narrows the rows down first, the table's filters only look at what is left
+    if (parsed.words.isEmpty()){
+        return parsed.hasFilters() ? table.select(parsed, nullptr) : table.getAllIds();
+    }
+    const std::vector<int64> ids = find(parsed.words.joinIntoString(" "));
+    if (!parsed.hasFilters() || ids.empty()){
+        return ids;
+    }
+    return table.select(parsed, &ids);
+}
+
+//==============================================================================
+String SearchIndex::fold(const String& text)
+{
+    String folded;
+    folded.preallocateBytes(text.getNumBytesAsUTF8() + 1);
+
+    //runs of spaces and punctuation become a single space
+    bool lastWasSpace = true;
+    for (auto p = text.getCharPointer(); !p.isEmpty(); ++p){
+        const juce_wchar c = foldCharacter(*p);
+        if (c == ' '){
+            if (!lastWasSpace){
+                folded << ' ';
+            }
+            lastWasSpace = true;
+        }
+        else{
+            folded << c;
+            lastWasSpace = false;
+        }
+    }
+    return folded.trimEnd();
+}
+
+void SearchIndex::getTrigrams(const String& foldedText, std::vector<uint64>& trigrams)
+{
+    //trigrams never span two words, the query words can be in any order
+    juce_wchar a = ' ', b = ' ';
+    for (auto p = foldedText.getCharPointer(); !p.isEmpty(); ++p){
+        const juce_wchar c = *p;
+        if (a != ' ' && b != ' ' && c != ' '){
+            trigrams.push_back(makeTrigram(a, b, c));
+        }
+        a = b;
+        b = c;
+    }
+}
+
+//==============================================================================
+void SearchIndex::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void SearchIndex::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
+
+size_t SearchIndex::getMemoryUsage() const
+{
+    const ScopedReadLock sl(indexLock);
+
+    size_t bytes = MemoryMonitor::getVectorBytes(slotIds) + MemoryMonitor::getVectorBytes(foldedTitles)
+                 + alive.capacity() / 8 + MemoryMonitor::getHashBytes(slotOfId) + MemoryMonitor::getHashBytes(postings);
+    return bytes + contentBytes;
+}
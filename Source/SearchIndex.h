@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    SearchIndex.h
+    Created: 19 Oct 2026 12:39:39pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "TrackTable.h"
+#include <unordered_map>
+#include <vector>
+
+//==============================================================================
+/*
+    Trigram index over the playlist titles, for filtering big libraries as
+    you type. Titles are folded once when they are added (lower case, accents
+    removed, punctuation turned into spaces), and every trigram of the folded
+    title points at the title's slot. A query is split into words; all words
+    must appear in the title. The posting lists of the words' trigrams are
+    intersected, and only the few candidates left are checked with a real
+    substring search (words shorter than three letters scan all titles).
+    Removing a title only marks its slot as dead; the index is rebuilt once
+    half of it is dead.
+    A query can also hold field filters (bpm:120-128 key:8A ..., see
+    TrackTable); the free text words go through the index first and the
+    filters are then only checked on the rows that are left.
+    search() is debounced and runs on the shared ThreadPool; the ids of the
+    matching tracks are handed to the listeners on the message thread, in the
+    order the tracks were added, or sorted by the sort order if one is set.
+    The sort runs on the same pool thread, so sorting a big library never
+    blocks the message thread either. add/remove/clear are message thread only.
+*/
+class SearchIndex  : private Timer
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called with the ids of the tracks matching the last query, in the order they were added or the sort order */
+        virtual void searchResultsReady(const String& query, const std::vector<int64>& ids) = 0;
+    };
+
+    SearchIndex(ThreadPool& threadPool, TrackTable& table, int debounceMilliseconds);
+    ~SearchIndex();
+
+    /** ids must be added in increasing order (library ids always are) */
+    void add(int64 id, const String& title);
+    void remove(int64 id);
+    void clear();
+    /** replaces the text a track is found by, e.g. once its tags have been read */
+    void setText(int64 id, const String& text);
+    /** replaces the texts of a batch of tracks; each posting list touched is put back in order once */
+    void setTexts(const std::vector<std::pair<int64, String>>& texts);
+
+    /** starts a search once the query has not changed for the debounce time */
+    void search(const String& query);
+
+    /** starts a search straight away, e.g. after the sort order changed */
+    void searchNow(const String& query);
+
+    /** sort order of the results from now on; empty for the order the tracks were added */
+    void setSortOrder(const std::vector<TrackTable::SortKey>& sortKeys);
+    bool isSorted() const;
+
+    /** forgets the pending search and any results still on their way */
+    void cancel();
+
+    /** looks up the free text words of a query straight away; thread safe */
+    std::vector<int64> find(const String& query) const;
+
+    /** runs a query with its field filters straight away; thread safe */
+    std::vector<int64> runQuery(const String& query) const;
+
+    /** estimated bytes held by the titles and posting lists */
+    size_t getMemoryUsage() const;
+
+    /** lower case, no accents, punctuation as spaces */
+    static String fold(const String& text);
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    class QueryJob;
+
+    void timerCallback() override;
+    /** called on the message thread by a finished QueryJob */
+    void queryFinished(int queryNumber, const String& query, const std::vector<int64>& ids);
+    /** drops dead slots and rebuilds the posting lists, with the write lock held */
+    void rebuild();
+    void indexSlot(int slot);
+    /** adds a slot to a trigram's posting list, counting what the list grows by */
+    void addPosting(uint64 trigram, int slot);
+
+    static void getTrigrams(const String& foldedText, std::vector<uint64>& trigrams);
+
+    ThreadPool& threadPool;
+    TrackTable& table;
+    int debounceMilliseconds;
+
+    //one slot per added title; dead slots stay until the next rebuild
+    std::vector<int64> slotIds;
+    std::vector<std::string> foldedTitles;
+    std::vector<bool> alive;
+    int numDead = 0;
+    std::unordered_map<int64, int> slotOfId;
+    //trigram -> slots containing it, in increasing order
+    std::unordered_map<uint64, std::vector<int>> postings;
+    //bytes of the folded titles and posting lists, kept up to date as they change so counting doesn't walk them
+    size_t contentBytes = 0;
+
+    mutable ReadWriteLock indexLock;
+
+    String pendingQuery;
+    std::vector<TrackTable::SortKey> sortOrder;
+    //results of older queries are dropped
+    int latestQueryNumber = 0;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (SearchIndex)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SearchIndex)
+};
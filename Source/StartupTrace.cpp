@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    StartupTrace.cpp
+    Created: 19 Oct 2026 1:05:57pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "StartupTrace.h"
+
+bool StartupTrace::enabled = false;
+bool StartupTrace::windowShown = false;
+double StartupTrace::startMs = 0.0;
+CriticalSection StartupTrace::logLock;
+
+namespace
+{
+    String getThreadName()
+    {
+        if (MessageManager::existsAndIsCurrentThread()){
+            return "message thread";
+        }
+        if (auto* thread = Thread::getCurrentThread()){
+            return thread->getThreadName();
+        }
+        return "other thread";
+    }
+}
+
+//==============================================================================
+StartupTrace::ScopedPhase::ScopedPhase(const char* _name)
+                                      : name(_name)
+{
+    if (enabled){
+        phaseStartMs = Time::getMillisecondCounterHiRes();
+    }
+}
+
+StartupTrace::ScopedPhase::~ScopedPhase()
+{
+    if (enabled){
+        const double endMs = Time::getMillisecondCounterHiRes();
+        log(String(phaseStartMs - startMs, 1).paddedLeft(' ', 8) + " ms  "
+            + String(endMs - phaseStartMs, 1).paddedLeft(' ', 8) + " ms  "
+            + name + " (" + getThreadName() + ")");
+    }
+}
+
+//==============================================================================
+void StartupTrace::begin(const String& commandLine)
+{
+    startMs = Time::getMillisecondCounterHiRes();
+    enabled = StringArray::fromTokens(commandLine, true).contains("--startup-trace");
+    if (enabled){
+        log("   start ms   took ms  phase");
+    }
+}
+
+void StartupTrace::mark(const char* name)
+{
+    if (enabled){
+        log(String(Time::getMillisecondCounterHiRes() - startMs, 1).paddedLeft(' ', 8) + " ms            "
+            + name + " (" + getThreadName() + ")");
+    }
+}
+
+void StartupTrace::windowPainted()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    if (windowShown){
+        return;
+    }
+    windowShown = true;
+    //phases still running in the background go on being logged as they end
+    mark("first paint of the main window, usable from here");
+}
+
+bool StartupTrace::isEnabled()
+{
+    return enabled;
+}
+
+void StartupTrace::log(const String& line)
+{
+    //phases end on several threads at once
+    const ScopedLock sl(logLock);
+    std::cout << "[startup] " << line << std::endl;
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    StartupTrace.h
+    Created: 19 Oct 2026 1:05:57pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==============================================================================
+/*
+    Times the phases of startup, from JUCEApplication::initialise() to the
+    first paint of the main window, and the background phases that run
+    alongside them (library check, waveform cache warm-up ...). Each phase is
+    logged as it ends, with the time since startup it began and how long it
+    took, and the thread it ran on, so phases that overlap are easy to spot.
+    Only on when the app is started with --startup-trace; otherwise a phase
+    costs a single flag check. Thread safe.
+*/
+class StartupTrace
+{
+public:
+    /** times the enclosing scope as one phase */
+    class ScopedPhase
+    {
+    public:
+        explicit ScopedPhase(const char* name);
+        ~ScopedPhase();
+
+    private:
+        const char* name;
+        double phaseStartMs = 0.0;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedPhase)
+    };
+
+    /** called first thing in initialise(); --startup-trace on the command line turns the log on */
+    static void begin(const String& commandLine);
+
+    /** logs a single point in time, e.g. when the window is made visible */
+    static void mark(const char* name);
+
+    /** called on every paint of the main window; the first one logs the total startup time */
+    static void windowPainted();
+
+    static bool isEnabled();
+
+private:
+    static void log(const String& line);
+
+    static bool enabled;
+    static bool windowShown;
+    static double startMs;
+    static CriticalSection logLock;
+};
@@ -0,0 +1,770 @@
+/*
+  ==============================================================================
+
+    TagReader.cpp
+    Created: 19 Oct 2026 12:57:44pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "TagReader.h"
+#include "TrackTable.h"
+
+namespace
+{
+    //tracks read by one pool job
+    const int filesPerJob = 64;
+    //no text tag is this big; bigger ID3 frames and RIFF chunks (cover art) are skipped
+    const int maxTextBytes = 64 * 1024;
+    //comment blocks can hold cover art as well, only this much of one is read
+    const int maxCommentBytes = 1024 * 1024;
+
+    enum Field
+    {
+        noField,
+        titleField,
+        artistField,
+        albumField,
+        genreField,
+        yearField,
+        bpmField,
+        keyField
+    };
+
+    //ID3v1 genre numbers, also used by old ID3v2 tags; 80 onwards are the Winamp additions
+    const char* const id3v1Genres[] =
+    {
+        "Blues", "Classic Rock", "Country", "Dance", "Disco", "Funk", "Grunge", "Hip-Hop",
+        "Jazz", "Metal", "New Age", "Oldies", "Other", "Pop", "R&B", "Rap",
+        "Reggae", "Rock", "Techno", "Industrial", "Alternative", "Ska", "Death Metal", "Pranks",
+        "Soundtrack", "Euro-Techno", "Ambient", "Trip-Hop", "Vocal", "Jazz+Funk", "Fusion", "Trance",
+        "Classical", "Instrumental", "Acid", "House", "Game", "Sound Clip", "Gospel", "Noise",
+        "Alternative Rock", "Bass", "Soul", "Punk", "Space", "Meditative", "Instrumental Pop", "Instrumental Rock",
+        "Ethnic", "Gothic", "Darkwave", "Techno-Industrial", "Electronic", "Pop-Folk", "Eurodance", "Dream",
+        "Southern Rock", "Comedy", "Cult", "Gangsta", "Top 40", "Christian Rap", "Pop/Funk", "Jungle",
+        "Native American", "Cabaret", "New Wave", "Psychedelic", "Rave", "Showtunes", "Trailer", "Lo-Fi",
+        "Tribal", "Acid Punk", "Acid Jazz", "Polka", "Retro", "Musical", "Rock & Roll", "Hard Rock",
+        "Folk", "Folk-Rock", "National Folk", "Swing", "Fast Fusion", "Bebop", "Latin", "Revival",
+        "Celtic", "Bluegrass", "Avantgarde", "Gothic Rock", "Progressive Rock", "Psychedelic Rock", "Symphonic Rock", "Slow Rock",
+        "Big Band", "Chorus", "Easy Listening", "Acoustic", "Humour", "Speech", "Chanson", "Opera",
+        "Chamber Music", "Sonata", "Symphony", "Booty Bass", "Primus", "Porn Groove", "Satire", "Slow Jam",
+        "Club", "Tango", "Samba", "Folklore", "Ballad", "Power Ballad", "Rhythmic Soul", "Freestyle",
+        "Duet", "Punk Rock", "Drum Solo", "A Cappella", "Euro-House", "Dance Hall"
+    };
+
+    //==============================================================================
+    bool readBlock(InputStream& in, int numBytes, MemoryBlock& block)
+    {
+        if (numBytes < 0){
+            return false;
+        }
+        block.setSize(static_cast<size_t>(numBytes));
+        return in.read(block.getData(), numBytes) == numBytes;
+    }
+
+    //ID3v2 sizes keep the top bit of every byte clear
+    int readSyncSafe(const uint8* data)
+    {
+        return ((data[0] & 0x7f) << 21) | ((data[1] & 0x7f) << 14) | ((data[2] & 0x7f) << 7) | (data[3] & 0x7f);
+    }
+
+    //0xff 0x00 was written for every 0xff that could look like an mp3 frame sync
+    void removeUnsynchronisation(MemoryBlock& block)
+    {
+        uint8* data = static_cast<uint8*>(block.getData());
+        size_t out = 0;
+        for (size_t i = 0; i < block.getSize(); ++i){
+            data[out++] = data[i];
+            if (data[i] == 0xff && i + 1 < block.getSize() && data[i + 1] == 0x00){
+                ++i;
+            }
+        }
+        block.setSize(out);
+    }
+
+    //==============================================================================
+    String toString(const std::vector<juce_wchar>& chars)
+    {
+        if (chars.empty()){
+            return {};
+        }
+        return String(CharPointer_UTF32(chars.data()), chars.size());
+    }
+
+    //the decoders stop at the first nul, so only the first of several values is kept
+    String decodeLatin1(const uint8* data, size_t size)
+    {
+        std::vector<juce_wchar> chars;
+        for (size_t i = 0; i < size && data[i] != 0; ++i){
+            chars.push_back(static_cast<juce_wchar>(data[i]));
+        }
+        return toString(chars);
+    }
+
+    String decodeUtf16(const uint8* data, size_t size, bool bigEndian)
+    {
+        auto unitAt = [data, bigEndian] (size_t i) {
+            return static_cast<juce_wchar>(bigEndian ? (data[i] << 8) | data[i + 1] : (data[i + 1] << 8) | data[i]);
+        };
+
+        std::vector<juce_wchar> chars;
+        for (size_t i = 0; i + 1 < size; i += 2){
+            juce_wchar c = unitAt(i);
+            if (c == 0){
+                break;
+            }
+            if (c >= 0xd800 && c < 0xdc00 && i + 3 < size){
+                const juce_wchar low = unitAt(i + 2);
+                if (low >= 0xdc00 && low < 0xe000){
+                    c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                    i += 2;
+                }
+            }
+            chars.push_back(c);
+        }
+        return toString(chars);
+    }
+
+    //RIFF and AIFF text is meant to be plain ASCII; it is UTF-8 or the writer's code page in practice
+    String decodeUtf8OrLatin1(const uint8* data, size_t size)
+    {
+        size_t length = 0;
+        while (length < size && data[length] != 0){
+            ++length;
+        }
+        const char* text = reinterpret_cast<const char*>(data);
+        if (CharPointer_UTF8::isValidString(text, static_cast<int>(length))){
+            return String::fromUTF8(text, static_cast<int>(length));
+        }
+        return decodeLatin1(data, length);
+    }
+
+    //ID3v2 text frames start with a byte giving the encoding
+    String decodeId3Text(const uint8* data, size_t size)
+    {
+        if (size < 2){
+            return {};
+        }
+        const uint8 encoding = data[0];
+        ++data;
+        --size;
+
+        switch (encoding){
+            case 1:
+                //UTF-16 with a byte order mark
+                if (size >= 2 && data[0] == 0xfe && data[1] == 0xff){
+                    return decodeUtf16(data + 2, size - 2, true);
+                }
+                if (size >= 2 && data[0] == 0xff && data[1] == 0xfe){
+                    return decodeUtf16(data + 2, size - 2, false);
+                }
+                return decodeUtf16(data, size, false);
+            case 2:
+                return decodeUtf16(data, size, true);
+            case 3:
+                return decodeUtf8OrLatin1(data, size);
+            default:
+                return decodeLatin1(data, size);
+        }
+    }
+
+    //"(17)", "17" or "(17)Rock" in older tags; the text wins if there is any
+    String resolveId3Genre(const String& text)
+    {
+        String genre = text.trim();
+        if (genre.startsWithChar('(') && genre.containsChar(')')){
+            const String rest = genre.fromFirstOccurrenceOf(")", false, false).trim();
+            if (rest.isNotEmpty()){
+                return rest;
+            }
+            genre = genre.substring(1).upToFirstOccurrenceOf(")", false, false);
+        }
+        if (genre.isNotEmpty() && genre.containsOnly("0123456789")){
+            const int index = genre.getIntValue();
+            return index < numElementsInArray(id3v1Genres) ? String(id3v1Genres[index]) : String();
+        }
+        return genre;
+    }
+
+    //==============================================================================
+    //the first tag found wins, so ID3v2 comes before ID3v1
+    void setField(TagReader::Tags& tags, Field field, const String& text)
+    {
+        const String value = text.trim();
+        if (value.isEmpty()){
+            return;
+        }
+        switch (field){
+            case titleField:  if (tags.title.isEmpty())  tags.title = value; break;
+            case artistField: if (tags.artist.isEmpty()) tags.artist = value; break;
+            case albumField:  if (tags.album.isEmpty())  tags.album = value; break;
+            case genreField:  if (tags.genre.isEmpty())  tags.genre = value; break;
+            //"2004" or a whole date, "2004-05-01"
+            case yearField:   if (tags.year == 0)        tags.year = jlimit(0, 9999, value.substring(0, 4).getIntValue()); break;
+            case bpmField:    if (tags.bpm <= 0.0)       tags.bpm = jlimit(0.0, 999.0, value.getDoubleValue()); break;
+            case keyField:    if (tags.key == 0)         tags.key = TrackTable::parseCamelotKey(value); break;
+            default: break;
+        }
+    }
+
+    //2.2 has three letter frame ids, 2.3 and 2.4 four letter ones
+    Field getId3Field(const uint8* id, int version)
+    {
+        static const struct { const char* id; Field field; } frames[] =
+        {
+            { "TT2", titleField }, { "TP1", artistField }, { "TAL", albumField }, { "TCO", genreField },
+            { "TYE", yearField }, { "TBP", bpmField }, { "TKE", keyField },
+            { "TIT2", titleField }, { "TPE1", artistField }, { "TALB", albumField }, { "TCON", genreField },
+            //TYER up to 2.3, TDRC (a whole date) from 2.4
+            { "TYER", yearField }, { "TDRC", yearField }, { "TBPM", bpmField }, { "TKEY", keyField }
+        };
+        const size_t idLength = version == 2 ? 3 : 4;
+        for (const auto& frame : frames){
+            if (strlen(frame.id) == idLength && memcmp(id, frame.id, idLength) == 0){
+                return frame.field;
+            }
+        }
+        return noField;
+    }
+
+    //Vorbis comment names, also used for the metadataValues of other formats
+    Field getCommentField(const String& upperCaseName)
+    {
+        if (upperCaseName == "TITLE") return titleField;
+        if (upperCaseName == "ARTIST") return artistField;
+        if (upperCaseName == "ALBUM") return albumField;
+        if (upperCaseName == "GENRE") return genreField;
+        if (upperCaseName == "DATE" || upperCaseName == "YEAR") return yearField;
+        if (upperCaseName == "BPM" || upperCaseName == "TEMPO") return bpmField;
+        if (upperCaseName == "INITIALKEY" || upperCaseName == "KEY") return keyField;
+        return noField;
+    }
+
+    Field getInfoField(const uint8* id)
+    {
+        if (memcmp(id, "INAM", 4) == 0) return titleField;
+        if (memcmp(id, "IART", 4) == 0) return artistField;
+        if (memcmp(id, "IPRD", 4) == 0) return albumField;
+        if (memcmp(id, "IGNR", 4) == 0) return genreField;
+        if (memcmp(id, "ICRD", 4) == 0) return yearField;
+        return noField;
+    }
+
+    //==============================================================================
+    void skipId3ExtendedHeader(InputStream& in, int version, int flags)
+    {
+        uint8 size[4];
+        if ((flags & 0x40) == 0 || in.read(size, 4) != 4){
+            return;
+        }
+        //2.3 counts the bytes after the size, 2.4 the whole header
+        if (version == 3){
+            in.skipNextBytes(ByteOrder::bigEndianInt(size));
+        }
+        else{
+            in.skipNextBytes(jmax(0, readSyncSafe(size) - 4));
+        }
+    }
+
+    void parseId3Frames(InputStream& in, int64 end, int version, TagReader::Tags& tags)
+    {
+        const int headerSize = version == 2 ? 6 : 10;
+        uint8 header[10] = {};
+        MemoryBlock body;
+
+        while (in.getPosition() + headerSize <= end){
+            if (in.read(header, headerSize) != headerSize || header[0] == 0){
+                return; //the rest is padding
+            }
+            const int size = version == 2 ? static_cast<int>(ByteOrder::bigEndian24Bit(header + 3))
+                           : version == 3 ? static_cast<int>(ByteOrder::bigEndianInt(header + 4))
+                           : readSyncSafe(header + 4);
+            const int64 next = in.getPosition() + size;
+            if (size < 0 || next > end){
+                return;
+            }
+
+            //pictures and everything else we don't show are skipped without reading them
+            const Field field = getId3Field(header, version);
+            if (field == noField || size == 0 || size > maxTextBytes){
+                in.setPosition(next);
+                continue;
+            }
+            if (!readBlock(in, size, body)){
+                return;
+            }
+
+            //flags can put extra bytes in front of the text
+            int offset = 0;
+            const uint8 formatFlags = header[9];
+            if (version == 3){
+                if ((formatFlags & 0xc0) != 0){
+                    continue; //compressed or encrypted
+                }
+                if ((formatFlags & 0x20) != 0){
+                    offset += 1; //group
+                }
+            }
+            else if (version == 4){
+                if ((formatFlags & 0x0c) != 0){
+                    continue; //compressed or encrypted
+                }
+                if ((formatFlags & 0x02) != 0){
+                    removeUnsynchronisation(body);
+                }
+                if ((formatFlags & 0x40) != 0){
+                    offset += 1; //group
+                }
+                if ((formatFlags & 0x01) != 0){
+                    offset += 4; //data length
+                }
+            }
+            if (offset >= static_cast<int>(body.getSize())){
+                continue;
+            }
+
+            String text = decodeId3Text(static_cast<const uint8*>(body.getData()) + offset, body.getSize() - static_cast<size_t>(offset));
+            if (field == genreField){
+                text = resolveId3Genre(text);
+            }
+            setField(tags, field, text);
+        }
+    }
+
+    //reads an ID3v2 tag at the current position and leaves the stream just after it
+    bool parseId3v2(InputStream& in, TagReader::Tags& tags)
+    {
+        const int64 start = in.getPosition();
+        uint8 header[10];
+        if (in.read(header, 10) != 10 || memcmp(header, "ID3", 3) != 0){
+            in.setPosition(start);
+            return false;
+        }
+        const int version = header[3];
+        const int flags = header[5];
+        const int size = readSyncSafe(header + 6);
+        const int64 end = start + 10 + size;
+
+        //2.2 used the extended header flag for compression, which nobody could read
+        if (version >= 2 && version <= 4 && !(version == 2 && (flags & 0x40) != 0)){
+            if ((flags & 0x80) != 0 && version < 4){
+                //the whole tag is unsynchronised, so it can only be read in one go
+                MemoryBlock block;
+                if (readBlock(in, jmin(size, maxCommentBytes), block)){
+                    removeUnsynchronisation(block);
+                    MemoryInputStream tagStream(block, false);
+                    skipId3ExtendedHeader(tagStream, version, flags);
+                    parseId3Frames(tagStream, tagStream.getTotalLength(), version, tags);
+                }
+            }
+            else{
+                skipId3ExtendedHeader(in, version, flags);
+                parseId3Frames(in, end, version, tags);
+            }
+        }
+
+        //2.4 tags can end with a copy of the header
+        in.setPosition(end + (version == 4 && (flags & 0x10) != 0 ? 10 : 0));
+        return true;
+    }
+
+    //the 128 bytes at the very end of older mp3 files
+    void parseId3v1(InputStream& in, TagReader::Tags& tags)
+    {
+        const int64 length = in.getTotalLength();
+        uint8 tag[128];
+        if (length < 128 || !in.setPosition(length - 128) || in.read(tag, 128) != 128 || memcmp(tag, "TAG", 3) != 0){
+            return;
+        }
+        setField(tags, titleField, decodeLatin1(tag + 3, 30));
+        setField(tags, artistField, decodeLatin1(tag + 33, 30));
+        setField(tags, albumField, decodeLatin1(tag + 63, 30));
+        setField(tags, yearField, decodeLatin1(tag + 93, 4));
+        if (tag[127] < numElementsInArray(id3v1Genres)){
+            setField(tags, genreField, id3v1Genres[tag[127]]);
+        }
+    }
+
+    //==============================================================================
+    //"NAME=value" comments with little endian lengths, as in FLAC, Vorbis and Opus
+    void parseVorbisComments(const uint8* data, size_t size, TagReader::Tags& tags)
+    {
+        size_t position = 0;
+        auto readLength = [&] (uint32& length) {
+            if (position + 4 > size){
+                return false;
+            }
+            length = ByteOrder::littleEndianInt(data + position);
+            position += 4;
+            return length <= size - position;
+        };
+
+        uint32 length = 0;
+        uint32 numComments = 0;
+        if (!readLength(length)){
+            return;
+        }
+        position += length; //vendor
+        if (!readLength(numComments)){
+            return;
+        }
+
+        for (uint32 i = 0; i < numComments; ++i){
+            if (!readLength(length)){
+                return;
+            }
+            const char* comment = reinterpret_cast<const char*>(data + position);
+            position += length;
+
+            //only the name is looked at first, so embedded pictures are never turned into strings
+            int nameLength = 0;
+            while (nameLength < jmin(static_cast<int>(length), 32) && comment[nameLength] != '='){
+                ++nameLength;
+            }
+            if (nameLength == 0 || nameLength >= static_cast<int>(length) || comment[nameLength] != '='){
+                continue;
+            }
+            const Field field = getCommentField(String::fromUTF8(comment, nameLength).toUpperCase());
+            if (field != noField){
+                setField(tags, field, String::fromUTF8(comment + nameLength + 1, static_cast<int>(length) - nameLength - 1));
+            }
+        }
+    }
+
+    bool parseFlac(InputStream& in, TagReader::Tags& tags)
+    {
+        uint8 header[4];
+        if (in.read(header, 4) != 4 || memcmp(header, "fLaC", 4) != 0){
+            return false;
+        }
+
+        MemoryBlock block;
+        while (in.read(header, 4) == 4){
+            const bool isLast = (header[0] & 0x80) != 0;
+            const int type = header[0] & 0x7f;
+            const int length = static_cast<int>(ByteOrder::bigEndian24Bit(header + 1));
+
+            //there is only one comment block; stream info, seek tables and pictures are skipped
+            if (type == 4){
+                if (readBlock(in, jmin(length, maxCommentBytes), block)){
+                    parseVorbisComments(static_cast<const uint8*>(block.getData()), block.getSize(), tags);
+                }
+                break;
+            }
+            if (isLast){
+                break;
+            }
+            in.skipNextBytes(length);
+        }
+        return true;
+    }
+
+    //the comments are the second packet of the first stream; a packet can go over several pages
+    bool parseOgg(InputStream& in, TagReader::Tags& tags)
+    {
+        uint8 header[27];
+        uint8 segments[255];
+        MemoryBlock page;
+        MemoryBlock packet;
+        int numPackets = 0;
+        uint32 serial = 0;
+
+        auto parseCommentPacket = [&] {
+            const uint8* data = static_cast<const uint8*>(packet.getData());
+            if (packet.getSize() >= 7 && memcmp(data, "\x03vorbis", 7) == 0){
+                parseVorbisComments(data + 7, packet.getSize() - 7, tags);
+            }
+            else if (packet.getSize() >= 8 && memcmp(data, "OpusTags", 8) == 0){
+                parseVorbisComments(data + 8, packet.getSize() - 8, tags);
+            }
+        };
+
+        for (int pageNumber = 0; pageNumber < 64; ++pageNumber){
+            if (in.read(header, 27) != 27 || memcmp(header, "OggS", 4) != 0){
+                return pageNumber > 0;
+            }
+            const int numSegments = header[26];
+            if (in.read(segments, numSegments) != numSegments){
+                return true;
+            }
+            int pageSize = 0;
+            for (int s = 0; s < numSegments; ++s){
+                pageSize += segments[s];
+            }
+
+            //pages of other streams (in a file with several) are skipped
+            const uint32 pageSerial = ByteOrder::littleEndianInt(header + 14);
+            if (pageNumber == 0){
+                serial = pageSerial;
+            }
+            else if (pageSerial != serial){
+                in.skipNextBytes(pageSize);
+                continue;
+            }
+            if (!readBlock(in, pageSize, page)){
+                return true;
+            }
+
+            //a segment shorter than 255 bytes ends a packet
+            int offset = 0;
+            for (int s = 0; s < numSegments; ++s){
+                if (numPackets == 1){
+                    packet.append(static_cast<const uint8*>(page.getData()) + offset, segments[s]);
+                }
+                offset += segments[s];
+                if (segments[s] < 255 && ++numPackets == 2){
+                    parseCommentPacket();
+                    return true;
+                }
+            }
+            if (packet.getSize() >= static_cast<size_t>(maxCommentBytes)){
+                parseCommentPacket(); //whatever comes before the picture
+                return true;
+            }
+        }
+        return true;
+    }
+
+    bool parseRiff(InputStream& in, TagReader::Tags& tags)
+    {
+        uint8 header[12];
+        if (in.read(header, 12) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0){
+            return false;
+        }
+
+        //the chunks are walked with seeks, the audio data is never read
+        const int64 end = jmin(in.getTotalLength(), 8 + static_cast<int64>(ByteOrder::littleEndianInt(header + 4)));
+        MemoryBlock block;
+        for (int chunkNumber = 0; chunkNumber < 64 && in.getPosition() + 8 <= end; ++chunkNumber){
+            uint8 chunk[8];
+            if (in.read(chunk, 8) != 8){
+                break;
+            }
+            const uint32 size = ByteOrder::littleEndianInt(chunk + 4);
+            //chunks are padded to an even size
+            const int64 next = in.getPosition() + size + (size & 1);
+
+            if (memcmp(chunk, "LIST", 4) == 0 && size >= 4 && size <= static_cast<uint32>(maxTextBytes)){
+                if (readBlock(in, static_cast<int>(size), block) && memcmp(block.getData(), "INFO", 4) == 0){
+                    //INFO holds one sub-chunk per field
+                    const uint8* data = static_cast<const uint8*>(block.getData()) + 4;
+                    const size_t infoSize = size - 4;
+                    size_t position = 0;
+                    while (position + 8 <= infoSize){
+                        const uint32 length = ByteOrder::littleEndianInt(data + position + 4);
+                        if (length > infoSize - position - 8){
+                            break;
+                        }
+                        setField(tags, getInfoField(data + position), decodeUtf8OrLatin1(data + position + 8, length));
+                        position += 8 + length + (length & 1);
+                    }
+                }
+            }
+            else if (memcmp(chunk, "id3 ", 4) == 0 || memcmp(chunk, "ID3 ", 4) == 0){
+                parseId3v2(in, tags);
+            }
+            in.setPosition(next);
+        }
+        return true;
+    }
+
+    bool parseAiff(InputStream& in, TagReader::Tags& tags)
+    {
+        uint8 header[12];
+        if (in.read(header, 12) != 12 || memcmp(header, "FORM", 4) != 0
+            || (memcmp(header + 8, "AIFF", 4) != 0 && memcmp(header + 8, "AIFC", 4) != 0)){
+            return false;
+        }
+
+        const int64 end = jmin(in.getTotalLength(), 8 + static_cast<int64>(ByteOrder::bigEndianInt(header + 4)));
+        MemoryBlock block;
+        for (int chunkNumber = 0; chunkNumber < 64 && in.getPosition() + 8 <= end; ++chunkNumber){
+            uint8 chunk[8];
+            if (in.read(chunk, 8) != 8){
+                break;
+            }
+            const uint32 size = ByteOrder::bigEndianInt(chunk + 4);
+            const int64 next = in.getPosition() + size + (size & 1);
+
+            const bool isName = memcmp(chunk, "NAME", 4) == 0;
+            if ((isName || memcmp(chunk, "AUTH", 4) == 0) && size <= static_cast<uint32>(maxTextBytes)){
+                if (readBlock(in, static_cast<int>(size), block)){
+                    setField(tags, isName ? titleField : artistField,
+                             decodeUtf8OrLatin1(static_cast<const uint8*>(block.getData()), block.getSize()));
+                }
+            }
+            else if (memcmp(chunk, "ID3 ", 4) == 0){
+                parseId3v2(in, tags);
+            }
+            in.setPosition(next);
+        }
+        return true;
+    }
+
+    //formats we have no parser for (e.g. m4a through the OS decoders) only give what their reader gives
+    void readFromFormatReader(AudioFormatManager& formatManager, const File& file, TagReader::Tags& tags)
+    {
+        std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor(file));
+        if (reader == nullptr){
+            return;
+        }
+        const StringPairArray& values = reader->metadataValues;
+        for (const String& key : values.getAllKeys()){
+            setField(tags, getCommentField(key.toUpperCase()), values[key]);
+        }
+    }
+}
+
+//==============================================================================
+/** reads the tags of a batch of files on a pool thread */
+class TagReader::ReadJob : public ThreadPoolJob
+{
+public:
+    ReadJob(TagReader& _owner, std::vector<Request> _requests)
+           : ThreadPoolJob("Tags"),
+             owner(&_owner),
+             formatManager(_owner.formatManager),
+             requests(std::move(_requests))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        std::vector<Result> results;
+        results.reserve(requests.size());
+        for (const Request& request : requests){
+            if (shouldExit()){
+                return jobHasFinished;
+            }
+            results.push_back({ request.id, readTags(formatManager, request.file) });
+        }
+
+        //hand the batch over on the message thread, if the reader still exists
+        WeakReference<TagReader> reader = owner;
+        MessageManager::callAsync([reader, results] {
+            if (auto* r = reader.get()){
+                r->batchRead(results);
+            }
+        });
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const TagReader* reader) const
+    {
+        return owner.get() == reader;
+    }
+
+private:
+    WeakReference<TagReader> owner;
+    AudioFormatManager& formatManager;
+    std::vector<Request> requests;
+};
+
+//==============================================================================
+bool TagReader::Tags::isEmpty() const
+{
+    return title.isEmpty() && artist.isEmpty() && album.isEmpty() && genre.isEmpty()
+        && year == 0 && bpm <= 0.0 && key == 0;
+}
+
+TagReader::TagReader(AudioFormatManager& _formatManager, ThreadPool& _threadPool)
+                    : formatManager(_formatManager),
+                      threadPool(_threadPool)
+{
+}
+
+TagReader::~TagReader()
+{
+    cancelPendingUpdate();
+
+    //the pool is shared, so only this reader's jobs are stopped
+    struct OwnJobs : public ThreadPool::JobSelector
+    {
+        const TagReader* reader;
+        bool isJobSuitable(ThreadPoolJob* job) override
+        {
+            auto* readJob = dynamic_cast<ReadJob*>(job);
+            return readJob != nullptr && readJob->belongsTo(reader);
+        }
+    };
+    OwnJobs selector;
+    selector.reader = this;
+    threadPool.removeAllJobs(true, 5000, &selector);
+
+    masterReference.clear();
+}
+
+void TagReader::read(int64 id, const File& file)
+{
+    queued.push_back({ id, file });
+    triggerAsyncUpdate();
+}
+
+void TagReader::handleAsyncUpdate()
+{
+    for (size_t start = 0; start < queued.size(); start += filesPerJob){
+        const size_t end = jmin(queued.size(), start + static_cast<size_t>(filesPerJob));
+        threadPool.addJob(new ReadJob(*this, std::vector<Request>(queued.begin() + static_cast<std::ptrdiff_t>(start),
+                                                                  queued.begin() + static_cast<std::ptrdiff_t>(end))), true);
+    }
+    queued.clear();
+}
+
+TagReader::Tags TagReader::readTags(AudioFormatManager& formatManager, const File& file)
+{
+    Tags tags;
+    FileInputStream fileStream(file);
+    if (fileStream.failedToOpen()){
+        return tags;
+    }
+    //frame and chunk headers come out of the buffer, anything big is skipped with a seek
+    BufferedInputStream in(fileStream, 16 * 1024);
+
+    uint8 magic[12] = {};
+    in.read(magic, 12);
+    in.setPosition(0);
+
+    if (memcmp(magic, "ID3", 3) == 0){
+        parseId3v2(in, tags);
+        //some FLAC files have an ID3v2 tag in front as well
+        parseFlac(in, tags);
+        if (tags.title.isEmpty() || tags.artist.isEmpty()){
+            parseId3v1(in, tags);
+        }
+    }
+    else if (memcmp(magic, "fLaC", 4) == 0){
+        parseFlac(in, tags);
+    }
+    else if (memcmp(magic, "OggS", 4) == 0){
+        parseOgg(in, tags);
+    }
+    else if (memcmp(magic, "RIFF", 4) == 0){
+        parseRiff(in, tags);
+    }
+    else if (memcmp(magic, "FORM", 4) == 0){
+        parseAiff(in, tags);
+    }
+    else if (file.hasFileExtension("mp3")){
+        parseId3v1(in, tags);
+    }
+    else{
+        readFromFormatReader(formatManager, file, tags);
+    }
+    return tags;
+}
+
+void TagReader::batchRead(const std::vector<Result>& results)
+{
+    listeners.call([&] (Listener& l) { l.tagsRead(results); });
+}
+
+void TagReader::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void TagReader::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
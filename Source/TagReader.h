@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    TagReader.h
+    Created: 19 Oct 2026 12:57:44pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <vector>
+
+//==============================================================================
+/*
+    Reads title, artist, album, genre, year, bpm and key tags of library
+    tracks on the shared background ThreadPool. The tags are parsed straight
+    from the file headers: ID3v2 (2.2 to 2.4, in mp3, wav and aiff files) with
+    ID3v1 as a fallback, FLAC and Ogg (Vorbis and Opus) comments, RIFF INFO
+    and AIFF text chunks. Only the header bytes are read; cover art and the
+    audio itself are skipped with a seek. Other containers fall back to the
+    metadataValues of an AudioFormatReader, which only parses the header too.
+    Requests are gathered until the message loop comes round and then read
+    in batches, one batch per pool job, so a whole library is spread over all
+    the pool threads and comes back in a few hundred messages rather than one
+    per track. Only used from the message thread; listeners are told on the
+    message thread.
+*/
+class TagReader  : private AsyncUpdater
+{
+public:
+    struct Tags
+    {
+        //empty if the file has no such tag
+        String title;
+        String artist;
+        String album;
+        String genre;
+        //0 if unknown
+        int year = 0;
+        double bpm = 0.0;
+        //Camelot code 1..24, see TrackTable::parseCamelotKey()
+        int key = 0;
+
+        bool isEmpty() const;
+    };
+
+    struct Result
+    {
+        int64 id;
+        Tags tags;
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called with the tags of a batch of tracks */
+        virtual void tagsRead(const std::vector<Result>& results) = 0;
+    };
+
+    TagReader(AudioFormatManager& formatManager, ThreadPool& threadPool);
+    ~TagReader() override;
+
+    /** queues a track; its tags arrive with one of the next tagsRead() calls */
+    void read(int64 id, const File& file);
+
+    /** reads the tags of a file straight away; thread safe, called by the pool jobs */
+    static Tags readTags(AudioFormatManager& formatManager, const File& file);
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    class ReadJob;
+
+    struct Request
+    {
+        int64 id;
+        File file;
+    };
+
+    /** hands the queued requests to the pool in batches */
+    void handleAsyncUpdate() override;
+    /** called on the message thread by a finished ReadJob */
+    void batchRead(const std::vector<Result>& results);
+
+    AudioFormatManager& formatManager;
+    ThreadPool& threadPool;
+
+    std::vector<Request> queued;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (TagReader)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TagReader)
+};
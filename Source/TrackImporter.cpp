@@ -0,0 +1,270 @@
+/*
+  ==============================================================================
+
+    TrackImporter.cpp
+    Created: 19 Oct 2026 12:46:16pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "TrackImporter.h"
+
+namespace
+{
+    //a folder with thousands of files still shows up in steps
+    const int filesPerBatch = 500;
+
+    /** the folder a link points to (through a chain of links), or the folder itself */
+    File resolveLink(const File& folder)
+    {
+        File target = folder;
+        //a loop of links is given up on
+        for (int i = 0; i < 8 && target.isSymbolicLink(); ++i){
+            target = target.getLinkedTarget();
+        }
+        return target;
+    }
+}
+
+//==============================================================================
+/** lists one folder on a pool thread */
+class TrackImporter::FolderJob : public ThreadPoolJob
+{
+public:
+    FolderJob(TrackImporter& _owner, const File& _folder, const String& _extensions, int _importNumber)
+             : ThreadPoolJob("Import " + _folder.getFileName()),
+               owner(&_owner),
+               folder(_folder),
+               extensions(_extensions),
+               importNumber(_importNumber)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        Array<File> files;
+        Array<File> subfolders;
+        int filesSkipped = 0;
+
+        for (const DirectoryEntry& entry : RangedDirectoryIterator(folder, false, "*",
+                                                                   File::findFilesAndDirectories | File::ignoreHiddenFiles)){
+            if (shouldExit()){
+                return jobHasFinished;
+            }
+            const File file = entry.getFile();
+            if (entry.isDirectory()){
+                //a linked folder is walked where it points, so one pointing back up the tree is seen
+                //as already walked by scanFolder() and the walk still ends
+                subfolders.add(resolveLink(file));
+            }
+            else if (file.hasFileExtension(extensions)){
+                files.add(file);
+                if (files.size() == filesPerBatch){
+                    post(files, {}, filesSkipped, false);
+                    files.clearQuick();
+                    filesSkipped = 0;
+                }
+            }
+            else{
+                ++filesSkipped;
+            }
+        }
+        post(files, subfolders, filesSkipped, true);
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const TrackImporter* importer) const
+    {
+        return owner.get() == importer;
+    }
+
+private:
+    /** hands a batch over on the message thread, if the importer still exists */
+    void post(const Array<File>& files, const Array<File>& subfolders, int filesSkipped, bool isLastBatch)
+    {
+        WeakReference<TrackImporter> importer = owner;
+        int number = importNumber;
+        MessageManager::callAsync([importer, number, files, subfolders, filesSkipped, isLastBatch] {
+            if (auto* i = importer.get()){
+                i->folderScanned(number, files, subfolders, filesSkipped, isLastBatch);
+            }
+        });
+    }
+
+    WeakReference<TrackImporter> owner;
+    File folder;
+    String extensions;
+    int importNumber;
+};
+
+//==============================================================================
+TrackImporter::TrackImporter(AudioFormatManager& _formatManager,
+                             ThreadPool& _threadPool,
+                             const LibraryStore& _library,
+                             TrackMetadataScanner& _metadataScanner)
+                            : formatManager(_formatManager),
+                              threadPool(_threadPool),
+                              library(_library),
+                              metadataScanner(_metadataScanner)
+{
+}
+
+TrackImporter::~TrackImporter()
+{
+    removeOwnJobs(5000);
+    masterReference.clear();
+}
+
+void TrackImporter::removeOwnJobs(int timeOutMilliseconds)
+{
+    //the pool is shared, so only this importer's jobs are stopped
+    struct OwnJobs : public ThreadPool::JobSelector
+    {
+        const TrackImporter* importer;
+        bool isJobSuitable(ThreadPoolJob* job) override
+        {
+            auto* folderJob = dynamic_cast<FolderJob*>(job);
+            return folderJob != nullptr && folderJob->belongsTo(importer);
+        }
+    };
+    OwnJobs selector;
+    selector.importer = this;
+    threadPool.removeAllJobs(true, timeOutMilliseconds, &selector);
+}
+
+//==============================================================================
+void TrackImporter::import(const Array<File>& filesAndFolders)
+{
+    if (!importing){
+        importing = true;
+        ++importNumber;
+        summary = Summary();
+        seenPaths.clear();
+        seenFolders.clear();
+        //"*.wav;*.mp3" -> ".wav;.mp3", the form File::hasFileExtension() takes
+        wildcard = formatManager.getWildcardForAllFormats().removeCharacters("*");
+    }
+
+    Array<File> files;
+    for (const File& file : filesAndFolders){
+        if (file.isDirectory()){
+            scanFolder(resolveLink(file));
+        }
+        else if (file.hasFileExtension(wildcard)){
+            files.add(file);
+        }
+        else{
+            ++summary.filesSkipped;
+        }
+    }
+    addFiles(files);
+
+    if (foldersPending == 0){
+        finish();
+    }
+    else{
+        //shows the progress bar before the first folder is done
+        const double progress = summary.foldersScanned / static_cast<double>(summary.foldersScanned + foldersPending);
+        listeners.call([&] (Listener& l) { l.importProgressChanged(progress); });
+    }
+}
+
+void TrackImporter::cancel()
+{
+    if (!importing){
+        return;
+    }
+
+    //running jobs are told to stop and whatever they still send is ignored
+    ++importNumber;
+    removeOwnJobs(0);
+    foldersPending = 0;
+    summary.cancelled = true;
+    finish();
+}
+
+bool TrackImporter::isImporting() const
+{
+    return importing;
+}
+
+void TrackImporter::scanFolder(const File& folder)
+{
+    //e.g. a folder dropped together with its parent, or reached through a link, is only walked once
+    if (!seenFolders.insert(folder.getFullPathName()).second){
+        return;
+    }
+    ++foldersPending;
+    threadPool.addJob(new FolderJob(*this, folder, wildcard, importNumber), true);
+}
+
+void TrackImporter::folderScanned(int number, const Array<File>& files, const Array<File>& subfolders,
+                                  int filesSkipped, bool isLastBatch)
+{
+    if (number != importNumber){
+        return;
+    }
+
+    summary.filesSkipped += filesSkipped;
+    addFiles(files);
+    if (!isLastBatch){
+        return;
+    }
+
+    --foldersPending;
+    ++summary.foldersScanned;
+    for (const File& subfolder : subfolders){
+        scanFolder(subfolder);
+    }
+
+    const double progress = summary.foldersScanned / static_cast<double>(summary.foldersScanned + foldersPending);
+    listeners.call([&] (Listener& l) { l.importProgressChanged(progress); });
+
+    if (foldersPending == 0){
+        finish();
+    }
+}
+
+void TrackImporter::addFiles(const Array<File>& files)
+{
+    //hash lookups only, so a batch costs the same whatever the size of the library
+    Array<File> newFiles;
+    for (const File& file : files){
+        if (!library.contains(file) && seenPaths.insert(file.getFullPathName()).second){
+            newFiles.add(file);
+        }
+        else{
+            ++summary.duplicates;
+        }
+    }
+    if (newFiles.isEmpty()){
+        return;
+    }
+
+    summary.tracksAdded += newFiles.size();
+    listeners.call([&] (Listener& l) { l.tracksImported(newFiles); });
+
+    //lengths are probed on the pool now, rather than when the rows are first painted
+    TrackMetadataScanner::TrackInfo info;
+    for (const File& file : newFiles){
+        metadataScanner.getOrRequest(file, info);
+    }
+}
+
+void TrackImporter::finish()
+{
+    importing = false;
+    listeners.call([&] (Listener& l) { l.importFinished(summary); });
+}
+
+//==============================================================================
+void TrackImporter::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void TrackImporter::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    TrackImporter.h
+    Created: 19 Oct 2026 12:46:16pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "LibraryStore.h"
+#include "TrackMetadataScanner.h"
+#include <unordered_set>
+
+//==============================================================================
+/*
+    Imports dropped or chosen files and folders into the library without
+    blocking the message thread. Every folder is listed by its own job on the
+    shared background ThreadPool, so a tree of folders is walked in parallel;
+    only files with an extension one of the registered formats can read are
+    kept. Each folder's files come back to the message thread as a batch,
+    are checked against the library and the rest of the import with hash
+    lookups, and the new ones are handed to the listeners straight away, so
+    rows appear while the walk is still going. The new tracks are queued on
+    the TrackMetadataScanner so their lengths are probed by the pool too.
+    Duplicates are only counted; the listeners get one summary at the end.
+    Only used from the message thread.
+*/
+class TrackImporter
+{
+public:
+    struct Summary
+    {
+        int tracksAdded = 0;
+        //already in the library, or twice in what was dropped
+        int duplicates = 0;
+        //not a format we can play
+        int filesSkipped = 0;
+        int foldersScanned = 0;
+        bool cancelled = false;
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** new tracks, not in the library yet; called once per batch while importing */
+        virtual void tracksImported(const Array<File>& files) = 0;
+        /** called as folders are scanned, with 0..1 (a guess, the folders still to find are unknown) */
+        virtual void importProgressChanged(double progress) = 0;
+        /** called once, when everything is scanned or the import was cancelled */
+        virtual void importFinished(const Summary& summary) = 0;
+    };
+
+    TrackImporter(AudioFormatManager& formatManager,
+                  ThreadPool& threadPool,
+                  const LibraryStore& library,
+                  TrackMetadataScanner& metadataScanner);
+    ~TrackImporter();
+
+    /** imports files and (recursively) folders; while importing, they join the running import */
+    void import(const Array<File>& filesAndFolders);
+
+    /** stops the walk; tracks already handed over stay in the library */
+    void cancel();
+
+    bool isImporting() const;
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    class FolderJob;
+
+    /** called on the message thread by a finished FolderJob */
+    void folderScanned(int importNumber, const Array<File>& files, const Array<File>& subfolders,
+                       int filesSkipped, bool isLastBatch);
+    void addFiles(const Array<File>& files);
+    void scanFolder(const File& folder);
+    void finish();
+    void removeOwnJobs(int timeOutMilliseconds);
+
+    AudioFormatManager& formatManager;
+    ThreadPool& threadPool;
+    const LibraryStore& library;
+    TrackMetadataScanner& metadataScanner;
+
+    //results of a cancelled import are dropped
+    int importNumber = 0;
+    bool importing = false;
+    //"*.wav;*.mp3;..." for the formats registered when the import started
+    String wildcard;
+    int foldersPending = 0;
+    //paths seen by this import, so a file dropped twice is only added once
+    std::unordered_set<String, LibraryStore::PathHash> seenPaths;
+    //folders queued by this import, by the path a linked folder points to
+    std::unordered_set<String, LibraryStore::PathHash> seenFolders;
+    Summary summary;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (TrackImporter)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TrackImporter)
+};
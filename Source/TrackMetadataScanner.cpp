@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    TrackMetadataScanner.cpp
+    Created: 19 Oct 2026 12:36:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "TrackMetadataScanner.h"
+#include "MemoryMonitor.h"
+
+//==============================================================================
+/** probes one file on a pool thread */
+class TrackMetadataScanner::ScanJob : public ThreadPoolJob
+{
+public:
+    ScanJob(TrackMetadataScanner& _owner, const File& _file)
+           : ThreadPoolJob("Metadata " + _file.getFileName()),
+             owner(&_owner),
+             formatManager(_owner.formatManager),
+             file(_file)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        TrackInfo info = probe(formatManager, file);
+        if (shouldExit()){
+            return jobHasFinished;
+        }
+
+        //hand the result over on the message thread, if the scanner still exists
+        WeakReference<TrackMetadataScanner> scanner = owner;
+        File scannedFile = file;
+        MessageManager::callAsync([scanner, scannedFile, info] {
+            if (auto* s = scanner.get()){
+                s->scanFinished(scannedFile, info);
+            }
+        });
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const TrackMetadataScanner* scanner) const
+    {
+        return owner.get() == scanner;
+    }
+
+private:
+    WeakReference<TrackMetadataScanner> owner;
+    AudioFormatManager& formatManager;
+    File file;
+};
+
+//==============================================================================
+TrackMetadataScanner::TrackMetadataScanner(AudioFormatManager& _formatManager, ThreadPool& _threadPool)
+                                          : formatManager(_formatManager),
+                                            threadPool(_threadPool)
+{
+}
+
+TrackMetadataScanner::~TrackMetadataScanner()
+{
+    removeOwnJobs(5000);
+    masterReference.clear();
+}
+
+void TrackMetadataScanner::removeOwnJobs(int timeOutMilliseconds)
+{
+    //the pool is shared, so only this scanner's jobs are stopped
+    struct OwnJobs : public ThreadPool::JobSelector
+    {
+        const TrackMetadataScanner* scanner;
+        bool isJobSuitable(ThreadPoolJob* job) override
+        {
+            auto* scanJob = dynamic_cast<ScanJob*>(job);
+            return scanJob != nullptr && scanJob->belongsTo(scanner);
+        }
+    };
+    OwnJobs selector;
+    selector.scanner = this;
+    threadPool.removeAllJobs(true, timeOutMilliseconds, &selector);
+}
+
+bool TrackMetadataScanner::getOrRequest(const File& file, TrackInfo& info)
+{
+    const String key = file.getFullPathName();
+
+    auto found = results.find(key);
+    if (found != results.end()){
+        info = found->second;
+        return true;
+    }
+
+    if (pendingFiles.insert(key).second){
+        pathBytes += MemoryMonitor::getStringBytes(key);
+        threadPool.addJob(new ScanJob(*this, file), true);
+    }
+    return false;
+}
+
+void TrackMetadataScanner::remove(const File& file)
+{
+    const String key = file.getFullPathName();
+    if (pendingFiles.erase(key) > 0){
+        pathBytes -= jmin(pathBytes, MemoryMonitor::getStringBytes(key));
+    }
+    if (results.erase(key) > 0){
+        pathBytes -= jmin(pathBytes, MemoryMonitor::getStringBytes(key));
+    }
+}
+
+void TrackMetadataScanner::clear()
+{
+    //running probes finish, but their results are ignored
+    removeOwnJobs(0);
+    pendingFiles.clear();
+    results.clear();
+    pathBytes = 0;
+}
+
+TrackMetadataScanner::TrackInfo TrackMetadataScanner::probe(AudioFormatManager& formatManager, const File& file)
+{
+    TrackInfo info;
+
+    //only the header is parsed, nothing is decoded
+    std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->sampleRate <= 0.0){
+        return info;
+    }
+
+    info.valid = true;
+    info.sampleRate = reader->sampleRate;
+    info.numChannels = static_cast<int>(reader->numChannels);
+    info.bitsPerSample = static_cast<int>(reader->bitsPerSample);
+    info.lengthInSeconds = reader->lengthInSamples / reader->sampleRate;
+    info.formatName = reader->getFormatName();
+
+    if (info.lengthInSeconds > 0.0){
+        info.bitrateKbps = roundToInt(file.getSize() * 8.0 / info.lengthInSeconds / 1000.0);
+    }
+    return info;
+}
+
+void TrackMetadataScanner::scanFinished(const File& file, const TrackInfo& info)
+{
+    const String key = file.getFullPathName();
+    //removed (or cleared) while it was being probed
+    if (pendingFiles.erase(key) == 0){
+        return;
+    }
+    pathBytes -= jmin(pathBytes, MemoryMonitor::getStringBytes(key));
+    auto inserted = results.insert({ key, info });
+    if (inserted.second){
+        pathBytes += MemoryMonitor::getStringBytes(key);
+    }
+    else{
+        inserted.first->second = info;
+    }
+
+    listeners.call([&] (Listener& l) { l.metadataReady(file, info); });
+}
+
+void TrackMetadataScanner::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void TrackMetadataScanner::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
+
+size_t TrackMetadataScanner::getMemoryUsage() const
+{
+    //format names are shared literals, only the paths are counted
+    return MemoryMonitor::getTreeBytes(results) + MemoryMonitor::getTreeBytes(pendingFiles) + pathBytes;
+}
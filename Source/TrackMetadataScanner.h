@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    TrackMetadataScanner.h
+    Created: 19 Oct 2026 12:36:13pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <map>
+#include <set>
+
+//==============================================================================
+/*
+    Probes duration, sample rate, channels and bitrate of playlist tracks on
+    the shared background ThreadPool, once per track, and keeps the results.
+    The playlist only ever reads the cache while painting, so scrolling never
+    opens a file on the message thread. Only used from the message thread;
+    listeners are told on the message thread when a track has been probed.
+*/
+class TrackMetadataScanner
+{
+public:
+    struct TrackInfo
+    {
+        //false if the file could not be opened or is not a supported format
+        bool valid = false;
+        double lengthInSeconds = 0.0;
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        int bitsPerSample = 0;
+        //average over the whole file, so it is also right for compressed formats
+        int bitrateKbps = 0;
+        String formatName;
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called when a requested track has been probed */
+        virtual void metadataReady(const File& file, const TrackInfo& info) = 0;
+    };
+
+    TrackMetadataScanner(AudioFormatManager& formatManager, ThreadPool& threadPool);
+    ~TrackMetadataScanner();
+
+    /** fills info and returns true if the track was probed already, otherwise queues it and returns false */
+    bool getOrRequest(const File& file, TrackInfo& info);
+    /** forgets a track that left the playlist; a probe still running for it is ignored */
+    void remove(const File& file);
+    /** forgets every track and drops the queued probes */
+    void clear();
+
+    /** probes a track; thread safe, called by the pool jobs */
+    static TrackInfo probe(AudioFormatManager& formatManager, const File& file);
+
+    /** estimated bytes held by the probed results */
+    size_t getMemoryUsage() const;
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+private:
+    class ScanJob;
+
+    /** called on the message thread by a finished ScanJob */
+    void scanFinished(const File& file, const TrackInfo& info);
+    void removeOwnJobs(int timeOutMilliseconds);
+
+    AudioFormatManager& formatManager;
+    ThreadPool& threadPool;
+
+    //keyed by full path name
+    std::map<String, TrackInfo> results;
+    //a set, so queueing a big import doesn't search a list for every file
+    std::set<String> pendingFiles;
+    //bytes of the paths in both, kept up to date as they change so counting doesn't walk them
+    size_t pathBytes = 0;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (TrackMetadataScanner)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TrackMetadataScanner)
+};
@@ -0,0 +1,691 @@
+/*
+  ==============================================================================
+
+    TrackTable.cpp
+    Created: 19 Oct 2026 12:42:50pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "TrackTable.h"
+#include "SearchIndex.h"
+#include "MemoryMonitor.h"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    const double millisecondsPerDay = 24.0 * 60.0 * 60.0 * 1000.0;
+
+    //clears the mask of every row whose value is outside [min, max];
+    //no branches, so the compiler can vectorise it
+    template <typename Type>
+    void keepInRange(uint8* mask, const Type* values, size_t numRows, double min, double max)
+    {
+        for (size_t i = 0; i < numRows; ++i){
+            const double v = static_cast<double>(values[i]);
+            mask[i] &= static_cast<uint8>((v >= min) & (v <= max));
+        }
+    }
+
+    //clears the mask of every row whose value is not allowed by the lookup table
+    template <typename Type>
+    void keepAllowed(uint8* mask, const Type* values, size_t numRows, const uint8* allowed)
+    {
+        for (size_t i = 0; i < numRows; ++i){
+            mask[i] &= allowed[values[i]];
+        }
+    }
+
+    //"3:30" is three and a half minutes, anything else is a plain number
+    double parseNumber(const String& text)
+    {
+        if (text.containsChar(':')){
+            return text.upToFirstOccurrenceOf(":", false, false).getDoubleValue() * 60.0
+                 + text.fromFirstOccurrenceOf(":", false, false).getDoubleValue();
+        }
+        return text.getDoubleValue();
+    }
+
+    //"a-b", ">=a", ">a", "<=a", "<a" or "a" (exact, or +-tolerance)
+    void parseRange(const String& text, double tolerance, double& min, double& max)
+    {
+        min = -infinity;
+        max = infinity;
+
+        if (text.startsWith(">=")){
+            min = parseNumber(text.substring(2));
+        }
+        else if (text.startsWith(">")){
+            min = std::nextafter(parseNumber(text.substring(1)), infinity);
+        }
+        else if (text.startsWith("<=")){
+            max = parseNumber(text.substring(2));
+        }
+        else if (text.startsWith("<")){
+            max = std::nextafter(parseNumber(text.substring(1)), -infinity);
+        }
+        else if (text.indexOfChar(1, '-') > 0){
+            min = parseNumber(text.upToFirstOccurrenceOf("-", false, false));
+            max = parseNumber(text.fromFirstOccurrenceOf("-", false, false));
+        }
+        else{
+            const double value = parseNumber(text);
+            min = value - tolerance;
+            max = value + tolerance;
+        }
+    }
+}
+
+//==============================================================================
+bool TrackTable::Query::hasFilters() const
+{
+    return !ranges.empty() || !matches.empty() || !keys.empty();
+}
+
+TrackTable::Query TrackTable::Query::parse(const String& text)
+{
+    Query query;
+
+    StringArray tokens;
+    tokens.addTokens(text, " \t", "\"");
+    tokens.removeEmptyStrings();
+
+    for (String token : tokens){
+        const String field = token.upToFirstOccurrenceOf(":", false, false).toLowerCase();
+        const String value = token.fromFirstOccurrenceOf(":", false, false).unquoted().trim();
+
+        if (!token.containsChar(':') || value.isEmpty()){
+            query.words.add(token.unquoted());
+            continue;
+        }
+
+        Range range;
+        if (field == "bpm"){
+            range.column = bpmColumn;
+            parseRange(value, 0.5, range.min, range.max);
+            query.ranges.push_back(range);
+        }
+        else if (field == "length" || field == "duration"){
+            range.column = durationColumn;
+            parseRange(value, 0.5, range.min, range.max);
+            query.ranges.push_back(range);
+        }
+        else if (field == "rating"){
+            range.column = ratingColumn;
+            parseRange(value, 0.0, range.min, range.max);
+            query.ranges.push_back(range);
+        }
+        else if (field == "plays"){
+            range.column = playCountColumn;
+            parseRange(value, 0.0, range.min, range.max);
+            query.ranges.push_back(range);
+        }
+        else if (field == "added"){
+            //in days ago, turned into a range of dates
+            double minDays, maxDays;
+            parseRange(value, 0.5, minDays, maxDays);
+            const double now = static_cast<double>(Time::currentTimeMillis());
+            range.column = dateAddedColumn;
+            range.min = now - maxDays * millisecondsPerDay;
+            range.max = now - minDays * millisecondsPerDay;
+            query.ranges.push_back(range);
+        }
+        else if (field == "year"){
+            range.column = yearColumn;
+            parseRange(value, 0.0, range.min, range.max);
+            query.ranges.push_back(range);
+        }
+        else if (field == "key"){
+            StringArray keyNames;
+            keyNames.addTokens(value, ",", "");
+            for (const String& name : keyNames){
+                const int code = parseCamelotKey(name);
+                if (code > 0){
+                    query.keys.push_back(code);
+                }
+            }
+            if (query.keys.empty()){
+                query.keys.push_back(-1); //nothing can match an unknown key name
+            }
+        }
+        else if (field == "artist" || field == "title" || field == "album" || field == "genre"){
+            Match match;
+            match.column = field == "artist" ? artistColumn
+                         : field == "title" ? titleColumn
+                         : field == "album" ? albumColumn : genreColumn;
+            match.text = SearchIndex::fold(value);
+            query.matches.push_back(match);
+        }
+        else{
+            //not a field we know, e.g. a title with a colon in it
+            query.words.add(token.unquoted());
+        }
+    }
+    return query;
+}
+
+//==============================================================================
+uint32 TrackTable::StringPool::intern(const String& s)
+{
+    if (s.isEmpty()){
+        return 0;
+    }
+    auto found = lookup.find(s);
+    if (found != lookup.end()){
+        return found->second;
+    }
+
+    const uint32 id = static_cast<uint32>(strings.size());
+    strings.push_back(s);
+    folded.push_back(SearchIndex::fold(s).toStdString());
+    lookup[s] = id;
+    textBytes += MemoryMonitor::getStringBytes(s) + MemoryMonitor::getStringBytes(folded.back());
+    return id;
+}
+
+void TrackTable::StringPool::clear()
+{
+    strings.clear();
+    folded.clear();
+    lookup.clear();
+    textBytes = 0;
+
+    //id 0 is always the empty string
+    strings.push_back({});
+    folded.push_back({});
+}
+
+//==============================================================================
+TrackTable::TrackTable()
+{
+    pool.clear();
+}
+
+void TrackTable::addRow(int64 id, const File& file, int64 dateAdded)
+{
+    const ScopedWriteLock sl(tableLock);
+    jassert(ids.empty() || id > ids.back()); //rows are found by binary search
+
+    //until the tags are read, "Artist - Title" file names are the best guess
+    const String name = file.getFileNameWithoutExtension();
+    String title = name;
+    String artist;
+    if (name.contains(" - ")){
+        artist = name.upToFirstOccurrenceOf(" - ", false, false).trim();
+        title = name.fromFirstOccurrenceOf(" - ", false, false).trim();
+    }
+
+    ids.push_back(id);
+    alive.push_back(1);
+    stringRanksValid = false;
+    titles.push_back(pool.intern(title));
+    artists.push_back(pool.intern(artist));
+    albums.push_back(0);
+    genres.push_back(0);
+    durations.push_back(0.0f);
+    bpms.push_back(0.0f);
+    keys.push_back(0);
+    ratings.push_back(0);
+    playCounts.push_back(0);
+    datesAdded.push_back(dateAdded);
+    years.push_back(0);
+}
+
+void TrackTable::removeRow(int64 id)
+{
+    const ScopedWriteLock sl(tableLock);
+    const int row = findRow(id);
+    if (row < 0){
+        return;
+    }
+    alive[static_cast<size_t>(row)] = 0;
+    ++numDead;
+    compactIfNeeded();
+}
+
+void TrackTable::clear()
+{
+    const ScopedWriteLock sl(tableLock);
+    ids.clear();
+    alive.clear();
+    titles.clear();
+    artists.clear();
+    albums.clear();
+    genres.clear();
+    durations.clear();
+    bpms.clear();
+    keys.clear();
+    ratings.clear();
+    playCounts.clear();
+    datesAdded.clear();
+    years.clear();
+    numDead = 0;
+    pool.clear();
+    stringRanksValid = false;
+}
+
+void TrackTable::compactIfNeeded()
+{
+    if (numDead < 1000 || numDead < static_cast<int>(ids.size()) / 2){
+        return;
+    }
+
+    //every column drops the same rows, so they all stay lined up
+    size_t out = 0;
+    for (size_t row = 0; row < ids.size(); ++row){
+        if (alive[row]){
+            ids[out] = ids[row];
+            alive[out] = 1;
+            titles[out] = titles[row];
+            artists[out] = artists[row];
+            albums[out] = albums[row];
+            genres[out] = genres[row];
+            durations[out] = durations[row];
+            bpms[out] = bpms[row];
+            keys[out] = keys[row];
+            ratings[out] = ratings[row];
+            playCounts[out] = playCounts[row];
+            datesAdded[out] = datesAdded[row];
+            years[out] = years[row];
+            ++out;
+        }
+    }
+    ids.resize(out);
+    alive.resize(out);
+    titles.resize(out);
+    artists.resize(out);
+    albums.resize(out);
+    genres.resize(out);
+    durations.resize(out);
+    bpms.resize(out);
+    keys.resize(out);
+    ratings.resize(out);
+    playCounts.resize(out);
+    datesAdded.resize(out);
+    years.resize(out);
+    numDead = 0;
+}
+
+//==============================================================================
+void TrackTable::setDuration(int64 id, double seconds)
+{
+    const ScopedWriteLock sl(tableLock);
+    const int row = findRow(id);
+    if (row >= 0){
+        durations[static_cast<size_t>(row)] = static_cast<float>(seconds);
+    }
+}
+
+void TrackTable::setBpm(int64 id, double bpm)
+{
+    const ScopedWriteLock sl(tableLock);
+    const int row = findRow(id);
+    if (row >= 0){
+        bpms[static_cast<size_t>(row)] = static_cast<float>(bpm);
+    }
+}
+
+void TrackTable::setKey(int64 id, int camelotCode)
+{
+    const ScopedWriteLock sl(tableLock);
+    const int row = findRow(id);
+    if (row >= 0){
+        keys[static_cast<size_t>(row)] = static_cast<uint8>(jlimit(0, 24, camelotCode));
+    }
+}
+
+void TrackTable::setRating(int64 id, int rating)
+{
+    const ScopedWriteLock sl(tableLock);
+    const int row = findRow(id);
+    if (row >= 0){
+        ratings[static_cast<size_t>(row)] = static_cast<uint8>(jlimit(0, 5, rating));
+    }
+}
+
+void TrackTable::setTags(int64 id, const String& title, const String& artist, const String& album,
+                         const String& genre, int year)
+{
+    const ScopedWriteLock sl(tableLock);
+    const int row = findRow(id);
+    if (row >= 0){
+        stringRanksValid = false;
+        //empty tags keep what the file name gave
+        if (title.isNotEmpty()){
+            titles[static_cast<size_t>(row)] = pool.intern(title);
+        }
+        if (artist.isNotEmpty()){
+            artists[static_cast<size_t>(row)] = pool.intern(artist);
+        }
+        albums[static_cast<size_t>(row)] = pool.intern(album);
+        genres[static_cast<size_t>(row)] = pool.intern(genre);
+        years[static_cast<size_t>(row)] = static_cast<uint16>(jlimit(0, 9999, year));
+    }
+}
+
+void TrackTable::incrementPlayCount(int64 id)
+{
+    const ScopedWriteLock sl(tableLock);
+    const int row = findRow(id);
+    if (row >= 0){
+        ++playCounts[static_cast<size_t>(row)];
+    }
+}
+
+void TrackTable::setPlayCount(int64 id, int count)
+{
+    const ScopedWriteLock sl(tableLock);
+    const int row = findRow(id);
+    if (row >= 0){
+        playCounts[static_cast<size_t>(row)] = static_cast<uint32>(jmax(0, count));
+    }
+}
+
+//==============================================================================
+std::vector<int64> TrackTable::select(const Query& query, const std::vector<int64>* candidates) const
+{
+    const ScopedReadLock sl(tableLock);
+
+    //string filters are decided once per distinct string, then scanned as ids
+    std::vector<std::vector<uint8>> stringMatches;
+    for (const Query::Match& match : query.matches){
+        const std::string text = match.text.toStdString();
+        std::vector<uint8> matching(pool.folded.size());
+        for (size_t i = 0; i < pool.folded.size(); ++i){
+            matching[i] = static_cast<uint8>(pool.folded[i].find(text) != std::string::npos);
+        }
+        stringMatches.push_back(std::move(matching));
+    }
+
+    uint8 allowedKeys[25] = {};
+    for (int code : query.keys){
+        if (code > 0 && code <= 24){
+            allowedKeys[code] = 1;
+        }
+    }
+
+    //the mask starts as the rows to look at, every filter clears the rows it rejects
+    const size_t numRows = ids.size();
+    std::vector<uint8> mask;
+    if (candidates == nullptr){
+        mask = alive;
+    }
+    else{
+        mask.assign(numRows, 0);
+        for (int64 id : *candidates){
+            const int row = findRow(id);
+            if (row >= 0){
+                mask[static_cast<size_t>(row)] = alive[static_cast<size_t>(row)];
+            }
+        }
+    }
+
+    for (const Query::Range& range : query.ranges){
+        switch (range.column){
+            case durationColumn:  keepInRange(mask.data(), durations.data(), numRows, range.min, range.max); break;
+            case bpmColumn:       keepInRange(mask.data(), bpms.data(), numRows, range.min, range.max); break;
+            case ratingColumn:    keepInRange(mask.data(), ratings.data(), numRows, range.min, range.max); break;
+            case playCountColumn: keepInRange(mask.data(), playCounts.data(), numRows, range.min, range.max); break;
+            case dateAddedColumn: keepInRange(mask.data(), datesAdded.data(), numRows, range.min, range.max); break;
+            case yearColumn:      keepInRange(mask.data(), years.data(), numRows, range.min, range.max); break;
+            default: break;
+        }
+    }
+    if (!query.keys.empty()){
+        keepAllowed(mask.data(), keys.data(), numRows, allowedKeys);
+    }
+    for (size_t i = 0; i < query.matches.size(); ++i){
+        keepAllowed(mask.data(), getStringColumn(query.matches[i].column).data(), numRows, stringMatches[i].data());
+    }
+
+    std::vector<int64> result;
+    for (size_t row = 0; row < numRows; ++row){
+        if (mask[row]){
+            result.push_back(ids[row]);
+        }
+    }
+    return result;
+}
+
+std::vector<int64> TrackTable::getAllIds() const
+{
+    const ScopedReadLock sl(tableLock);
+    std::vector<int64> result;
+    result.reserve(ids.size());
+    for (size_t row = 0; row < ids.size(); ++row){
+        if (alive[row]){
+            result.push_back(ids[row]);
+        }
+    }
+    return result;
+}
+
+void TrackTable::sort(std::vector<int64>& idsToSort, const std::vector<SortKey>& sortKeys) const
+{
+    const ScopedReadLock sl(tableLock);
+    if (sortKeys.empty() || idsToSort.size() < 2){
+        return;
+    }
+
+    //strings are compared by their precomputed rank, so the sort only ever compares numbers
+    const std::vector<uint32>& ranks = getStringRanks();
+
+    //all keys of a row side by side, looked up once per row; descending keys are negated
+    const size_t numKeys = sortKeys.size();
+    std::vector<double> keyValues(idsToSort.size() * numKeys, 0.0);
+    for (size_t i = 0; i < idsToSort.size(); ++i){
+        const int row = findRow(idsToSort[i]);
+        if (row < 0){
+            continue;
+        }
+        const size_t r = static_cast<size_t>(row);
+        for (size_t k = 0; k < numKeys; ++k){
+            double value = 0.0;
+            switch (sortKeys[k].column){
+                case titleColumn:     value = ranks[titles[r]]; break;
+                case artistColumn:    value = ranks[artists[r]]; break;
+                case albumColumn:     value = ranks[albums[r]]; break;
+                case durationColumn:  value = durations[r]; break;
+                case bpmColumn:       value = bpms[r]; break;
+                case keyColumn:       value = keys[r]; break;
+                case ratingColumn:    value = ratings[r]; break;
+                case playCountColumn: value = playCounts[r]; break;
+                case dateAddedColumn: value = static_cast<double>(datesAdded[r]); break;
+                case genreColumn:     value = ranks[genres[r]]; break;
+                case yearColumn:      value = years[r]; break;
+            }
+            keyValues[i * numKeys + k] = sortKeys[k].ascending ? value : -value;
+        }
+    }
+
+    std::vector<uint32> order(idsToSort.size());
+    for (uint32 i = 0; i < order.size(); ++i){
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&keyValues, numKeys] (uint32 a, uint32 b) {
+        const double* keysA = keyValues.data() + a * numKeys;
+        const double* keysB = keyValues.data() + b * numKeys;
+        for (size_t k = 0; k < numKeys; ++k){
+            if (keysA[k] != keysB[k]){
+                return keysA[k] < keysB[k];
+            }
+        }
+        return false;
+    });
+
+    std::vector<int64> sorted(idsToSort.size());
+    for (size_t i = 0; i < order.size(); ++i){
+        sorted[i] = idsToSort[order[i]];
+    }
+    idsToSort.swap(sorted);
+}
+
+bool TrackTable::getValues(int64 id, Values& values) const
+{
+    const ScopedReadLock sl(tableLock);
+    const int row = findRow(id);
+    if (row < 0){
+        return false;
+    }
+    const size_t r = static_cast<size_t>(row);
+    values.duration = durations[r];
+    values.bpm = bpms[r];
+    values.key = keys[r];
+    values.rating = ratings[r];
+    values.playCount = static_cast<int>(playCounts[r]);
+    values.dateAdded = datesAdded[r];
+    values.year = years[r];
+    return true;
+}
+
+bool TrackTable::getText(int64 id, Text& text) const
+{
+    const ScopedReadLock sl(tableLock);
+    const int row = findRow(id);
+    if (row < 0){
+        return false;
+    }
+    const size_t r = static_cast<size_t>(row);
+    text.title = pool.strings[titles[r]];
+    text.artist = pool.strings[artists[r]];
+    text.album = pool.strings[albums[r]];
+    text.genre = pool.strings[genres[r]];
+    return true;
+}
+
+const std::vector<uint32>& TrackTable::getStringRanks() const
+{
+    //called with the read lock held, so the pool can't change underneath
+    const ScopedLock sl(stringRanksLock);
+    if (!stringRanksValid){
+        std::vector<uint32> order(pool.folded.size());
+        for (uint32 i = 0; i < order.size(); ++i){
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [this] (uint32 a, uint32 b) {
+            return pool.folded[a] < pool.folded[b];
+        });
+        stringRanks.resize(order.size());
+        for (uint32 rank = 0; rank < order.size(); ++rank){
+            stringRanks[order[rank]] = rank;
+        }
+        stringRanksValid = true;
+    }
+    return stringRanks;
+}
+
+//==============================================================================
+int TrackTable::parseCamelotKey(const String& text)
+{
+    const String key = text.trim().toUpperCase();
+    const juce_wchar letter = key.getLastCharacter();
+    const int number = key.dropLastCharacters(1).getIntValue();
+
+    if (key.isNotEmpty() && key[0] >= 'A' && key[0] <= 'G'){
+        return parseKeyName(text.trim());
+    }
+    if (number < 1 || number > 12 || !key.dropLastCharacters(1).containsOnly("0123456789")){
+        return 0;
+    }
+    if (letter == 'A'){
+        return number;
+    }
+    if (letter == 'B'){
+        return number + 12;
+    }
+    return 0;
+}
+
+int TrackTable::parseKeyName(const String& text)
+{
+    //pitch class of the note, C = 0
+    static const int notePitches[] = { 9, 11, 0, 2, 4, 5, 7 }; //A..G
+    int pitch = notePitches[CharacterFunctions::toUpperCase(text[0]) - 'A'];
+
+    String rest = text.substring(1).trim();
+    if (rest.startsWith("#") || rest.startsWith(String::charToString(0x266f))){
+        ++pitch;
+        rest = rest.substring(1);
+    }
+    else if (rest.startsWith("b") || rest.startsWith(String::charToString(0x266d))){
+        --pitch;
+        rest = rest.substring(1);
+    }
+    pitch = (pitch + 12) % 12;
+
+    rest = rest.trim().toLowerCase();
+    bool minor;
+    if (rest.isEmpty() || rest == "maj" || rest == "major"){
+        minor = false;
+    }
+    else if (rest == "m" || rest == "min" || rest == "minor"){
+        minor = true;
+    }
+    else{
+        return 0;
+    }
+
+    //a step of a fifth is one step round the wheel: C major is 8B, A minor is 8A
+    const int number = (pitch * 7 + (minor ? 4 : 7)) % 12 + 1;
+    return minor ? number : number + 12;
+}
+
+String TrackTable::getCamelotKeyName(int camelotCode)
+{
+    if (camelotCode < 1 || camelotCode > 24){
+        return {};
+    }
+    return camelotCode <= 12 ? String(camelotCode) + "A" : String(camelotCode - 12) + "B";
+}
+
+int TrackTable::getNumRows() const
+{
+    const ScopedReadLock sl(tableLock);
+    return static_cast<int>(ids.size()) - numDead;
+}
+
+size_t TrackTable::getMemoryUsage() const
+{
+    const ScopedReadLock sl(tableLock);
+
+    size_t bytes = MemoryMonitor::getVectorBytes(ids) + MemoryMonitor::getVectorBytes(alive)
+                 + MemoryMonitor::getVectorBytes(titles) + MemoryMonitor::getVectorBytes(artists)
+                 + MemoryMonitor::getVectorBytes(albums) + MemoryMonitor::getVectorBytes(genres)
+                 + MemoryMonitor::getVectorBytes(durations) + MemoryMonitor::getVectorBytes(bpms)
+                 + MemoryMonitor::getVectorBytes(keys) + MemoryMonitor::getVectorBytes(ratings)
+                 + MemoryMonitor::getVectorBytes(playCounts) + MemoryMonitor::getVectorBytes(datesAdded)
+                 + MemoryMonitor::getVectorBytes(years);
+
+    //the lookup's keys share their text with the pool's strings
+    bytes += MemoryMonitor::getVectorBytes(pool.strings) + MemoryMonitor::getVectorBytes(pool.folded)
+           + MemoryMonitor::getHashBytes(pool.lookup) + pool.textBytes;
+
+    const ScopedLock rl(stringRanksLock);
+    return bytes + MemoryMonitor::getVectorBytes(stringRanks);
+}
+
+int TrackTable::findRow(int64 id) const
+{
+    auto found = std::lower_bound(ids.begin(), ids.end(), id);
+    if (found == ids.end() || *found != id){
+        return -1;
+    }
+    return static_cast<int>(found - ids.begin());
+}
+
+const std::vector<uint32>& TrackTable::getStringColumn(Column column) const
+{
+    if (column == artistColumn){
+        return artists;
+    }
+    if (column == albumColumn){
+        return albums;
+    }
+    if (column == genreColumn){
+        return genres;
+    }
+    return titles;
+}
@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    TrackTable.h
+    Created: 19 Oct 2026 12:42:50pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <unordered_map>
+#include <vector>
+
+//==============================================================================
+/*
+    Column oriented table of track metadata, one row per library track, in
+    library (id) order. Strings are interned, so a row only holds 32 bit
+    string ids, and numbers live in packed arrays, one per column.
+    Filters are evaluated one column at a time over the whole table with
+    branch free loops the compiler can vectorise; string filters are matched
+    once per distinct string and then scanned as ids.
+    Removed rows are only marked dead until half the table is dead.
+    Written from the message thread; select() and sort() may be called from
+    any thread.
+
+    Query syntax (words are ANDed, quotes group words):
+        bpm:120-128  bpm:>=100  key:8A  key:8A,9A,8B  rating:>=4  plays:0
+        length:3:00-5:00  added:<7 (days ago)  year:1990-1999  key:Am
+        artist:foo  title:"bar baz"  album:qux  genre:house
+    Anything else is free text for the SearchIndex.
+*/
+class TrackTable
+{
+public:
+    enum Column
+    {
+        titleColumn,
+        artistColumn,
+        albumColumn,
+        durationColumn,
+        bpmColumn,
+        keyColumn,
+        ratingColumn,
+        playCountColumn,
+        dateAddedColumn,
+        genreColumn,
+        yearColumn
+    };
+
+    struct SortKey
+    {
+        Column column;
+        bool ascending;
+    };
+
+    /** one row's numbers, for display */
+    struct Values
+    {
+        float duration = 0.0f;
+        float bpm = 0.0f;
+        //Camelot code, 0 if unknown
+        int key = 0;
+        int rating = 0;
+        int playCount = 0;
+        int64 dateAdded = 0;
+        //0 if unknown
+        int year = 0;
+    };
+
+    /** one row's strings, for display; title and artist are guessed from the file name until tags are read */
+    struct Text
+    {
+        String title;
+        String artist;
+        String album;
+        String genre;
+    };
+
+    struct Query
+    {
+        struct Range
+        {
+            Column column;
+            double min;
+            double max;
+        };
+        struct Match
+        {
+            Column column;
+            //folded, see SearchIndex::fold()
+            String text;
+        };
+
+        //free text, for the title search
+        StringArray words;
+        std::vector<Range> ranges;
+        std::vector<Match> matches;
+        //Camelot codes (1..24) allowed by key:, empty if there was no key filter
+        std::vector<int> keys;
+
+        bool hasFilters() const;
+
+        static Query parse(const String& text);
+    };
+
+    TrackTable();
+
+    /** ids must be added in increasing order (library ids always are); title and artist come from the file name */
+    void addRow(int64 id, const File& file, int64 dateAdded);
+    void removeRow(int64 id);
+    void clear();
+
+    void setDuration(int64 id, double seconds);
+    void setBpm(int64 id, double bpm);
+    void setKey(int64 id, int camelotCode);
+    void setRating(int64 id, int rating);
+    /** empty title or artist keeps the guess from the file name */
+    void setTags(int64 id, const String& title, const String& artist, const String& album,
+                 const String& genre, int year);
+    void incrementPlayCount(int64 id);
+    /** the count kept by the library, when the row is added */
+    void setPlayCount(int64 id, int count);
+
+    /** ids of the rows passing every filter of the query, in id order; only candidates are checked if given */
+    std::vector<int64> select(const Query& query, const std::vector<int64>* candidates) const;
+
+    /** ids of all live rows, in id order */
+    std::vector<int64> getAllIds() const;
+
+    /** sorts ids by the first key, then the next for ties, and so on; rows equal in every key keep their order */
+    void sort(std::vector<int64>& ids, const std::vector<SortKey>& sortKeys) const;
+
+    /** false if there is no row with this id */
+    bool getValues(int64 id, Values& values) const;
+    bool getText(int64 id, Text& text) const;
+
+    /** Camelot code 1..24 (1A..12A, 1B..12B) for text like "8A" or a key name like "Am", "F#" or "Bb minor";
+        0 if it isn't one */
+    static int parseCamelotKey(const String& text);
+    static String getCamelotKeyName(int camelotCode);
+
+    int getNumRows() const;
+
+    /** estimated bytes held by the columns and the string pool */
+    size_t getMemoryUsage() const;
+
+private:
+    /** each distinct string is stored once; id 0 is the empty string */
+    struct StringPool
+    {
+        struct Hash
+        {
+            size_t operator() (const String& s) const noexcept { return static_cast<size_t>(s.hashCode64()); }
+        };
+
+        std::vector<String> strings;
+        std::vector<std::string> folded;
+        std::unordered_map<String, uint32, Hash> lookup;
+        //bytes of the strings and their folded copies, added up as they are interned
+        size_t textBytes = 0;
+
+        uint32 intern(const String& s);
+        void clear();
+    };
+
+    /** row of an id, or -1; rows are in id order so this is a binary search */
+    int findRow(int64 id) const;
+    void compactIfNeeded();
+
+    /** Camelot code for a key name like "F#m", 0 if it isn't one */
+    static int parseKeyName(const String& text);
+
+    const std::vector<uint32>& getStringColumn(Column column) const;
+    /** collation rank of every pool string, worked out again only after new strings came in */
+    const std::vector<uint32>& getStringRanks() const;
+
+    //one entry per row in every column
+    std::vector<int64> ids;
+    std::vector<uint8> alive;
+    std::vector<uint32> titles;
+    std::vector<uint32> artists;
+    std::vector<uint32> albums;
+    std::vector<uint32> genres;
+    std::vector<float> durations;
+    std::vector<float> bpms;
+    std::vector<uint8> keys;
+    std::vector<uint8> ratings;
+    std::vector<uint32> playCounts;
+    std::vector<int64> datesAdded;
+    std::vector<uint16> years;
+    int numDead = 0;
+
+    StringPool pool;
+
+    //cached by getStringRanks(); sorts may run on several threads at once
+    mutable std::vector<uint32> stringRanks;
+    mutable bool stringRanksValid = false;
+    mutable CriticalSection stringRanksLock;
+
+    mutable ReadWriteLock tableLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TrackTable)
+};
@@ -0,0 +1,220 @@
+/*
+  ==============================================================================
+
+    WaveformCache.cpp
+    Created: 19 Oct 2026 12:27:37pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "WaveformCache.h"
+#include "StartupTrace.h"
+
+//==============================================================================
+/** decodes one file into a pyramid on a pool thread */
+class WaveformCache::BuildJob : public ThreadPoolJob
+{
+public:
+    BuildJob(WaveformCache& _owner, const File& _file)
+            : ThreadPoolJob("Waveform " + _file.getFileName()),
+              owner(&_owner),
+              formatManager(_owner.formatManager),
+              diskCache(_owner.diskCache),
+              file(_file)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        //tracks seen before load straight from disk, without decoding
+        WaveformPyramid::Ptr pyramid = diskCache.load(file);
+
+        if (pyramid == nullptr){
+            std::unique_ptr<AudioFormatReader> reader (formatManager.createReaderFor(file));
+            if (reader != nullptr){
+                pyramid = WaveformPyramid::build(*reader, [this] { return shouldExit(); });
+            }
+            if (shouldExit()){
+                return jobHasFinished;
+            }
+            if (pyramid != nullptr){
+                diskCache.save(file, *pyramid);
+            }
+        }
+
+        //hand the result over on the message thread, if the cache still exists
+        WeakReference<WaveformCache> cache = owner;
+        File builtFile = file;
+        MessageManager::callAsync([cache, builtFile, pyramid] {
+            if (auto* c = cache.get()){
+                c->buildFinished(builtFile, pyramid);
+            }
+        });
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const WaveformCache* cache) const
+    {
+        return owner.get() == cache;
+    }
+
+private:
+    WeakReference<WaveformCache> owner;
+    AudioFormatManager& formatManager;
+    WaveformDiskCache& diskCache;
+    File file;
+};
+
+//==============================================================================
+/** scans the disk cache folder on a pool thread, deleting whatever is over budget */
+class WaveformCache::WarmUpJob : public ThreadPoolJob
+{
+public:
+    WarmUpJob(WaveformCache& _owner)
+             : ThreadPoolJob("Waveform cache warm-up"),
+               owner(&_owner),
+               diskCache(_owner.diskCache)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        StartupTrace::ScopedPhase phase("waveform cache warm-up");
+
+        //the size is kept from now on, so saves never have to walk the folder
+        if (diskCache.getSizeOnDisk() > diskCache.getMaxSize()){
+            diskCache.compact();
+        }
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const WaveformCache* cache) const
+    {
+        return owner.get() == cache;
+    }
+
+private:
+    WeakReference<WaveformCache> owner;
+    WaveformDiskCache& diskCache;
+};
+
+//==============================================================================
+WaveformCache::WaveformCache(AudioFormatManager& _formatManager,
+                             ThreadPool& _threadPool,
+                             int _maxNumTracks,
+                             const File& diskCacheDirectory,
+                             int64 maxDiskCacheSize)
+                            : formatManager(_formatManager),
+                              threadPool(_threadPool),
+                              maxNumTracks(_maxNumTracks),
+                              diskCache(diskCacheDirectory, maxDiskCacheSize)
+{
+}
+
+WaveformCache::~WaveformCache()
+{
+    //the pool is shared, so only this cache's jobs are stopped
+    struct OwnJobs : public ThreadPool::JobSelector
+    {
+        const WaveformCache* cache;
+        bool isJobSuitable(ThreadPoolJob* job) override
+        {
+            if (auto* buildJob = dynamic_cast<BuildJob*>(job)){
+                return buildJob->belongsTo(cache);
+            }
+            auto* warmUpJob = dynamic_cast<WarmUpJob*>(job);
+            return warmUpJob != nullptr && warmUpJob->belongsTo(cache);
+        }
+    };
+    OwnJobs selector;
+    selector.cache = this;
+    threadPool.removeAllJobs(true, 5000, &selector);
+
+    masterReference.clear();
+}
+
+void WaveformCache::warmUp()
+{
+    threadPool.addJob(new WarmUpJob(*this), true);
+}
+
+WaveformPyramid::Ptr WaveformCache::getOrRequest(const File& file)
+{
+    const String key = file.getFullPathName();
+
+    auto found = entries.find(key);
+    if (found != entries.end()){
+        found->second.lastUsed = ++useCounter;
+        return found->second.pyramid;
+    }
+
+    if (!pendingFiles.contains(key)){
+        pendingFiles.add(key);
+        threadPool.addJob(new BuildJob(*this, file), true);
+    }
+    return nullptr;
+}
+
+void WaveformCache::buildFinished(const File& file, WaveformPyramid::Ptr pyramid)
+{
+    pendingFiles.removeString(file.getFullPathName());
+
+    if (pyramid != nullptr){
+        store(file, pyramid);
+    }
+    listeners.call([&] (Listener& l) { l.waveformReady(file, pyramid); });
+}
+
+void WaveformCache::store(const File& file, WaveformPyramid::Ptr pyramid)
+{
+    Entry entry;
+    entry.pyramid = pyramid;
+    entry.lastUsed = ++useCounter;
+    entry.bytes = pyramid->getMemoryUsage();
+    Entry& stored = entries[file.getFullPathName()];
+    entryBytes += entry.bytes;
+    entryBytes -= jmin(entryBytes, stored.bytes);
+    stored = entry;
+
+    while (static_cast<int>(entries.size()) > maxNumTracks){
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it){
+            if (it->second.lastUsed < oldest->second.lastUsed){
+                oldest = it;
+            }
+        }
+        entryBytes -= jmin(entryBytes, oldest->second.bytes);
+        entries.erase(oldest);
+    }
+}
+
+void WaveformCache::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void WaveformCache::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
+
+size_t WaveformCache::getMemoryUsage() const
+{
+    return entryBytes;
+}
+
+void WaveformCache::trimMemory(size_t targetBytes)
+{
+    //a deck still showing a dropped pyramid keeps it; it comes back from the disk cache when asked for again
+    while (entryBytes > targetBytes && !entries.empty()){
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it){
+            if (it->second.lastUsed < oldest->second.lastUsed){
+                oldest = it;
+            }
+        }
+        entryBytes -= jmin(entryBytes, oldest->second.bytes);
+        entries.erase(oldest);
+    }
+}
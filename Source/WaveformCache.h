@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    WaveformCache.h
+    Created: 19 Oct 2026 12:27:37pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WaveformPyramid.h"
+#include "WaveformDiskCache.h"
+#include <map>
+
+//==============================================================================
+/*
+    Keeps the waveform pyramids of recently loaded tracks in memory (replacing
+    the old AudioThumbnailCache) and fetches missing ones on the shared
+    background ThreadPool: from the WaveformDiskCache when the track was seen
+    before, otherwise by decoding it (and saving the result for next time). Only used from the message thread; listeners are
+    told on the message thread when a pyramid is ready.
+*/
+class WaveformCache
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called when a requested pyramid has been built; pyramid is nullptr if the file could not be read */
+        virtual void waveformReady(const File& file, WaveformPyramid::Ptr pyramid) = 0;
+    };
+
+    WaveformCache(AudioFormatManager& formatManager,
+                  ThreadPool& threadPool,
+                  int maxNumTracks,
+                  const File& diskCacheDirectory,
+                  int64 maxDiskCacheSize);
+    ~WaveformCache();
+
+    /** adds up (and trims) the disk cache on a pool thread, so the first build doesn't have to */
+    void warmUp();
+
+    /** returns the pyramid if it is in memory, otherwise starts building it and returns nullptr */
+    WaveformPyramid::Ptr getOrRequest(const File& file);
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+    /** bytes used by all pyramids held in memory */
+    size_t getMemoryUsage() const;
+    /** drops the least recently used pyramids until no more than targetBytes are held */
+    void trimMemory(size_t targetBytes);
+
+private:
+    class BuildJob;
+    class WarmUpJob;
+
+    struct Entry
+    {
+        WaveformPyramid::Ptr pyramid;
+        uint32 lastUsed = 0;
+        //counted once when stored, a pyramid doesn't change after it is built
+        size_t bytes = 0;
+    };
+
+    /** called on the message thread by a finished BuildJob */
+    void buildFinished(const File& file, WaveformPyramid::Ptr pyramid);
+    /** stores a pyramid, dropping the least recently used ones above maxNumTracks */
+    void store(const File& file, WaveformPyramid::Ptr pyramid);
+
+    AudioFormatManager& formatManager;
+    ThreadPool& threadPool;
+    int maxNumTracks;
+    WaveformDiskCache diskCache;
+
+    //keyed by full path name
+    std::map<String, Entry> entries;
+    StringArray pendingFiles;
+    uint32 useCounter = 0;
+    //bytes of the stored pyramids, kept up to date as they come and go so counting doesn't walk them
+    size_t entryBytes = 0;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (WaveformCache)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformCache)
+};
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    WaveformDiskCache.cpp
+    Created: 19 Oct 2026 12:28:31pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "WaveformDiskCache.h"
+#include <algorithm>
+
+//==============================================================================
+WaveformDiskCache::WaveformDiskCache(const File& cacheDirectory, int64 maxSizeInBytes)
+                                    : directory(cacheDirectory),
+                                      maxSize(maxSizeInBytes)
+{
+}
+
+String WaveformDiskCache::getIdentity(const File& audioFile)
+{
+    return audioFile.getFullPathName()
+         + "|" + String(audioFile.getSize())
+         + "|" + String(audioFile.getLastModificationTime().toMilliseconds());
+}
+
+File WaveformDiskCache::getCacheFileFor(const String& identity) const
+{
+    return directory.getChildFile(String::toHexString(identity.hashCode64()) + ".wfp");
+}
+
+WaveformPyramid::Ptr WaveformDiskCache::load(const File& audioFile)
+{
+    const String identity = getIdentity(audioFile);
+    const File cacheFile = getCacheFileFor(identity);
+
+    FileInputStream in(cacheFile);
+    if (!in.openedOk()){
+        return nullptr;
+    }
+
+    //the full identity is stored too, in case two of them share a hash
+    if (in.readString() != identity){
+        return nullptr;
+    }
+
+    WaveformPyramid::Ptr pyramid = WaveformPyramid::readFrom(in);
+    if (pyramid != nullptr){
+        //the modification time of a cache file doubles as its "last used" stamp
+        cacheFile.setLastModificationTime(Time::getCurrentTime());
+    }
+    return pyramid;
+}
+
+void WaveformDiskCache::save(const File& audioFile, const WaveformPyramid& pyramid)
+{
+    const String identity = getIdentity(audioFile);
+    const File cacheFile = getCacheFileFor(identity);
+
+    if (!directory.createDirectory()){
+        return;
+    }
+
+    const int64 oldSize = cacheFile.getSize();
+
+    //written next to the target and renamed over it, so readers never see half a file
+    TemporaryFile temp(cacheFile);
+    {
+        FileOutputStream out(temp.getFile());
+        if (!out.openedOk()){
+            return;
+        }
+        out.writeString(identity);
+        pyramid.writeTo(out);
+        out.flush();
+        if (out.getStatus().failed()){
+            return;
+        }
+    }
+    if (!temp.overwriteTargetFileWithTemporary()){
+        return;
+    }
+
+    bool overBudget = false;
+    {
+        const ScopedLock sl(lock);
+        scanSizeIfNeeded();
+        sizeOnDisk += cacheFile.getSize() - oldSize;
+        overBudget = sizeOnDisk > maxSize;
+    }
+    if (overBudget){
+        compact();
+    }
+}
+
+void WaveformDiskCache::compact()
+{
+    const ScopedLock sl(lock);
+
+    struct CacheEntry
+    {
+        File file;
+        Time lastUsed;
+        int64 size;
+    };
+    std::vector<CacheEntry> cacheEntries;
+    int64 total = 0;
+    const Time staleTempTime = Time::getCurrentTime() - RelativeTime::hours(1);
+
+    for (const auto& entry : RangedDirectoryIterator(directory, false, "*", File::findFiles)){
+        const File file = entry.getFile();
+
+        //leftovers of a save that crashed half way
+        if (file.getFileName().contains("_temp") || !file.hasFileExtension("wfp")){
+            if (entry.getModificationTime() < staleTempTime){
+                file.deleteFile();
+            }
+            continue;
+        }
+        cacheEntries.push_back({ file, entry.getModificationTime(), entry.getFileSize() });
+        total += entry.getFileSize();
+    }
+
+    //oldest first
+    std::sort(cacheEntries.begin(), cacheEntries.end(),
+              [] (const CacheEntry& a, const CacheEntry& b) { return a.lastUsed < b.lastUsed; });
+
+    //trim to 3/4 of the budget so we don't compact again after the next save
+    const int64 target = maxSize * 3 / 4;
+    for (const CacheEntry& entry : cacheEntries){
+        if (total <= target){
+            break;
+        }
+        if (entry.file.deleteFile()){
+            total -= entry.size;
+        }
+    }
+    sizeOnDisk = total;
+}
+
+int64 WaveformDiskCache::getSizeOnDisk()
+{
+    const ScopedLock sl(lock);
+    scanSizeIfNeeded();
+    return sizeOnDisk;
+}
+
+int64 WaveformDiskCache::getMaxSize() const
+{
+    return maxSize;
+}
+
+void WaveformDiskCache::scanSizeIfNeeded()
+{
+    if (sizeOnDisk >= 0){
+        return;
+    }
+    sizeOnDisk = 0;
+    for (const auto& entry : RangedDirectoryIterator(directory, false, "*.wfp", File::findFiles)){
+        sizeOnDisk += entry.getFileSize();
+    }
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    WaveformDiskCache.h
+    Created: 19 Oct 2026 12:28:31pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WaveformPyramid.h"
+
+//==============================================================================
+/*
+    On-disk store of waveform pyramids, so tracks seen in an earlier session
+    never have to be decoded again just to draw their overview.
+    Entries are keyed by the file's identity (path + size + modification time),
+    so an edited or replaced file gets analysed again. When the folder grows
+    past its size budget the least recently used entries are deleted.
+    All functions are thread safe; they are called from the pool's build jobs.
+*/
+class WaveformDiskCache
+{
+public:
+    WaveformDiskCache(const File& cacheDirectory, int64 maxSizeInBytes);
+
+    /** returns the stored pyramid for the file, or nullptr if there is none or it is out of date */
+    WaveformPyramid::Ptr load(const File& audioFile);
+    /** stores a pyramid for the file and trims the cache if it went over budget */
+    void save(const File& audioFile, const WaveformPyramid& pyramid);
+
+    /** deletes the least recently used entries (and stray temp files) until the cache is within 3/4 of its budget */
+    void compact();
+
+    int64 getSizeOnDisk();
+    int64 getMaxSize() const;
+
+private:
+    /** the identity of a file's contents, as far as we can tell without reading it */
+    static String getIdentity(const File& audioFile);
+    File getCacheFileFor(const String& identity) const;
+    /** adds up the size of the cache folder on first use */
+    void scanSizeIfNeeded();
+
+    const File directory;
+    const int64 maxSize;
+
+    CriticalSection lock;
+    int64 sizeOnDisk = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformDiskCache)
+};
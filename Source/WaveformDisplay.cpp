@@ -10,18 +10,21 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "WaveformDisplay.h"
+#include "PaintProfiler.h"
 
 //==============================================================================
-WaveformDisplay::WaveformDisplay(AudioFormatManager & 	formatManagerToUse,
-                                 AudioThumbnailCache & 	cacheToUse,
+WaveformDisplay::WaveformDisplay(WaveformCache & 	cacheToUse,
+                                 WaveformTileRenderer & 	tileRendererToUse,
                                  bool differentColour
                                  ) :
-                                 audioThumb(1000, formatManagerToUse, cacheToUse), 
+                                 cache(cacheToUse), 
+                                 tileRenderer(tileRendererToUse), 
                                  fileLoaded(false), 
                                  position(0)
                           
 {
-    audioThumb.addChangeListener(this);
+    cache.addListener(this);
+    tileRenderer.addListener(this);
 
     if (!differentColour){
         colour1 = Colour(0, 255, 127);
@@ -35,40 +38,51 @@ WaveformDisplay::WaveformDisplay(AudioFormatManager & 	formatManagerToUse,
 
 WaveformDisplay::~WaveformDisplay()
 {
+    cache.removeListener(this);
+    tileRenderer.removeListener(this);
 }
 
 void WaveformDisplay::paint (Graphics& g)
 {
+    PaintProfiler::ScopedPaint profile(g, "WaveformDisplay");
+
     g.fillAll (Colour(22, 22, 22));  //background colour
 
     g.setColour (Colour(0, 245, 245)); //outline colour);
     g.drawRect (getLocalBounds(), 1);  //draw an outline around the component
 
-    //g.setColour (colour);
-    //get a gradient colour fill:
-    ColourGradient gradientColour = ColourGradient(colour1, 0.0, getHeight()/2, colour2, getWidth(), getHeight()/2, false);
-    g.setGradientFill(gradientColour);
-    if(fileLoaded){
-        // adjusted the area and zoom parameters 
-        // two channels drawn on top of each other
-        audioThumb.drawChannel(g, 
-                               Rectangle<int>::Rectangle(3, 0, getWidth() - 6, getHeight()/2 - 2),
-                               0, 
-                               audioThumb.getTotalLength(), 
-                               0, 
-                               0.9f // zoomed out a bit
-                               );
-        audioThumb.drawChannel(g,
-                               Rectangle<int>::Rectangle(3, getHeight() / 2, getWidth() - 6, getHeight() / 2 - 2),
-                               0,
-                               audioThumb.getTotalLength(),
-                               0,
-                               0.9f // zoomed out a bit
-                               );
+    if(fileLoaded && pyramid != nullptr){
+        // the waveform itself is drawn in tiles on the background threads,
+        // here we only blit the ones that are ready
+        WaveformTileRenderer::TileKey key;
+        key.pyramid = pyramid.get();
+        key.totalWidth = getWidth();
+        key.height = getHeight();
+        key.colour1 = colour1.getARGB();
+        key.colour2 = colour2.getARGB();
+
+        const Rectangle<int> clip = g.getClipBounds();
+        const int firstTile = clip.getX() / WaveformTileRenderer::tileWidth;
+        const int lastTile = (clip.getRight() - 1) / WaveformTileRenderer::tileWidth;
+        for (int i = firstTile; i <= lastTile; ++i){
+            key.tileIndex = i;
+            Image tile = tileRenderer.getTile(key, pyramid);
+            if (tile.isValid()){
+                g.drawImageAt(tile, i * WaveformTileRenderer::tileWidth, 0);
+            }
+        }
+
       g.setColour(Colours::darkviolet);
       g.drawRect(1.5 + (position * (getWidth() - 4.5)), 1, 2, getHeight() - 1);
     }
+    else if(fileLoaded){
+      g.setColour (colour1);
+      g.setFont (20.0f);
+      g.drawText ("Analysing waveform...", getLocalBounds(),
+                  Justification::centred, true);
+    }
     else{
+      g.setColour (colour1);
       g.setFont (20.0f);
       g.drawText ("File not loaded...", getLocalBounds(),
                   Justification::centred, true);   // draw some placeholder text
@@ -83,10 +97,14 @@ void WaveformDisplay::resized()
 
 void WaveformDisplay::loadURL(URL audioURL)
 {
-  audioThumb.clear();
-  fileLoaded  = audioThumb.setSource(new URLInputSource(audioURL));
+  loadedFile = audioURL.isLocalFile() ? audioURL.getLocalFile() : File();
+  fileLoaded = loadedFile.existsAsFile();
+  pyramid = nullptr;
+
   if (fileLoaded)
   {
+    // nullptr until the background analysis is done, see waveformReady()
+    pyramid = cache.getOrRequest(loadedFile);
     repaint();
   }
   else {
@@ -94,17 +112,36 @@ void WaveformDisplay::loadURL(URL audioURL)
   }
 }
 
-void WaveformDisplay::changeListenerCallback (ChangeBroadcaster *source)
+void WaveformDisplay::waveformReady (const File& file, WaveformPyramid::Ptr newPyramid)
+{
+    if (file != loadedFile)
+    {
+        return; // a track loaded on the other deck
+    }
+    pyramid = newPyramid;
+    fileLoaded = (pyramid != nullptr);
+    repaint();
+}
+
+void WaveformDisplay::waveformTileReady()
 {
     repaint();
 }
 
+Rectangle<int> WaveformDisplay::getPlayheadBounds(double pos) const
+{
+    // same x as the marker drawn in paint(), with a pixel to spare each side
+    return Rectangle<int>(static_cast<int>(1.5 + (pos * (getWidth() - 4.5))) - 1, 0, 5, getHeight());
+}
+
 void WaveformDisplay::setPositionRelative(double pos)
 {
   if (pos != position)
   {
+    // only the old and new marker areas need redrawing, the tiles stay put
+    repaint(getPlayheadBounds(position));
     position = pos;
-    repaint();
+    repaint(getPlayheadBounds(position));
   }
 }
 
@@ -11,23 +11,30 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "WaveformCache.h"
+#include "WaveformTileRenderer.h"
 
 //==============================================================================
 /*
 */
 class WaveformDisplay    : public Component, 
-                           public ChangeListener
+                           public WaveformCache::Listener,
+                           public WaveformTileRenderer::Listener
 {
 public:
-    WaveformDisplay(AudioFormatManager & 	formatManagerToUse,
-                    AudioThumbnailCache & 	cacheToUse,
+    WaveformDisplay(WaveformCache & 	cacheToUse,
+                    WaveformTileRenderer & 	tileRendererToUse,
                     bool differentColour);
     ~WaveformDisplay();
 
     void paint (Graphics&) override;
     void resized() override;
 
-    void changeListenerCallback (ChangeBroadcaster *source) override;
+    /** called by the WaveformCache when a pyramid has been built in the background */
+    void waveformReady (const File& file, WaveformPyramid::Ptr pyramid) override;
+
+    /** called by the WaveformTileRenderer when a tile has been drawn in the background */
+    void waveformTileReady() override;
 
     void loadURL(URL audioURL);
 
@@ -35,7 +42,14 @@ public:
     void setPositionRelative(double pos);
 
 private:
-    AudioThumbnail audioThumb;
+    /** the area covered by the playhead marker at the given position */
+    Rectangle<int> getPlayheadBounds(double pos) const;
+
+    WaveformCache& cache;
+    WaveformTileRenderer& tileRenderer;
+    //the loaded track and its overview (nullptr while it is being analysed)
+    File loadedFile;
+    WaveformPyramid::Ptr pyramid;
     bool fileLoaded; 
     double position;
 
@@ -0,0 +1,359 @@
+/*
+  ==============================================================================
+
+    WaveformPyramid.cpp
+    Created: 19 Oct 2026 12:27:37pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "WaveformPyramid.h"
+
+namespace
+{
+    /** sum of an array of squares; eight accumulators so the compiler can vectorise the loop */
+    float sumOf(const float* data, int num)
+    {
+        float acc[8] = {};
+        int i = 0;
+        for (; i + 8 <= num; i += 8){
+            for (int k = 0; k < 8; ++k){
+                acc[k] += data[i + k];
+            }
+        }
+        float sum = 0.0f;
+        for (int k = 0; k < 8; ++k){
+            sum += acc[k];
+        }
+        for (; i < num; ++i){
+            sum += data[i];
+        }
+        return sum;
+    }
+
+    int8 toPeak(float value)
+    {
+        return static_cast<int8>(jlimit(-127, 127, roundToInt(value * 127.0f)));
+    }
+
+    uint8 toRMS(float value)
+    {
+        return static_cast<uint8>(jlimit(0, 255, roundToInt(value * 255.0f)));
+    }
+
+    //"OTWF" - marks a waveform cache file
+    const int fileMagic = 0x4657544f;
+}
+
+static_assert(sizeof(WaveformPyramid::Peak) == 3, "peaks are written to disk as raw bytes");
+static_assert(sizeof(BandEnergyAnalyser::Bands) == 3, "bands are written to disk as raw bytes");
+
+//==============================================================================
+WaveformPyramid::Ptr WaveformPyramid::build(AudioFormatReader& reader, const std::function<bool()>& shouldStop)
+{
+    //filter state decaying to silence must not hit denormals
+    ScopedNoDenormals noDenormals;
+
+    Ptr pyramid = new WaveformPyramid();
+    pyramid->sampleRate = reader.sampleRate > 0 ? reader.sampleRate : 44100.0;
+    pyramid->lengthInSamples = reader.lengthInSamples;
+    pyramid->numChannels = jlimit(1, 2, static_cast<int>(reader.numChannels));
+
+    const int numChannels = pyramid->numChannels;
+    const int64 length = pyramid->lengthInSamples;
+
+    Level base;
+    base.samplesPerBin = baseSamplesPerBin;
+    base.numBins = static_cast<int>((length + baseSamplesPerBin - 1) / baseSamplesPerBin);
+    base.peaks.resize(static_cast<size_t>(base.numBins) * static_cast<size_t>(numChannels));
+    base.bands.resize(static_cast<size_t>(base.numBins));
+
+    //decode in big chunks (a whole number of bins) and reduce each bin with vector ops
+    const int chunkSize = baseSamplesPerBin * 256;
+    AudioBuffer<float> chunk(numChannels, chunkSize);
+    HeapBlock<float> squares(baseSamplesPerBin);
+    HeapBlock<float> mono(chunkSize);
+    BandEnergyAnalyser bandAnalyser(pyramid->sampleRate);
+
+    for (int64 position = 0; position < length; position += chunkSize){
+        if (shouldStop()){
+            return nullptr;
+        }
+
+        const int numSamples = static_cast<int>(jmin(static_cast<int64>(chunkSize), length - position));
+        reader.read(&chunk, 0, numSamples, position, true, true);
+
+        const int firstBin = static_cast<int>(position / baseSamplesPerBin);
+        for (int ch = 0; ch < numChannels; ++ch){
+            const float* data = chunk.getReadPointer(ch);
+            Peak* peaks = base.peaks.data() + static_cast<size_t>(ch) * static_cast<size_t>(base.numBins);
+
+            for (int offset = 0; offset < numSamples; offset += baseSamplesPerBin){
+                const int num = jmin(baseSamplesPerBin, numSamples - offset);
+                const auto range = FloatVectorOperations::findMinAndMax(data + offset, num);
+                FloatVectorOperations::multiply(squares.get(), data + offset, data + offset, num);
+
+                Peak& peak = peaks[firstBin + offset / baseSamplesPerBin];
+                peak.min = toPeak(range.getStart());
+                peak.max = toPeak(range.getEnd());
+                peak.rms = toRMS(std::sqrt(sumOf(squares.get(), num) / num));
+            }
+        }
+
+        //band energies are measured on the mono mix
+        FloatVectorOperations::copy(mono.get(), chunk.getReadPointer(0), numSamples);
+        if (numChannels > 1){
+            FloatVectorOperations::add(mono.get(), chunk.getReadPointer(1), numSamples);
+            FloatVectorOperations::multiply(mono.get(), 0.5f, numSamples);
+        }
+        for (int offset = 0; offset < numSamples; offset += baseSamplesPerBin){
+            const int num = jmin(baseSamplesPerBin, numSamples - offset);
+            base.bands[static_cast<size_t>(firstBin + offset / baseSamplesPerBin)] = bandAnalyser.process(mono.get() + offset, num);
+        }
+    }
+
+    pyramid->levels.push_back(std::move(base));
+    pyramid->buildUpperLevels();
+    return pyramid;
+}
+
+void WaveformPyramid::buildUpperLevels()
+{
+    //a level of 16 bins is coarser than anything a display would ask for
+    while (levels.back().numBins > 16){
+        const Level& lower = levels.back();
+
+        Level upper;
+        upper.samplesPerBin = lower.samplesPerBin * 2;
+        upper.numBins = (lower.numBins + 1) / 2;
+        upper.peaks.resize(static_cast<size_t>(upper.numBins) * static_cast<size_t>(numChannels));
+        upper.bands.resize(static_cast<size_t>(upper.numBins));
+
+        for (int ch = 0; ch < numChannels; ++ch){
+            const Peak* source = lower.peaks.data() + static_cast<size_t>(ch) * static_cast<size_t>(lower.numBins);
+            Peak* dest = upper.peaks.data() + static_cast<size_t>(ch) * static_cast<size_t>(upper.numBins);
+
+            for (int bin = 0; bin < upper.numBins; ++bin){
+                const Peak& a = source[bin * 2];
+                const Peak& b = (bin * 2 + 1 < lower.numBins) ? source[bin * 2 + 1] : a;
+
+                dest[bin].min = jmin(a.min, b.min);
+                dest[bin].max = jmax(a.max, b.max);
+                dest[bin].rms = static_cast<uint8>(std::sqrt((a.rms * a.rms + b.rms * b.rms) * 0.5f));
+            }
+        }
+
+        auto combine = [] (uint8 a, uint8 b) {
+            return static_cast<uint8>(std::sqrt((a * a + b * b) * 0.5f));
+        };
+        for (size_t bin = 0; bin < upper.bands.size(); ++bin){
+            const auto& a = lower.bands[bin * 2];
+            const auto& b = (bin * 2 + 1 < lower.bands.size()) ? lower.bands[bin * 2 + 1] : a;
+            upper.bands[bin].low = combine(a.low, b.low);
+            upper.bands[bin].mid = combine(a.mid, b.mid);
+            upper.bands[bin].high = combine(a.high, b.high);
+        }
+        levels.push_back(std::move(upper));
+    }
+}
+
+//==============================================================================
+void WaveformPyramid::writeTo(OutputStream& out) const
+{
+    out.writeInt(fileMagic);
+    out.writeInt(fileFormatVersion);
+    out.writeDouble(sampleRate);
+    out.writeInt64(lengthInSamples);
+    out.writeInt(numChannels);
+    out.writeInt(static_cast<int>(levels.size()));
+
+    for (const Level& level : levels){
+        out.writeInt(level.samplesPerBin);
+        out.writeInt(level.numBins);
+        out.write(level.peaks.data(), level.peaks.size() * sizeof(Peak));
+        out.write(level.bands.data(), level.bands.size() * sizeof(BandEnergyAnalyser::Bands));
+    }
+}
+
+bool WaveformPyramid::canRead(InputStream& in, size_t numBytes)
+{
+    //streams of unknown length report -1; the read below then catches a short file
+    const int64 remaining = in.getNumBytesRemaining();
+    return numBytes <= static_cast<size_t>(std::numeric_limits<int>::max())
+        && (in.getTotalLength() < 0 || static_cast<int64>(numBytes) <= remaining);
+}
+
+WaveformPyramid::Ptr WaveformPyramid::readFrom(InputStream& in)
+{
+    if (in.readInt() != fileMagic || in.readInt() != fileFormatVersion){
+        return nullptr;
+    }
+
+    Ptr pyramid = new WaveformPyramid();
+    pyramid->sampleRate = in.readDouble();
+    pyramid->lengthInSamples = in.readInt64();
+    pyramid->numChannels = in.readInt();
+    const int numLevels = in.readInt();
+
+    if (pyramid->sampleRate <= 0.0 || pyramid->lengthInSamples < 0
+        || pyramid->numChannels < 1 || pyramid->numChannels > 2
+        || numLevels < 1 || numLevels > 64){
+        return nullptr;
+    }
+
+    for (int i = 0; i < numLevels; ++i){
+        Level level;
+        level.samplesPerBin = in.readInt();
+        level.numBins = in.readInt();
+        if (level.samplesPerBin < baseSamplesPerBin || level.numBins < 0){
+            return nullptr;
+        }
+
+        //a damaged count must not make us allocate (or read) more than the track or the file can hold
+        const int64 maxBins = (pyramid->lengthInSamples + level.samplesPerBin - 1) / level.samplesPerBin;
+        const size_t numBytes = static_cast<size_t>(level.numBins) * static_cast<size_t>(pyramid->numChannels) * sizeof(Peak);
+        if (level.numBins > maxBins || !canRead(in, numBytes)){
+            return nullptr;
+        }
+        level.peaks.resize(static_cast<size_t>(level.numBins) * static_cast<size_t>(pyramid->numChannels));
+        if (static_cast<size_t>(in.read(level.peaks.data(), static_cast<int>(numBytes))) != numBytes){
+            return nullptr; //truncated file
+        }
+
+        const size_t numBandBytes = static_cast<size_t>(level.numBins) * sizeof(BandEnergyAnalyser::Bands);
+        if (!canRead(in, numBandBytes)){
+            return nullptr;
+        }
+        level.bands.resize(static_cast<size_t>(level.numBins));
+        if (static_cast<size_t>(in.read(level.bands.data(), static_cast<int>(numBandBytes))) != numBandBytes){
+            return nullptr;
+        }
+        pyramid->levels.push_back(std::move(level));
+    }
+    return pyramid;
+}
+
+//==============================================================================
+double WaveformPyramid::getSampleRate() const
+{
+    return sampleRate;
+}
+
+int64 WaveformPyramid::getLengthInSamples() const
+{
+    return lengthInSamples;
+}
+
+double WaveformPyramid::getTotalLength() const
+{
+    return lengthInSamples / sampleRate;
+}
+
+int WaveformPyramid::getNumChannels() const
+{
+    return numChannels;
+}
+
+size_t WaveformPyramid::getMemoryUsage() const
+{
+    size_t bytes = sizeof(*this);
+    for (const Level& level : levels){
+        bytes += level.peaks.capacity() * sizeof(Peak);
+        bytes += level.bands.capacity() * sizeof(BandEnergyAnalyser::Bands);
+    }
+    return bytes;
+}
+
+int WaveformPyramid::chooseLevel(double samplesPerPixel) const
+{
+    int chosen = 0;
+    for (int i = 1; i < static_cast<int>(levels.size()); ++i){
+        if (levels[static_cast<size_t>(i)].samplesPerBin > samplesPerPixel){
+            break;
+        }
+        chosen = i;
+    }
+    return chosen;
+}
+
+void WaveformPyramid::drawChannel(Graphics& g,
+                                  Rectangle<int> area,
+                                  double startTime,
+                                  double endTime,
+                                  int channel,
+                                  float verticalZoom,
+                                  DrawMode mode) const
+{
+    if (area.isEmpty() || endTime <= startTime || levels.empty()){
+        return;
+    }
+
+    const double samplesPerPixel = (endTime - startTime) * sampleRate / area.getWidth();
+    const Level& level = levels[static_cast<size_t>(chooseLevel(samplesPerPixel))];
+    const Peak* peaks = level.peaks.data()
+                      + static_cast<size_t>(jmin(channel, numChannels - 1)) * static_cast<size_t>(level.numBins);
+
+    const float midY = static_cast<float>(area.getCentreY());
+    const float halfHeight = area.getHeight() * 0.5f * verticalZoom;
+    const double startSample = startTime * sampleRate;
+
+    //one rectangle per pixel column, filled with a single call at the end
+    RectangleList<float> columns;
+    columns.ensureStorageAllocated(area.getWidth());
+
+    for (int x = 0; x < area.getWidth(); ++x){
+        const double from = startSample + x * samplesPerPixel;
+        if (from < 0.0){
+            continue;
+        }
+
+        const int firstBin = static_cast<int>(from / level.samplesPerBin);
+        if (firstBin >= level.numBins){
+            break;
+        }
+        const int lastBin = jlimit(firstBin + 1, level.numBins,
+                                   static_cast<int>(std::ceil((from + samplesPerPixel) / level.samplesPerBin)));
+
+        float top, bottom;
+        if (mode == drawRMS){
+            uint8 rms = peaks[firstBin].rms;
+            for (int bin = firstBin + 1; bin < lastBin; ++bin){
+                rms = jmax(rms, peaks[bin].rms);
+            }
+            top = midY - rms / 255.0f * halfHeight;
+            bottom = midY + rms / 255.0f * halfHeight;
+        }
+        else{
+            int8 low = peaks[firstBin].min;
+            int8 high = peaks[firstBin].max;
+            for (int bin = firstBin + 1; bin < lastBin; ++bin){
+                low = jmin(low, peaks[bin].min);
+                high = jmax(high, peaks[bin].max);
+            }
+            top = midY - high / 127.0f * halfHeight;
+            bottom = midY - low / 127.0f * halfHeight;
+        }
+
+        //silence still gets a one pixel line, like AudioThumbnail
+        const Rectangle<float> column(static_cast<float>(area.getX() + x), top, 1.0f, jmax(1.0f, bottom - top));
+
+        if (mode == drawBandColouredPeaks){
+            //every column has its own colour, so these can't be batched
+            BandEnergyAnalyser::Bands bands = level.bands[static_cast<size_t>(firstBin)];
+            for (int bin = firstBin + 1; bin < lastBin; ++bin){
+                const auto& b = level.bands[static_cast<size_t>(bin)];
+                bands.low = jmax(bands.low, b.low);
+                bands.mid = jmax(bands.mid, b.mid);
+                bands.high = jmax(bands.high, b.high);
+            }
+            g.setColour(BandEnergyAnalyser::getColourFor(bands));
+            g.fillRect(column);
+        }
+        else{
+            columns.addWithoutMerging(column);
+        }
+    }
+
+    g.fillRectList(columns);
+}
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    WaveformPyramid.h
+    Created: 19 Oct 2026 12:27:37pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "BandEnergyAnalyser.h"
+#include <functional>
+#include <vector>
+
+//==============================================================================
+/*
+    Multi-resolution waveform overview of one track (a min/max/RMS mip-map).
+    Level 0 holds one peak per 256 samples, every level above halves the
+    resolution of the one below. Each bin also has the low/mid/high band
+    energy of the (mono) mix, used to colour the waveform. Everything is
+    stored as 8 bit values, so a five minute stereo track needs about 1 MB.
+    Drawing picks the level that has about one peak per pixel, so the cost of
+    a paint only depends on the width of the area, not on the zoom or length.
+*/
+class WaveformPyramid : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<WaveformPyramid>;
+
+    /** one bin of one channel: peaks scaled to -127..127, rms to 0..255 */
+    struct Peak
+    {
+        int8 min = 0;
+        int8 max = 0;
+        uint8 rms = 0;
+    };
+
+    enum DrawMode
+    {
+        drawPeaks,
+        drawRMS,
+        //peaks coloured by their low/mid/high band energy, ignores the current colour of g
+        drawBandColouredPeaks
+    };
+
+    static constexpr int baseSamplesPerBin = 256;
+
+    /** decodes the whole reader and builds every level; returns nullptr if shouldStop() returned true on the way */
+    static Ptr build(AudioFormatReader& reader, const std::function<bool()>& shouldStop);
+
+    /** writes the pyramid in the binary format of the on-disk cache */
+    void writeTo(OutputStream& out) const;
+    /** reads what writeTo() wrote; returns nullptr for a damaged or out of date stream */
+    static Ptr readFrom(InputStream& in);
+
+    double getSampleRate() const;
+    int64 getLengthInSamples() const;
+    /** track length in seconds */
+    double getTotalLength() const;
+    int getNumChannels() const;
+    /** bytes used by all levels */
+    size_t getMemoryUsage() const;
+
+    /** fills one channel's peaks (or rms) between the two times with the current colour/gradient of g */
+    void drawChannel(Graphics& g,
+                     Rectangle<int> area,
+                     double startTime,
+                     double endTime,
+                     int channel,
+                     float verticalZoom,
+                     DrawMode mode = drawPeaks) const;
+
+private:
+    struct Level
+    {
+        int samplesPerBin = 0;
+        int numBins = 0;
+        //channel after channel: peaks[channel * numBins + bin]
+        std::vector<Peak> peaks;
+        //one per bin, for the mix of all channels
+        std::vector<BandEnergyAnalyser::Bands> bands;
+    };
+
+    WaveformPyramid() = default;
+
+    /** coarsest level that still has at least one bin per pixel */
+    int chooseLevel(double samplesPerPixel) const;
+    /** halves level 0 repeatedly until a level fits in a few bins */
+    void buildUpperLevels();
+    /** true if numBytes can be read into one buffer and the stream still holds that many */
+    static bool canRead(InputStream& in, size_t numBytes);
+
+    double sampleRate = 44100.0;
+    int64 lengthInSamples = 0;
+    int numChannels = 1;
+    std::vector<Level> levels;
+
+    //bumped whenever the layout written by writeTo() changes
+    static constexpr int fileFormatVersion = 2;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformPyramid)
+};
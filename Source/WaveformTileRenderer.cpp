@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    WaveformTileRenderer.cpp
+    Created: 19 Oct 2026 12:30:33pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "WaveformTileRenderer.h"
+#include <tuple>
+
+//==============================================================================
+bool WaveformTileRenderer::TileKey::operator< (const TileKey& other) const
+{
+    return std::tie(pyramid, totalWidth, height, tileIndex, colour1, colour2)
+         < std::tie(other.pyramid, other.totalWidth, other.height, other.tileIndex, other.colour1, other.colour2);
+}
+
+//==============================================================================
+/** draws one tile on a pool thread */
+class WaveformTileRenderer::RenderJob : public ThreadPoolJob
+{
+public:
+    RenderJob(WaveformTileRenderer& _owner, const TileKey& _key, WaveformPyramid::Ptr _pyramid)
+             : ThreadPoolJob("Waveform tile"),
+               owner(&_owner),
+               key(_key),
+               pyramid(_pyramid)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        Image image = renderTile(key, *pyramid);
+        if (shouldExit()){
+            return jobHasFinished;
+        }
+
+        WeakReference<WaveformTileRenderer> renderer = owner;
+        TileKey tileKey = key;
+        WaveformPyramid::Ptr tilePyramid = pyramid;
+        MessageManager::callAsync([renderer, tileKey, tilePyramid, image] {
+            if (auto* r = renderer.get()){
+                r->tileFinished(tileKey, tilePyramid, image);
+            }
+        });
+        return jobHasFinished;
+    }
+
+    bool belongsTo(const WaveformTileRenderer* renderer) const
+    {
+        return owner.get() == renderer;
+    }
+
+private:
+    WeakReference<WaveformTileRenderer> owner;
+    TileKey key;
+    WaveformPyramid::Ptr pyramid;
+};
+
+//==============================================================================
+WaveformTileRenderer::WaveformTileRenderer(ThreadPool& _threadPool, int _maxNumTiles)
+                                          : threadPool(_threadPool),
+                                            maxNumTiles(_maxNumTiles)
+{
+}
+
+WaveformTileRenderer::~WaveformTileRenderer()
+{
+    //the pool is shared, so only this renderer's jobs are stopped
+    struct OwnJobs : public ThreadPool::JobSelector
+    {
+        const WaveformTileRenderer* renderer;
+        bool isJobSuitable(ThreadPoolJob* job) override
+        {
+            auto* renderJob = dynamic_cast<RenderJob*>(job);
+            return renderJob != nullptr && renderJob->belongsTo(renderer);
+        }
+    };
+    OwnJobs selector;
+    selector.renderer = this;
+    threadPool.removeAllJobs(true, 5000, &selector);
+
+    masterReference.clear();
+}
+
+Image WaveformTileRenderer::getTile(const TileKey& key, WaveformPyramid::Ptr pyramid)
+{
+    auto found = tiles.find(key);
+    if (found != tiles.end()){
+        found->second.lastUsed = ++useCounter;
+        return found->second.image;
+    }
+
+    if (pendingTiles.count(key) == 0){
+        pendingTiles.insert(key);
+        threadPool.addJob(new RenderJob(*this, key, pyramid), true);
+    }
+    return {};
+}
+
+void WaveformTileRenderer::tileFinished(const TileKey& key, WaveformPyramid::Ptr pyramid, Image image)
+{
+    pendingTiles.erase(key);
+
+    Entry entry;
+    entry.image = image;
+    entry.pyramid = pyramid;
+    entry.lastUsed = ++useCounter;
+    Entry& stored = tiles[key];
+    tileBytes += getImageBytes(image);
+    tileBytes -= jmin(tileBytes, getImageBytes(stored.image));
+    stored = entry;
+
+    //least recently used tiles go first (old sizes, old tracks)
+    while (static_cast<int>(tiles.size()) > maxNumTiles){
+        auto oldest = tiles.begin();
+        for (auto it = tiles.begin(); it != tiles.end(); ++it){
+            if (it->second.lastUsed < oldest->second.lastUsed){
+                oldest = it;
+            }
+        }
+        tileBytes -= jmin(tileBytes, getImageBytes(oldest->second.image));
+        tiles.erase(oldest);
+    }
+
+    listeners.call([] (Listener& l) { l.waveformTileReady(); });
+}
+
+void WaveformTileRenderer::addListener(Listener* listener)
+{
+    listeners.add(listener);
+}
+
+void WaveformTileRenderer::removeListener(Listener* listener)
+{
+    listeners.remove(listener);
+}
+
+size_t WaveformTileRenderer::getMemoryUsage() const
+{
+    return tileBytes;
+}
+
+void WaveformTileRenderer::trimMemory(size_t targetBytes)
+{
+    //tiles still on screen are simply drawn again on the next paint
+    while (tileBytes > targetBytes && !tiles.empty()){
+        auto oldest = tiles.begin();
+        for (auto it = tiles.begin(); it != tiles.end(); ++it){
+            if (it->second.lastUsed < oldest->second.lastUsed){
+                oldest = it;
+            }
+        }
+        tileBytes -= jmin(tileBytes, getImageBytes(oldest->second.image));
+        tiles.erase(oldest);
+    }
+}
+
+size_t WaveformTileRenderer::getImageBytes(const Image& image)
+{
+    //ARGB, 4 bytes a pixel; a null image has no size
+    return static_cast<size_t>(image.getWidth()) * static_cast<size_t>(image.getHeight()) * 4;
+}
+
+//==============================================================================
+Image WaveformTileRenderer::renderTile(const TileKey& key, const WaveformPyramid& pyramid)
+{
+    const int tileX = key.tileIndex * tileWidth;
+    const int width = jmin(tileWidth, key.totalWidth - tileX);
+    if (width <= 0 || key.height <= 0){
+        return {};
+    }
+
+    //software images can safely be drawn on any thread
+    Image image(Image::ARGB, width, key.height, true, SoftwareImageType());
+    Graphics g(image);
+
+    //draw in display coordinates, so the tiles line up with each other
+    g.setOrigin(-tileX, 0);
+    const Rectangle<int> tileArea(tileX, 0, width, key.height);
+
+    //the rms body keeps the deck's gradient, faintly, on top of the band coloured peaks
+    const ColourGradient deckGradient(Colour(key.colour1).withAlpha(0.35f), 0.0f, key.height / 2.0f,
+                                      Colour(key.colour2).withAlpha(0.35f), static_cast<float>(key.totalWidth), key.height / 2.0f,
+                                      false);
+
+    //two channels, one above the other; the whole track spans x = 3 .. width - 3
+    const Rectangle<int> lanes[] = { { 3, 0, key.totalWidth - 6, key.height / 2 - 2 },
+                                     { 3, key.height / 2, key.totalWidth - 6, key.height / 2 - 2 } };
+    const double totalLength = pyramid.getTotalLength();
+
+    for (int channel = 0; channel < 2; ++channel){
+        const Rectangle<int> area = lanes[channel].getIntersection(tileArea);
+        if (area.isEmpty()){
+            continue;
+        }
+        const double startTime = (area.getX() - 3) * totalLength / lanes[channel].getWidth();
+        const double endTime = (area.getRight() - 3) * totalLength / lanes[channel].getWidth();
+        pyramid.drawChannel(g, area, startTime, endTime, channel, 0.9f, WaveformPyramid::drawBandColouredPeaks);
+        g.setGradientFill(deckGradient);
+        pyramid.drawChannel(g, area, startTime, endTime, channel, 0.9f, WaveformPyramid::drawRMS);
+    }
+    return image;
+}
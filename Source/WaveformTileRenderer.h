@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    WaveformTileRenderer.h
+    Created: 19 Oct 2026 12:30:33pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WaveformPyramid.h"
+#include <map>
+#include <set>
+
+//==============================================================================
+/*
+    Rasterises the overview waveforms on the shared background ThreadPool.
+    A WaveformDisplay is split into columns of tileWidth pixels; each tile is
+    drawn into a software Image by a pool job and kept in a small LRU cache,
+    so the display's paint() only has to blit tiles that are ready.
+    A tile is identified by everything that changes its pixels (the pyramid,
+    the size of the display and its colours), so tiles are only redrawn after
+    a resize, a colour change or new analysis data.
+*/
+class WaveformTileRenderer
+{
+public:
+    static constexpr int tileWidth = 256;
+
+    struct TileKey
+    {
+        const WaveformPyramid* pyramid = nullptr;
+        int totalWidth = 0;
+        int height = 0;
+        int tileIndex = 0;
+        uint32 colour1 = 0;
+        uint32 colour2 = 0;
+
+        bool operator< (const TileKey& other) const;
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        /** called on the message thread whenever a new tile is ready */
+        virtual void waveformTileReady() = 0;
+    };
+
+    WaveformTileRenderer(ThreadPool& threadPool, int maxNumTiles);
+    ~WaveformTileRenderer();
+
+    /** returns the tile if it is ready, otherwise queues it and returns an invalid Image */
+    Image getTile(const TileKey& key, WaveformPyramid::Ptr pyramid);
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+    /** bytes used by the cached tile images */
+    size_t getMemoryUsage() const;
+    /** drops the least recently used tiles until no more than targetBytes are cached */
+    void trimMemory(size_t targetBytes);
+
+    /** draws one overview tile; thread safe, called by the pool jobs */
+    static Image renderTile(const TileKey& key, const WaveformPyramid& pyramid);
+
+private:
+    class RenderJob;
+
+    struct Entry
+    {
+        Image image;
+        //keeps the pyramid alive, so its address can't be reused by another track
+        WaveformPyramid::Ptr pyramid;
+        uint32 lastUsed = 0;
+    };
+
+    static size_t getImageBytes(const Image& image);
+
+    void tileFinished(const TileKey& key, WaveformPyramid::Ptr pyramid, Image image);
+
+    ThreadPool& threadPool;
+    int maxNumTiles;
+
+    std::map<TileKey, Entry> tiles;
+    std::set<TileKey> pendingTiles;
+    uint32 useCounter = 0;
+    //bytes of the tiles held, kept up to date as they come and go so counting doesn't walk them
+    size_t tileBytes = 0;
+
+    ListenerList<Listener> listeners;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (WaveformTileRenderer)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformTileRenderer)
+};